@@ -200,6 +200,14 @@ void rr_test(void);
 
 void barrier_test(void);
 
+/* mm_stress.c **************************************************************/
+
+void mm_stress_test(void);
+
+/* mm_granbench.c ***********************************************************/
+
+void gran_bench_test(void);
+
 /* prioinherit.c ************************************************************/
 
 void priority_inheritance(void);
@@ -456,6 +456,22 @@ static int user_main(int argc, char *argv[])
 		check_test_memory_usage();
 #endif
 
+#ifdef CONFIG_EXAMPLES_KERNEL_SAMPLE_MM_STRESS
+		/* Measure heap contention between threads */
+
+		printf("\nuser_main: heap stress test\n");
+		mm_stress_test();
+		check_test_memory_usage();
+#endif
+
+#ifdef CONFIG_EXAMPLES_KERNEL_SAMPLE_GRANBENCH
+		/* Measure the granule allocator search */
+
+		printf("\nuser_main: granule allocator benchmark\n");
+		gran_bench_test();
+		check_test_memory_usage();
+#endif
+
 #if defined(CONFIG_PRIORITY_INHERITANCE) && !defined(CONFIG_DISABLE_SIGNALS) && !defined(CONFIG_DISABLE_PTHREAD)
 		/* Verify priority inheritance */
 
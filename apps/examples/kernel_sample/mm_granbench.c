@@ -0,0 +1,117 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * examples/kernel_sample/mm_granbench.c
+ *
+ * A granule heap is fragmented by freeing every other small allocation, and
+ * then the average time of a gran_alloc()/gran_free() pair is shown for
+ * several allocation sizes.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <tinyara/mm/gran.h>
+
+#include "kernel_sample.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define GRAN_BENCH_LOG2GRAN   5
+#define GRAN_BENCH_GRANSIZE   (1 << GRAN_BENCH_LOG2GRAN)
+#define GRAN_BENCH_NGRANULES  1024
+#define GRAN_BENCH_NFRAGMENTS 256
+#define GRAN_BENCH_NLOOPS     200
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint8_t g_granbench_heap[GRAN_BENCH_NGRANULES * GRAN_BENCH_GRANSIZE];
+static FAR void *g_granbench_frags[GRAN_BENCH_NFRAGMENTS];
+static const int g_granbench_sizes[] = { 1, 4, 32, 64 };
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void gran_bench_test(void)
+{
+	GRAN_HANDLE handle;
+	struct timespec before;
+	struct timespec after;
+	FAR void *mem;
+	size_t size;
+	uint64_t nsec;
+	int loop;
+	int i;
+
+	handle = gran_initialize(g_granbench_heap, sizeof(g_granbench_heap), GRAN_BENCH_LOG2GRAN, GRAN_BENCH_LOG2GRAN);
+	if (handle == NULL) {
+		printf("gran_bench_test: ERROR gran_initialize failed\n");
+		return;
+	}
+
+	/* Fill the front of the heap with one-granule holes */
+
+	for (i = 0; i < GRAN_BENCH_NFRAGMENTS; i++) {
+		g_granbench_frags[i] = gran_alloc(handle, GRAN_BENCH_GRANSIZE);
+	}
+
+	for (i = 0; i < GRAN_BENCH_NFRAGMENTS; i += 2) {
+		if (g_granbench_frags[i] != NULL) {
+			gran_free(handle, g_granbench_frags[i], GRAN_BENCH_GRANSIZE);
+			g_granbench_frags[i] = NULL;
+		}
+	}
+
+	for (i = 0; i < sizeof(g_granbench_sizes) / sizeof(g_granbench_sizes[0]); i++) {
+		size = g_granbench_sizes[i] * GRAN_BENCH_GRANSIZE;
+
+		(void)clock_gettime(CLOCK_REALTIME, &before);
+		for (loop = 0; loop < GRAN_BENCH_NLOOPS; loop++) {
+			mem = gran_alloc(handle, size);
+			if (mem == NULL) {
+				printf("gran_bench_test: ERROR gran_alloc of %d granules failed\n", g_granbench_sizes[i]);
+				break;
+			}
+			gran_free(handle, mem, size);
+		}
+		(void)clock_gettime(CLOCK_REALTIME, &after);
+
+		nsec = (uint64_t)(after.tv_sec - before.tv_sec) * 1000000000 + after.tv_nsec - before.tv_nsec;
+		printf("gran_bench_test: %2d granules: %lu nsec per alloc/free\n", g_granbench_sizes[i], (unsigned long)(nsec / GRAN_BENCH_NLOOPS));
+	}
+
+	for (i = 1; i < GRAN_BENCH_NFRAGMENTS; i += 2) {
+		if (g_granbench_frags[i] != NULL) {
+			gran_free(handle, g_granbench_frags[i], GRAN_BENCH_GRANSIZE);
+		}
+	}
+
+	gran_release(handle);
+}
@@ -0,0 +1,141 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * examples/kernel_sample/mm_stress.c
+ *
+ * Several threads allocate and free small blocks as fast as they can, and
+ * the time taken and the number of waits on the heap semaphore are shown.
+ * With CONFIG_MM_TASK_CACHE the run is made with and without the thread
+ * caches.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <tinyara/mm/mm.h>
+
+#include "kernel_sample.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MM_STRESS_NTHREADS 4
+#define MM_STRESS_NLOOPS   2000
+#define MM_STRESS_NBLOCKS  8
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void *mm_stress_thread(void *parameter)
+{
+	FAR void *blocks[MM_STRESS_NBLOCKS];
+	int id = (int)parameter;
+	int loop;
+	int i;
+
+	for (loop = 0; loop < MM_STRESS_NLOOPS; loop++) {
+		/* Block sizes between 16 and 256 bytes, as made by protocol stacks
+		 * and parsers
+		 */
+
+		for (i = 0; i < MM_STRESS_NBLOCKS; i++) {
+			blocks[i] = malloc(16 << ((id + loop + i) % 5));
+		}
+
+		for (i = 0; i < MM_STRESS_NBLOCKS; i++) {
+			if (blocks[i] == NULL) {
+				printf("mm_stress_thread[%d]: ERROR malloc failed in loop %d\n", id, loop);
+			}
+			free(blocks[i]);
+		}
+	}
+
+	return NULL;
+}
+
+static void mm_stress_run(const char *title)
+{
+	pthread_t threads[MM_STRESS_NTHREADS];
+	struct timespec before;
+	struct timespec after;
+	struct mallinfo mmbefore;
+	struct mallinfo mmafter;
+	long msec;
+	int status;
+	int i;
+
+#ifdef CONFIG_CAN_PASS_STRUCTS
+	mmbefore = mallinfo();
+#else
+	(void)mallinfo(&mmbefore);
+#endif
+	(void)clock_gettime(CLOCK_REALTIME, &before);
+
+	for (i = 0; i < MM_STRESS_NTHREADS; i++) {
+		status = pthread_create(&threads[i], NULL, mm_stress_thread, (pthread_addr_t)i);
+		if (status != 0) {
+			printf("mm_stress_test: ERROR pthread_create failed, status=%d\n", status);
+			break;
+		}
+	}
+
+	while (--i >= 0) {
+		pthread_join(threads[i], NULL);
+	}
+
+	(void)clock_gettime(CLOCK_REALTIME, &after);
+#ifdef CONFIG_CAN_PASS_STRUCTS
+	mmafter = mallinfo();
+#else
+	(void)mallinfo(&mmafter);
+#endif
+
+	msec = (after.tv_sec - before.tv_sec) * 1000 + (after.tv_nsec - before.tv_nsec) / 1000000;
+	printf("mm_stress_test: %s: %d threads x %d allocations in %ld ms\n", title, MM_STRESS_NTHREADS, MM_STRESS_NLOOPS * MM_STRESS_NBLOCKS, msec);
+#ifdef CONFIG_MM_TASK_CACHE
+	printf("mm_stress_test: %s: heap semaphore waits %d\n", title, mmafter.semwaits - mmbefore.semwaits);
+#endif
+	printf("mm_stress_test: %s: free %d bytes before, %d bytes after\n", title, mmbefore.fordblks, mmafter.fordblks);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void mm_stress_test(void)
+{
+#ifdef CONFIG_MM_TASK_CACHE
+	mm_taskcache_enable(false);
+	mm_stress_run("shared heap");
+	mm_taskcache_enable(true);
+	mm_stress_run("thread caches");
+#else
+	mm_stress_run("shared heap");
+#endif
+}
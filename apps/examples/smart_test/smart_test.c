@@ -64,6 +64,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <time.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -78,6 +79,8 @@ static int *g_lineLen;
 static int g_seekCount;
 static int g_writeCount;
 static int g_circCount;
+static int g_appendCount;
+static char *g_statusFile;
 
 static int g_lineCount = 2000;
 static int g_recordLen = 64;
@@ -505,6 +508,117 @@ static int smart_circular_log_test(char *filename)
 	return OK;
 }
 
+/****************************************************************************
+ * Name: smart_bytes_written
+ *
+ * Description: Returns the number of bytes programmed to the flash, read
+ *              from the SMARTFS procfs status file given with -p, or 0
+ *              if it is not available.
+ *
+ ****************************************************************************/
+
+static unsigned long smart_bytes_written(void)
+{
+	FILE *fp;
+	char line[64];
+	unsigned long bytes = 0;
+
+	if (g_statusFile == NULL) {
+		return 0;
+	}
+
+	fp = fopen(g_statusFile, "r");
+	if (fp == NULL) {
+		printf("Unable to open %s\n", g_statusFile);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "Bytes Written", 13) == 0) {
+			bytes = strtoul(&line[13], NULL, 10);
+			break;
+		}
+	}
+
+	fclose(fp);
+	return bytes;
+}
+
+/****************************************************************************
+ * Name: smart_append_bench
+ *
+ * Description: Measures the rate of small appends to a log file, and the
+ *              number of flash bytes they program per byte of the file.
+ *              The records are written with open / write, so that each
+ *              of them reaches SMARTFS as one write.
+ *
+ ****************************************************************************/
+
+static int smart_append_bench(char *filename)
+{
+	int fd;
+	int x;
+	char *record;
+	struct timespec before;
+	struct timespec after;
+	unsigned long bytes;
+	long msec;
+
+	if (g_recordLen <= 0) {
+		printf("Invalid record parameters\n");
+		return -EINVAL;
+	}
+
+	record = malloc(g_recordLen);
+	if (record == NULL) {
+		printf("Unable to allocate memory for record storage\n");
+		return -ENOMEM;
+	}
+
+	for (x = 0; x < g_recordLen - 1; x++) {
+		record[x] = 'a' + x % 26;
+	}
+	record[x] = '\n';
+
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND);
+	if (fd == -1) {
+		printf("Unable to create file %s\n", filename);
+		free(record);
+		return -ENOENT;
+	}
+
+	bytes = smart_bytes_written();
+	(void)clock_gettime(CLOCK_REALTIME, &before);
+
+	for (x = 0; x < g_appendCount; x++) {
+		if (write(fd, record, g_recordLen) != g_recordLen) {
+			printf("Error writing record %d\n", x);
+			break;
+		}
+	}
+
+	/* The appends which are still held are committed by the close */
+
+	close(fd);
+	(void)clock_gettime(CLOCK_REALTIME, &after);
+	bytes = smart_bytes_written() - bytes;
+	free(record);
+
+	msec = (after.tv_sec - before.tv_sec) * 1000 + (after.tv_nsec - before.tv_nsec) / 1000000;
+	printf("\n%d appends of %d bytes in %ld msec", x, g_recordLen, msec);
+	if (msec > 0) {
+		printf(": %ld appends/sec", (long)x * 1000 / msec);
+	}
+	printf("\n");
+
+	if (g_statusFile != NULL && x > 0) {
+		bytes = bytes * 100 / ((unsigned long)x * g_recordLen);
+		printf("Flash bytes written per byte appended: %lu.%02lu\n", bytes / 100, bytes % 100);
+	}
+
+	return x == g_appendCount ? OK : -EIO;
+}
+
 /****************************************************************************
  * Name: smart_usage
  *
@@ -513,13 +627,19 @@ static int smart_circular_log_test(char *filename)
  ****************************************************************************/
 static void smart_usage(void)
 {
-	fprintf(stderr, "usage: smart_test [-c COUNT] [-s SEEKCOUNT] [-w WRITECOUNT] smart_mounted_filename\n\n");
+	fprintf(stderr, "usage: smart_test [-a APPENDCOUNT] [-c COUNT] [-s SEEKCOUNT] [-w WRITECOUNT] smart_mounted_filename\n\n");
 
 	fprintf(stderr, "DESCRIPTION\n");
 	fprintf(stderr, "    Conducts various stress tests to validate SMARTFS operation.\n");
-	fprintf(stderr, "    Please choose one or more of -c, -s, or -w to conduct tests.\n\n");
+	fprintf(stderr, "    Please choose one or more of -a, -c, -s, or -w to conduct tests.\n\n");
 
 	fprintf(stderr, "OPTIONS\n");
+	fprintf(stderr, "    -a APPENDCOUNT\n");
+	fprintf(stderr, "          Measures the rate of small appends to a log file.  Uses the -r\n");
+	fprintf(stderr, "          option to specify the length of each appended record, and the -p\n");
+	fprintf(stderr, "          option to also report the flash bytes written per byte appended.\n");
+	fprintf(stderr, "          The APPENDCOUNT parameter sets the number of appends to perform.\n\n");
+
 	fprintf(stderr, "    -c COUNT\n");
 	fprintf(stderr, "          Performs a circular log style test where a fixed number of fixed\n");
 	fprintf(stderr, "          length records are written and then overwritten with new data.\n");
@@ -543,8 +663,13 @@ static void smart_usage(void)
 	fprintf(stderr, "          Sets the number of lines of test data to write to the test file\n");
 	fprintf(stderr, "          during seek and seek/write tests.\n\n");
 
+	fprintf(stderr, "    -p STATUSFILE\n");
+	fprintf(stderr, "          Sets the SMARTFS procfs status file of the volume, for instance\n");
+	fprintf(stderr, "          /proc/fs/smartfs/smart0/status, to read the flash bytes written.\n\n");
+
 	fprintf(stderr, "    -r RECORDLEN\n");
-	fprintf(stderr, "          Sets the length of each log record during circular log tests.\n\n");
+	fprintf(stderr, "          Sets the length of each log record during circular log and append\n");
+	fprintf(stderr, "          tests.\n\n");
 
 	fprintf(stderr, "    -e ERASECOUNT\n");
 	fprintf(stderr, "          Sets the erase granularity for overwriting old circular log entries.\n");
@@ -572,8 +697,12 @@ int smart_test_main(int argc, char *argv[])
 	/* Argument given? */
 
 	optind = -1;
-	while ((opt = getopt(argc, argv, "c:e:l:r:s:t:w:")) != -1) {
+	while ((opt = getopt(argc, argv, "a:c:e:l:p:r:s:t:w:")) != -1) {
 		switch (opt) {
+		case 'a':
+			g_appendCount = atoi(optarg);
+			break;
+
 		case 'c':
 			g_circCount = atoi(optarg);
 			break;
@@ -586,6 +715,10 @@ int smart_test_main(int argc, char *argv[])
 			g_lineCount = atoi(optarg);
 			break;
 
+		case 'p':
+			g_statusFile = optarg;
+			break;
+
 		case 'r':
 			g_recordLen = atoi(optarg);
 			break;
@@ -608,7 +741,7 @@ int smart_test_main(int argc, char *argv[])
 		}
 	}
 
-	if (argc < 2 || (g_seekCount + g_writeCount + g_circCount == 0)) {
+	if (argc < 2 || (g_seekCount + g_writeCount + g_circCount + g_appendCount == 0)) {
 		smart_usage();
 		return -1;
 	}
@@ -662,11 +795,22 @@ int smart_test_main(int argc, char *argv[])
 		}
 	}
 
+	/* Measure the append rate? */
+
+	if (g_appendCount > 0) {
+		ret = smart_append_bench(argv[optind]);
+		if (ret < 0) {
+			goto err_out_with_mem;
+		}
+	}
+
 	/* Perform a "circular log" test */
 
-	ret = smart_circular_log_test(argv[optind]);
-	if (ret < 0) {
-		goto err_out_with_mem;
+	if (g_circCount > 0) {
+		ret = smart_circular_log_test(argv[optind]);
+		if (ret < 0) {
+			goto err_out_with_mem;
+		}
 	}
 
 err_out_with_mem:
@@ -251,6 +251,42 @@ static void tc_umm_heap_zalloc(void)
 	TC_SUCCESS_RESULT();
 }
 
+#ifdef CONFIG_MM_QUICKLIST
+/**
+* @fn                   :tc_umm_heap_quicklist
+* @brief                :Small chunks are reused from the quick lists.
+* @scenario             :Allocate and free a small chunk\n
+*                        Allocate the same size again and check mallinfo
+* @API's covered        :malloc, mallinfo, free
+* @passcase             :When the freed chunk is handed out again and counted as a quick list hit.
+* @failcase             :When another chunk is returned or the quick list counters are not updated.
+* @Preconditions        :NA
+*/
+static void tc_umm_heap_quicklist(void)
+{
+	int *mem_ptr = NULL;
+	int *reused_ptr;
+	struct mallinfo st_before;
+	struct mallinfo st_after;
+
+	mem_ptr = (int *)malloc(sizeof(int) * ALLOC_SIZE_VAL);
+	TC_ASSERT_NOT_NULL("malloc", mem_ptr);
+	free(mem_ptr);
+
+	st_before = mallinfo();
+	TC_ASSERT_GT("mallinfo", st_before.qlblks, 0);
+
+	reused_ptr = (int *)malloc(sizeof(int) * ALLOC_SIZE_VAL);
+	TC_ASSERT_EQ_CLEANUP("malloc", reused_ptr, mem_ptr, get_errno(), TC_FREE_MEMORY(reused_ptr));
+
+	st_after = mallinfo();
+	TC_ASSERT_EQ_CLEANUP("mallinfo", st_after.qlhits, st_before.qlhits + 1, get_errno(), TC_FREE_MEMORY(reused_ptr));
+	TC_ASSERT_EQ_CLEANUP("mallinfo", st_after.qlblks, st_before.qlblks - 1, get_errno(), TC_FREE_MEMORY(reused_ptr));
+	TC_FREE_MEMORY(reused_ptr);
+	TC_SUCCESS_RESULT();
+}
+#endif
+
 static int umm_task(int argc, char *argv[])
 {
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
@@ -263,6 +299,9 @@ static int umm_task(int argc, char *argv[])
 #endif
 	tc_umm_heap_mallinfo();
 	tc_umm_heap_zalloc();
+#ifdef CONFIG_MM_QUICKLIST
+	tc_umm_heap_quicklist();
+#endif
 
 	task_delete(0);
 	return 0;
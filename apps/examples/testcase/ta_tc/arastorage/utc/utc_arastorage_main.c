@@ -22,7 +22,10 @@
 
 #include <tinyara/config.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
 #include <arastorage/arastorage.h>
 #include <apps/shell/tash.h>
 #include <tinyara/fs/fs_utils.h>
@@ -39,6 +42,29 @@
 #define QUERY_LENGTH 128
 
 #define DATA_SET_NUM 10
+
+#define RANGE_RELATION_NAME "range"
+#define BULK_RELATION_NAME "bulk"
+#define BULK_TUPLE_NUM 200
+#define PREPARED_RELATION_NAME "prepared"
+#define WIDE_RELATION_NAME "widekey"
+#define WIDE_TUPLE_NUM 50
+#define WIDE_KEY_BASE 1600000000L
+#define WIDE_KEY_STEP 70000L
+#define GROUP_RELATION_NAME "grouped"
+#define GROUP_NUM 4
+#define GROUP_TUPLE_NUM 40
+
+#ifdef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_UTC_PERF
+#define PERF_RELATION_NAME "perf"
+#define PERF_STEP_NUM 5
+#define CONTENTION_RELATION_NAME "contend"
+#define CONTENTION_TUPLE_NUM 200
+#define CONTENTION_WRITE_NUM 100
+#define CONTENTION_READERS 3
+#define CONTENTION_QUERIES 20
+#define CONTENTION_RANGE 20
+#endif
 /****************************************************************************
  *  Global Variables
  ****************************************************************************/
@@ -1419,6 +1445,811 @@ void utc_arastorage_cursor_get_string_value_tc_n(void)
 	printf("PASS\n");
 }
 
+static db_result_t range_query_count(char *query, int expected)
+{
+	db_cursor_t *cursor;
+	int count;
+
+	cursor = db_query(query);
+	if (cursor == NULL) {
+		printf("db_query Failed : %s\n", query);
+		return DB_CURSOR_ERROR;
+	}
+	count = cursor_get_count(cursor);
+	db_cursor_free(cursor);
+	if (count != expected) {
+		printf("%s returned %d rows, expected %d\n", query, count, expected);
+		return DB_INDEX_ERROR;
+	}
+	return DB_OK;
+}
+
+void utc_arastorage_db_get_plan_stats_tc_p(void)
+{
+	db_result_t res;
+	db_plan_stats_t stats;
+	char query[QUERY_LENGTH];
+	int i;
+
+	printf("%d. db_get_plan_stats Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", RANGE_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create relation) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], RANGE_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Int\n", g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE INDEX %s.%s TYPE %s;", RANGE_RELATION_NAME, g_attribute_set[0], RELATION_INDEX);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Index) Type : %s Attribute = %s\n", RELATION_INDEX, g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	for (i = 0; i < DATA_SET_NUM; i++) {
+		snprintf(query, QUERY_LENGTH, "INSERT (%d) INTO %s;", g_arastorage_data_set[i].int_value, RANGE_RELATION_NAME);
+		res = db_exec(query);
+		if (DB_ERROR(res)) {
+			printf("db_exec Failed(Insert Data) Tuple Row : %d\n", i);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+
+	db_reset_plan_stats();
+
+	/* Compound and mirrored predicates on the indexed attribute use a range scan */
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s > 3 AND %s < 8;", g_attribute_set[0], RANGE_RELATION_NAME, g_attribute_set[0], g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, 4))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE 3 >= %s;", g_attribute_set[0], RANGE_RELATION_NAME, g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, 3))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* A disjunction with an unindexed condition cannot be bounded by the index */
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s < 3 OR %s <> 5;", g_attribute_set[0], RANGE_RELATION_NAME, g_attribute_set[0], g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, DATA_SET_NUM - 1))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	res = db_get_plan_stats(&stats);
+	if (DB_ERROR(res) || stats.index_scans != 2 || stats.full_scans != 1 || stats.index_rows != 7) {
+		printf("db_get_plan_stats Failed : index %u full %u index rows %u\n", stats.index_scans, stats.full_scans, stats.index_rows);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	printf("PASS\n");
+
+done:
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", RANGE_RELATION_NAME);
+	db_exec(query);
+}
+
+void utc_arastorage_db_get_plan_stats_tc_n(void)
+{
+	printf("%d. db_get_plan_stats Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+	if (db_get_plan_stats(NULL) != DB_ARGUMENT_ERROR) {
+		printf("db_get_plan_stats Failed with NULL\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS\n");
+}
+
+void utc_arastorage_db_bulk_insert_tc_p(void)
+{
+	db_result_t res;
+	db_value_t *values;
+	char query[QUERY_LENGTH];
+	int i;
+
+	printf("%d. db_bulk_insert Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	values = (db_value_t *)malloc(sizeof(db_value_t) * BULK_TUPLE_NUM);
+	if (values == NULL) {
+		printf("Failed to allocate tuples\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	/* Keys are given in descending order, the index must sort them */
+	for (i = 0; i < BULK_TUPLE_NUM; i++) {
+		values[i].domain = DOMAIN_INT;
+		values[i].u.int_value = BULK_TUPLE_NUM - 1 - i;
+	}
+
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", BULK_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create relation) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		free(values);
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], BULK_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Int\n", g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE INDEX %s.%s TYPE %s;", BULK_RELATION_NAME, g_attribute_set[0], RELATION_INDEX);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Index) Type : %s Attribute = %s\n", RELATION_INDEX, g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	res = db_bulk_insert(BULK_RELATION_NAME, values, BULK_TUPLE_NUM);
+	if (DB_ERROR(res)) {
+		printf("db_bulk_insert Failed res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s;", g_attribute_set[0], BULK_RELATION_NAME);
+	if (DB_ERROR(range_query_count(query, BULK_TUPLE_NUM))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s >= 50 AND %s < 150;", g_attribute_set[0], BULK_RELATION_NAME, g_attribute_set[0], g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, 100))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* Tuples inserted afterwards go through the bulk-built tree */
+	snprintf(query, QUERY_LENGTH, "INSERT (%d) INTO %s;", 75, BULK_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Insert Data) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s = 75;", g_attribute_set[0], BULK_RELATION_NAME, g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, 2))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	printf("PASS\n");
+
+done:
+	free(values);
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", BULK_RELATION_NAME);
+	db_exec(query);
+}
+
+void utc_arastorage_db_bulk_insert_tc_n(void)
+{
+	db_value_t value;
+
+	printf("%d. db_bulk_insert Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	value.domain = DOMAIN_INT;
+	value.u.int_value = 0;
+	if (db_bulk_insert(NULL, &value, 1) != DB_ARGUMENT_ERROR) {
+		printf("db_bulk_insert Failed with NULL relation\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	if (db_bulk_insert(BULK_RELATION_NAME, NULL, 1) != DB_ARGUMENT_ERROR) {
+		printf("db_bulk_insert Failed with NULL values\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	if (!DB_ERROR(db_bulk_insert(BULK_RELATION_NAME, &value, 1))) {
+		printf("db_bulk_insert Failed with a missing relation\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS\n");
+}
+
+void utc_arastorage_db_index_wide_key_tc_p(void)
+{
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	int i;
+
+	printf("%d. B+-tree wide key Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", WIDE_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create relation) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN long IN %s;", g_attribute_set[1], WIDE_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Long\n", g_attribute_set[1]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE INDEX %s.%s TYPE %s;", WIDE_RELATION_NAME, g_attribute_set[1], RELATION_INDEX);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Index) Type : %s Attribute = %s\n", RELATION_INDEX, g_attribute_set[1]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* Timestamp-like keys, far apart enough that 16-bit keys would collide */
+	for (i = 0; i < WIDE_TUPLE_NUM; i++) {
+		snprintf(query, QUERY_LENGTH, "INSERT (%ld) INTO %s;", WIDE_KEY_BASE + i * WIDE_KEY_STEP, WIDE_RELATION_NAME);
+		res = db_exec(query);
+		if (DB_ERROR(res)) {
+			printf("db_exec Failed(Insert Data) res : %d\n", res);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s = %ld;", g_attribute_set[1], WIDE_RELATION_NAME, g_attribute_set[1], WIDE_KEY_BASE + 5 * WIDE_KEY_STEP);
+	if (DB_ERROR(range_query_count(query, 1))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s >= %ld AND %s < %ld;", g_attribute_set[1], WIDE_RELATION_NAME, g_attribute_set[1], WIDE_KEY_BASE + 10 * WIDE_KEY_STEP, g_attribute_set[1], WIDE_KEY_BASE + 30 * WIDE_KEY_STEP);
+	if (DB_ERROR(range_query_count(query, 20))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	printf("PASS\n");
+
+done:
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", WIDE_RELATION_NAME);
+	db_exec(query);
+}
+
+void utc_arastorage_db_query_group_by_tc_p(void)
+{
+	db_result_t res;
+	db_cursor_t *cursor;
+	char query[QUERY_LENGTH];
+	int seen;
+	int key;
+	int i;
+
+	printf("%d. GROUP BY Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", GROUP_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create relation) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], GROUP_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Int\n", g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN long IN %s;", g_attribute_set[1], GROUP_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Long\n", g_attribute_set[1]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* Group k holds the values k, k + GROUP_NUM, ... */
+	for (i = 0; i < GROUP_TUPLE_NUM; i++) {
+		snprintf(query, QUERY_LENGTH, "INSERT (%d, %d) INTO %s;", i % GROUP_NUM, i, GROUP_RELATION_NAME);
+		res = db_exec(query);
+		if (DB_ERROR(res)) {
+			printf("db_exec Failed(Insert Data) res : %d\n", res);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+
+	snprintf(query, QUERY_LENGTH, "SELECT %s, COUNT(%s), MIN(%s), MAX(%s), MEAN(%s) FROM %s GROUP BY %s;", g_attribute_set[0], g_attribute_set[1], g_attribute_set[1], g_attribute_set[1], g_attribute_set[1], GROUP_RELATION_NAME, g_attribute_set[0]);
+	cursor = db_query(query);
+	if (cursor == NULL) {
+		printf("db_query Failed : %s\n", query);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	if (cursor_get_count(cursor) != GROUP_NUM) {
+		printf("GROUP BY returned %d groups, expected %d\n", cursor_get_count(cursor), GROUP_NUM);
+		db_cursor_free(cursor);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	seen = 0;
+	for (i = 0; i < GROUP_NUM; i++) {
+		if (DB_ERROR(cursor_move_to(cursor, i))) {
+			printf("cursor_move_to Failed row : %d\n", i);
+			break;
+		}
+		key = cursor_get_int_value(cursor, 0);
+		if (key < 0 || key >= GROUP_NUM || (seen & (1 << key))) {
+			printf("GROUP BY returned an unexpected group %d\n", key);
+			break;
+		}
+		seen |= 1 << key;
+#ifdef CONFIG_ARCH_FLOAT_H
+		if (cursor_get_double_value(cursor, 1) != GROUP_TUPLE_NUM / GROUP_NUM || cursor_get_double_value(cursor, 2) != key || cursor_get_double_value(cursor, 3) != key + GROUP_TUPLE_NUM - GROUP_NUM || cursor_get_double_value(cursor, 4) != key + (GROUP_TUPLE_NUM - GROUP_NUM) / 2) {
+			printf("GROUP BY returned wrong aggregates for group %d\n", key);
+			break;
+		}
+#endif
+	}
+	db_cursor_free(cursor);
+	if (i != GROUP_NUM) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* The predicate is applied before the tuples are grouped */
+	snprintf(query, QUERY_LENGTH, "SELECT %s, COUNT(%s) FROM %s WHERE %s < 2 GROUP BY %s;", g_attribute_set[0], g_attribute_set[1], GROUP_RELATION_NAME, g_attribute_set[1], g_attribute_set[0]);
+	if (DB_ERROR(range_query_count(query, 2))) {
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	printf("PASS\n");
+
+done:
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", GROUP_RELATION_NAME);
+	db_exec(query);
+}
+
+void utc_arastorage_db_query_group_by_tc_n(void)
+{
+	char query[QUERY_LENGTH];
+
+	printf("%d. GROUP BY Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	/* The grouping attribute must be projected */
+	snprintf(query, QUERY_LENGTH, "SELECT COUNT(%s) FROM %s GROUP BY %s;", g_attribute_set[1], GROUP_RELATION_NAME, g_attribute_set[0]);
+	if (db_query(query) != NULL) {
+		printf("db_query Failed with a grouping attribute out of the projection\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "SELECT %s, COUNT(%s) FROM %s GROUP %s;", g_attribute_set[0], g_attribute_set[1], GROUP_RELATION_NAME, g_attribute_set[0]);
+	if (db_query(query) != NULL) {
+		printf("db_query Failed without BY\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	printf("PASS\n");
+}
+
+void utc_arastorage_db_prepare_tc_p(void)
+{
+	db_result_t res;
+	db_stmt_t *insert_stmt;
+	db_stmt_t *select_stmt;
+	db_cursor_t *cursor;
+	db_value_t value;
+	char query[QUERY_LENGTH];
+	int count;
+	int i;
+
+	printf("%d. db_prepare Positive Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	insert_stmt = NULL;
+	select_stmt = NULL;
+
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", PREPARED_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create relation) res : %d\n", res);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], PREPARED_RELATION_NAME);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Int\n", g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE INDEX %s.%s TYPE %s;", PREPARED_RELATION_NAME, g_attribute_set[0], RELATION_INDEX);
+	res = db_exec(query);
+	if (DB_ERROR(res)) {
+		printf("db_exec Failed(Create Index) Type : %s Attribute = %s\n", RELATION_INDEX, g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	snprintf(query, QUERY_LENGTH, "INSERT (?) INTO %s;", PREPARED_RELATION_NAME);
+	insert_stmt = db_prepare(query);
+	if (insert_stmt == NULL) {
+		printf("db_prepare Failed : %s\n", query);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	value.domain = DOMAIN_INT;
+	for (i = 0; i < DATA_SET_NUM; i++) {
+		value.u.int_value = i;
+		if (DB_ERROR(db_bind(insert_stmt, 0, &value)) || DB_ERROR(db_exec_prepared(insert_stmt))) {
+			printf("db_exec_prepared Failed Tuple Row : %d\n", i);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s >= ? AND %s < ?;", g_attribute_set[0], PREPARED_RELATION_NAME, g_attribute_set[0], g_attribute_set[0]);
+	select_stmt = db_prepare(query);
+	if (select_stmt == NULL) {
+		printf("db_prepare Failed : %s\n", query);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	/* The same statement is run with a different window each time */
+	for (i = 0; i < DATA_SET_NUM - 3; i++) {
+		value.u.int_value = i;
+		db_bind(select_stmt, 0, &value);
+		value.u.int_value = i + 3;
+		db_bind(select_stmt, 1, &value);
+		cursor = db_query_prepared(select_stmt);
+		if (cursor == NULL) {
+			printf("db_query_prepared Failed : [%d, %d)\n", i, i + 3);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+		count = cursor_get_count(cursor);
+		db_cursor_free(cursor);
+		if (count != 3) {
+			printf("db_query_prepared returned %d rows for [%d, %d), expected 3\n", count, i, i + 3);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+	printf("PASS\n");
+
+done:
+	if (insert_stmt != NULL) {
+		db_finalize(insert_stmt);
+	}
+	if (select_stmt != NULL) {
+		db_finalize(select_stmt);
+	}
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", PREPARED_RELATION_NAME);
+	db_exec(query);
+}
+
+void utc_arastorage_db_prepare_tc_n(void)
+{
+	db_stmt_t *stmt;
+	db_value_t value;
+	char query[QUERY_LENGTH];
+
+	printf("%d. db_prepare Negative Unit Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	stmt = NULL;
+
+	if (db_prepare(NULL) != NULL) {
+		printf("db_prepare Failed with NULL\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	if (db_finalize(NULL) != DB_ARGUMENT_ERROR) {
+		printf("db_finalize Failed with NULL\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	/* Only SELECT and INSERT can be prepared */
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", PREPARED_RELATION_NAME);
+	stmt = db_prepare(query);
+	if (stmt != NULL) {
+		printf("db_prepare Failed with %s\n", query);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	if (DB_ERROR(db_exec(query))) {
+		printf("db_exec Failed(Create relation)\n");
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], PREPARED_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		printf("db_exec Failed(Create Attribute) Name : %s Type : Int\n", g_attribute_set[0]);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	/* Parameters cannot be used without a prepared statement */
+	snprintf(query, QUERY_LENGTH, "SELECT %s FROM %s WHERE %s > ?;", g_attribute_set[0], PREPARED_RELATION_NAME, g_attribute_set[0]);
+	if (db_query(query) != NULL) {
+		printf("db_query Failed with an unbound parameter\n");
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+
+	stmt = db_prepare(query);
+	if (stmt == NULL) {
+		printf("db_prepare Failed : %s\n", query);
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	if (db_query_prepared(stmt) != NULL) {
+		printf("db_query_prepared Failed with an unbound parameter\n");
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	value.domain = DOMAIN_INT;
+	value.u.int_value = 0;
+	if (db_bind(stmt, 1, &value) != DB_ARGUMENT_ERROR || db_bind(stmt, 0, NULL) != DB_ARGUMENT_ERROR) {
+		printf("db_bind Failed with an invalid parameter\n");
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	value.domain = DOMAIN_STRING;
+	value.u.string_value = (unsigned char *)"text";
+	if (db_bind(stmt, 0, &value) != DB_TYPE_ERROR) {
+		printf("db_bind Failed with a string in a condition\n");
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	if (db_exec_prepared(stmt) != DB_ARGUMENT_ERROR) {
+		printf("db_exec_prepared Failed with a SELECT statement\n");
+		g_arastorage_tc_fail_count++;
+		goto done;
+	}
+	printf("PASS\n");
+
+done:
+	if (stmt != NULL) {
+		db_finalize(stmt);
+	}
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", PREPARED_RELATION_NAME);
+	db_exec(query);
+}
+
+#ifdef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_UTC_PERF
+static const int g_perf_rows[PERF_STEP_NUM] = {100, 250, 500, 1000, 2000};
+
+static unsigned long perf_elapsed_usec(struct timeval *start)
+{
+	struct timeval end;
+
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) * 1000000 + (end.tv_usec - start->tv_usec);
+}
+
+static db_result_t perf_create_relation(void)
+{
+	char query[QUERY_LENGTH];
+
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", PERF_RELATION_NAME);
+	db_exec(query);
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", PERF_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		return DB_RELATIONAL_ERROR;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], PERF_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		return DB_RELATIONAL_ERROR;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN long IN %s;", g_attribute_set[1], PERF_RELATION_NAME);
+	return db_exec(query);
+}
+
+/* Iterate whole results from 100 rows up to the tuple limit and measure time per row */
+void utc_arastorage_cursor_iteration_perf_p(void)
+{
+	db_result_t res;
+	db_cursor_t *cursor;
+	char query[QUERY_LENGTH];
+	struct timeval start;
+	unsigned long usec;
+	int inserted;
+	int step;
+	int i;
+
+	printf("%d. cursor iteration Performance Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	if (DB_ERROR(perf_create_relation())) {
+		printf("Failed to create relation %s\n", PERF_RELATION_NAME);
+		g_arastorage_tc_fail_count++;
+		return;
+	}
+
+	inserted = 0;
+	for (step = 0; step < PERF_STEP_NUM; step++) {
+		for (; inserted < g_perf_rows[step]; inserted++) {
+			snprintf(query, QUERY_LENGTH, "INSERT (%d, %ld) INTO %s;", inserted, 20160101L + inserted, PERF_RELATION_NAME);
+			res = db_exec(query);
+			if (res == DB_LIMIT_ERROR) {
+				printf("Tuple limit reached at %d rows\n", inserted);
+				goto done;
+			} else if (DB_ERROR(res)) {
+				printf("db_exec Failed(Insert Data) Tuple Row : %d res : %d\n", inserted, res);
+				g_arastorage_tc_fail_count++;
+				goto done;
+			}
+		}
+
+		snprintf(query, QUERY_LENGTH, "SELECT %s, %s FROM %s;", g_attribute_set[0], g_attribute_set[1], PERF_RELATION_NAME);
+		cursor = db_query(query);
+		if (cursor == NULL) {
+			printf("db_query Failed\n");
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+
+		gettimeofday(&start, NULL);
+		for (i = 0, res = cursor_move_first(cursor); DB_SUCCESS(res); res = cursor_move_next(cursor)) {
+			i++;
+		}
+		usec = perf_elapsed_usec(&start);
+		printf("rows %d : forward %lu us", i, usec);
+
+		gettimeofday(&start, NULL);
+		for (res = cursor_move_last(cursor); DB_SUCCESS(res) && !cursor_is_first_row(cursor); res = cursor_move_prev(cursor)) {
+		}
+		printf(", backward %lu us\n", perf_elapsed_usec(&start));
+
+		db_cursor_free(cursor);
+		if (i != inserted) {
+			printf("cursor iteration Failed : %d != %d\n", i, inserted);
+			g_arastorage_tc_fail_count++;
+			goto done;
+		}
+	}
+	printf("PASS\n");
+
+done:
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", PERF_RELATION_NAME);
+	db_exec(query);
+}
+
+struct contention_reader_s {
+	int id;
+	int failed;
+	unsigned long total_usec;
+	unsigned long max_usec;
+};
+
+static void *contention_reader(void *arg)
+{
+	struct contention_reader_s *reader = (struct contention_reader_s *)arg;
+	db_cursor_t *cursor;
+	db_result_t res;
+	char query[QUERY_LENGTH];
+	struct timeval start;
+	unsigned long usec;
+	int low;
+	int i;
+
+	for (i = 0; i < CONTENTION_QUERIES; i++) {
+		low = ((reader->id * CONTENTION_QUERIES + i) * CONTENTION_RANGE) % CONTENTION_TUPLE_NUM;
+		snprintf(query, QUERY_LENGTH, "SELECT %s, %s FROM %s WHERE %s >= %d AND %s < %d;", g_attribute_set[0], g_attribute_set[1], CONTENTION_RELATION_NAME, g_attribute_set[0], low, g_attribute_set[0], low + CONTENTION_RANGE);
+
+		gettimeofday(&start, NULL);
+		cursor = db_query(query);
+		if (cursor == NULL) {
+			reader->failed++;
+			continue;
+		}
+		for (res = cursor_move_first(cursor); DB_SUCCESS(res); res = cursor_move_next(cursor)) {
+		}
+		usec = perf_elapsed_usec(&start);
+		db_cursor_free(cursor);
+
+		reader->total_usec += usec;
+		if (usec > reader->max_usec) {
+			reader->max_usec = usec;
+		}
+	}
+
+	return NULL;
+}
+
+static void *contention_writer(void *arg)
+{
+	int *failed = (int *)arg;
+	char query[QUERY_LENGTH];
+	int i;
+
+	for (i = CONTENTION_TUPLE_NUM; i < CONTENTION_TUPLE_NUM + CONTENTION_WRITE_NUM; i++) {
+		snprintf(query, QUERY_LENGTH, "INSERT (%d, %ld) INTO %s;", i, 20160101L + i, CONTENTION_RELATION_NAME);
+		if (DB_ERROR(db_exec(query))) {
+			(*failed)++;
+		}
+	}
+
+	return NULL;
+}
+
+/* Run indexed range queries from several readers while a writer inserts and report the query latency */
+void utc_arastorage_rw_contention_perf_p(void)
+{
+	struct contention_reader_s readers[CONTENTION_READERS];
+	pthread_t reader_tid[CONTENTION_READERS];
+	pthread_t writer_tid;
+	char query[QUERY_LENGTH];
+	int write_failed = 0;
+	int started;
+	int i;
+
+	printf("%d. rw lock contention Performance Test started. Please wait...\n", g_arastorage_tc_count++);
+
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", CONTENTION_RELATION_NAME);
+	db_exec(query);
+	snprintf(query, QUERY_LENGTH, "CREATE RELATION %s;", CONTENTION_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		goto errout;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN int IN %s;", g_attribute_set[0], CONTENTION_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		goto errout;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE ATTRIBUTE %s DOMAIN long IN %s;", g_attribute_set[1], CONTENTION_RELATION_NAME);
+	if (DB_ERROR(db_exec(query))) {
+		goto errout;
+	}
+	snprintf(query, QUERY_LENGTH, "CREATE INDEX %s.%s TYPE %s;", CONTENTION_RELATION_NAME, g_attribute_set[0], RELATION_INDEX);
+	if (DB_ERROR(db_exec(query))) {
+		goto errout;
+	}
+	for (i = 0; i < CONTENTION_TUPLE_NUM; i++) {
+		snprintf(query, QUERY_LENGTH, "INSERT (%d, %ld) INTO %s;", i, 20160101L + i, CONTENTION_RELATION_NAME);
+		if (DB_ERROR(db_exec(query))) {
+			goto errout;
+		}
+	}
+
+	memset(readers, 0, sizeof(readers));
+	for (started = 0; started < CONTENTION_READERS; started++) {
+		readers[started].id = started;
+		if (pthread_create(&reader_tid[started], NULL, contention_reader, &readers[started]) != 0) {
+			break;
+		}
+	}
+	if (pthread_create(&writer_tid, NULL, contention_writer, &write_failed) != 0) {
+		write_failed = CONTENTION_WRITE_NUM;
+	} else {
+		pthread_join(writer_tid, NULL);
+	}
+	for (i = 0; i < started; i++) {
+		pthread_join(reader_tid[i], NULL);
+	}
+
+	if (started != CONTENTION_READERS || write_failed > 0) {
+		printf("rw lock contention Failed : readers %d, failed inserts %d\n", started, write_failed);
+		goto errout;
+	}
+	for (i = 0; i < CONTENTION_READERS; i++) {
+		if (readers[i].failed > 0) {
+			printf("rw lock contention Failed : reader %d, failed queries %d\n", i, readers[i].failed);
+			goto errout;
+		}
+		printf("reader %d : avg %lu us, max %lu us\n", i, readers[i].total_usec / CONTENTION_QUERIES, readers[i].max_usec);
+	}
+	printf("PASS\n");
+	goto done;
+
+errout:
+	g_arastorage_tc_fail_count++;
+done:
+	snprintf(query, QUERY_LENGTH, "REMOVE RELATION %s;", CONTENTION_RELATION_NAME);
+	db_exec(query);
+}
+#endif
+
 int arastorage_sample_launcher(int argc, FAR char *argv[])
 {
 
@@ -1451,6 +2282,15 @@ int arastorage_sample_launcher(int argc, FAR char *argv[])
 #endif
 	utc_arastorage_cursor_get_string_value_tc_p();
 	utc_arastorage_db_cursor_free_tc_p();
+	utc_arastorage_db_get_plan_stats_tc_p();
+	utc_arastorage_db_bulk_insert_tc_p();
+	utc_arastorage_db_index_wide_key_tc_p();
+	utc_arastorage_db_query_group_by_tc_p();
+	utc_arastorage_db_prepare_tc_p();
+#ifdef CONFIG_EXAMPLES_TESTCASE_ARASTORAGE_UTC_PERF
+	utc_arastorage_cursor_iteration_perf_p();
+	utc_arastorage_rw_contention_perf_p();
+#endif
 	utc_arastorage_db_deinit_tc_p();
 
 	printf("#########################################\n");
@@ -1489,6 +2329,10 @@ int arastorage_sample_launcher(int argc, FAR char *argv[])
 #endif
 	utc_arastorage_cursor_get_string_value_tc_n();
 	utc_arastorage_db_cursor_free_tc_n();
+	utc_arastorage_db_get_plan_stats_tc_n();
+	utc_arastorage_db_bulk_insert_tc_n();
+	utc_arastorage_db_query_group_by_tc_n();
+	utc_arastorage_db_prepare_tc_n();
 	db_deinit();
 
 
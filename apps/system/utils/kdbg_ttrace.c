@@ -85,6 +85,204 @@ static int print_packet(struct trace_packet *packet)
 	}
 }
 
+#ifdef CONFIG_TTRACE_BINARY
+/* Option which prints the trace as Chrome trace events (JSON), which
+ * chrome://tracing and Perfetto load.  The running task and the interrupts
+ * are shown on two tracks of a "CPU" process, and the spans and semaphore
+ * waits of each task on its own track of a "tasks" process.
+ */
+
+#define TTRACE_JSON       'j'
+
+#define JSON_PID_CPU      0
+#define JSON_PID_TASKS    1
+#define JSON_TID_SCHED    0
+#define JSON_TID_IRQ      1
+
+/* The names of the tasks, as seen when they were switched in */
+
+#define TTRACE_NCOMMS 32
+
+static struct {
+	pid_t pid;
+	char comm[TTRACE_EVENT_COMM_BYTES + 1];
+} g_comms[TTRACE_NCOMMS];
+
+static bool g_json;
+static int g_json_count;
+static bool g_json_running;
+
+static const char *comm_of(pid_t pid)
+{
+	int i = pid % TTRACE_NCOMMS;
+
+	return g_comms[i].pid == pid ? g_comms[i].comm : "?";
+}
+
+/* Remember the name of a task, returning true if it was not known */
+
+static bool set_comm(pid_t pid, const char *comm)
+{
+	int i = pid % TTRACE_NCOMMS;
+
+	if (g_comms[i].pid == pid && strncmp(g_comms[i].comm, comm, TTRACE_EVENT_COMM_BYTES) == 0) {
+		return false;
+	}
+
+	g_comms[i].pid = pid;
+	memcpy(g_comms[i].comm, comm, TTRACE_EVENT_COMM_BYTES);
+	return true;
+}
+
+static void json_usec(uint64_t usec)
+{
+	if (usec >= USEC_PER_SEC) {
+		printf("%u%06u", (unsigned int)(usec / USEC_PER_SEC), (unsigned int)(usec % USEC_PER_SEC));
+	} else {
+		printf("%u", (unsigned int)usec);
+	}
+}
+
+static void json_string(const char *str)
+{
+	putchar('"');
+	for (; *str != '\0'; str++) {
+		if (*str == '"' || *str == '\\') {
+			putchar('\\');
+			putchar(*str);
+		} else if ((unsigned char)*str >= ' ') {
+			putchar(*str);
+		}
+	}
+	putchar('"');
+}
+
+/* Print the beginning ('B') or the end ('E') of a span */
+
+static void json_event(char phase, uint64_t usec, int pid, int tid, const char *name)
+{
+	printf("%s{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":", g_json_count++ > 0 ? ",\r\n" : "", phase, pid, tid);
+	json_usec(usec);
+	if (name != NULL) {
+		printf(",\"name\":");
+		json_string(name);
+	}
+	putchar('}');
+}
+
+/* Print the name of a process or of a track */
+
+static void json_name(const char *what, int pid, int tid, const char *name)
+{
+	printf("%s{\"ph\":\"M\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":", g_json_count++ > 0 ? ",\r\n" : "", what, pid, tid);
+	json_string(name);
+	printf("}}");
+}
+
+static void print_event(struct ttrace_header_s *header, struct ttrace_event_s *event)
+{
+	uint64_t usec = ttrace_event_usec(header, event);
+	uint32_t prev = event->args[0];
+	uint32_t next = event->args[1];
+	char message[128];
+	bool known;
+
+	switch (event->event_type) {
+	case TTRACE_EVENT_TYPE_SCHED:
+		known = !set_comm(next & 0xffff, (const char *)&event->args[2]);
+		if (g_json) {
+			if (!known) {
+				json_name("thread_name", JSON_PID_TASKS, next & 0xffff, comm_of(next & 0xffff));
+			}
+			if (g_json_running) {
+				json_event('E', usec, JSON_PID_CPU, JSON_TID_SCHED, NULL);
+			}
+			json_event('B', usec, JSON_PID_CPU, JSON_TID_SCHED, comm_of(next & 0xffff));
+			g_json_running = true;
+			return;
+		}
+		snprintf(message, sizeof(message), "prev_comm=%s prev_pid=%u prev_prio=%u prev_state=%u ==> next_comm=%s next_pid=%u next_prio=%u", comm_of(prev & 0xffff), prev & 0xffff, (prev >> 16) & 0xff, prev >> 24, comm_of(next & 0xffff), next & 0xffff, (next >> 16) & 0xff);
+		break;
+
+	case TTRACE_EVENT_TYPE_IRQ:
+	case TTRACE_EVENT_TYPE_IRQ_END:
+		if (g_json) {
+			snprintf(message, sizeof(message), "irq %u", event->args[0]);
+			json_event(event->event_type == TTRACE_EVENT_TYPE_IRQ ? 'B' : 'E', usec, JSON_PID_CPU, JSON_TID_IRQ, message);
+			return;
+		}
+		snprintf(message, sizeof(message), "irq=%u", event->args[0]);
+		break;
+
+	case TTRACE_EVENT_TYPE_SEM:
+	case TTRACE_EVENT_TYPE_SEM_END:
+		if (g_json) {
+			json_event(event->event_type == TTRACE_EVENT_TYPE_SEM ? 'B' : 'E', usec, JSON_PID_TASKS, event->pid, "sem_wait");
+			return;
+		}
+		snprintf(message, sizeof(message), "sem=0x%08x", event->args[0]);
+		break;
+
+	default:
+		if (event->code & TTRACE_CODE_UNIQUE) {
+			snprintf(message, sizeof(message), "%u", (uint8_t)(event->code & ~TTRACE_CODE_UNIQUE));
+		} else {
+			snprintf(message, sizeof(message), event->fmt, event->args[0], event->args[1], event->args[2], event->args[3]);
+		}
+
+		if (g_json) {
+			json_event(event->event_type == TTRACE_EVENT_TYPE_BEGIN ? 'B' : 'E', usec, JSON_PID_TASKS, event->pid, event->event_type == TTRACE_EVENT_TYPE_BEGIN ? message : NULL);
+			return;
+		}
+		break;
+	}
+
+	printf("[%06u:%06u] %03d: %c|%s\r\n", (unsigned int)(usec / USEC_PER_SEC), (unsigned int)(usec % USEC_PER_SEC), event->pid, event->event_type, message);
+}
+
+static void print_events(char *buffer, int len)
+{
+	struct ttrace_header_s *header = (struct ttrace_header_s *)buffer;
+	struct ttrace_event_s *event = (struct ttrace_event_s *)(header + 1);
+	uint64_t usec = 0;
+	uint32_t i;
+
+	if (len < sizeof(struct ttrace_header_s) || header->magic != TTRACE_HEADER_MAGIC) {
+		printf("No trace events\r\n");
+		return;
+	}
+
+	memset(g_comms, 0, sizeof(g_comms));
+	if (g_json) {
+		g_json_count = 0;
+		g_json_running = false;
+		printf("{\"traceEvents\":[\r\n");
+		json_name("process_name", JSON_PID_CPU, 0, "CPU");
+		json_name("thread_name", JSON_PID_CPU, JSON_TID_SCHED, "running");
+		json_name("thread_name", JSON_PID_CPU, JSON_TID_IRQ, "interrupts");
+		json_name("process_name", JSON_PID_TASKS, 0, "tasks");
+	}
+
+	for (i = 0; i < header->nevents; i++, event++) {
+		/* Skip the events which were still being written */
+
+		if (event->event_type != 0) {
+			usec = ttrace_event_usec(header, event);
+			print_event(header, event);
+		}
+	}
+
+	if (g_json) {
+		if (g_json_running) {
+			json_event('E', usec, JSON_PID_CPU, JSON_TID_SCHED, NULL);
+		}
+		printf("\r\n],\"otherData\":{\"lost\":%u}}\r\n", header->lost);
+	} else if (header->lost > 0) {
+		printf("%u older events were overwritten\r\n", header->lost);
+	}
+}
+#endif
+
 static void show_help()
 {
 	printf("usage: ttrace [opions] [tags...]\r\n");
@@ -94,6 +292,9 @@ static void show_help()
 	printf("    -i     Show information(state, available/selected/TP used tags, bufsize)\r\n");
 	printf("    -d     Dump trace buffer, It should be run after finish\r\n");
 	printf("    -p     Print trace buffer, It should be run after finish)\r\n");
+#ifdef CONFIG_TTRACE_BINARY
+	printf("    -j     Print trace buffer as Chrome trace events (JSON), It should be run after finish\r\n");
+#endif
 }
 
 static int assign_tag(char *name)
@@ -123,10 +324,15 @@ static int parse_args(int argc, char **args)
 	 * -g : TTRACE_FUNC_TAG, TP's tag(hidden to user)
 	 * -d : TTRACE_DUMP, dump mode(hang), It should be run after finish.
 	 * -p : TTRACE_PRINT, print traces, It should be run after finish.
+	 * -j : TTRACE_JSON, print traces as JSON, It should be run after finish.
 	 */
 	while (1) {
 		optarg = NULL;
+#ifdef CONFIG_TTRACE_BINARY
+		ret = getopt(argc, args, "sfidpjb:");
+#else
 		ret = getopt(argc, args, "sfidpb:");
+#endif
 		if (ret == '?') {
 			show_help();
 			return TTRACE_INVALID;
@@ -222,9 +428,13 @@ static int read_tracebuffer(FILE *file, int bufsize)
 		return TTRACE_INVALID;
 	}
 
+#ifdef CONFIG_TTRACE_BINARY
+	print_events(buffer, read_len);
+#else
 	while (offset < read_len) {
 		offset += print_packet((struct trace_packet *)(buffer + offset));
 	}
+#endif
 
 	free_tracebuffer(buffer);
 	return TTRACE_VALID;
@@ -256,6 +466,15 @@ static int send_cmds(FILE *file, int cmd)
 		ret = read_tracebuffer(file, bufsize);
 		return ret;
 	}
+#ifdef CONFIG_TTRACE_BINARY
+	else if (cmd == TTRACE_JSON) {
+		bufsize = run_cmd(file, TTRACE_USED_BUFSIZE, param);
+		g_json = true;
+		ret = read_tracebuffer(file, bufsize);
+		g_json = false;
+		return ret;
+	}
+#endif
 
 	if (run_cmd(file, cmd, param) == TTRACE_INVALID) {
 		return TTRACE_INVALID;
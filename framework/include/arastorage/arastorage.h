@@ -161,6 +161,9 @@ typedef struct _db_handle_s db_handle_t;
 struct _db_cursor_s;
 typedef struct _db_cursor_s db_cursor_t;
 
+struct _db_stmt_s;
+typedef struct _db_stmt_s db_stmt_t;
+
 typedef int db_storage_id_t;
 
 typedef uint32_t cursor_row_t;
@@ -169,6 +172,32 @@ typedef uint32_t tuple_id_t;
 
 typedef uint8_t attribute_id_t;
 
+/**
+ * @brief A typed attribute value, used to pass tuples to db_bulk_insert()
+ *        and parameters to db_bind()
+ */
+struct db_value_s {
+	union {
+		int int_value;
+		long long_value;
+		double double_value;
+		unsigned char *string_value;
+	} u;
+	domain_t domain;
+};
+typedef struct db_value_s db_value_t;
+
+/**
+ * @brief Counters of the access paths taken by selections since db_init()
+ */
+struct db_plan_stats_s {
+	uint32_t index_scans;		/* Selections served by an index range scan */
+	uint32_t full_scans;		/* Selections served by a sequential scan */
+	uint32_t index_rows;		/* Rows fetched through an index */
+	uint32_t scan_rows;			/* Rows read by sequential scans */
+};
+typedef struct db_plan_stats_s db_plan_stats_t;
+
 /****************************************************************************
 * Public Variables
 ****************************************************************************/
@@ -211,6 +240,10 @@ db_result_t db_exec(char *format);
 /**
 * @brief Arastorage basic query API
 *
+* A SELECT with aggregates may end with "GROUP BY <attribute>", where the
+* attribute is the only plain one in its projection. Each group is then one
+* row of the cursor, and the aggregates are read as double values.
+*
 * @param[in] handle of database
 * @param[in] query sentence
 * @return On success, pointer of db_handle_t returned. On failure, a NULL is returned.
@@ -219,6 +252,79 @@ db_result_t db_exec(char *format);
 db_cursor_t *db_query(char *format);
 
 
+/**
+* @brief Insert many tuples into a relation at once, bypassing the AQL parser.
+*
+* The rows are appended to the tuple file in a single pass and the indexes of
+* the relation are built from the sorted keys. If a value does not match its
+* attribute or the tuple limit would be exceeded, no tuple is inserted.
+* The insert is not atomic otherwise: rows stored before a storage error stay
+* in the relation, and after an index error (DB_INDEX_ERROR) all the rows are
+* stored but some of them may be missing from an index of the relation.
+*
+* @param[in] name of the relation
+* @param[in] values of the tuples, count tuples of one value per attribute each,
+*            in the order the attributes were created
+* @param[in] number of tuples
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.0
+*/
+db_result_t db_bulk_insert(char *relation_name, db_value_t *values, tuple_id_t count);
+
+/**
+* @brief Parse a query once for repeated execution.
+*
+* SELECT and INSERT queries may contain '?' in place of constants in the
+* WHERE clause or the VALUES list. The parameters are numbered from 0 in the
+* order they appear and are set with db_bind() before each execution.
+*
+* @param[in] query sentence
+* @return On success, pointer of db_stmt_t returned. On failure, a NULL is returned.
+* @since Tizen RT v1.0
+*/
+db_stmt_t *db_prepare(char *format);
+
+/**
+* @brief Set the value of a parameter of a prepared statement.
+*
+* Parameters in a WHERE clause take INT or LONG values. A STRING value is
+* not copied and must stay valid until the statement is executed.
+*
+* @param[in] prepared statement
+* @param[in] number of the parameter
+* @param[in] value of the parameter
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.0
+*/
+db_result_t db_bind(db_stmt_t *stmt, uint8_t index, db_value_t *value);
+
+/**
+* @brief Execute a prepared INSERT with the values bound to its parameters.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.0
+*/
+db_result_t db_exec_prepared(db_stmt_t *stmt);
+
+/**
+* @brief Execute a prepared SELECT with the values bound to its parameters.
+*
+* @param[in] prepared statement
+* @return On success, pointer of db_cursor_t returned. On failure, a NULL is returned.
+* @since Tizen RT v1.0
+*/
+db_cursor_t *db_query_prepared(db_stmt_t *stmt);
+
+/**
+* @brief Free a prepared statement and release its relation.
+*
+* @param[in] prepared statement
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.0
+*/
+db_result_t db_finalize(db_stmt_t *stmt);
+
 /**
 * @brief free allocated cursor data. This should be called before application terminated.
 *
@@ -436,6 +542,24 @@ double cursor_get_double_value(db_cursor_t *cursor, int attr_index);
 */
 unsigned char *cursor_get_string_value(db_cursor_t *cursor, int attr_index);
 
+/**
+* @brief Get the number of selections which used an index or a sequential scan
+*
+* @param[out] Counters of the access paths taken since db_init()
+* @return On success, positive value is returned. On failure, a negative value is returned.
+* @since Tizen RT v1.0
+*/
+db_result_t db_get_plan_stats(db_plan_stats_t *stats);
+
+/**
+* @brief Reset the access path counters returned by db_get_plan_stats
+*
+* @param none
+* @return none
+* @since Tizen RT v1.0
+*/
+void db_reset_plan_stats(void);
+
 /** @} */ // end of AraStorage group
 
 #endif /* __ARASTORAGE_ARA_STORAGE_H */
@@ -96,6 +96,7 @@
 #define AQL_FLAG_AGGREGATE              1
 #define AQL_FLAG_SELECT_ALL             2
 #define AQL_FLAG_ASSIGN                 4
+#define AQL_FLAG_GROUP                  8
 
 #define AQL_CLEAR(adt)                  aql_clear(adt)
 #define AQL_SET_TYPE(adt, type)  (((adt))->optype = (type))
@@ -126,6 +127,8 @@
 #define AQL_SET_CONDITION(adt, cond)    ((adt)->lvm_instance = (cond))
 #define AQL_ADD_VALUE(adt, domain, value)                               \
 	aql_add_value((adt), (domain), (value))
+#define AQL_ADD_PARAMETER(adt)          aql_add_parameter(adt)
+#define AQL_SET_GROUP(adt, attr)        aql_set_group((adt), (attr))
 
 /****************************************************************************
 * Public Type Definitions
@@ -193,6 +196,9 @@ enum token_e {
 
 	ATTRIBUTE,
 	BPLUSTREE,					/* 48 */
+	PARAMETER,
+	GROUP,						/* 50 */
+	BY,
 
 	INTEGER_VALUE = 251,
 	FLOAT_VALUE = 252,
@@ -245,9 +251,26 @@ struct aql_adt_s {
 	uint32_t optype;
 	uint8_t flags;
 	void *lvm_instance;
+	uint8_t parameter_count;
+	/* The value slot of each parameter of an INSERT */
+	uint8_t parameter_slots[AQL_PARAMETER_LIMIT];
+	/* The projected attribute of a GROUP BY clause */
+	uint8_t group_attribute;
 };
 typedef struct aql_adt_s aql_adt_t;
 
+/*
+ * A prepared statement keeps the parse result of a query, including the
+ * predicate bytecode with its parameters unbound, and the relation the
+ * query runs on until db_finalize().
+ */
+struct _db_stmt_s {
+	aql_adt_t adt;
+	relation_t *rel;
+	attribute_value_t parameters[AQL_PARAMETER_LIMIT];
+	uint32_t bound;
+};
+
 /****************************************************************************
 * Global Function Prototypes
 ****************************************************************************/
@@ -260,5 +283,7 @@ void aql_add_relation(aql_adt_t *adt, char *rel);
 aql_status_t aql_parse(aql_adt_t *adt, char *query_string);
 db_result_t aql_add_attribute(aql_adt_t *adt, char *name, domain_t domain, unsigned element_size, int processed_only);
 db_result_t aql_add_value(aql_adt_t *adt, domain_t domain, void *value);
+db_result_t aql_add_parameter(aql_adt_t *adt);
+db_result_t aql_set_group(aql_adt_t *adt, char *name);
 
 #endif							/* !AQL_H */
@@ -84,6 +84,7 @@ void aql_clear(aql_adt_t *adt)
 	adt->relation_count = 0;
 	adt->attribute_count = 0;
 	adt->value_count = 0;
+	adt->parameter_count = 0;
 	adt->flags = 0;
 	memset(adt->aggregators, 0, sizeof(adt->aggregators));
 }
@@ -160,3 +161,35 @@ db_result_t aql_add_value(aql_adt_t *adt, domain_t domain, void *value_ptr)
 
 	return DB_OK;
 }
+
+db_result_t aql_add_parameter(aql_adt_t *adt)
+{
+	attribute_value_t *value;
+
+	if (adt->value_count == AQL_ATTRIBUTE_LIMIT || adt->parameter_count == AQL_PARAMETER_LIMIT) {
+		return DB_LIMIT_ERROR;
+	}
+
+	/* The value is filled in when the statement is executed. */
+	value = &adt->values[adt->value_count];
+	value->domain = DOMAIN_UNSPECIFIED;
+	adt->parameter_slots[adt->parameter_count++] = adt->value_count++;
+
+	return DB_OK;
+}
+
+db_result_t aql_set_group(aql_adt_t *adt, char *name)
+{
+	int i;
+
+	/* Rows are grouped by a plain attribute of the projection. */
+	for (i = 0; i < adt->attribute_count; i++) {
+		if (adt->aggregators[i] == AQL_NONE && !(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE) && strcmp(adt->attributes[i].name, name) == 0) {
+			adt->group_attribute = i;
+			adt->flags |= AQL_FLAG_GROUP | AQL_FLAG_AGGREGATE;
+			return DB_OK;
+		}
+	}
+
+	return DB_NAME_ERROR;
+}
@@ -68,6 +68,7 @@
 #include "relation.h"
 #include "result.h"
 #include "aql.h"
+#include "lvm.h"
 
 /****************************************************************************
 * Private Functions
@@ -91,6 +92,9 @@ db_result_t aql_deinit_handle(db_handle_t **handle)
 		return DB_ARGUMENT_ERROR;
 	}
 	res = DB_OK;
+	if ((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
+		index_release_iterator(&((*handle)->index_iterator));
+	}
 	if ((*handle)->rel != NULL) {
 		res = relation_release((*handle)->rel);
 		if (DB_ERROR(res)) {
@@ -107,6 +111,10 @@ db_result_t aql_deinit_handle(db_handle_t **handle)
 		free((*handle)->tuple);
 		(*handle)->tuple = NULL;
 	}
+	if ((*handle)->page != NULL) {
+		free((*handle)->page);
+		(*handle)->page = NULL;
+	}
 	if ((*handle)->lvm_instance != NULL) {
 		free((*handle)->lvm_instance);
 		(*handle)->lvm_instance = NULL;
@@ -115,12 +123,104 @@ db_result_t aql_deinit_handle(db_handle_t **handle)
 		free((*handle)->attr_map);
 		(*handle)->attr_map = NULL;
 	}
+	if ((*handle)->group != NULL) {
+		if ((*handle)->group->rows != NULL) {
+			free((*handle)->group->rows);
+		}
+		free((*handle)->group);
+		(*handle)->group = NULL;
+	}
 	free(*handle);
 	*handle = NULL;
 	DB_LOG_D("deinit handle!\n");
 	return res;
 }
 
+static db_cursor_t *aql_process_query(aql_adt_t *adt, relation_t *rel)
+{
+	uint32_t optype;
+	db_handle_t *handler;
+	attribute_t *attr_ptr;
+	db_cursor_t *cursor;
+
+	handler = NULL;
+	cursor = NULL;
+
+	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(adt));
+	switch (optype) {
+	case AQL_TYPE_REMOVE_TUPLES:
+		/* Overwrite the attribute array with a full copy of the original
+		   relation's attributes. */
+		adt->attribute_count = 0;
+		for (attr_ptr = list_head(rel->attributes); attr_ptr != NULL; attr_ptr = attr_ptr->next) {
+			AQL_ADD_ATTRIBUTE(adt, attr_ptr->name, DOMAIN_UNSPECIFIED, 0);
+		}
+	/* FALLTHROUGH */
+	case AQL_TYPE_SELECT:
+		if (DB_ERROR(aql_init_handle(&handler))) {
+			DB_LOG_E("DB: Init handle failed\n");
+			goto errout;
+		}
+		if (DB_ERROR(relation_select(&handler, rel, adt))) {
+			DB_LOG_E("DB: Failed relation_select\n");
+			goto errout;
+		}
+		cursor = relation_process_result(handler);
+		if (cursor == NULL) {
+			DB_LOG_E("DB: Failed to process cursor tuples\n");
+			goto errout;
+		}
+		break;
+	case AQL_TYPE_FLUSH:
+	//TODO flush operation will be implemented later
+	default:
+		break;
+	}
+
+	if (rel != NULL) {
+		if (handler == NULL || !(handler->flags & DB_HANDLE_FLAG_PROCESSING)) {
+			relation_release(rel);
+		}
+	}
+	aql_deinit_handle(&handler);
+
+	return cursor;
+
+errout:
+	/* Once relation_select took the relation, the handle releases it. */
+	if (rel != NULL && (handler == NULL || handler->rel != rel)) {
+		relation_release(rel);
+	}
+
+	if (cursor != NULL) {
+		cursor_deinit(cursor);
+	}
+
+	aql_deinit_handle(&handler);
+
+	return NULL;
+}
+
+static void aql_free_stmt(db_stmt_t *stmt)
+{
+	int i;
+
+	if (stmt->adt.lvm_instance != NULL) {
+		free(stmt->adt.lvm_instance);
+	}
+	for (i = 0; i < stmt->adt.value_count; i++) {
+		if (stmt->adt.values[i].domain == DOMAIN_STRING) {
+			free(VALUE_STRING(&stmt->adt.values[i]));
+		}
+	}
+	free(stmt);
+}
+
+static bool aql_stmt_bound(db_stmt_t *stmt)
+{
+	return stmt->bound == (uint32_t)((1ULL << stmt->adt.parameter_count) - 1);
+}
+
 /****************************************************************************
 * Public Functions
 ****************************************************************************/
@@ -161,6 +261,11 @@ db_result_t db_exec(char *format)
 		return DB_PARSING_ERROR;
 	}
 
+	if (adt.parameter_count > 0) {
+		DB_LOG_E("DB : Parameters need a prepared statement\n");
+		return DB_ARGUMENT_ERROR;
+	}
+
 	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(&adt));
 	if (optype == AQL_OP_TYPE_QUERY) {
 		DB_LOG_E("DB : AQL OP TYPE Error \n");
@@ -236,22 +341,44 @@ db_result_t db_exec(char *format)
 	return res;
 }
 
+db_result_t db_bulk_insert(char *relation_name, db_value_t *values, tuple_id_t count)
+{
+	db_result_t res;
+	relation_t *rel;
+
+	if (relation_name == NULL || (values == NULL && count > 0)) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	rel = relation_load(relation_name);
+	if (rel == NULL) {
+		DB_LOG_E("DB : get relation Failed\n");
+		return DB_RELATIONAL_ERROR;
+	}
+
+	res = relation_bulk_insert(rel, values, count);
+	relation_release(rel);
+
+	return res;
+}
+
 db_cursor_t *db_query(char *format)
 {
 	aql_adt_t adt;
 	relation_t *rel;
 	uint32_t optype;
-	db_handle_t *handler;
-	attribute_t *attr_ptr;
-	db_cursor_t *cursor;
-
-	handler = NULL;
-	cursor = NULL;
 
 	if (DB_ERROR(aql_get_parse_result(format, &adt))) {
 		DB_LOG_E("DB : Parsing Error in db_create : %d\n");
 		return NULL;
 	}
+	if (adt.parameter_count > 0) {
+		DB_LOG_E("DB : Parameters need a prepared statement\n");
+		if (adt.lvm_instance != NULL) {
+			free(adt.lvm_instance);
+		}
+		return NULL;
+	}
 	optype = AQL_GET_OP_TYPE(AQL_GET_TYPE(&adt));
 	if (optype != AQL_OP_TYPE_QUERY) {
 		DB_LOG_E("DB : AQL OP TYPE Error \n");
@@ -268,56 +395,149 @@ db_cursor_t *db_query(char *format)
 		return NULL;
 	}
 
-	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&adt));
-	switch (optype) {
-	case AQL_TYPE_REMOVE_TUPLES:
-		/* Overwrite the attribute array with a full copy of the original
-		   relation's attributes. */
-		adt.attribute_count = 0;
-		for (attr_ptr = list_head(rel->attributes); attr_ptr != NULL; attr_ptr = attr_ptr->next) {
-			AQL_ADD_ATTRIBUTE(&adt, attr_ptr->name, DOMAIN_UNSPECIFIED, 0);
+	return aql_process_query(&adt, rel);
+}
+
+db_stmt_t *db_prepare(char *format)
+{
+	db_stmt_t *stmt;
+	uint32_t optype;
+
+	stmt = (db_stmt_t *)malloc(sizeof(db_stmt_t));
+	if (stmt == NULL) {
+		DB_LOG_E("DB : Failed to malloc prepared statement\n");
+		return NULL;
+	}
+	memset(stmt, 0, sizeof(db_stmt_t));
+
+	if (DB_ERROR(aql_get_parse_result(format, &stmt->adt))) {
+		DB_LOG_E("DB : Parsing Error in db_prepare\n");
+		aql_free_stmt(stmt);
+		return NULL;
+	}
+
+	/* Removal replaces the relation, so it cannot be kept loaded. */
+	optype = AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&stmt->adt));
+	if (optype != AQL_TYPE_SELECT && optype != AQL_TYPE_INSERT) {
+		DB_LOG_E("DB : Only SELECT and INSERT can be prepared\n");
+		aql_free_stmt(stmt);
+		return NULL;
+	}
+
+	stmt->rel = aql_get_relation(&stmt->adt);
+	if (stmt->rel == NULL) {
+		DB_LOG_E("DB : get relation Failed\n");
+		aql_free_stmt(stmt);
+		return NULL;
+	}
+
+	return stmt;
+}
+
+db_result_t db_bind(db_stmt_t *stmt, uint8_t index, db_value_t *value)
+{
+	if (stmt == NULL || value == NULL || index >= stmt->adt.parameter_count) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	switch (value->domain) {
+	case DOMAIN_INT:
+	case DOMAIN_LONG:
+		break;
+	case DOMAIN_STRING:
+		/* The logic VM only compares integers. */
+		if (stmt->adt.lvm_instance == NULL) {
+			break;
 		}
-	/* FALLTHROUGH */
-	case AQL_TYPE_SELECT:
-		if (DB_ERROR(aql_init_handle(&handler))) {
-			DB_LOG_E("DB: Init handle failed\n");
-			goto errout;
+	default:
+		return DB_TYPE_ERROR;
+	}
+
+	memcpy(&stmt->parameters[index], value, sizeof(db_value_t));
+	stmt->bound |= 1u << index;
+
+	return DB_OK;
+}
+
+db_result_t db_exec_prepared(db_stmt_t *stmt)
+{
+	attribute_value_t values[AQL_ATTRIBUTE_LIMIT];
+	db_result_t res;
+	int i;
+
+	if (stmt == NULL || AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&stmt->adt)) != AQL_TYPE_INSERT || !aql_stmt_bound(stmt)) {
+		return DB_ARGUMENT_ERROR;
+	}
+
+	if (relation_cardinality(stmt->rel) >= DB_TUPLE_LIMIT) {
+		return DB_LIMIT_ERROR;
+	}
+
+	memcpy(values, stmt->adt.values, sizeof(attribute_value_t) * stmt->adt.value_count);
+	for (i = 0; i < stmt->adt.parameter_count; i++) {
+		memcpy(&values[stmt->adt.parameter_slots[i]], &stmt->parameters[i], sizeof(attribute_value_t));
+	}
+
+	res = relation_insert(stmt->rel, values);
+	if (DB_SUCCESS(res)) {
+		res = DB_OK;
+	}
+	return res;
+}
+
+db_cursor_t *db_query_prepared(db_stmt_t *stmt)
+{
+	aql_adt_t adt;
+	lvm_instance_t *lvm;
+	operand_value_t values[AQL_PARAMETER_LIMIT];
+	int i;
+
+	if (stmt == NULL || AQL_GET_EXEC_TYPE(AQL_GET_TYPE(&stmt->adt)) != AQL_TYPE_SELECT || !aql_stmt_bound(stmt)) {
+		return NULL;
+	}
+
+	/* Each execution works on a copy, the statement keeps the template. */
+	memcpy(&adt, &stmt->adt, sizeof(aql_adt_t));
+	if (stmt->adt.lvm_instance != NULL) {
+		lvm = (lvm_instance_t *)malloc(sizeof(lvm_instance_t));
+		if (lvm == NULL) {
+			DB_LOG_E("DB : Failed to malloc lvm instance\n");
+			return NULL;
 		}
-		if (DB_ERROR(relation_select(&handler, rel, &adt))) {
-			DB_LOG_E("DB: Failed relation_select\n");
-			goto errout;
+		lvm_clone(lvm, (lvm_instance_t *)stmt->adt.lvm_instance);
+		for (i = 0; i < stmt->adt.parameter_count; i++) {
+			values[i].l = db_value_to_long(&stmt->parameters[i]);
 		}
-		cursor = relation_process_result(handler);
-		if (cursor == NULL) {
-			DB_LOG_E("DB: Failed to process cursor tuples\n");
-			goto errout;
+		if (LVM_ERROR(lvm_bind_parameters(lvm, values, stmt->adt.parameter_count))) {
+			DB_LOG_E("DB : Failed to bind parameters\n");
+			free(lvm);
+			return NULL;
 		}
-		break;
-	case AQL_TYPE_FLUSH:
-	//TODO flush operation will be implemented later
-	default:
-		break;
+		AQL_SET_CONDITION(&adt, lvm);
 	}
 
-	if (rel != NULL) {
-		if (handler == NULL || !(handler->flags & DB_HANDLE_FLAG_PROCESSING)) {
-			relation_release(rel);
-		}
+#ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
+	if (DB_SUCCESS(storage_flush_insert_buffer())) {
+		DB_LOG_D("DB : flush insert buffer!!\n");
 	}
-	aql_deinit_handle(&handler);
+#endif
 
-	return cursor;
+	/* The query releases its own reference, the statement keeps the relation loaded. */
+	stmt->rel->references++;
 
-errout:
-	if (rel != NULL) {
-		relation_release(rel);
-	}
+	return aql_process_query(&adt, stmt->rel);
+}
 
-	if (cursor != NULL) {
-		cursor_deinit(cursor);
+db_result_t db_finalize(db_stmt_t *stmt)
+{
+	db_result_t res;
+
+	if (stmt == NULL) {
+		return DB_ARGUMENT_ERROR;
 	}
 
-	aql_deinit_handle(&handler);
+	res = relation_release(stmt->rel);
+	aql_free_stmt(stmt);
 
-	return NULL;
+	return res;
 }
@@ -86,8 +86,9 @@ static const struct keyword keywords[] = {
 	{"*", MUL},
 	{"/", DIV},
 	{"#", COMMENT},
+	{"?", PARAMETER},
 
-	{">=", GEQ},				/* 13 */
+	{">=", GEQ},				/* 14 */
 	{"<=", LEQ},
 	{"<>", NOT_EQUAL},
 	{"<-", ASSIGN},
@@ -95,8 +96,9 @@ static const struct keyword keywords[] = {
 	{"IS", IS},
 	{"ON", ON},
 	{"IN", IN},
+	{"BY", BY},
 
-	{"ALL", ALL},				/* 21 */
+	{"ALL", ALL},				/* 23 */
 	{"AND", AND},
 	{"NOT", NOT},
 	{"SUM", SUM},
@@ -104,18 +106,19 @@ static const struct keyword keywords[] = {
 	{"MIN", MIN},
 	{"INT", INT},
 
-	{"INTO", INTO},				/* 28 */
+	{"INTO", INTO},				/* 30 */
 	{"FROM", FROM},
 	{"MEAN", MEAN},
 	{"JOIN", JOIN},
 	{"LONG", LONG},
 	{"TYPE", TYPE},
 
-	{"WHERE", WHERE},			/* 34 */
+	{"WHERE", WHERE},			/* 36 */
 	{"COUNT", COUNT},
 	{"INDEX", INDEX},
+	{"GROUP", GROUP},
 
-	{"INSERT", INSERT},			/* 37 */
+	{"INSERT", INSERT},			/* 40 */
 	{"SELECT", SELECT},
 	{"REMOVE", REMOVE},
 	{"CREATE", CREATE},
@@ -125,16 +128,16 @@ static const struct keyword keywords[] = {
 	{"INLINE", INLINE},
 	{"REMAIN", REMAIN},
 
-	{"PROJECT", PROJECT},		/* 46 */
+	{"PROJECT", PROJECT},		/* 49 */
 
-	{"RELATION", RELATION},		/* 47 */
+	{"RELATION", RELATION},		/* 50 */
 
-	{"ATTRIBUTE", ATTRIBUTE},	/* 48 */
+	{"ATTRIBUTE", ATTRIBUTE},	/* 51 */
 	{"BPLUSTREE", BPLUSTREE}
 };
 
 /* Provides a pointer to the first keyword of a specific length. */
-static const int8_t skip_hint[] = { 0, 13, 21, 28, 34, 37, 46, 47, 48 };
+static const int8_t skip_hint[] = { 0, 14, 23, 30, 36, 40, 49, 50, 51 };
 
 static char separators[] = "#.;,() \t\n";
 
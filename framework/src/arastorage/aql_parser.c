@@ -260,6 +260,11 @@ PARSER(values)
 	case INTEGER_VALUE:
 		AQL_ADD_VALUE(adt, DOMAIN_INT, VALUE);
 		break;
+	case PARAMETER:
+		if (DB_ERROR(AQL_ADD_PARAMETER(adt))) {
+			RETURN(SYNTAX_ERROR);
+		}
+		break;
 	default:
 		RETURN(SYNTAX_ERROR);
 	}
@@ -294,6 +299,12 @@ PARSER(operand)
 	case INTEGER_VALUE:
 		lvm_set_long(p, *(long *)lexer->value);
 		break;
+	case PARAMETER:
+		if (adt->parameter_count == AQL_PARAMETER_LIMIT) {
+			RETURN(SYNTAX_ERROR);
+		}
+		lvm_set_parameter(p, adt->parameter_count++);
+		break;
 	default:
 		RETURN(SYNTAX_ERROR);
 	}
@@ -463,11 +474,30 @@ PARSER(where)
 		}
 	}
 
+	/* The predicate was truncated if it did not fit in the bytecode buffer */
+	if (lvm_get_error(p)) {
+		RETURN(SYNTAX_ERROR);
+	}
+
 	lvm_print_code(p);
 
 	return STATUS_OK;
 }
 
+PARSER(group)
+{
+	CONSUME(BY);
+	CONSUME(IDENTIFIER);
+
+	/* Aggregates are not mixed with plain attributes, except for the
+	   attribute the rows are grouped by. */
+	if (DB_ERROR(AQL_SET_GROUP(adt, VALUE))) {
+		RETURN(SYNTAX_ERROR);
+	}
+
+	RETURN(STATUS_OK);
+}
+
 PARSER(select)
 {
 	lvm_instance_t *lvm;
@@ -507,11 +537,28 @@ PARSER(select)
 			AQL_SET_CONDITION(adt, NULL);
 			RETURN(SYNTAX_ERROR);
 		}
-	} else {
+
+		NEXT;
+		if (TOKEN != GROUP) {
+			REWIND;
+			CONSUME(END);
+			return STATUS_OK;
+		}
+	}
+
+	if (TOKEN != GROUP) {
 		REWIND;
 		RETURN(STATUS_OK);
 	}
 
+	if (!PARSE(group)) {
+		if (adt->lvm_instance != NULL) {
+			free(adt->lvm_instance);
+			AQL_SET_CONDITION(adt, NULL);
+		}
+		RETURN(SYNTAX_ERROR);
+	}
+
 	CONSUME(END);
 
 	return STATUS_OK;
@@ -88,17 +88,8 @@ struct attribute_s {
 
 typedef struct attribute_s attribute_t;
 
-struct attribute_value_s {
-	union {
-		int int_value;
-		long long_value;
-		double double_value;
-		unsigned char *string_value;
-	} u;
-	domain_t domain;
-};
-
-typedef struct attribute_value_s attribute_value_t;
+/* Attribute values share their layout with db_value_t of the public API. */
+typedef db_value_t attribute_value_t;
 
 #define VALUE_LONG(value)   (value)->u.long_value
 #define VALUE_INT(value)    (value)->u.int_value
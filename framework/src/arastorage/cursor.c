@@ -30,6 +30,101 @@
 #include "memb.h"
 #include "relation.h"
 
+/****************************************************************************
+* Private Functions
+****************************************************************************/
+
+/* Search (row_id)th set tuple id in the row bitmap. Whole zero words are skipped. */
+static tuple_id_t cursor_search_storage_row(db_cursor_t *cursor, tuple_id_t row_id)
+{
+	int i, index, pos;
+	tuple_id_t cnt = 0;
+
+	for (i = 0; i < cursor->total_rows; i++) {
+		index = GET_INDEX(i);
+		pos = GET_POS(i);
+
+		if (pos == 0 && cursor->row_arr[index] == 0) {
+			i += (sizeof(uint32_t) * 8) - 1;
+			continue;
+		}
+
+		if (BIT_CHECK(cursor->row_arr[index], pos)) {
+			if (cnt == row_id) {
+				return i;
+			}
+			cnt++;
+		}
+	}
+	return INVALID_TUPLE;
+}
+
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+/* Build the compact array of set tuple ids with one pass over the row bitmap.
+   The array is dropped whenever a tuple is added, and rebuilt on next move. */
+static db_result_t cursor_build_row_index(db_cursor_t *cursor)
+{
+	int i, index, pos;
+	tuple_id_t cnt = 0;
+
+	if (cursor->row_index != NULL) {
+		return DB_OK;
+	}
+
+	cursor->row_index = (tuple_id_t *)malloc(sizeof(tuple_id_t) * cursor->cursor_rows);
+	if (cursor->row_index == NULL) {
+		DB_LOG_E("failed to allocate cursor row index\n");
+		return DB_ALLOCATION_ERROR;
+	}
+
+	for (i = 0; i < cursor->total_rows && cnt < cursor->cursor_rows; i++) {
+		index = GET_INDEX(i);
+		pos = GET_POS(i);
+
+		if (pos == 0 && cursor->row_arr[index] == 0) {
+			i += (sizeof(uint32_t) * 8) - 1;
+			continue;
+		}
+
+		if (BIT_CHECK(cursor->row_arr[index], pos)) {
+			cursor->row_index[cnt++] = i;
+		}
+	}
+
+	if (cnt != cursor->cursor_rows) {
+		DB_LOG_E("cursor row index mismatch : %d != %d\n", cnt, cursor->cursor_rows);
+		free(cursor->row_index);
+		cursor->row_index = NULL;
+		return DB_CURSOR_ERROR;
+	}
+
+	return DB_OK;
+}
+
+static void cursor_free_row_index(db_cursor_t *cursor)
+{
+	if (cursor->row_index != NULL) {
+		free(cursor->row_index);
+		cursor->row_index = NULL;
+	}
+}
+#endif
+
+/* Get storage row id of (row_id)th row in cursor. */
+static tuple_id_t cursor_get_storage_row(db_cursor_t *cursor, tuple_id_t row_id)
+{
+	if (row_id >= cursor->cursor_rows) {
+		return INVALID_TUPLE;
+	}
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+	if (DB_SUCCESS(cursor_build_row_index(cursor))) {
+		return cursor->row_index[row_id];
+	}
+	/* Fall back to scanning the bitmap if the index can not be built. */
+#endif
+	return cursor_search_storage_row(cursor, row_id);
+}
+
 /****************************************************************************
 * Public Functions
 ****************************************************************************/
@@ -37,6 +132,8 @@
 /* Update current cursor id and storage id. */
 db_result_t cursor_move_to(db_cursor_t *cursor, tuple_id_t row_id)
 {
+	tuple_id_t storage_row;
+
 	if (IS_EMPTY_CURSOR(cursor)) {
 		DB_LOG_E("Empty Cursor\n");
 		return DB_CURSOR_ERROR;
@@ -47,25 +144,15 @@ db_result_t cursor_move_to(db_cursor_t *cursor, tuple_id_t row_id)
 		return DB_CURSOR_ERROR;
 	}
 
-	int i, index, pos;
-	int cnt = 0;
-
-	/* search (row_id)th set tuple id */
-	for (i = 0; i < cursor->total_rows; i++) {
-		index = GET_INDEX(i);
-		pos = GET_POS(i);
-
-		if (BIT_CHECK(cursor->row_arr[index], pos)) {
-			if (cnt == row_id) {
-				cursor->current_cursor_row = row_id;
-				cursor->current_storage_row = i;
-				DB_LOG_D("set current cursor id = %d, storage id = %d\n", cursor->current_cursor_row, cursor->current_storage_row);
-				return DB_OK;
-			}
-			cnt++;
-		}
+	storage_row = cursor_get_storage_row(cursor, row_id);
+	if (storage_row == INVALID_TUPLE) {
+		return DB_CURSOR_ERROR;
 	}
-	return DB_CURSOR_ERROR;
+
+	cursor->current_cursor_row = row_id;
+	cursor->current_storage_row = storage_row;
+	DB_LOG_D("set current cursor id = %d, storage id = %d\n", cursor->current_cursor_row, cursor->current_storage_row);
+	return DB_OK;
 }
 
 /* Search the first set tuple id and update storage id corresponding it. */
@@ -104,9 +191,7 @@ cursor_row_t cursor_get_row(db_cursor_t *cursor)
 /* Check whether cursor is pointing the first row*/
 bool cursor_is_first_row(db_cursor_t *cursor)
 {
-	int i, index, pos;
-
-	if (cursor == NULL) {
+	if (IS_EMPTY_CURSOR(cursor)) {
 		return false;
 	}
 	//check whether pointing cursor id is correct
@@ -114,24 +199,13 @@ bool cursor_is_first_row(db_cursor_t *cursor)
 		return false;
 	}
 	//check whether pointing storage row id is true
-	for (i = 0; i < cursor->total_rows; i++) {
-		index = GET_INDEX(i);
-		pos = GET_POS(i);
-
-		if (BIT_CHECK(cursor->row_arr[index], pos)) {
-			if (i == cursor->current_storage_row) {
-				return true;
-			}
-			return false;
-		}
-	}
-	return false;
+	return cursor_get_storage_row(cursor, 0) == cursor->current_storage_row;
 }
 
 /* Check whether cursor is pointing the last row*/
 bool cursor_is_last_row(db_cursor_t *cursor)
 {
-	if (cursor == NULL) {
+	if (IS_EMPTY_CURSOR(cursor)) {
 		return false;
 	}
 	//check whether pointing cursor id is correct
@@ -139,20 +213,7 @@ bool cursor_is_last_row(db_cursor_t *cursor)
 		return false;
 	}
 	//check whether pointing storage row id is true
-	int i, index, pos;
-
-	for (i = cursor->total_rows - 1; i >= 0; i--) {
-		index = GET_INDEX(i);
-		pos = GET_POS(i);
-
-		if (BIT_CHECK(cursor->row_arr[index], pos)) {
-			if (i == cursor->current_storage_row) {
-				return true;
-			}
-			return false;
-		}
-	}
-	return false;
+	return cursor_get_storage_row(cursor, cursor->cursor_rows - 1) == cursor->current_storage_row;
 }
 
 db_result_t cursor_data_add(db_cursor_t *cursor, tuple_id_t tuple_id)
@@ -170,8 +231,15 @@ db_result_t cursor_data_add(db_cursor_t *cursor, tuple_id_t tuple_id)
 	int index = GET_INDEX(tuple_id);
 	int pos = GET_POS(tuple_id);
 
+	if (BIT_CHECK(cursor->row_arr[index], pos)) {
+		return DB_OK;
+	}
+
 	BIT_SET(cursor->row_arr[index], pos);
 	cursor->cursor_rows++;
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+	cursor_free_row_index(cursor);
+#endif
 
 	DB_LOG_D("cursor data added successfully : id %d, cardinality %d\n", tuple_id, cursor->cursor_rows);
 
@@ -260,6 +328,9 @@ db_result_t cursor_get_value_storage(attribute_value_t *value, db_cursor_t *curs
 	if (cursor->attr_map[col].valuetype == AGGREGATE_VALUE) {
 		/* If the type of value is aggregate value, we don't need to read storage.
 		 Because aggregate result is already calculated and stored in buffer. */
+		if (cursor->result_rows != NULL) {
+			buf = cursor->result_rows + cursor->current_storage_row * cursor->result_row_length;
+		}
 		buf += cursor->attr_map[col].offset;
 	} else {
 		/* Otherwise, Read tuple value from storage. */
@@ -400,6 +471,14 @@ void cursor_clean_data(db_cursor_t *cursor)
 		free(cursor->row_arr);
 	}
 	cursor->row_arr = NULL;
+	if (cursor->result_rows != NULL) {
+		free(cursor->result_rows);
+	}
+	cursor->result_rows = NULL;
+	cursor->result_row_length = 0;
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+	cursor_free_row_index(cursor);
+#endif
 }
 
 db_result_t cursor_init(db_cursor_t **cursor, relation_t *rel)
@@ -439,6 +518,13 @@ db_result_t cursor_deinit(db_cursor_t *cursor)
 		free(cursor->row_arr);
 		cursor->row_arr = NULL;
 	}
+	if (cursor->result_rows != NULL) {
+		free(cursor->result_rows);
+		cursor->result_rows = NULL;
+	}
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+	cursor_free_row_index(cursor);
+#endif
 	free(cursor);
 	return DB_OK;
 }
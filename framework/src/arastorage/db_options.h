@@ -101,7 +101,11 @@
 /* The maximum size of the LVM bytecode compiled from a
    single database query. */
 #ifndef DB_VM_BYTECODE_SIZE
-#define DB_VM_BYTECODE_SIZE             32
+#ifdef CONFIG_ARASTORAGE_VM_BYTECODE_SIZE
+#define DB_VM_BYTECODE_SIZE             CONFIG_ARASTORAGE_VM_BYTECODE_SIZE
+#else
+#define DB_VM_BYTECODE_SIZE             128
+#endif
 #endif							/* DB_VM_BYTECODE_SIZE */
 
 /*----------------------------------------------------------------------------*/
@@ -127,6 +131,11 @@
 #define AQL_ATTRIBUTE_LIMIT             6
 #endif							/* AQL_ATTRIBUTE_LIMIT */
 
+/* The maximum number of parameters in a prepared statement. */
+#ifndef AQL_PARAMETER_LIMIT
+#define AQL_PARAMETER_LIMIT             8
+#endif							/* AQL_PARAMETER_LIMIT */
+
 /*----------------------------------------------------------------------------*/
 
 /*
@@ -165,9 +174,28 @@
 
 /* The maximum number of tuples in a relation. */
 #ifndef DB_TUPLE_LIMIT
+#ifdef CONFIG_ARASTORAGE_TUPLE_LIMIT
+#define DB_TUPLE_LIMIT          CONFIG_ARASTORAGE_TUPLE_LIMIT
+#else
 #define DB_TUPLE_LIMIT          2000
+#endif
 #endif							/* DB_TUPLE_LIMIT */
 
+/* The maximum number of groups in the result of a GROUP BY query. */
+#ifndef DB_GROUP_LIMIT
+#ifdef CONFIG_ARASTORAGE_GROUP_LIMIT
+#define DB_GROUP_LIMIT          CONFIG_ARASTORAGE_GROUP_LIMIT
+#else
+#define DB_GROUP_LIMIT          32
+#endif
+#endif							/* DB_GROUP_LIMIT */
+
+/* The number of hash chains used to find the group of a tuple.
+   It must be a power of two. */
+#ifndef DB_GROUP_HASH_SIZE
+#define DB_GROUP_HASH_SIZE      16
+#endif							/* DB_GROUP_HASH_SIZE */
+
 /* The number of int array in a cursor. */
 #ifndef DB_CURSOR_LIMIT
 #define DB_CURSOR_LIMIT          ((DB_TUPLE_LIMIT / (sizeof(uint32_t)*8)) + 1)
@@ -178,6 +206,15 @@
 #define DB_CURSOR_RESULT_ENTRY          ((DB_CURSOR_LIMIT) * (sizeof(uint32_t)*8))
 #endif							/* DB_CURSOR_RESULT_ENTRY */
 
+/* The size of the page buffer used when scanning tuples sequentially. */
+#ifndef DB_SCAN_PAGE_SIZE
+#ifdef CONFIG_ARASTORAGE_SCAN_PAGE_SIZE
+#define DB_SCAN_PAGE_SIZE               CONFIG_ARASTORAGE_SCAN_PAGE_SIZE
+#else
+#define DB_SCAN_PAGE_SIZE               1024
+#endif
+#endif							/* DB_SCAN_PAGE_SIZE */
+
 /* The name of the intermediate "result" relation file, which is used
    for presenting the result of a query to a user. */
 #ifndef RESULT_RELATION
@@ -230,6 +267,16 @@
 #define DB_TREE_CACHE_LIMIT             10
 #endif
 
+/* How many times, and how many microseconds apart, a selection retries
+   to find a bucket that another task is editing before it gives up. */
+#ifndef DB_TREE_BUSY_RETRIES
+#define DB_TREE_BUSY_RETRIES            1000
+#endif							/* DB_TREE_BUSY_RETRIES */
+
+#ifndef DB_TREE_BUSY_WAIT_US
+#define DB_TREE_BUSY_WAIT_US            1000
+#endif							/* DB_TREE_BUSY_WAIT_US */
+
 /*----------------------------------------------------------------------------*/
 
 /* LVM options. */
@@ -69,6 +69,12 @@
 #define INDEX_API_COMPLETE      0x08
 #define INDEX_API_RANGE_QUERIES 0x10
 
+/* Bound and state flags of an index iterator */
+#define INDEX_ITERATOR_MIN_EXCLUSIVE 0x01
+#define INDEX_ITERATOR_MAX_EXCLUSIVE 0x02
+#define INDEX_ITERATOR_ACTIVE        0x10
+#define INDEX_ITERATOR_FINISHED      0x20
+
 /****************************************************************************
 * Public Type Definitions
 ****************************************************************************/
@@ -106,6 +112,8 @@ struct index_iterator_s {
 	attribute_value_t max_value;
 	tuple_id_t next_item_no;
 	tuple_id_t found_items;
+	uint8_t flags;
+	void *opaque_data;			/* Iteration state owned by the index implementation */
 };
 typedef struct index_iterator_s index_iterator_t;
 
@@ -119,6 +127,8 @@ struct index_api_s {
 	db_result_t(*insert)(index_t *, attribute_value_t *, tuple_id_t);
 	db_result_t(*delete)(index_t *, attribute_value_t *);
 	tuple_id_t(*get_next)(index_iterator_t *, uint8_t);
+	void (*release_iterator)(index_iterator_t *);
+	db_result_t(*bulk_insert)(index_t *, attribute_value_t *, unsigned, tuple_id_t, tuple_id_t);
 };
 
 typedef struct index_api_s index_api_t;
@@ -138,9 +148,12 @@ db_result_t index_destroy(index_t *);
 db_result_t index_load(relation_t *, attribute_t *);
 db_result_t index_release(index_t *);
 db_result_t index_insert(index_t *, attribute_value_t *, tuple_id_t);
+db_result_t index_bulk_insert(index_t *, attribute_value_t *, unsigned, tuple_id_t, tuple_id_t);
 db_result_t index_delete(index_t *, attribute_value_t *);
 db_result_t index_get_iterator(index_iterator_t *, index_t *, attribute_value_t *, attribute_value_t *);
+db_result_t index_get_range_iterator(index_iterator_t *, index_t *, attribute_value_t *, attribute_value_t *, uint8_t);
 tuple_id_t index_get_next(index_iterator_t *, uint8_t);
+void index_release_iterator(index_iterator_t *);
 int index_exists(attribute_t *);
 db_result_t index_deinit(void);
 #endif							/* !INDEX_H */
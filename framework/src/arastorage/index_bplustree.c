@@ -53,6 +53,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <pthread.h>
 
 #include "result.h"
@@ -73,13 +74,20 @@
 #define NODE_DEPTH      2
 #define LEAF_NODES      pow(BRANCH_FACTOR, NODE_DEPTH)
 #define EMPTY_NODE(node)        (node)->val[BRANCH_FACTOR-1] == 0
-#define KEY_MAX 32768
+#define KEY_MAX LONG_MAX
 #define ROW_XOR 0xf6U
 #define NODE_STATE_VALID 1
 #define NODE_STATE_LOCK 2
 #define NODE_STATE_DIRTY 4
 #define ROOT_NODE_PARENT 255
 
+/* Identifies the on-flash layout of the tree descriptor, nodes and buckets.
+ * Version 1 stores full-width keys and tuple ids; indexes written in the
+ * older 16-bit layout carry no header and are rebuilt when loaded.
+ */
+#define TREE_MAGIC 0x42505452
+#define TREE_LAYOUT_VERSION 1
+
 /* The total number of states possible of a node */
 #define NODE_STATES 255
 #define CONFIG_VACUUM_THRESHOLD 40
@@ -126,14 +134,19 @@
 /****************************************************************************
  * Private Types
  ****************************************************************************/
+/* Keys have the width of the long values of indexed attributes, so
+ * lookups are exact on both 32-bit and 64-bit targets.
+ */
+typedef long tree_key_t;
+
 struct key_value_pair_s {
-	uint16_t key;
-	uint16_t value;
+	tree_key_t key;
+	tuple_id_t value;
 };
 typedef struct key_value_pair_s pair_t;
 
 struct tree_node_s {
-	uint16_t val[BRANCH_FACTOR];
+	tree_key_t val[BRANCH_FACTOR];
 	uint16_t id[BRANCH_FACTOR];
 	uint16_t is_leaf;
 };
@@ -142,7 +155,7 @@ typedef struct tree_node_s tree_node_t;
 struct bucket_s {
 	pair_t pairs[BUCKET_SIZE];
 	uint8_t next_free_slot;
-	int info[3];
+	tree_key_t info[3];
 };
 typedef struct bucket_s bucket_t;
 
@@ -236,8 +249,8 @@ struct tree_s {
 	uint8_t off_nodes, off_buckets;	/*  Maintaining number of nodes and buckets used by the index structure */
 	uint8_t root;				/*   The node id of the root of the bplus-tree */
 	uint8_t lock_buckets[CONFIG_BUCKETS_LIMIT];	/* The structure to prevent to tasks to simultaneously edit same buckets  */
-	uint16_t inserted;			/*  Count of total number of tuples inserted  */
-	uint16_t deleted;			/*    Count of total number of tuples deleted  */
+	uint32_t inserted;			/*  Count of total number of tuples inserted  */
+	uint32_t deleted;			/*    Count of total number of tuples deleted  */
 	uint8_t levels;				/*  The depth of the bplus-tree including the buckets  */
 	tree_cache_t *node_cache;	/*  Structure to maintain node cache  */
 	bucket_cache_t *buck_cache;	/*   Structure to maintain bucket cache  */
@@ -245,9 +258,42 @@ struct tree_s {
 	pthread_mutex_t buck_cache_lock;	/*  Maintains concurrency control over Bucket Cache  */
 	pthread_mutex_t bucket_lock;	/*  Maintains serialisability over in RAM Tree Structure  */
 	struct rw_lock_s tree_lock;	/*  A Reader Writer Lock used to maintain consistency in tree structure */
+	uint32_t generation;		/*  Advanced whenever the tree write lock is released */
 };
 typedef struct tree_s tree_t;
 
+/* Tree Metadata saved at the start of the descriptor file */
+struct tree_header_s {
+	uint32_t magic;				/*  TREE_MAGIC  */
+	uint8_t version;			/*  TREE_LAYOUT_VERSION  */
+	uint8_t key_size;			/*  sizeof(tree_key_t) when the index was created  */
+	uint8_t off_nodes, off_buckets;
+	uint8_t root;
+	uint8_t levels;
+	uint16_t reserved;
+	uint32_t inserted;
+	uint32_t deleted;
+};
+typedef struct tree_header_s tree_header_t;
+
+/* The state of one index iteration, kept in the iterator.
+ * A removal edits the bucket in the main cache under the tree write lock.
+ * A selection works on a sorted copy of the bucket instead, so that it only
+ * holds the tree read lock while the copy is taken.
+ */
+struct iteration_cache_s {
+	bucket_t *bucket;			/* The bucket in the main cache, or the snapshot */
+	bucket_t snapshot;
+	uint32_t generation;		/* The tree generation when the snapshot was taken */
+	pair_t last;				/* The last pair returned by a selection */
+	uint16_t bucket_id;
+	uint8_t start;
+	uint8_t end;
+	bool exclusive;
+	bool resume;
+};
+typedef struct iteration_cache_s iteration_cache_t;
+
 /****************************************************************************
  * Private variables
  ****************************************************************************/
@@ -256,30 +302,38 @@ static int base_offset = 0;
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
-static int transform_key(int);
+static tree_key_t transform_key(tree_key_t);
+static void tree_unlock_write(tree_t *);
 static tree_node_t *tree_read(tree_t *, int);
 static int tree_write(tree_t *, int, tree_node_t *);
-static tree_result_t tree_insert(tree_t *, int);
-static pair_t *tree_find(tree_t *, int key);
-tree_result_t insert_item_btree(tree_t *, int, int);
+static tree_result_t tree_insert(tree_t *, tree_key_t);
+static tree_result_t tree_build(tree_t *, pair_t *, int);
+static pair_t *tree_find(tree_t *, tree_key_t key, bool *busy);
+tree_result_t insert_item_btree(tree_t *, tree_key_t, tuple_id_t);
 
 static bucket_t *bucket_read(tree_t *, int);
 static int bucket_write(tree_t *, int, bucket_t *);
-static bsplit_status_t bucket_split(tree_t *, int, int, pair_t *);
+static bsplit_status_t bucket_split(tree_t *, tree_key_t, tuple_id_t, pair_t *);
 static cache_result_t cache_bucket_append(tree_t *, int, pair_t *);
 static cache_result_t cache_write_bucket(tree_t *, int, bucket_t *);
 
 static cache_result_t modify_cache(tree_t *, int, cache_type_t, op_type_t);
 static cache_result_t cache_write_node(tree_t *, int, tree_node_t *);
 static cache_result_t cache_replace_node(tree_t *, int, tree_node_t *);
+static void cache_flush(tree_t *);
+static int tree_write_header(tree_t *);
+static db_result_t tree_read_header(tree_t *, db_storage_id_t);
+static void cache_invalidate(tree_t *);
 
 static db_result_t create(index_t *);
 static db_result_t destroy(index_t *);
 static db_result_t load(index_t *);
 static db_result_t release(index_t *);
 static db_result_t insert(index_t *, attribute_value_t *, tuple_id_t);
+static db_result_t bulk_insert(index_t *, attribute_value_t *, unsigned, tuple_id_t, tuple_id_t);
 static db_result_t delete(index_t *, attribute_value_t *);
 static tuple_id_t get_next(index_iterator_t *, uint8_t);
+static void release_iterator(index_iterator_t *);
 static db_result_t vacuum(tree_t *, relation_t *);
 
 /****************************************************************************
@@ -298,7 +352,9 @@ index_api_t index_bplustree = {
 	release,
 	insert,
 	delete,
-	get_next
+	get_next,
+	release_iterator,
+	bulk_insert
 };
 
 /****************************************************************************
@@ -309,10 +365,17 @@ index_api_t index_bplustree = {
  ****************************************************************************/
 int compare(const void *p1, const void *p2)
 {
-	if (((pair_t *)p1)->key <= ((pair_t *)p2)->key) {
-		return -1;
+	const pair_t *a = (const pair_t *)p1;
+	const pair_t *b = (const pair_t *)p2;
+
+	/* Equal keys are ordered by tuple id, which lets a scan resume exactly */
+	if (a->key != b->key) {
+		return a->key < b->key ? -1 : 1;
 	}
-	return 1;
+	if (a->value != b->value) {
+		return a->value < b->value ? -1 : 1;
+	}
+	return 0;
 }
 
 /****************************************************************************
@@ -389,8 +452,8 @@ static db_result_t create(index_t *index)
 		return result;
 
 	}
-	storage_write_to(tree->tree_storage, tree, offset, sizeof(tree_t));
-	offset += sizeof(tree_t);
+	tree_write_header(tree);
+	offset += sizeof(tree_header_t);
 	storage_write_to(tree->tree_storage, bucket_filename, offset, sizeof(bucket_filename));
 	offset += sizeof(bucket_filename);
 	base_offset = offset;
@@ -498,6 +561,7 @@ static db_result_t create(index_t *index)
 		result = DB_STORAGE_ERROR;
 		return result;
 	}
+	tree_write_header(tree);
 
 	DB_LOG_D("DB: Created a bplus-tree index\n");
 	result = DB_OK;
@@ -516,7 +580,8 @@ static db_result_t destroy(index_t *index)
 	if (fd < 0) {
 		return DB_STORAGE_ERROR;
 	}
-	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_t), sizeof(bucket_file)))) {
+	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_header_t), sizeof(bucket_file)))) {
+		storage_close(fd);
 		return DB_STORAGE_ERROR;
 	}
 	storage_close(fd);
@@ -547,13 +612,16 @@ static db_result_t load(index_t *index)
 		DB_LOG_E("Failed opening index descriptor file\n");
 		goto storage_error;
 	}
-	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_t), sizeof(bucket_file)))) {
-		DB_LOG_E("Failed reading bucket file\n");
+	result = tree_read_header(tree, fd);
+	if (DB_ERROR(result)) {
+		DB_LOG_E("Failed  reading tree structure from descriptor file\n");
 		storage_close(fd);
-		goto storage_error;
+		free(tree);
+		index->opaque_data = NULL;
+		return result;
 	}
-	if (DB_ERROR(storage_read_from(fd, tree, 0, sizeof(tree_t)))) {
-		DB_LOG_E("Failed  reading tree structure from descriptor file\n");
+	if (DB_ERROR(storage_read_from(fd, bucket_file, sizeof(tree_header_t), sizeof(bucket_file)))) {
+		DB_LOG_E("Failed reading bucket file\n");
 		storage_close(fd);
 		goto storage_error;
 	}
@@ -628,7 +696,7 @@ static db_result_t load(index_t *index)
 		return result;
 	}
 
-	base_offset = sizeof(tree_t) + sizeof(bucket_file);
+	base_offset = sizeof(tree_header_t) + sizeof(bucket_file);
 	tree->tree_storage = storage_open(index->descriptor_file, O_RDWR);
 	tree->bucket_storage = storage_open(bucket_file, O_RDWR);
 
@@ -637,14 +705,10 @@ static db_result_t load(index_t *index)
 	return DB_OK;
 
 storage_error:
+	/* The caches are not allocated yet */
 	DB_LOG_E("DB: Storage error while loading index\n");
-	free(tree->node_cache->in_cache.head);
-	free(tree->node_cache->in_cache.tail);
-	free(tree->buck_cache->in_cache.head);
-	free(tree->buck_cache->in_cache.tail);
-	free(tree->buck_cache);
-	free(tree->node_cache);
 	free(tree);
+	index->opaque_data = NULL;
 	return DB_STORAGE_ERROR;
 
 }
@@ -667,7 +731,7 @@ static db_result_t release(index_t *index)
 	if ((tree->buck_cache->in_cache.tail == NULL) || (tree->buck_cache->in_cache.head == NULL)) {
 		return DB_ALLOCATION_ERROR;
 	}
-	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
+	tree_write_header(tree);
 
 	/* Bucket Cache being flushed */
 	tmp_node = tree->buck_cache->in_cache.head->next;
@@ -715,7 +779,6 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 {
 	tree_t *tree;
 	long long_key;
-	qnode_t *tmp_node;
 
 	tree = (tree_t *)index->opaque_data;
 	long_key = db_value_to_long(key);
@@ -726,29 +789,66 @@ static db_result_t insert(index_t *index, attribute_value_t *key, tuple_id_t val
 		value = value - DB_TUPLES_LIMIT / 2;
 	}
 #endif
-	if (insert_item_btree(tree, (int)long_key, (int)value) == TREE_INSERT_FAIL) {
+	if (insert_item_btree(tree, long_key, value) != TREE_OK) {
 		DB_LOG_E("DB: Failed to insert key %ld into a bplus-tree index\n", long_key);
 		return DB_INDEX_ERROR;
 	}
-	storage_write_to(tree->tree_storage, tree, 0, sizeof(tree_t));
+	cache_flush(tree);
 
-	/* Bucket Cache being flushed */
-	tmp_node = tree->buck_cache->in_cache.head->next;
-	while (tmp_node != tree->buck_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			bucket_write(tree, tmp_node->id, &(tree->buck_cache->cache_t[tmp_node->pos].bucket));
-			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
-		}
-		tmp_node = tmp_node->next;
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: bulk_insert
+ *
+ * Description: Inserts the keys of count consecutive tuples at once.
+ *              The keys are sorted first. An empty tree is then built
+ *              bottom-up by tree_build, otherwise the sorted keys are
+ *              inserted one by one, which keeps consecutive insertions
+ *              in the same bucket and node cache entries.
+ *
+ ****************************************************************************/
+static db_result_t bulk_insert(index_t *index, attribute_value_t *keys, unsigned stride, tuple_id_t first_id, tuple_id_t count)
+{
+	tree_t *tree;
+	pair_t *pairs;
+	tuple_id_t i;
+	tree_result_t result;
+	bool built;
+
+	tree = (tree_t *)index->opaque_data;
+
+	pairs = (pair_t *)malloc(sizeof(pair_t) * count);
+	if (pairs == NULL) {
+		return DB_ALLOCATION_ERROR;
 	}
-	tmp_node = tree->node_cache->in_cache.head->next;
-	while (tmp_node != tree->node_cache->in_cache.tail) {
-		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
-			tree_write(tree, tmp_node->id, &(tree->node_cache->cache_t[tmp_node->pos].node));
-			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
+	for (i = 0; i < count; i++) {
+		pairs[i].key = db_value_to_long(&keys[i * stride]);
+		pairs[i].value = first_id + i;
+	}
+	qsort(pairs, count, sizeof(pair_t), compare);
+
+	rw_lock_write(&(tree->tree_lock));
+	built = tree->inserted == 0 && tree->deleted == 0 && tree->off_buckets <= 1;
+	if (built) {
+		result = tree_build(tree, pairs, count);
+	}
+	tree_unlock_write(tree);
+
+	if (!built) {
+		result = TREE_OK;
+		for (i = 0; i < count && result == TREE_OK; i++) {
+			result = insert_item_btree(tree, pairs[i].key, pairs[i].value);
 		}
-		tmp_node = tmp_node->next;
 	}
+	free(pairs);
+
+	if (result != TREE_OK) {
+		DB_LOG_E("DB: Failed to bulk insert %lu keys into a bplus-tree index\n", (unsigned long)count);
+		return DB_INDEX_ERROR;
+	}
+
+	cache_flush(tree);
 
 	return DB_OK;
 }
@@ -776,145 +876,372 @@ static uint16_t next_bucket(tree_t *tree, bucket_t *bucket)
 	return next_bucket;
 }
 
+/****************************************************************************
+ * Name: get_key_range
+ *
+ * Description: Helper function for get_next.
+ *              Converts the bounds of the iterator into an inclusive range
+ *              of keys stored in the tree. Returns false when the range
+ *              cannot hold any key.
+ *
+ ****************************************************************************/
+static bool get_key_range(index_iterator_t *iterator, long *key_min, long *key_max)
+{
+	long min_value;
+	long max_value;
+
+	min_value = db_value_to_long(&iterator->min_value);
+	max_value = db_value_to_long(&iterator->max_value);
+
+	/* Keys are integers, so an exclusive bound is the adjacent inclusive one */
+	if (iterator->flags & INDEX_ITERATOR_MIN_EXCLUSIVE) {
+		if (min_value == LONG_MAX) {
+			return false;
+		}
+		min_value++;
+	}
+	if (iterator->flags & INDEX_ITERATOR_MAX_EXCLUSIVE) {
+		if (max_value == LONG_MIN) {
+			return false;
+		}
+		max_value--;
+	}
+
+	*key_min = min_value;
+	*key_max = max_value;
+
+	return min_value <= max_value;
+}
+
+/****************************************************************************
+ * Name: tree_unlock_write
+ *
+ * Description: Releases the tree write lock. The writer may have split
+ *              buckets or moved tuples, so the generation is advanced to
+ *              make selections holding a bucket snapshot descend the tree
+ *              again instead of following a stale bucket chain.
+ *
+ ****************************************************************************/
+static void tree_unlock_write(tree_t *tree)
+{
+	tree->generation++;
+	rw_unlock_write(&(tree->tree_lock));
+}
+
+/****************************************************************************
+ * Name: bucket_flag_lock
+ *
+ * Description: Helper function for get_next.
+ *              Waits until no other task is editing the bucket and marks it
+ *              as being edited.
+ *
+ ****************************************************************************/
+static void bucket_flag_lock(tree_t *tree, uint16_t bucket_id)
+{
+	pthread_mutex_lock(&(tree->bucket_lock));
+	while (tree->lock_buckets[bucket_id] == 1) {
+		pthread_mutex_unlock(&(tree->bucket_lock));
+		DB_LOG_D("BUCKET ALREADY LOCKED IN GET NEXT SPINNING\n");
+		pthread_mutex_lock(&(tree->bucket_lock));
+	}
+	tree->lock_buckets[bucket_id] = 1;
+	pthread_mutex_unlock(&(tree->bucket_lock));
+}
+
+static void bucket_flag_unlock(tree_t *tree, uint16_t bucket_id)
+{
+	pthread_mutex_lock(&(tree->bucket_lock));
+	tree->lock_buckets[bucket_id] = 0;
+	pthread_mutex_unlock(&(tree->bucket_lock));
+}
+
+/****************************************************************************
+ * Name: end_iteration
+ *
+ * Description: Helper function for get_next.
+ *              Marks the iteration as finished and releases the iteration
+ *              state, and the tree write lock held by a removal.
+ *
+ ****************************************************************************/
+static void end_iteration(tree_t *tree, index_iterator_t *iterator)
+{
+	iteration_cache_t *cache = (iteration_cache_t *)iterator->opaque_data;
+
+	iterator->flags &= ~INDEX_ITERATOR_ACTIVE;
+	iterator->flags |= INDEX_ITERATOR_FINISHED;
+	if (cache->exclusive) {
+		tree_unlock_write(tree);
+	}
+	free(cache);
+	iterator->opaque_data = NULL;
+}
+
+/****************************************************************************
+ * Name: take_snapshot
+ *
+ * Description: Helper function for get_next.
+ *              Copies a bucket for a selection under the tree read lock and
+ *              sorts the copy by key. The bucket is found by descending the
+ *              tree with the given key on the first call, and again whenever
+ *              a writer released the tree since the previous snapshot.
+ *              Otherwise the given bucket of the chain is copied.
+ *
+ ****************************************************************************/
+static bool take_snapshot(tree_t *tree, iteration_cache_t *cache, tree_key_t key, uint16_t bucket_id, bool descend)
+{
+	pair_t *path;
+	bucket_t *bucket;
+	bool busy;
+	int retries = 0;
+
+	rw_lock_read(&(tree->tree_lock));
+	if (descend || cache->generation != tree->generation) {
+		/* Back off while another task edits the bucket */
+		while ((path = tree_find(tree, key, &busy)) == NULL) {
+			rw_unlock_read(&(tree->tree_lock));
+			if (!busy) {
+				DB_LOG_E("DB: Failed to find the bucket of the selection\n");
+				return false;
+			}
+			if (++retries >= DB_TREE_BUSY_RETRIES) {
+				DB_LOG_E("DB: Bucket of the selection stayed busy\n");
+				return false;
+			}
+			usleep(DB_TREE_BUSY_WAIT_US);
+			rw_lock_read(&(tree->tree_lock));
+		}
+		bucket_id = path[tree->levels].key;
+		free(path);
+	} else {
+		bucket_flag_lock(tree, bucket_id);
+	}
+
+	bucket = bucket_read(tree, bucket_id);
+	if (bucket != NULL) {
+		memcpy(&cache->snapshot, bucket, sizeof(bucket_t));
+		modify_cache(tree, bucket_id, BUCKET, UNLOCK);
+	}
+	bucket_flag_unlock(tree, bucket_id);
+	cache->generation = tree->generation;
+	rw_unlock_read(&(tree->tree_lock));
+
+	if (bucket == NULL) {
+		return false;
+	}
+
+	qsort(cache->snapshot.pairs, cache->snapshot.next_free_slot, sizeof(pair_t), compare);
+	cache->bucket = &cache->snapshot;
+	cache->bucket_id = bucket_id;
+	cache->start = 0;
+	cache->end = cache->snapshot.next_free_slot;
+
+	return true;
+}
+
 /****************************************************************************
  * Name: get_next
  *
  * Description: Returns the tuple id of the next valid tuple for the case of
- *              select and remove queries
+ *              select and remove queries.
+ *              The first call descends the tree to the bucket holding the
+ *              lower bound of the range, later calls follow the bucket chain
+ *              in increasing order of keys until a bucket starts above the
+ *              upper bound.
+ *              A removal keeps the tree write locked for the duration of the
+ *              iteration. A selection only read locks the tree while it
+ *              copies each bucket, so selections run side by side and
+ *              writers are not held off for a whole query. When a writer
+ *              changed the tree in between, the selection resumes after the
+ *              last pair it returned.
  *
  ****************************************************************************/
 static tuple_id_t get_next(index_iterator_t *iterator, uint8_t matched_condition)
 {
-
-	/* This cache holds a pointer to a bucket in the main cache and other
-	 * information required to iterate over the bucket
-	 */
-	struct iteration_cache {
-		index_iterator_t *index_iterator;
-		uint16_t bucket_id;
-		bucket_t *bucket;
-		tuple_id_t found_items;
-		uint8_t start;
-		uint8_t end;
-	};
 	int i;
-	static struct iteration_cache cache;
-	uint16_t key_max;
-	uint16_t key_min;
+	long key_min;
+	long key_max;
+	tree_key_t key;
+	pair_t pair;
+	uint16_t bucket_id;
+	pair_t *path;
 	tree_t *tree;
-	key_min = *(int *)&iterator->min_value;
-	key_max = *(int *)&iterator->max_value;
+	iteration_cache_t *cache;
+
+	if (iterator->flags & INDEX_ITERATOR_FINISHED) {
+		return INVALID_TUPLE;
+	}
+
 	tree = (tree_t *)iterator->index->opaque_data;
+	if (!get_key_range(iterator, &key_min, &key_max)) {
+		iterator->flags |= INDEX_ITERATOR_FINISHED;
+		return INVALID_TUPLE;
+	}
 
-	/* To initialize the iterator_cache */
-	if (iterator->next_item_no == 0) {	/* removed the condition of iterator inequality */
-		if (iterator->found_items == 0) {
+	/* To initialize the iteration cache */
+	if (!(iterator->flags & INDEX_ITERATOR_ACTIVE)) {
+		cache = (iteration_cache_t *)malloc(sizeof(iteration_cache_t));
+		if (cache == NULL) {
+			DB_LOG_E("DB: Failed to allocate the iteration cache\n");
+			return INVALID_TUPLE;
+		}
+		cache->exclusive = (matched_condition == FALSE);
+		cache->resume = false;
+
+		if (!cache->exclusive) {
+			if (!take_snapshot(tree, cache, key_min, 0, true)) {
+				free(cache);
+				return INVALID_TUPLE;
+			}
+		} else {
 			rw_lock_write(&(tree->tree_lock));
-			pair_t *path = tree_find(tree, key_min);
+			path = tree_find(tree, key_min, NULL);
 			if (path == NULL) {
+				tree_unlock_write(tree);
+				free(cache);
 				return INVALID_TUPLE;
 			}
-			uint16_t bucket_id = path[tree->levels].key;
+			bucket_id = path[tree->levels].key;
 			free(path);
-			/* TODO
-			 * Absent of non-cast return handling, should be taken care in the definition
-			 */
-			cache.bucket = bucket_read(tree, bucket_id);
-			cache.bucket_id = bucket_id;
-			cache.start = 0;
-			cache.end = cache.bucket->next_free_slot;
+
+			cache->bucket = bucket_read(tree, bucket_id);
+			if (cache->bucket == NULL) {
+				bucket_flag_unlock(tree, bucket_id);
+				tree_unlock_write(tree);
+				free(cache);
+				return INVALID_TUPLE;
+			}
+			cache->bucket_id = bucket_id;
+			cache->start = 0;
+			cache->end = cache->bucket->next_free_slot;
 		}
+		iterator->opaque_data = cache;
+		iterator->flags |= INDEX_ITERATOR_ACTIVE;
 	}
+	cache = (iteration_cache_t *)iterator->opaque_data;
+
+	while (true) {
+		/* Iterate over the key-value pairs in the bucket and find the ones which satisfy the condition */
+		for (i = cache->start; i < cache->end; i++) {
+			pair = cache->bucket->pairs[i];
+			if (pair.key < key_min || pair.key > key_max) {
+				continue;
+			}
+			/* Skip what was returned before the tree changed under a selection */
+			if (cache->resume && compare(&pair, &cache->last) <= 0) {
+				continue;
+			}
 
-	/* Iterate over the key-value pairs in the bucket and find the ones which satisfy the condition */
-	for (i = cache.start; i < cache.end; i++) {
-		if ((key_min <= cache.bucket->pairs[i].key) && (cache.bucket->pairs[i].key <= key_max)) {
 			iterator->found_items++;
 			iterator->next_item_no = iterator->found_items;
 
 			/* matched condition is FALSE when the query is for remove tuples */
-			if (matched_condition == FALSE) {
-				tuple_id_t tmp = cache.bucket->pairs[i].value;
-				if (cache.end > (i + 1)) {
-					cache.bucket->pairs[i] = cache.bucket->pairs[cache.end - 1];
+			if (cache->exclusive) {
+				if (cache->end > (i + 1)) {
+					cache->bucket->pairs[i] = cache->bucket->pairs[cache->end - 1];
 
 					/* Start Bucket chaining */
 					int iter = 0;
-					uint16_t new_min = cache.bucket->info[1];
-					uint16_t new_max = cache.bucket->info[2];
-					for (; iter < cache.bucket->next_free_slot - 1; iter++) {
-						new_min = min(cache.bucket->pairs[iter].key, new_min);
-						new_max = max(cache.bucket->pairs[iter].key, new_max);
+					tree_key_t new_min = cache->bucket->info[1];
+					tree_key_t new_max = cache->bucket->info[2];
+					for (; iter < cache->bucket->next_free_slot - 1; iter++) {
+						new_min = min(cache->bucket->pairs[iter].key, new_min);
+						new_max = max(cache->bucket->pairs[iter].key, new_max);
 					}
-					cache.bucket->info[1] = new_min;
-					cache.bucket->info[2] = new_max;
+					cache->bucket->info[1] = new_min;
+					cache->bucket->info[2] = new_max;
 					/* End of Bucket chaining */
 				}
 
-				cache.bucket->next_free_slot--;
+				cache->bucket->next_free_slot--;
 				tree->deleted++;
-				cache.end--;
-				cache.start = i;
-				return tmp;
+				cache->end--;
+				cache->start = i;
 			} else {
-				cache.start = i + 1;
+				cache->start = i + 1;
+				cache->last = pair;
+				cache->resume = true;
 			}
-			return cache.bucket->pairs[i].value;
+			return pair.value;
 		}
-	}
 
-	/* case when delete query comes */
-	if (matched_condition == FALSE) {
-		modify_cache(tree, cache.bucket_id, BUCKET, INVALIDATE);
-		cache_write_bucket(tree, cache.bucket_id, cache.bucket);
-		if ((double)(tree->deleted) / tree->inserted >= VACUUM_THRESHOLD) {
-			vacuum(tree, iterator->index->rel);
-		}
-	} else {
-		modify_cache(tree, cache.bucket_id, BUCKET, UNLOCK);
-	}
-	pthread_mutex_lock(&(tree->bucket_lock));
-	tree->lock_buckets[cache.bucket_id] = 0;
-	cache.bucket_id = next_bucket(tree, cache.bucket);
-	if (cache.bucket_id == (uint16_t)-1) {
-		if (iterator->found_items == 0) {
-			iterator->next_item_no = 0;
+		/* The bucket is exhausted, release it and move on to the next one in the chain */
+		bucket_id = next_bucket(tree, cache->bucket);
+		if (!cache->exclusive) {
+			if (bucket_id == (uint16_t)-1) {
+				end_iteration(tree, iterator);
+				return INVALID_TUPLE;
+			}
+			/* A descent after a split starts from the largest key seen so far so that the scan moves forward */
+			key = cache->resume ? cache->last.key : key_min;
+			if (cache->end > 0 && cache->snapshot.pairs[cache->end - 1].key > key) {
+				key = cache->snapshot.pairs[cache->end - 1].key;
+			}
+			if (!take_snapshot(tree, cache, key, bucket_id, false)) {
+				end_iteration(tree, iterator);
+				return INVALID_TUPLE;
+			}
 		} else {
-			iterator->next_item_no = 1;
+			modify_cache(tree, cache->bucket_id, BUCKET, INVALIDATE);
+			cache_write_bucket(tree, cache->bucket_id, cache->bucket);
+			if ((double)(tree->deleted) / tree->inserted >= VACUUM_THRESHOLD) {
+				vacuum(tree, iterator->index->rel);
+			}
+			bucket_flag_unlock(tree, cache->bucket_id);
+			if (bucket_id == (uint16_t)-1) {
+				end_iteration(tree, iterator);
+				return INVALID_TUPLE;
+			}
+			bucket_flag_lock(tree, bucket_id);
+
+			/* TODO
+			 * Absent of non-cast return handling, should be taken care in the definition
+			 */
+			cache->bucket_id = bucket_id;
+			cache->bucket = bucket_read(tree, bucket_id);
+			if (cache->bucket == NULL) {
+				bucket_flag_unlock(tree, bucket_id);
+				end_iteration(tree, iterator);
+				return INVALID_TUPLE;
+			}
+			cache->start = 0;
+			cache->end = cache->bucket->next_free_slot;
+		}
+
+		/* Buckets are chained in increasing order of keys, so no later bucket can hold a key in range */
+		if (cache->bucket->next_free_slot > 0 && cache->bucket->info[1] > key_max) {
+			if (cache->exclusive) {
+				modify_cache(tree, cache->bucket_id, BUCKET, UNLOCK);
+				bucket_flag_unlock(tree, cache->bucket_id);
+			}
+			end_iteration(tree, iterator);
+			return INVALID_TUPLE;
 		}
-		pthread_mutex_unlock(&(tree->bucket_lock));
-		rw_unlock_write(&(tree->tree_lock));
-		return INVALID_TUPLE;
-	}
-	while (tree->lock_buckets[cache.bucket_id] == 1) {
-		pthread_mutex_unlock(&(tree->bucket_lock));
-		DB_LOG_D("BUCKET ALREADY LOCKED IN GET NEXT SPINNING\n");
-		pthread_mutex_lock(&(tree->bucket_lock));
 	}
-	tree->lock_buckets[cache.bucket_id] = 1;
-	pthread_mutex_unlock(&(tree->bucket_lock));
+}
 
-	cache.start = 0;
-	cache.end = cache.bucket->next_free_slot;
+/****************************************************************************
+ * Name: release_iterator
+ *
+ * Description: Releases the bucket and the tree lock held by an iteration
+ *              which was abandoned before get_next reached its end.
+ *
+ ****************************************************************************/
+static void release_iterator(index_iterator_t *iterator)
+{
+	tree_t *tree;
+	iteration_cache_t *cache;
 
-	/* TODO
-	 * Absent of non-cast return handling, should be taken care in the definition
-	 */
-	cache.bucket = bucket_read(tree, cache.bucket_id);
-	if (cache.bucket->info[1] > key_max) {
-		modify_cache(tree, cache.bucket_id, BUCKET, UNLOCK);
-		if (iterator->found_items == 0) {
-			iterator->next_item_no = 0;
-		} else {
-			iterator->next_item_no = 1;
-		}
-		pthread_mutex_unlock(&(tree->bucket_lock));
-		rw_unlock_write(&(tree->tree_lock));
-		return INVALID_TUPLE;
+	if (!(iterator->flags & INDEX_ITERATOR_ACTIVE)) {
+		return;
+	}
 
+	tree = (tree_t *)iterator->index->opaque_data;
+	cache = (iteration_cache_t *)iterator->opaque_data;
+	if (cache->exclusive) {
+		modify_cache(tree, cache->bucket_id, BUCKET, UNLOCK);
+		bucket_flag_unlock(tree, cache->bucket_id);
 	}
-	iterator->next_item_no = 1;
-	return get_next(iterator, matched_condition);
+	end_iteration(tree, iterator);
 }
 
 /****************************************************************************
@@ -1040,6 +1367,11 @@ static cache_result_t modify_cache(tree_t *tree, int id, cache_type_t cache, op_
 	}
 	if (temp == end) {
 		DB_LOG_E("PANIC CACHE OPERATION FOR A NON EXISTENT ENTRY\n");
+		if (cache == NODE) {
+			pthread_mutex_unlock(&(tree->node_cache_lock));
+		} else {
+			pthread_mutex_unlock(&(tree->buck_cache_lock));
+		}
 		return CACHE_NOT_EXIST;
 	}
 	if (cache == NODE) {
@@ -1189,6 +1521,121 @@ static cache_result_t cache_write_bucket(tree_t *tree, int id, bucket_t *bucket)
 	return CACHE_OK;
 }
 
+/****************************************************************************
+ * Name: tree_write_header
+ *
+ * Description: Saves the tree metadata at the start of the descriptor file,
+ *              tagged with the layout version.
+ *
+ ****************************************************************************/
+static int tree_write_header(tree_t *tree)
+{
+	tree_header_t header;
+
+	memset(&header, 0, sizeof(tree_header_t));
+	header.magic = TREE_MAGIC;
+	header.version = TREE_LAYOUT_VERSION;
+	header.key_size = sizeof(tree_key_t);
+	header.off_nodes = tree->off_nodes;
+	header.off_buckets = tree->off_buckets;
+	header.root = tree->root;
+	header.levels = tree->levels;
+	header.inserted = tree->inserted;
+	header.deleted = tree->deleted;
+
+	return storage_write_to(tree->tree_storage, &header, 0, sizeof(tree_header_t));
+}
+
+/****************************************************************************
+ * Name: tree_read_header
+ *
+ * Description: Restores the tree metadata from the descriptor file. An index
+ *              saved in another layout, including the older 16-bit one which
+ *              has no header, is reported as inconsistent so that the index
+ *              manager rebuilds it.
+ *
+ ****************************************************************************/
+static db_result_t tree_read_header(tree_t *tree, db_storage_id_t fd)
+{
+	tree_header_t header;
+
+	if (DB_ERROR(storage_read_from(fd, &header, 0, sizeof(tree_header_t)))) {
+		return DB_STORAGE_ERROR;
+	}
+	if (header.magic != TREE_MAGIC || header.version != TREE_LAYOUT_VERSION || header.key_size != sizeof(tree_key_t)) {
+		DB_LOG_E("DB: Index layout %u with %u-byte keys is not supported\n", header.magic == TREE_MAGIC ? header.version : 0, header.key_size);
+		return DB_INCONSISTENCY_ERROR;
+	}
+
+	tree->off_nodes = header.off_nodes;
+	tree->off_buckets = header.off_buckets;
+	tree->root = header.root;
+	tree->levels = header.levels;
+	tree->inserted = header.inserted;
+	tree->deleted = header.deleted;
+	memset(&tree->lock_buckets, 0, sizeof(tree->lock_buckets));
+
+	return DB_OK;
+}
+
+/****************************************************************************
+ * Name: cache_flush
+ *
+ * Description: Writes the dirty entries of both caches to flash, keeping
+ *              them cached. Called after each insertion so that the index
+ *              on flash stays consistent with the tuple file.
+ *
+ ****************************************************************************/
+static void cache_flush(tree_t *tree)
+{
+	qnode_t *tmp_node;
+
+	tree_write_header(tree);
+
+	/* Bucket Cache being flushed */
+	tmp_node = tree->buck_cache->in_cache.head->next;
+	while (tmp_node != tree->buck_cache->in_cache.tail) {
+		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
+			bucket_write(tree, tmp_node->id, &(tree->buck_cache->cache_t[tmp_node->pos].bucket));
+			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
+		}
+		tmp_node = tmp_node->next;
+	}
+	tmp_node = tree->node_cache->in_cache.head->next;
+	while (tmp_node != tree->node_cache->in_cache.tail) {
+		if ((tmp_node->node_state & NODE_STATE_DIRTY) && (tmp_node->node_state & NODE_STATE_VALID)) {
+			tree_write(tree, tmp_node->id, &(tree->node_cache->cache_t[tmp_node->pos].node));
+			UNSET_NODE_STATE(tmp_node, NODE_STATE_DIRTY);
+		}
+		tmp_node = tmp_node->next;
+	}
+}
+
+/****************************************************************************
+ * Name: cache_invalidate
+ *
+ * Description: Drops every entry of both caches without writing it back.
+ *              Used when the nodes and buckets on flash are rewritten as a
+ *              whole by tree_build.
+ *
+ ****************************************************************************/
+static void cache_invalidate(tree_t *tree)
+{
+	qnode_t *tmp_node;
+
+	pthread_mutex_lock(&(tree->buck_cache_lock));
+	for (tmp_node = tree->buck_cache->in_cache.head->next; tmp_node != tree->buck_cache->in_cache.tail; tmp_node = tmp_node->next) {
+		UNSET_NODE_STATE(tmp_node, NODE_STATE_VALID | NODE_STATE_DIRTY | NODE_STATE_LOCK);
+	}
+	pthread_mutex_unlock(&(tree->buck_cache_lock));
+
+	pthread_mutex_lock(&(tree->node_cache_lock));
+	for (tmp_node = tree->node_cache->in_cache.head->next; tmp_node != tree->node_cache->in_cache.tail; tmp_node = tmp_node->next) {
+		UNSET_NODE_STATE(tmp_node, NODE_STATE_VALID | NODE_STATE_DIRTY | NODE_STATE_LOCK);
+	}
+	pthread_mutex_unlock(&(tree->node_cache_lock));
+}
+
 /****************************************************************************
  * Name: transform_key
  *
@@ -1197,7 +1644,7 @@ static cache_result_t cache_write_bucket(tree_t *tree, int id, bucket_t *bucket)
  *              some codes will be added in future.
  *
  ****************************************************************************/
-static int transform_key(int key)
+static tree_key_t transform_key(tree_key_t key)
 {
 	return key;
 }
@@ -1315,10 +1762,10 @@ static int bucket_write(tree_t *tree, int pos, bucket_t *bucket)
  * Name: tree_insert
  *
  * Description: Initialises the bplus tree by putting a dummy entry with
- *              value max(uint16_t) and two buckets
+ *              value KEY_MAX and two buckets
  *
  ****************************************************************************/
-static tree_result_t tree_insert(tree_t *tree, int max)
+static tree_result_t tree_insert(tree_t *tree, tree_key_t max)
 {
 	int i = tree->off_nodes;
 	tree_node_t *node;
@@ -1344,23 +1791,122 @@ static tree_result_t tree_insert(tree_t *tree, int max)
 	return TREE_OK;
 }
 
+/****************************************************************************
+ * Name: tree_build
+ *
+ * Description: Builds the tree bottom-up from count pairs sorted by key,
+ *              replacing the empty tree made by tree_insert. Buckets are
+ *              filled completely and chained in key order, then each level
+ *              of nodes gets at most BRANCH_FACTOR children, spread evenly,
+ *              until a single root node remains. Every separator is the
+ *              largest key of the child on its left, as tree_split leaves it.
+ *
+ ****************************************************************************/
+static tree_result_t tree_build(tree_t *tree, pair_t *pairs, int count)
+{
+	bucket_t bucket;
+	tree_node_t node;
+	uint16_t ids[CONFIG_BUCKETS_LIMIT];
+	tree_key_t keys[CONFIG_BUCKETS_LIMIT];
+	int num_buckets;
+	int num_children;
+	int num_nodes;
+	int start;
+	int end;
+	int i;
+	int j;
+
+	num_buckets = (count + BUCKET_SIZE - 1) / BUCKET_SIZE;
+	if (num_buckets == 0 || num_buckets > CONFIG_BUCKETS_LIMIT - 1) {
+		DB_LOG_E("TREE FULL !");
+		return TREE_INSERT_FAIL;
+	}
+
+	/* Entries cached for the empty tree would shadow the new nodes and buckets */
+	cache_invalidate(tree);
+
+	for (i = 0; i < num_buckets; i++) {
+		start = i * BUCKET_SIZE;
+		end = min(count, start + BUCKET_SIZE);
+		memset(&bucket, 0, sizeof(bucket_t));
+		memcpy(bucket.pairs, &pairs[start], sizeof(pair_t) * (end - start));
+		bucket.next_free_slot = end - start;
+		/* Start Bucket chaining */
+		bucket.info[0] = (i + 1 < num_buckets) ? i + 1 : CONFIG_BUCKETS_LIMIT - 1;
+		bucket.info[1] = pairs[start].key;
+		bucket.info[2] = pairs[end - 1].key;
+		/* End of Bucket chaining */
+		if (!bucket_write(tree, i, &bucket)) {
+			return TREE_INSERT_FAIL;
+		}
+		ids[i] = i;
+		keys[i] = pairs[end - 1].key;
+	}
+
+	/* Build the levels of nodes from the leaves up to the root */
+	tree->off_nodes = 0;
+	tree->levels = 1;
+	num_children = num_buckets;
+	do {
+		num_nodes = (num_children + BRANCH_FACTOR - 1) / BRANCH_FACTOR;
+		if (tree->off_nodes + num_nodes > CONFIG_NODE_LIMIT) {
+			DB_LOG_E("TREE FULL !");
+			return TREE_INSERT_FAIL;
+		}
+		for (i = 0; i < num_nodes; i++) {
+			start = i * num_children / num_nodes;
+			end = (i + 1) * num_children / num_nodes;
+			memset(&node, 0, sizeof(tree_node_t));
+			node.is_leaf = (tree->levels == 1);
+			node.val[BRANCH_FACTOR - 1] = end - start - 1;
+			for (j = start; j < end; j++) {
+				node.id[j - start] = ids[j];
+				if (j < end - 1) {
+					node.val[j - start] = keys[j];
+				}
+			}
+			if (!tree_write(tree, tree->off_nodes, &node)) {
+				return TREE_INSERT_FAIL;
+			}
+			ids[i] = tree->off_nodes++;
+			keys[i] = keys[end - 1];
+		}
+		num_children = num_nodes;
+		tree->levels++;
+	} while (num_nodes > 1);
+
+	tree->root = ids[0];
+	tree->off_buckets = num_buckets;
+	tree->inserted = count;
+
+	return TREE_OK;
+}
+
 /****************************************************************************
  * Name: tree_find
  *
  * Description: Traverses the bplus tree to find the appropriate bucket
- *              for an insertion
+ *              for an insertion and marks the bucket as being edited.
+ *              Returns NULL when a node can not be read or memory runs
+ *              out, or when another task is editing the bucket, in which
+ *              case busy is set if given.
  *
  ****************************************************************************/
-static pair_t *tree_find(tree_t *tree, int key)
+static pair_t *tree_find(tree_t *tree, tree_key_t key, bool *busy)
 {
-	int hashed_key;
+	tree_key_t hashed_key;
 	uint8_t id;
 	tree_node_t *node;
 	int index;
 	hashed_key = transform_key(key);
 	bool iset;
 	int j;
-	pair_t *path = malloc(sizeof(pair_t) * ((tree->levels) + 1));
+	pair_t *path;
+
+	if (busy != NULL) {
+		*busy = false;
+	}
+	path = malloc(sizeof(pair_t) * ((tree->levels) + 1));
 	if (path == NULL) {
 		return NULL;
 	}
@@ -1375,6 +1921,7 @@ static pair_t *tree_find(tree_t *tree, int key)
 		 */
 		node = tree_read(tree, id);
 		if (node == NULL) {
+			free(path);
 			return NULL;
 		}
 		index = id;
@@ -1398,6 +1945,10 @@ static pair_t *tree_find(tree_t *tree, int key)
 			if (tree->lock_buckets[node->id[index]]) {
 				pthread_mutex_unlock(&(tree->bucket_lock));
 				modify_cache(tree, id, NODE, UNLOCK);
+				free(path);
+				if (busy != NULL) {
+					*busy = true;
+				}
 				return NULL;
 			} else {
 				tree->lock_buckets[node->id[index]] = 1;
@@ -1444,14 +1995,14 @@ void tree_print(tree_t *tree, int id)
 			bucket = bucket_read(tree, node->id[i]);
 			DB_LOG_V("Bucket id:%d\n", node->id[i]);
 			for (j = 0; j < bucket->next_free_slot; j++) {
-				DB_LOG_V("Key %d, Value %d\n", bucket->pairs[j].key, bucket->pairs[j].value);
+				DB_LOG_V("Key %ld, Value %lu\n", bucket->pairs[j].key, (unsigned long)bucket->pairs[j].value);
 			}
 			modify_cache(tree, node->id[i], BUCKET, UNLOCK);
 		}
 		bucket = bucket_read(tree, node->id[node->val[BRANCH_FACTOR - 1]]);
 		DB_LOG_D("Bucket id:%d\n", node->id[node->val[BRANCH_FACTOR - 1]]);
 		for (j = 0; j < bucket->next_free_slot; j++) {
-			DB_LOG_V("Key %d, Value %d\n", bucket->pairs[j].key, bucket->pairs[j].value);
+			DB_LOG_V("Key %ld, Value %lu\n", bucket->pairs[j].key, (unsigned long)bucket->pairs[j].value);
 		}
 		modify_cache(tree, node->id[node->val[BRANCH_FACTOR - 1]], BUCKET, UNLOCK);
 
@@ -1590,7 +2141,7 @@ static cache_result_t cache_bucket_append(tree_t *tree, int bucket_id, pair_t *p
  *              i.e. higher nodes are split then the lower nodes are split.
  *
  ****************************************************************************/
-static tsplit_status_t tree_split(tree_t *tree, int key, int id, pair_t *path, int level)
+static tsplit_status_t tree_split(tree_t *tree, tree_key_t key, int id, pair_t *path, int level)
 {
 	if (level < 0 || level > (tree->levels - 1)) {
 		DB_LOG_E("PANIC: Tree level out of bounds\n");
@@ -1658,7 +2209,7 @@ static tsplit_status_t tree_split(tree_t *tree, int key, int id, pair_t *path, i
 		int res;
 		int nid = tree->off_nodes++;
 		/* Create dummy arrays to facilitate splitting */
-		int key_arr[BRANCH_FACTOR];
+		tree_key_t key_arr[BRANCH_FACTOR];
 		int ids_arr[BRANCH_FACTOR + 1];
 
 		if (tree->off_nodes > CONFIG_NODE_LIMIT) {
@@ -1720,9 +2271,9 @@ static tsplit_status_t tree_split(tree_t *tree, int key, int id, pair_t *path, i
  *              the insertion process of an index entry
  *
  ****************************************************************************/
-static bsplit_status_t bucket_split(tree_t *tree, int key, int value, pair_t *path)
+static bsplit_status_t bucket_split(tree_t *tree, tree_key_t key, tuple_id_t value, pair_t *path)
 {
-	int median;
+	tree_key_t median;
 	bucket_t *bucket;
 	uint16_t bucket_id = path[tree->levels].key;
 	int i;
@@ -1796,20 +2347,25 @@ static bsplit_status_t bucket_split(tree_t *tree, int key, int value, pair_t *pa
  *              routines defined above.
  *
  ****************************************************************************/
-tree_result_t insert_item_btree(tree_t *tree, int key, int value)
+tree_result_t insert_item_btree(tree_t *tree, tree_key_t key, tuple_id_t value)
 {
 	int bucket_id;
 	pair_t *path;
 	bucket_t *tmp_bucket;
 	int num_entries_bucket = 0;
+	bool busy;
 start:
 	bucket_id = -1;
 	pair_t pair;
 	while (bucket_id < 0) {
 		rw_lock_read(&(tree->tree_lock));
-		path = tree_find(tree, key);
+		path = tree_find(tree, key, &busy);
 		if (path == NULL) {
 			rw_unlock_read(&(tree->tree_lock));
+			if (!busy) {
+				return TREE_READ_FAIL;
+			}
+			usleep(DB_TREE_BUSY_WAIT_US);
 			continue;
 		}
 		bucket_id = path[tree->levels].key;
@@ -1839,18 +2395,18 @@ retry:
 			if (tree->lock_buckets[bucket_id] == 0) {
 				DB_LOG_E("PANIC EDITED BUCKET WITHOUT LOCK\n");
 				pthread_mutex_unlock(&(tree->bucket_lock));
-				rw_unlock_write(&(tree->tree_lock));
+				tree_unlock_write(tree);
 				free(path);
 				return TREE_LOCK_ERROR;
 			} else {
 				tree->lock_buckets[bucket_id] = 0;
 				pthread_mutex_unlock(&(tree->bucket_lock));
-				rw_unlock_write(&(tree->tree_lock));
+				tree_unlock_write(tree);
 			}
 			free(path);
 			return TREE_INSERT_FAIL;
 		} else if (res == BSPLIT_RETRY) {
-			rw_unlock_write(&(tree->tree_lock));
+			tree_unlock_write(tree);
 			goto retry;
 		}
 
@@ -1858,13 +2414,13 @@ retry:
 		if (tree->lock_buckets[bucket_id] == 0) {
 			DB_LOG_E("PANIC EDITED BUCKET WITHOUT LOCK\n");
 			pthread_mutex_unlock(&(tree->bucket_lock));
-			rw_unlock_write(&(tree->tree_lock));
+			tree_unlock_write(tree);
 			free(path);
 			return TREE_LOCK_ERROR;
 		} else {
 			tree->lock_buckets[bucket_id] = 0;
 			pthread_mutex_unlock(&(tree->bucket_lock));
-			rw_unlock_write(&(tree->tree_lock));
+			tree_unlock_write(tree);
 		}
 	} else {
 		/* If the bucket has space for the entry, just append the new entry in the cache */
@@ -1950,7 +2506,7 @@ static int db_flush(tree_t *tree, relation_t *rel)
 			if (tup >= flush_threshold) {
 				storage_get_row(&old_rel, &tup, temp);
 				storage_put_row(rel, temp, FALSE);
-				uint16_t tmp_key = bucket->pairs[num].key;
+				tree_key_t tmp_key = bucket->pairs[num].key;
 				bucket->pairs[ind].key = tmp_key;
 				bucket->pairs[ind].value = num_tuples;
 				num_tuples++;
@@ -1962,8 +2518,8 @@ static int db_flush(tree_t *tree, relation_t *rel)
 		}
 		/* Start Bucket chaining */
 		int iter = 0;
-		uint16_t new_min = bucket->info[1];
-		uint16_t new_max = bucket->info[2];
+		tree_key_t new_min = bucket->info[1];
+		tree_key_t new_max = bucket->info[2];
 		for (; iter < bucket->next_free_slot; iter++) {
 			new_min = min(bucket->pairs[iter].key, new_min);
 			new_max = max(bucket->pairs[iter].key, new_max);
@@ -231,6 +231,8 @@ db_result_t index_load(relation_t *rel, attribute_t *attr)
 {
 	index_t *index;
 	index_api_t *api;
+	index_type_t type;
+	db_result_t result;
 
 	DB_LOG_D("DB: Attempting to load an index over %s.%s\n", rel->name, attr->name);
 
@@ -280,7 +282,19 @@ db_result_t index_load(relation_t *rel, attribute_t *attr)
 
 		index->api = api;
 
-		if (DB_ERROR(api->load(index))) {
+		result = api->load(index);
+		if (result == DB_INCONSISTENCY_ERROR) {
+			/* The index was saved in an older layout; rebuild it from the relation. */
+			DB_LOG_D("DB: Rebuilding the index over %s.%s\n", rel->name, attr->name);
+			storage_remove(index->descriptor_file);
+			storage_remove_index(rel, attr);
+			type = index->type;
+			index->rel = NULL;
+			index->attr = NULL;
+			memb_free(&index_memb, index);
+			return index_create(type, rel, attr);
+		}
+		if (DB_ERROR(result)) {
 			DB_LOG_E("DB: Index-specific load failed\n");
 			index->rel = NULL;
 			index->attr = NULL;
@@ -306,6 +320,30 @@ db_result_t index_insert(index_t *index, attribute_value_t *value, tuple_id_t tu
 	return index->api->insert(index, value, tuple_id);
 }
 
+/*
+ * Insert the keys of count consecutive tuples starting at first_id. The key
+ * of tuple first_id + i is keys[i * stride]. Indexes without a bulk load
+ * routine get the keys one by one.
+ */
+db_result_t index_bulk_insert(index_t *index, attribute_value_t *keys, unsigned stride, tuple_id_t first_id, tuple_id_t count)
+{
+	tuple_id_t i;
+	db_result_t result;
+
+	if (index->api->bulk_insert != NULL) {
+		return index->api->bulk_insert(index, keys, stride, first_id, count);
+	}
+
+	for (i = 0; i < count; i++) {
+		result = index->api->insert(index, &keys[i * stride], first_id + i);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+	}
+
+	return DB_OK;
+}
+
 db_result_t index_delete(index_t *index, attribute_value_t *value)
 {
 	if (index->state != INDEX_READY) {
@@ -316,6 +354,17 @@ db_result_t index_delete(index_t *index, attribute_value_t *value)
 }
 
 db_result_t index_get_iterator(index_iterator_t *iterator, index_t *index, attribute_value_t *min_value, attribute_value_t *max_value)
+{
+	return index_get_range_iterator(iterator, index, min_value, max_value, 0);
+}
+
+/*
+ * Prepare an iterator over the keys between min_value and max_value.
+ * INDEX_ITERATOR_MIN_EXCLUSIVE and INDEX_ITERATOR_MAX_EXCLUSIVE in
+ * bound_flags leave out the respective bound. Indexes may still return a
+ * superset of the range, so callers evaluate the predicate on each tuple.
+ */
+db_result_t index_get_range_iterator(index_iterator_t *iterator, index_t *index, attribute_value_t *min_value, attribute_value_t *max_value, uint8_t bound_flags)
 {
 	tuple_id_t cardinality;
 	unsigned long range;
@@ -365,8 +414,11 @@ db_result_t index_get_iterator(index_iterator_t *iterator, index_t *index, attri
 	iterator->min_value = *min_value;
 	iterator->max_value = *max_value;
 	iterator->next_item_no = 0;
+	iterator->found_items = 0;
+	iterator->flags = bound_flags & (INDEX_ITERATOR_MIN_EXCLUSIVE | INDEX_ITERATOR_MAX_EXCLUSIVE);
+	iterator->opaque_data = NULL;
 
-	DB_LOG_D("DB: Acquired an index iterator for %s.%s over the range (%ld,%ld)\n", index->rel->name, index->attr->name, min_value->u.long_value, max_value->u.long_value);
+	DB_LOG_D("DB: Acquired an index iterator for %s.%s over the range %c%ld,%ld%c\n", index->rel->name, index->attr->name, (bound_flags & INDEX_ITERATOR_MIN_EXCLUSIVE) ? '(' : '[', min, max, (bound_flags & INDEX_ITERATOR_MAX_EXCLUSIVE) ? ')' : ']');
 
 	return DB_OK;
 }
@@ -384,14 +436,13 @@ tuple_id_t index_get_next(index_iterator_t *iterator, uint8_t matched_condition)
 	if ((iterator->index->attr->flags & ATTRIBUTE_FLAG_UNIQUE) && iterator->next_item_no == 1) {
 		min = db_value_to_long(&iterator->min_value);
 		max = db_value_to_long(&iterator->max_value);
-		printf("%d\n", __LINE__);
-		sleep(1);
 		if (min == max) {
 			/*
 			 * We stop if this is an equivalence search on an attribute
 			 * whose values are unique, and we already found one item.
 			 */
-			DB_LOG_E("DB: Equivalence search finished\n");
+			DB_LOG_D("DB: Equivalence search finished\n");
+			index_release_iterator(iterator);
 			return INVALID_TUPLE;
 		}
 	}
@@ -399,6 +450,16 @@ tuple_id_t index_get_next(index_iterator_t *iterator, uint8_t matched_condition)
 	return iterator->index->api->get_next(iterator, matched_condition);
 }
 
+void index_release_iterator(index_iterator_t *iterator)
+{
+	if (iterator->index == NULL || iterator->index->api->release_iterator == NULL) {
+		return;
+	}
+
+	/* Drop whatever the index still holds for an iteration that was not run to its end. */
+	iterator->index->api->release_iterator(iterator);
+}
+
 /****************************************************************************
 * Private Functions
 ****************************************************************************/
@@ -484,8 +545,7 @@ db_result_t db_indexing(relation_t *rel)
 			goto errout;
 		}
 
-		row += offset;
-		result = db_phy_to_value(&value, index->attr, row);
+		result = db_phy_to_value(&value, index->attr, row + offset);
 		if (DB_ERROR(result)) {
 			DB_LOG_E("DB: Failed to get value from row\n");
 			goto errout;
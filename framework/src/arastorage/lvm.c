@@ -284,6 +284,11 @@ void lvm_reset(lvm_instance_t *p)
 	memset(p->derivations, 0, sizeof(p->derivations));
 }
 
+void lvm_clone(lvm_instance_t *dst, lvm_instance_t *src)
+{
+	memcpy(dst, src, sizeof(lvm_instance_t));
+}
+
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p)
 {
 	lvm_ip_t old_end;
@@ -318,6 +323,11 @@ lvm_ip_t lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end)
 	return old_end + sizeof(operator_t) + sizeof(node_type_t);
 }
 
+unsigned lvm_get_error(lvm_instance_t *p)
+{
+	return p->error;
+}
+
 lvm_ip_t lvm_get_end(lvm_instance_t *p)
 {
 	return p->end;
@@ -344,6 +354,16 @@ void lvm_set_type(lvm_instance_t *p, node_type_t type)
 	p->end += sizeof(type);
 }
 
+/* Check that a node of the given size still fits in the bytecode buffer. */
+static bool lvm_node_fits(lvm_instance_t *p, size_t size)
+{
+	if (p->end + sizeof(node_type_t) + size > DB_VM_BYTECODE_SIZE) {
+		p->error = __LINE__;
+		return false;
+	}
+	return true;
+}
+
 lvm_status_t lvm_execute(lvm_instance_t *p)
 {
 	node_type_t type;
@@ -372,6 +392,9 @@ lvm_status_t lvm_execute(lvm_instance_t *p)
 
 void lvm_set_op(lvm_instance_t *p, operator_t op)
 {
+	if (!lvm_node_fits(p, sizeof(op))) {
+		return;
+	}
 	lvm_set_type(p, LVM_ARITH_OP);
 	memcpy(&p->code[p->end], &op, sizeof(op));
 	p->end += sizeof(op);
@@ -379,6 +402,9 @@ void lvm_set_op(lvm_instance_t *p, operator_t op)
 
 void lvm_set_relation(lvm_instance_t *p, operator_t op)
 {
+	if (!lvm_node_fits(p, sizeof(op))) {
+		return;
+	}
 	lvm_set_type(p, LVM_CMP_OP);
 	memcpy(&p->code[p->end], &op, sizeof(op));
 	p->end += sizeof(op);
@@ -386,6 +412,9 @@ void lvm_set_relation(lvm_instance_t *p, operator_t op)
 
 void lvm_set_operand(lvm_instance_t *p, operand_t *op)
 {
+	if (!lvm_node_fits(p, sizeof(*op))) {
+		return;
+	}
 	lvm_set_type(p, LVM_OPERAND);
 	memcpy(&p->code[p->end], op, sizeof(*op));
 	p->end += sizeof(*op);
@@ -461,6 +490,53 @@ void lvm_set_variable(lvm_instance_t *p, char *name)
 	}
 }
 
+void lvm_set_parameter(lvm_instance_t *p, variable_id_t id)
+{
+	operand_t op;
+
+	op.type = LVM_PARAMETER;
+	op.value.id = id;
+
+	lvm_set_operand(p, &op);
+}
+
+/*
+ * Replace the parameter operands of a prepared predicate with the bound
+ * values. The code is rewritten in place, so the caller binds a clone
+ * and keeps the original as a template.
+ */
+lvm_status_t lvm_bind_parameters(lvm_instance_t *p, operand_value_t *values, unsigned count)
+{
+	lvm_ip_t ip;
+	operand_t operand;
+
+	for (ip = 0; ip < p->end;) {
+		switch (*(node_type_t *)(p->code + ip)) {
+		case LVM_CMP_OP:
+		case LVM_ARITH_OP:
+			ip += sizeof(node_type_t) + sizeof(operator_t);
+			break;
+		case LVM_OPERAND:
+			ip += sizeof(node_type_t);
+			memcpy(&operand, p->code + ip, sizeof(operand));
+			if (operand.type == LVM_PARAMETER) {
+				if (operand.value.id >= count) {
+					return INVALID_IDENTIFIER;
+				}
+				operand.type = LVM_LONG;
+				operand.value.l = values[operand.value.id].l;
+				memcpy(p->code + ip, &operand, sizeof(operand));
+			}
+			ip += sizeof(operand_t);
+			break;
+		default:
+			return SEMANTIC_ERROR;
+		}
+	}
+
+	return LVM_TRUE;
+}
+
 static void create_intersection(derivation_t *result, derivation_t *d1, derivation_t *d2)
 {
 	int i;
@@ -499,14 +575,10 @@ static void create_union(derivation_t *result, derivation_t *d1, derivation_t *d
 	int i;
 
 	for (i = 0; i < LVM_MAX_VARIABLE_ID; i++) {
-		if (!d1[i].derived && !d2[i].derived) {
+		if (!d1[i].derived || !d2[i].derived) {
+			/* A variable which is not constrained by one of the
+			   disjuncts can take any value. */
 			continue;
-		} else if (d1[i].derived && !d2[i].derived) {
-			result[i].min.l = d1[i].min.l;
-			result[i].max.l = d1[i].max.l;
-		} else if (!d1[i].derived && d2[i].derived) {
-			result[i].min.l = d2[i].min.l;
-			result[i].max.l = d2[i].max.l;
 		} else {
 			/* Both derivations have been made; create a
 			   union of the ranges. */
@@ -528,6 +600,41 @@ static void create_union(derivation_t *result, derivation_t *d1, derivation_t *d
 	/* DEBUG */
 }
 
+static void skip_node(lvm_instance_t *p)
+{
+	node_type_t type;
+	operator_t *operator;
+	operand_t operand;
+
+	type = get_type(p);
+	if (type == LVM_OPERAND) {
+		get_operand(p, &operand);
+		return;
+	}
+
+	operator = get_operator(p);
+	skip_node(p);
+	if (*operator != LVM_NOT) {
+		skip_node(p);
+	}
+}
+
+static operator_t mirror_relation(operator_t op)
+{
+	switch (op) {
+	case LVM_GE:
+		return LVM_LE;
+	case LVM_GEQ:
+		return LVM_LEQ;
+	case LVM_LE:
+		return LVM_GE;
+	case LVM_LEQ:
+		return LVM_GEQ;
+	default:
+		return op;
+	}
+}
+
 static int derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 {
 	operator_t *operator;
@@ -538,6 +645,9 @@ static int derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 	operand_value_t *value;
 	derivation_t *derivation;
 
+	lvm_ip_t operand_ip;
+	operator_t relation;
+
 	type = get_type(p);
 	operator = get_operator(p);
 
@@ -546,7 +656,9 @@ static int derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 		derivation_t d2[LVM_MAX_VARIABLE_ID];
 
 		if (*operator != LVM_AND && *operator != LVM_OR) {
-			return DERIVATION_ERROR;
+			/* A negation does not narrow down the range of any variable. */
+			skip_node(p);
+			return LVM_TRUE;
 		}
 
 		DB_LOG_D("Attempting to infer ranges from a logical connective\n");
@@ -574,31 +686,37 @@ static int derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 		return LVM_TRUE;
 	}
 
+	/*
+	 * Relations which cannot be expressed as a range of a single variable
+	 * leave all variables unconstrained, so that they can still take part
+	 * in a conjunction with derivable relations.
+	 */
+	operand_ip = p->ip;
 	for (i = 0; i < 2; i++) {
 		type = get_type(p);
-		switch (type) {
-		case LVM_OPERAND:
-			get_operand(p, &operand[i]);
-			break;
-		default:
-			return DERIVATION_ERROR;
+		if (type != LVM_OPERAND) {
+			p->ip = operand_ip;
+			skip_node(p);
+			skip_node(p);
+			return LVM_TRUE;
 		}
+		get_operand(p, &operand[i]);
 	}
 
-	if (operand[0].type == LVM_VARIABLE && operand[1].type == LVM_VARIABLE) {
-		return DERIVATION_ERROR;
+	if ((operand[0].type == LVM_VARIABLE) == (operand[1].type == LVM_VARIABLE) || *operator == LVM_NEQ) {
+		return LVM_TRUE;
 	}
 
-	/* Determine which of the operands that is the variable. */
+	/* Determine which of the operands that is the variable, and mirror
+	   the relation if the constant comes first. */
+	relation = *operator;
 	if (operand[0].type == LVM_VARIABLE) {
-		if (operand[1].type == LVM_VARIABLE) {
-			return DERIVATION_ERROR;
-		}
 		variable_id = operand[0].value.id;
 		value = &operand[1].value;
 	} else {
 		variable_id = operand[1].value.id;
 		value = &operand[0].value;
+		relation = mirror_relation(relation);
 	}
 
 	if (variable_id >= LVM_MAX_VARIABLE_ID) {
@@ -612,7 +730,7 @@ static int derive_relation(lvm_instance_t *p, derivation_t *local_derivations)
 	derivation->max.l = DB_LONG_MAX;
 	derivation->min.l = DB_LONG_MIN;
 
-	switch (*operator) {
+	switch (relation) {
 	case LVM_EQ:
 		derivation->max = *value;
 		derivation->min = *value;
@@ -715,6 +833,9 @@ static lvm_ip_t print_operand(lvm_instance_t *p, lvm_ip_t index)
 	case LVM_LONG:
 		DB_LOG_D("long:%ld ", operand.value.l);
 		break;
+	case LVM_PARAMETER:
+		DB_LOG_D("param:%d ", operand.value.id);
+		break;
 	default:
 		DB_LOG_D("?? ");
 		break;
@@ -118,7 +118,8 @@ typedef enum lvm_operator_e operator_t;
 enum operand_type_e {
 	LVM_VARIABLE,
 	LVM_FLOAT,
-	LVM_LONG
+	LVM_LONG,
+	LVM_PARAMETER
 };
 typedef enum operand_type_e operand_type_t;
 
@@ -177,6 +178,7 @@ void lvm_print_code(lvm_instance_t *p);
 lvm_ip_t lvm_jump_to_operand(lvm_instance_t *p);
 lvm_ip_t lvm_shift_for_operator(lvm_instance_t *p, lvm_ip_t end);
 lvm_ip_t lvm_get_end(lvm_instance_t *p);
+unsigned lvm_get_error(lvm_instance_t *p);
 lvm_ip_t lvm_set_end(lvm_instance_t *p, lvm_ip_t end);
 void lvm_set_op(lvm_instance_t *p, operator_t op);
 void lvm_set_relation(lvm_instance_t *p, operator_t op);
@@ -184,5 +186,7 @@ void lvm_set_operand(lvm_instance_t *p, operand_t *op);
 void lvm_set_operand_value(lvm_instance_t *p, attribute_t *attr, unsigned char *value);
 void lvm_set_long(lvm_instance_t *p, long l);
 void lvm_set_variable(lvm_instance_t *p, char *name);
+void lvm_set_parameter(lvm_instance_t *p, variable_id_t id);
+lvm_status_t lvm_bind_parameters(lvm_instance_t *p, operand_value_t *values, unsigned count);
 
 #endif							/* LVM_H */
@@ -77,6 +77,9 @@ LIST(relations);
 MEMB(relations_memb, relation_t, DB_RELATION_POOL_SIZE);
 MEMB(attributes_memb, attribute_t, DB_ATTRIBUTE_POOL_SIZE);
 
+/* Access paths chosen for selections, reported through db_get_plan_stats() */
+static db_plan_stats_t g_plan_stats;
+
 static relation_t *relation_find(char *);
 static attribute_t *attribute_find(relation_t *, char *);
 static int get_attribute_value_offset(relation_t *, attribute_t *);
@@ -206,6 +209,7 @@ db_result_t relation_init(void)
 	}
 	memb_init(&relations_memb);
 	memb_init(&attributes_memb);
+	db_reset_plan_stats();
 	return DB_OK;
 }
 
@@ -514,10 +518,146 @@ db_result_t relation_insert(relation_t *rel, attribute_value_t *values)
 	return storage_put_row(rel, record, FALSE);
 }
 
+/* Check that a value can be stored in an attribute, as relation_insert() does. */
+static db_result_t relation_check_value(attribute_t *attr, attribute_value_t *value)
+{
+	if (attr->domain != value->domain && !(attr->domain == DOMAIN_LONG && value->domain == DOMAIN_INT)) {
+		DB_LOG_E("DB: The value domain %d does not match the domain %d of attribute %s\n", value->domain, attr->domain, attr->name);
+		return DB_RELATIONAL_ERROR;
+	}
+	if (attr->domain != DOMAIN_INT && attr->domain != DOMAIN_LONG && attr->domain != DOMAIN_STRING) {
+		return DB_TYPE_ERROR;
+	}
+	return DB_OK;
+}
+
+/*
+ * Append count tuples of rel->attribute_count values each. The rows are
+ * encoded into a page buffer which is written with one storage access per
+ * page, and every index of the relation receives all new keys at once so
+ * that it can be built from sorted keys instead of one insertion per tuple.
+ * Only the validation is all or none: the tuple file can not be truncated
+ * and the B+ tree index can not delete, so a failure after the first page
+ * leaves the rows written so far in place.
+ */
+db_result_t relation_bulk_insert(relation_t *rel, attribute_value_t *values, tuple_id_t count)
+{
+	attribute_t *attr;
+	attribute_value_t *value;
+	attribute_value_t long_value;
+	unsigned char *page;
+	unsigned char *ptr;
+	tuple_id_t cardinality;
+	tuple_id_t page_capacity;
+	tuple_id_t page_rows;
+	tuple_id_t first_row;
+	tuple_id_t i;
+	unsigned attr_pos;
+	db_result_t result;
+
+	if (count == 0) {
+		return DB_OK;
+	}
+	if (rel->attribute_count == 0 || rel->row_length == 0) {
+		return DB_RELATIONAL_ERROR;
+	}
+
+	cardinality = relation_cardinality(rel);
+	if (cardinality == INVALID_TUPLE) {
+		return DB_STORAGE_ERROR;
+	}
+	if (count > DB_TUPLE_LIMIT || cardinality > DB_TUPLE_LIMIT - count) {
+		return DB_LIMIT_ERROR;
+	}
+
+	/* Validate every value first, so that a bad tuple leaves the relation untouched. */
+	value = values;
+	for (i = 0; i < count; i++) {
+		for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next, value++) {
+			if (!(attr->flags & ATTRIBUTE_FLAG_INVALID) && DB_ERROR(relation_check_value(attr, value))) {
+				DB_LOG_E("DB: Invalid value in bulk tuple %lu\n", (unsigned long)i);
+				return DB_TYPE_ERROR;
+			}
+		}
+	}
+
+	page_capacity = rel->row_length >= DB_SCAN_PAGE_SIZE ? 1 : DB_SCAN_PAGE_SIZE / rel->row_length;
+	if (page_capacity > count) {
+		page_capacity = count;
+	}
+	page = (unsigned char *)malloc(sizeof(char) * rel->row_length * page_capacity);
+	if (page == NULL) {
+		return DB_ALLOCATION_ERROR;
+	}
+
+	/* Tuple ids are positions in the tuple file. */
+	first_row = cardinality;
+	page_rows = 0;
+	value = values;
+	for (i = 0; i < count; i++) {
+		ptr = page + page_rows * rel->row_length;
+		for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next, value++) {
+			if (attr->flags & ATTRIBUTE_FLAG_INVALID) {
+				/* Set the data area for removed attributes to 0. */
+				memset(ptr, 0, attr->element_size);
+			} else if (attr->domain == DOMAIN_LONG && value->domain == DOMAIN_INT) {
+				long_value.domain = DOMAIN_LONG;
+				VALUE_LONG(&long_value) = VALUE_INT(value);
+				db_value_to_phy(ptr, attr, &long_value);
+			} else {
+				db_value_to_phy(ptr, attr, value);
+			}
+			ptr += attr->element_size;
+		}
+
+		if (++page_rows == page_capacity || i + 1 == count) {
+			result = storage_put_rows(rel, page, page_rows);
+			if (DB_ERROR(result)) {
+				free(page);
+				return result;
+			}
+			page_rows = 0;
+		}
+	}
+	free(page);
+
+	attr_pos = 0;
+	for (attr = list_head(rel->attributes); attr != NULL; attr = attr->next, attr_pos++) {
+		if (attr->index == NULL) {
+			index_load(rel, attr);
+		}
+		if (attr->index != NULL) {
+			if (DB_ERROR(index_bulk_insert(attr->index, values + attr_pos, rel->attribute_count, first_row, count))) {
+				DB_LOG_E("DB: Failed to bulk load the index of %s.%s\n", rel->name, attr->name);
+				return DB_INDEX_ERROR;
+			}
+		}
+	}
+
+	DB_LOG_D("DB: Bulk inserted %lu tuples into %s\n", (unsigned long)count, rel->name);
+
+	return DB_OK;
+}
+
+/*
+ * The initial aggregation value before any tuple is read.
+ */
+static double aggregate_init(uint8_t aggregator)
+{
+	switch (aggregator) {
+	case AQL_MAX:
+		return LONG_MIN;
+	case AQL_MIN:
+		return LONG_MAX;
+	default:
+		return 0;
+	}
+}
+
 /*
  * Update aggregation value whenever each tuple is read.
  */
-static db_result_t aggregate(attribute_t *attr, attribute_value_t *value, tuple_id_t count)
+static db_result_t aggregate(uint8_t aggregator, double *aggregation_value, attribute_value_t *value, tuple_id_t count)
 {
 	long long_value;
 	double sum_value;
@@ -534,29 +674,29 @@ static db_result_t aggregate(attribute_t *attr, attribute_value_t *value, tuple_
 	}
 
 	sum_value = 0;
-	switch (attr->aggregator) {
+	switch (aggregator) {
 	case AQL_COUNT:
-		attr->aggregation_value++;
+		(*aggregation_value)++;
 		break;
 	case AQL_SUM:
-		attr->aggregation_value += (double)long_value;
+		*aggregation_value += (double)long_value;
 		break;
 	case AQL_MEAN:
 		if (count == 1) {
-			attr->aggregation_value = (double)long_value;
+			*aggregation_value = (double)long_value;
 		} else {
-			sum_value = (double) (attr->aggregation_value * (count - 1));
-			attr->aggregation_value = (double) ((sum_value + long_value) / count);
+			sum_value = (double) (*aggregation_value * (count - 1));
+			*aggregation_value = (double) ((sum_value + long_value) / count);
 		}
 		break;
 	case AQL_MAX:
-		if (long_value > attr->aggregation_value) {
-			attr->aggregation_value = (double)long_value;
+		if (long_value > *aggregation_value) {
+			*aggregation_value = (double)long_value;
 		}
 		break;
 	case AQL_MIN:
-		if (long_value < attr->aggregation_value) {
-			attr->aggregation_value = (double)long_value;
+		if (long_value < *aggregation_value) {
+			*aggregation_value = (double)long_value;
 		}
 		break;
 	default:
@@ -564,11 +704,173 @@ static db_result_t aggregate(attribute_t *attr, attribute_value_t *value, tuple_
 		break;
 	}
 
-	DB_LOG_D("DB: aggregation value of attribute %s is %f.\n", attr->name, attr->aggregation_value);
+	DB_LOG_D("DB: aggregation value is %f.\n", *aggregation_value);
 
 	return DB_OK;
 }
 
+/* Hash the grouping key of a tuple into one of the group hash chains. */
+static uint16_t group_hash(unsigned char *key, unsigned size)
+{
+	uint32_t hash;
+	unsigned i;
+
+	/* FNV-1a */
+	hash = 2166136261UL;
+	for (i = 0; i < size; i++) {
+		hash = (hash ^ key[i]) * 16777619UL;
+	}
+
+	return hash & (DB_GROUP_HASH_SIZE - 1);
+}
+
+/* Prepare a GROUP BY selection on the given attribute of the result. */
+static db_result_t relation_group_init(db_handle_t *handle, char *name)
+{
+	relation_group_t *group;
+	source_dest_map_t *attr_map_ptr, *attr_map_end;
+	int i;
+
+	group = (relation_group_t *)malloc(sizeof(relation_group_t));
+	if (group == NULL) {
+		DB_LOG_E("DB: Failed to malloc group\n");
+		return DB_ALLOCATION_ERROR;
+	}
+	memset(group, 0, sizeof(relation_group_t));
+	for (i = 0; i < DB_GROUP_HASH_SIZE; i++) {
+		group->heads[i] = -1;
+	}
+	handle->group = group;
+
+	group->rows = (unsigned char *)malloc(DB_GROUP_LIMIT * handle->result_rel->row_length);
+	if (group->rows == NULL) {
+		DB_LOG_E("DB: Failed to malloc group rows\n");
+		return DB_ALLOCATION_ERROR;
+	}
+
+	/* Every column of a group is computed in RAM, including the key. */
+	attr_map_end = handle->attr_map + handle->result_rel->attribute_count;
+	for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+		if (group->key == NULL && attr_map_ptr->to_attr->aggregator == AQL_NONE && strcmp(attr_map_ptr->to_attr->name, name) == 0) {
+			group->key = attr_map_ptr;
+		}
+		attr_map_ptr->valuetype = AGGREGATE_VALUE;
+	}
+	if (group->key == NULL) {
+		DB_LOG_E("DB: Invalid grouping attribute %s\n", name);
+		return DB_NAME_ERROR;
+	}
+
+	return DB_OK;
+}
+
+/* Find or add the group of a matched tuple, and update its aggregates. */
+static db_result_t relation_group_add(db_handle_t *handle, storage_row_t row)
+{
+	relation_group_t *group;
+	source_dest_map_t *attr_map_ptr, *attr_map_end;
+	attribute_value_t value;
+	unsigned char *key, *group_row;
+	unsigned key_size, row_length;
+	double aggregation_value;
+	db_result_t result;
+	uint16_t hash;
+	int16_t id;
+
+	group = handle->group;
+	row_length = handle->result_rel->row_length;
+	key_size = group->key->to_attr->element_size;
+
+	/* Build the key in the tuple buffer. Strings are cut at the terminator
+	   so that equal keys are equal byte by byte. */
+	key = handle->tuple + group->key->to_offset;
+	memset(key, 0, key_size);
+	if (group->key->to_attr->domain == DOMAIN_STRING) {
+		strncpy((char *)key, (char *)row + group->key->from_offset, key_size - 1);
+	} else {
+		memcpy(key, row + group->key->from_offset, key_size);
+	}
+
+	hash = group_hash(key, key_size);
+	for (id = group->heads[hash]; id >= 0; id = group->next[id]) {
+		if (memcmp(group->rows + id * row_length + group->key->to_offset, key, key_size) == 0) {
+			break;
+		}
+	}
+
+	attr_map_end = handle->attr_map + handle->result_rel->attribute_count;
+
+	if (id < 0) {
+		if (group->count == DB_GROUP_LIMIT) {
+			DB_LOG_E("DB: The query has more than %d groups\n", DB_GROUP_LIMIT);
+			return DB_LIMIT_ERROR;
+		}
+		id = group->count++;
+		group_row = group->rows + id * row_length;
+		memset(group_row, 0, row_length);
+		memcpy(group_row + group->key->to_offset, key, key_size);
+		for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+			if (attr_map_ptr->to_attr->aggregator != AQL_NONE) {
+				aggregation_value = aggregate_init(attr_map_ptr->to_attr->aggregator);
+				memcpy(group_row + attr_map_ptr->to_offset, &aggregation_value, sizeof(double));
+			}
+		}
+		group->members[id] = 0;
+		group->next[id] = group->heads[hash];
+		group->heads[hash] = id;
+	}
+
+	group_row = group->rows + id * row_length;
+	group->members[id]++;
+
+	for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+		if (attr_map_ptr->to_attr->aggregator == AQL_NONE) {
+			continue;
+		}
+		result = db_phy_to_value(&value, attr_map_ptr->from_attr, row + attr_map_ptr->from_offset);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+
+		/* The rows are not aligned, so the aggregates are copied in and out. */
+		memcpy(&aggregation_value, group_row + attr_map_ptr->to_offset, sizeof(double));
+		result = aggregate(attr_map_ptr->to_attr->aggregator, &aggregation_value, &value, group->members[id]);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+		memcpy(group_row + attr_map_ptr->to_offset, &aggregation_value, sizeof(double));
+	}
+
+	return DB_OK;
+}
+
+/* Hand the rows of all groups over to the cursor. */
+static db_result_t relation_select_groups(db_handle_t *handle, db_cursor_t *cursor)
+{
+	relation_group_t *group;
+	db_result_t result;
+	tuple_id_t id;
+
+	group = handle->group;
+	for (id = 0; id < group->count; id++) {
+		result = cursor_data_add(cursor, id);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+	}
+
+	cursor->result_rows = group->rows;
+	cursor->result_row_length = handle->result_rel->row_length;
+	group->rows = NULL;
+
+	handle->current_row = 0;
+	handle->adt_flags &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
+
+	DB_LOG_D("DB: Aggregated %d groups\n", group->count);
+
+	return DB_FINISHED;
+}
+
 static db_result_t generate_attribute_map(source_dest_map_t *attr_map, unsigned attribute_count, relation_t *from_rel, relation_t *to_rel)
 {
 	attribute_t *from_attr;
@@ -611,6 +913,13 @@ static db_result_t generate_attribute_map(source_dest_map_t *attr_map, unsigned
 	return DB_OK;
 }
 
+/*
+ * Choose the access path of a selection. The derived ranges of all
+ * indexed attributes are compared, including ranges derived from
+ * conjunctions and disjunctions of several relations such as
+ * "ts > X AND ts < Y", and the index with the narrowest range is scanned.
+ * Without a usable index, the relation is scanned sequentially.
+ */
 static void select_index(db_handle_t **handle)
 {
 	index_t *index;
@@ -619,7 +928,7 @@ static void select_index(db_handle_t **handle)
 	operand_value_t max;
 	attribute_value_t av_min;
 	attribute_value_t av_max;
-	long range;
+	unsigned long range;
 	unsigned long min_range;
 	index = NULL;
 	min_range = ULONG_MAX;
@@ -629,11 +938,13 @@ static void select_index(db_handle_t **handle)
 	attr = list_head((*handle)->rel->attributes);
 	while (attr != NULL) {
 		if (attr->index != NULL && !LVM_ERROR(lvm_get_derived_range((*handle)->lvm_instance, attr->name, &min, &max))) {
-			range = (unsigned long)max.l - (unsigned long)min.l;
-			DB_LOG_D("DB: The search range for attribute \"%s\" comprises %ld values\n", attr->name, range + 1);
-			if (range <= min_range) {
+			/* Contradicting relations leave an empty range */
+			range = min.l > max.l ? 0 : (unsigned long)max.l - (unsigned long)min.l;
+			DB_LOG_D("DB: The search range for attribute \"%s\" is [%ld,%ld]\n", attr->name, min.l, max.l);
+			if (index == NULL || range < min_range) {
 				index = attr->index;
-				av_min.domain = av_max.domain = DOMAIN_INT;
+				min_range = range;
+				av_min.domain = av_max.domain = DOMAIN_LONG;
 				VALUE_LONG(&av_min) = min.l;
 				VALUE_LONG(&av_max) = max.l;
 			}
@@ -643,7 +954,7 @@ static void select_index(db_handle_t **handle)
 
 	if (index != NULL) {
 		/* We found a suitable index; get an iterator for it. */
-		if (index_get_iterator(&((*handle)->index_iterator), index, &av_min, &av_max) == DB_OK) {
+		if (index_get_range_iterator(&((*handle)->index_iterator), index, &av_min, &av_max, 0) == DB_OK) {
 			(*handle)->flags |= DB_HANDLE_FLAG_SEARCH_INDEX;
 		}
 	} else {
@@ -714,6 +1025,15 @@ static db_result_t generate_selection_result(db_handle_t **handle, relation_t *r
 		}
 	}
 
+	/* Removal always rewrites the relation with a sequential scan. */
+	if ((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX && AQL_GET_EXEC_TYPE((*handle)->optype) == AQL_TYPE_SELECT) {
+		DB_LOG_D("DB: Plan for %s: index scan on %s\n", rel->name, (*handle)->index_iterator.index->attr->name);
+		g_plan_stats.index_scans++;
+	} else {
+		DB_LOG_D("DB: Plan for %s: sequential scan\n", rel->name);
+		g_plan_stats.full_scans++;
+	}
+
 	(*handle)->tuple = (tuple_t)malloc(sizeof(char) * result_rel->row_length + 1);
 	if ((*handle)->tuple == NULL) {
 		DB_LOG_E("DB: Failed to malloc tuple row\n");
@@ -721,6 +1041,23 @@ static db_result_t generate_selection_result(db_handle_t **handle, relation_t *r
 		return DB_ALLOCATION_ERROR;
 	}
 
+	/* Tuples found by an index are read one by one, otherwise a page of rows is read at once. */
+	if (((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX && AQL_GET_EXEC_TYPE((*handle)->optype) == AQL_TYPE_SELECT) || rel->row_length == 0 || rel->row_length >= DB_SCAN_PAGE_SIZE) {
+		(*handle)->page_capacity = 1;
+	} else {
+		(*handle)->page_capacity = DB_SCAN_PAGE_SIZE / rel->row_length;
+	}
+	(*handle)->page_start = 0;
+	(*handle)->page_rows = 0;
+	(*handle)->page = (storage_row_t)malloc(sizeof(char) * rel->row_length * (*handle)->page_capacity + 1);
+	if ((*handle)->page == NULL) {
+		DB_LOG_E("DB: Failed to malloc scan page\n");
+		free((*handle)->tuple);
+		(*handle)->tuple = NULL;
+		free((*handle)->attr_map);
+		return DB_ALLOCATION_ERROR;
+	}
+
 	/* Set flag to process tuples which need to be read */
 	(*handle)->flags |= DB_HANDLE_FLAG_PROCESSING;
 
@@ -754,75 +1091,58 @@ int db_processing_status(db_handle_t *handle)
 	return handle->flags & DB_HANDLE_FLAG_PROCESSING;
 }
 
-db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
+/*
+ * Get the row of the next tuple in a sequential scan. Rows are served from
+ * the page buffer of the handle, which is refilled with one storage access
+ * when the next tuple is not in it.
+ */
+static db_result_t relation_scan_next_row(db_handle_t *handle, storage_row_t *row)
 {
 	db_result_t result;
-	unsigned attribute_count;
-	source_dest_map_t *attr_map_ptr, *attr_map_end;
-	attribute_t *result_attr, *from_attr;
-	unsigned char *from_ptr, *to_ptr;
-	char aggr_buf[8];
-	attribute_value_t value;
-	storage_row_t row = NULL;
-	tuple_t result_row;
-
-	if (cursor == NULL) {
-		return DB_CURSOR_ERROR;
-	}
-	if ((*handle)->tuple == NULL) {
-		return DB_ALLOCATION_ERROR;
-	}
+	tuple_id_t count;
 
-	result_row = (*handle)->tuple;
-	attribute_count = (*handle)->result_rel->attribute_count;
-	attr_map_end = (*handle)->attr_map + attribute_count;
+	handle->tuple_id++;
 
-	if ((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
-		(*handle)->tuple_id = index_get_next(&((*handle)->index_iterator), TRUE);
-		if ((*handle)->tuple_id == INVALID_TUPLE) {
-			DB_LOG_E("DB: An attribute value could not be found in the index\n");
-			if ((*handle)->index_iterator.next_item_no == 0) {
-				return DB_INDEX_ERROR;
-			}
-			if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
-				result = DB_FINISHED;
-				goto processing_aggregation;
-			}
-			return DB_FINISHED;
+	if (handle->tuple_id < handle->page_start || handle->tuple_id >= handle->page_start + handle->page_rows) {
+		count = handle->page_capacity;
+		result = storage_get_rows(handle->rel, handle->tuple_id, handle->page, &count);
+		if (result != DB_OK) {
+			handle->page_rows = 0;
+			return result;
 		}
-	} else {
-		(*handle)->tuple_id++;
+		handle->page_start = handle->tuple_id;
+		handle->page_rows = count;
+		g_plan_stats.scan_rows += count;
 	}
 
-	row = (storage_row_t)malloc(sizeof(char) * (*handle)->rel->row_length + 1);
-	if (row == NULL) {
-		DB_LOG_E("DB: Failed to allocate row\n");
-		return DB_ALLOCATION_ERROR;
-	}
+	*row = handle->page + (handle->tuple_id - handle->page_start) * handle->rel->row_length;
+	return DB_OK;
+}
 
-	/* Put the tuples fulfilling the- given condition into a new relation.
-	   The tuples may be projected. */
-	result = storage_get_row((*handle)->rel, &((*handle)->tuple_id), row);
-	if (DB_ERROR(result)) {
-		DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
-		goto errout;
-	} else if (result == DB_FINISHED) {
-		if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
-			goto processing_aggregation;
-		}
-		if (row != NULL) {
-			free(row);
-		}
-		return DB_FINISHED;
-	}
+/* Check whether the current tuple of a sequential scan is the last one in the page buffer. */
+static bool relation_scan_page_end(db_handle_t *handle)
+{
+	return handle->tuple_id + 1 >= handle->page_start + handle->page_rows;
+}
+
+/* Evaluate the predicate for a row and put it in the cursor or the aggregation if matched. */
+static db_result_t relation_select_row(db_handle_t *handle, db_cursor_t *cursor, storage_row_t row)
+{
+	db_result_t result;
+	source_dest_map_t *attr_map_ptr, *attr_map_end;
+	attribute_t *from_attr;
+	unsigned char *from_ptr;
+	attribute_value_t value;
+
+	attr_map_end = handle->attr_map + handle->result_rel->attribute_count;
 
 	/* Process the attributes in the result relation. */
-	for (attr_map_ptr = (*handle)->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+	for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
 		from_ptr = row + attr_map_ptr->from_offset;
 		from_attr = attr_map_ptr->from_attr;
 
 		if (from_attr->domain == DOMAIN_INT || from_attr->domain == DOMAIN_LONG) {
-			lvm_set_operand_value((*handle)->lvm_instance, from_attr, from_ptr);
+			lvm_set_operand_value(handle->lvm_instance, from_attr, from_ptr);
 		}
 
 		if (from_attr->flags & ATTRIBUTE_FLAG_NO_STORE) {
@@ -831,76 +1151,172 @@ db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
 			continue;
 		}
 
-		if (!((*handle)->adt_flags & AQL_FLAG_AGGREGATE)) {
+		if (!(handle->adt_flags & AQL_FLAG_AGGREGATE)) {
 			/* No aggregators. Copy the original value into the resulting tuple. */
-			memcpy(result_row + attr_map_ptr->to_offset, from_ptr, from_attr->element_size);
+			memcpy(handle->tuple + attr_map_ptr->to_offset, from_ptr, from_attr->element_size);
 		}
 	}
 
 	/* Check whether the given predicate is true for this tuple. */
-	if ((*handle)->lvm_instance == NULL || lvm_execute((*handle)->lvm_instance) == TRUE) {
-		(*handle)->current_row++;
+	if (handle->lvm_instance != NULL && lvm_execute(handle->lvm_instance) != TRUE) {
+		return DB_OK;
+	}
 
-		if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
-			for (attr_map_ptr = (*handle)->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
-				from_ptr = row + attr_map_ptr->from_offset;
-				result = db_phy_to_value(&value, attr_map_ptr->from_attr, from_ptr);
-				if (DB_ERROR(result)) {
-					goto errout;
-				}
-
-				result = aggregate(attr_map_ptr->to_attr, &value, (*handle)->current_row);
-				if (DB_ERROR(result)) {
-					goto errout;
-				}
-			}
-		} else {
-			result = cursor_data_add(cursor, (*handle)->tuple_id);
-			if (DB_ERROR(result)) {
-				goto errout;
-			}
-		}
+	handle->current_row++;
+
+	if (!(handle->adt_flags & AQL_FLAG_AGGREGATE)) {
+		return cursor_data_add(cursor, handle->tuple_id);
 	}
 
-	if (row != NULL) {
-		free(row);
+	if (handle->group != NULL) {
+		return relation_group_add(handle, row);
+	}
+
+	for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+		if (attr_map_ptr->to_attr->aggregator == AQL_NONE) {
+			/* Attributes used only by the predicate are not aggregated. */
+			continue;
+		}
+		from_ptr = row + attr_map_ptr->from_offset;
+		result = db_phy_to_value(&value, attr_map_ptr->from_attr, from_ptr);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+
+		result = aggregate(attr_map_ptr->to_attr->aggregator, &attr_map_ptr->to_attr->aggregation_value, &value, handle->current_row);
+		if (DB_ERROR(result)) {
+			return result;
+		}
 	}
 	return DB_OK;
+}
 
-processing_aggregation:
-	/* Generate aggregated result if requested. */
-	for (attr_map_ptr = (*handle)->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
+/* Generate aggregated result and put it in the cursor. */
+static db_result_t relation_select_aggregation(db_handle_t *handle, db_cursor_t *cursor)
+{
+	db_result_t result;
+	source_dest_map_t *attr_map_ptr, *attr_map_end;
+	attribute_t *result_attr;
+	attribute_value_t value;
+
+	if (handle->group != NULL) {
+		return relation_select_groups(handle, cursor);
+	}
+
+	attr_map_end = handle->attr_map + handle->result_rel->attribute_count;
+
+	for (attr_map_ptr = handle->attr_map; attr_map_ptr < attr_map_end; attr_map_ptr++) {
 		result_attr = attr_map_ptr->to_attr;
-		to_ptr = result_row + attr_map_ptr->to_offset;
+		if (result_attr->aggregator == AQL_NONE) {
+			continue;
+		}
 
-		snprintf(aggr_buf, sizeof(aggr_buf), "%f", result_attr->aggregation_value);
-		from_ptr = (unsigned char *)aggr_buf;
-		memcpy(to_ptr, from_ptr, sizeof(aggr_buf));
+		value.domain = DOMAIN_DOUBLE;
+		VALUE_DOUBLE(&value) = result_attr->aggregation_value;
+		db_value_to_phy(handle->tuple + attr_map_ptr->to_offset, result_attr, &value);
 	}
 
-	/* Copy aggregated result to tuple in cursor */
-	memcpy(cursor->tuple, result_row, sizeof(cursor->tuple));
+	/* Copy aggregated result to the cursor, the row can be longer than its tuple buffer */
+	cursor->result_rows = (unsigned char *)malloc(handle->result_rel->row_length);
+	if (cursor->result_rows == NULL) {
+		return DB_ALLOCATION_ERROR;
+	}
+	memcpy(cursor->result_rows, handle->tuple, handle->result_rel->row_length);
+	cursor->result_row_length = handle->result_rel->row_length;
 
-	(*handle)->current_row = 0;
-	(*handle)->adt_flags &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
+	handle->current_row = 0;
+	handle->adt_flags &= ~AQL_FLAG_AGGREGATE; /* Stop the aggregation. */
 
-	result = cursor_data_add(cursor, (*handle)->current_row);
+	result = cursor_data_add(cursor, handle->current_row);
 	if (DB_ERROR(result)) {
-		goto errout;
+		return result;
 	}
 	cursor->total_rows = 1;
 
-	if (row != NULL) {
-		free(row);
-	}
 	return DB_FINISHED;
+}
 
-errout:
-	if (row != NULL) {
-		free(row);
+db_result_t db_get_plan_stats(db_plan_stats_t *stats)
+{
+	if (stats == NULL) {
+		return DB_ARGUMENT_ERROR;
 	}
 
-	return result;
+	memcpy(stats, &g_plan_stats, sizeof(db_plan_stats_t));
+
+	return DB_OK;
+}
+
+void db_reset_plan_stats(void)
+{
+	memset(&g_plan_stats, 0, sizeof(db_plan_stats_t));
+}
+
+db_result_t relation_process_select(db_handle_t **handle, db_cursor_t *cursor)
+{
+	db_result_t result;
+	storage_row_t row;
+
+	if (cursor == NULL) {
+		return DB_CURSOR_ERROR;
+	}
+	if ((*handle)->tuple == NULL || (*handle)->page == NULL) {
+		return DB_ALLOCATION_ERROR;
+	}
+
+	if ((*handle)->flags & DB_HANDLE_FLAG_SEARCH_INDEX) {
+		(*handle)->tuple_id = index_get_next(&((*handle)->index_iterator), TRUE);
+		if ((*handle)->tuple_id == INVALID_TUPLE) {
+			/* An empty range is a valid result, only a failed lookup is an error. */
+			if ((*handle)->index_iterator.next_item_no == 0 && !((*handle)->index_iterator.flags & INDEX_ITERATOR_FINISHED)) {
+				DB_LOG_E("DB: An attribute value could not be found in the index\n");
+				return DB_INDEX_ERROR;
+			}
+			if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
+				return relation_select_aggregation(*handle, cursor);
+			}
+			return DB_FINISHED;
+		}
+
+		/* Tuples found by the index are not sequential, read them one by one. */
+		row = (*handle)->page;
+		result = storage_get_row((*handle)->rel, &((*handle)->tuple_id), row);
+		if (DB_ERROR(result)) {
+			DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
+			return result;
+		} else if (result == DB_FINISHED) {
+			if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
+				return relation_select_aggregation(*handle, cursor);
+			}
+			return DB_FINISHED;
+		}
+
+		g_plan_stats.index_rows++;
+
+		return relation_select_row(*handle, cursor, row);
+	}
+
+	/* Put the tuples fulfilling the given condition into the cursor,
+	   processing all rows in the page buffer at once. */
+	do {
+		result = relation_scan_next_row(*handle, &row);
+		if (DB_ERROR(result)) {
+			DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
+			return result;
+		} else if (result == DB_FINISHED) {
+			if ((*handle)->adt_flags & AQL_FLAG_AGGREGATE) {
+				return relation_select_aggregation(*handle, cursor);
+			}
+			return DB_FINISHED;
+		}
+
+		result = relation_select_row(*handle, cursor, row);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+	} while (!relation_scan_page_end(*handle));
+
+	return DB_OK;
 }
 
 db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
@@ -915,7 +1331,7 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 	source_dest_map_t *attr_map_ptr, *attr_map_end;
 	int i;
 
-	if ((*handle)->tuple == NULL) {
+	if ((*handle)->tuple == NULL || (*handle)->page == NULL) {
 		return DB_ALLOCATION_ERROR;
 	}
 
@@ -923,18 +1339,10 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 	attribute_count = (*handle)->result_rel->attribute_count;
 	attr_map_end = (*handle)->attr_map + attribute_count;
 
-	/* Search all tuples sequentially without index. */
-	(*handle)->tuple_id++;
-
-	row = (storage_row_t)malloc(sizeof(char) * (*handle)->rel->row_length + 1);
-	if (row == NULL) {
-		DB_LOG_E("DB: Failed to allocate row\n");
-		return DB_ALLOCATION_ERROR;
-	}
-
-	/* Put the tuples fulfilling the- given condition into a new relation.
+	/* Search all tuples sequentially without index.
+	   Put the tuples fulfilling the- given condition into a new relation.
 	   The tuples may be projected. */
-	result = storage_get_row((*handle)->rel, &((*handle)->tuple_id), row);
+	result = relation_scan_next_row(*handle, &row);
 	if (DB_ERROR(result)) {
 		DB_LOG_E("DB: Failed to get a row in relation %s!\n", (*handle)->rel->name);
 		goto errout;
@@ -969,15 +1377,9 @@ db_result_t relation_process_remove(db_handle_t **handle, db_cursor_t *cursor)
 		}
 
 		(*handle)->current_row++;
-		if (row != NULL) {
-			free(row);
-		}
 		return DB_GOT_ROW;
 	}
 
-	if (row != NULL) {
-		free(row);
-	}
 	return DB_OK;
 
 end_removal:
@@ -1021,10 +1423,6 @@ end_removal:
 		}
 	}
 
-	if (row != NULL) {
-		free(row);
-	}
-
 	return DB_FINISHED;
 
 errout:
@@ -1032,10 +1430,6 @@ errout:
 	storage_write_buffer_clean();
 #endif
 
-	if (row != NULL) {
-		free(row);
-	}
-
 	return result;
 }
 
@@ -1092,6 +1486,7 @@ db_result_t relation_select(db_handle_t **handle, relation_t *rel, void *adt_ptr
 	db_direction_t dir;
 	char *attribute_name;
 	attribute_t *attr, *attr_ptr;
+	db_result_t result;
 	int i;
 	int normal_attributes = 0;
 	adt = (aql_adt_t *)adt_ptr;
@@ -1159,26 +1554,27 @@ db_result_t relation_select(db_handle_t **handle, relation_t *rel, void *adt_ptr
 				return DB_ALLOCATION_ERROR;
 			}
 			attr->aggregator = adt->aggregators[i];
-			switch (attr->aggregator) {
-			case AQL_NONE:
-				if (!(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
-					/* Only count attributes projected into the result set. */
-					normal_attributes++;
-				}
-				break;
-			case AQL_MAX:
-				attr->aggregation_value = LONG_MIN;
-				break;
-			case AQL_MIN:
-				attr->aggregation_value = LONG_MAX;
-				break;
-			default:
-				attr->aggregation_value = 0;
-				break;
+			if (attr->aggregator == AQL_NONE && !(adt->attributes[i].flags & ATTRIBUTE_FLAG_NO_STORE)) {
+				/* Only count attributes projected into the result set. */
+				normal_attributes++;
 			}
+			attr->aggregation_value = aggregate_init(attr->aggregator);
 			attr->flags = adt->attributes[i].flags;
 		}
 	}
+
+	if (AQL_GET_FLAGS(adt) & AQL_FLAG_GROUP) {
+		/* Only the grouping attribute may be projected besides the aggregates. */
+		if (normal_attributes != 1) {
+			return DB_RELATIONAL_ERROR;
+		}
+		result = generate_selection_result(handle, rel);
+		if (DB_ERROR(result)) {
+			return result;
+		}
+		return relation_group_init(*handle, adt->attributes[adt->group_attribute].name);
+	}
+
 	/* Preclude mixes of normal attributes and aggregated ones in
 	   selection results. */
 	if (normal_attributes > 0 && (*handle)->result_rel->attribute_count > normal_attributes) {
@@ -158,7 +158,13 @@ struct _db_cursor_s {
 	attribute_id_t attribute_count;
 	size_t storage_row_length;
 	uint32_t *row_arr;
+#ifdef CONFIG_ARASTORAGE_ENABLE_CURSOR_INDEX
+	tuple_id_t *row_index;
+#endif
 	unsigned char tuple[DB_MAX_ELEMENT_SIZE + 1];
+	/* Rows computed by the query itself, such as GROUP BY results */
+	unsigned char *result_rows;
+	size_t result_row_length;
 	char name[TUPLE_NAME_LENGTH + 1];
 	char rel_name[RELATION_NAME_LENGTH + 1];
 	cursor_data_map_t attr_map[AQL_ATTRIBUTE_LIMIT];
@@ -191,6 +197,7 @@ db_result_t relation_attribute_remove(relation_t *, char *);
 db_result_t relation_set_primary_key(relation_t *, char *);
 db_result_t relation_remove(char *, int);
 db_result_t relation_insert(relation_t *, attribute_value_t *);
+db_result_t relation_bulk_insert(relation_t *, attribute_value_t *, tuple_id_t);
 db_result_t relation_select(db_handle_t **, relation_t *, void *);
 tuple_id_t relation_cardinality(relation_t *);
 
@@ -125,7 +125,9 @@ db_result_t db_phy_to_value(attribute_value_t *value, attribute_t *attr, unsigne
 		DB_LOG_V("DB: %s = %ld\n", attr->name, long_value);
 		break;
 	case DOMAIN_DOUBLE:
-		double_value = atof((char *)ptr);
+		/* Doubles are only produced by aggregations and kept in RAM,
+		   so they use the native representation. */
+		memcpy(&double_value, ptr, sizeof(double_value));
 		VALUE_DOUBLE(value) = double_value;
 		DB_LOG_V("DB: %s = %.5f\n", attr->name, double_value);
 		break;
@@ -160,6 +162,9 @@ db_result_t db_value_to_phy(unsigned char *ptr, attribute_t *attr, attribute_val
 		ptr[2] = long_value >> 8;
 		ptr[3] = long_value & 0xff;
 		break;
+	case DOMAIN_DOUBLE:
+		memcpy(ptr, &VALUE_DOUBLE(value), sizeof(double));
+		break;
 	default:
 		return DB_TYPE_ERROR;
 	}
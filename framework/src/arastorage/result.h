@@ -94,6 +94,22 @@ struct source_dest_map_s {
 };
 typedef struct source_dest_map_s source_dest_map_t;
 
+/*
+ * The state of a GROUP BY selection. The group of a tuple is found
+ * through a small chained hash table on the grouping attribute. Each
+ * group owns one row of the result relation, which holds the group key
+ * and the running aggregates, in an arena of DB_GROUP_LIMIT rows.
+ */
+struct relation_group_s {
+	source_dest_map_t *key;
+	unsigned char *rows;
+	uint16_t count;
+	int16_t heads[DB_GROUP_HASH_SIZE];
+	int16_t next[DB_GROUP_LIMIT];
+	tuple_id_t members[DB_GROUP_LIMIT];
+};
+typedef struct relation_group_s relation_group_t;
+
 struct _db_handle_s {
 	index_iterator_t index_iterator;
 	tuple_id_t tuple_id;
@@ -101,12 +117,17 @@ struct _db_handle_s {
 	relation_t *rel;
 	relation_t *result_rel;
 	tuple_t tuple;
+	storage_row_t page;
+	tuple_id_t page_start;
+	tuple_id_t page_rows;
+	tuple_id_t page_capacity;
 	uint32_t optype;
 	uint8_t flags;
 	uint8_t adt_flags;
 	uint8_t ncolumns;
 	void *lvm_instance;
 	source_dest_map_t *attr_map;
+	relation_group_t *group;
 };
 
 /****************************************************************************
@@ -29,24 +29,33 @@
 void rw_init(struct rw_lock_s *rwLock)
 {
 	pthread_mutex_init(&rwLock->mutex, NULL);
-	pthread_cond_init(&rwLock->noWriters, NULL);
-	pthread_cond_init(&rwLock->noActiveWriter, NULL);
-	pthread_cond_init(&rwLock->noReaders, NULL);
+	pthread_cond_init(&rwLock->readers_cond, NULL);
+	pthread_cond_init(&rwLock->writers_cond, NULL);
 	rwLock->readers = 0;
-	rwLock->writers = 0;
-	rwLock->writerActive = false;
+	rwLock->readers_waiting = 0;
+	rwLock->writers_waiting = 0;
+	rwLock->phase = 0;
+	rwLock->writer_active = false;
 }
 
 void rw_lock_read(struct rw_lock_s *rwLock)
 {
+	uint32_t phase;
+
 	pthread_mutex_lock(&rwLock->mutex);
+	if (!rwLock->writer_active && rwLock->writers_waiting == 0) {
+		rwLock->readers++;
+		pthread_mutex_unlock(&rwLock->mutex);
+		return;
+	}
 
-	// Wait until there are no writers
-	while (rwLock->writers > 0) {
-		pthread_cond_wait(&rwLock->noWriters, &rwLock->mutex);
+	// Queue behind the writer. The writer admits all queued readers
+	// at once when it unlocks, so only wait for the phase to change.
+	rwLock->readers_waiting++;
+	phase = rwLock->phase;
+	while (rwLock->phase == phase) {
+		pthread_cond_wait(&rwLock->readers_cond, &rwLock->mutex);
 	}
-	// Since there are no writers, we can proceed to read
-	rwLock->readers++;
 	pthread_mutex_unlock(&rwLock->mutex);
 }
 
@@ -54,10 +63,9 @@ void rw_unlock_read(struct rw_lock_s *rwLock)
 {
 	pthread_mutex_lock(&rwLock->mutex);
 	rwLock->readers--;
-	// The last reader will signal that there are no readers,
-	// allowing any waiting writers to proceed
-	if (rwLock->readers == 0) {
-		pthread_cond_signal(&rwLock->noReaders);
+	// The last reader lets a waiting writer proceed
+	if (rwLock->readers == 0 && rwLock->writers_waiting > 0) {
+		pthread_cond_signal(&rwLock->writers_cond);
 	}
 	pthread_mutex_unlock(&rwLock->mutex);
 }
@@ -65,48 +73,41 @@ void rw_unlock_read(struct rw_lock_s *rwLock)
 int rw_trylock_write(struct rw_lock_s *rwLock)
 {
 	pthread_mutex_lock(&rwLock->mutex);
-	if (rwLock->readers > 0 || rwLock->writers > 0 || rwLock->writerActive) {
+	if (rwLock->readers > 0 || rwLock->writers_waiting > 0 || rwLock->writer_active) {
 		pthread_mutex_unlock(&rwLock->mutex);
 		return 0;
-	} else {
-		rwLock->writers++;
-		rwLock->writerActive = true;
-		pthread_mutex_unlock(&rwLock->mutex);
-		return 1;
 	}
+	rwLock->writer_active = true;
+	pthread_mutex_unlock(&rwLock->mutex);
+	return 1;
 }
 
 void rw_lock_write(struct rw_lock_s *rwLock)
 {
 	pthread_mutex_lock(&rwLock->mutex);
-	// Announce intent to write: keep out any new readers
-	rwLock->writers++;
-	// Wait for readers to finish
-	while (rwLock->readers > 0) {
-		pthread_cond_wait(&rwLock->noReaders, &rwLock->mutex);
-	}
-	// Wait for any active writer to finish
-	while (rwLock->writerActive) {
-		pthread_cond_wait(&rwLock->noActiveWriter, &rwLock->mutex);
+	// Announce intent to write: new readers queue for the next read phase
+	rwLock->writers_waiting++;
+	while (rwLock->readers > 0 || rwLock->writer_active) {
+		pthread_cond_wait(&rwLock->writers_cond, &rwLock->mutex);
 	}
-	// Now this thread is the active writer
-	rwLock->writerActive = true;
+	rwLock->writers_waiting--;
+	rwLock->writer_active = true;
 	pthread_mutex_unlock(&rwLock->mutex);
 }
 
 void rw_unlock_write(struct rw_lock_s *rwLock)
 {
 	pthread_mutex_lock(&rwLock->mutex);
-	rwLock->writerActive = false;
-	rwLock->writers--;
-	// If there are other writers waiting, let the next one take a turn.
-	// Otherwise, signal that there are no more writers, allowing any waiting readers
-	// to proceed.
-	if (rwLock->writers > 0) {
-		pthread_cond_signal(&rwLock->noActiveWriter);
-	} else {					/* rwLock->writers == 0 */
-
-		pthread_cond_signal(&rwLock->noWriters);
+	rwLock->writer_active = false;
+	if (rwLock->readers_waiting > 0) {
+		// Start a read phase with every reader that queued behind this
+		// writer. The next writer waits until they are all done.
+		rwLock->readers += rwLock->readers_waiting;
+		rwLock->readers_waiting = 0;
+		rwLock->phase++;
+		pthread_cond_broadcast(&rwLock->readers_cond);
+	} else if (rwLock->writers_waiting > 0) {
+		pthread_cond_signal(&rwLock->writers_cond);
 	}
 	pthread_mutex_unlock(&rwLock->mutex);
 }
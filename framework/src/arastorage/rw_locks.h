@@ -21,32 +21,41 @@
 /****************************************************************************
  * Included Files
  ****************************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
 #include <pthread.h>
 
 /****************************************************************************
 * Public Type Definitions
 ****************************************************************************/
+/*
+ * A phase-fair reader writer lock. Readers that arrive while a writer holds
+ * or waits for the lock queue behind it, and are all let in together when
+ * that writer leaves, before the next writer. Neither side can starve the
+ * other.
+ */
 struct rw_lock_s {
 	pthread_mutex_t mutex;
-	pthread_cond_t noWriters;
-	pthread_cond_t noActiveWriter;
-	pthread_cond_t noReaders;
-	int readers;
-	int writers;
-	bool writerActive;
+	pthread_cond_t readers_cond;	/* Signalled when a read phase starts */
+	pthread_cond_t writers_cond;	/* Signalled when a writer may go in */
+	int readers;				/* Readers holding the lock */
+	int readers_waiting;		/* Readers queued for the next read phase */
+	int writers_waiting;		/* Writers queued for the lock */
+	uint32_t phase;				/* Count of read phases started by writers */
+	bool writer_active;
 };
 
 /****************************************************************************
 * Global Function Prototypes
 ****************************************************************************/
-void RW_Init(struct rw_lock_s *rwLock);
-void RW_Lock_Read(struct rw_lock_s *rwLock);
-void RW_Unlock_Read(struct rw_lock_s *rwLock);
+void rw_init(struct rw_lock_s *rwLock);
+void rw_lock_read(struct rw_lock_s *rwLock);
+void rw_unlock_read(struct rw_lock_s *rwLock);
 
-int RW_Trylock_Write(struct rw_lock_s *rwLock);
+int rw_trylock_write(struct rw_lock_s *rwLock);
 
-void RW_Lock_Write(struct rw_lock_s *rwLock);
+void rw_lock_write(struct rw_lock_s *rwLock);
 
-void RW_Unlock_Write(struct rw_lock_s *rwLock);
+void rw_unlock_write(struct rw_lock_s *rwLock);
 
 #endif							/* __RW_LOCKS_H__ */
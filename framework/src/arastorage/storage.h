@@ -96,7 +96,9 @@ db_result_t storage_get_index(index_t *, relation_t *, attribute_t *);
 db_result_t storage_put_index(index_t *);
 db_result_t storage_remove_index(relation_t *rel, attribute_t *attr);
 db_result_t storage_get_row(relation_t *, tuple_id_t *, storage_row_t);
+db_result_t storage_get_rows(relation_t *, tuple_id_t, storage_row_t, tuple_id_t *);
 db_result_t storage_put_row(relation_t *, storage_row_t, uint8_t);
+db_result_t storage_put_rows(relation_t *, storage_row_t, tuple_id_t);
 db_result_t storage_write_row(db_storage_id_t, storage_row_t, unsigned, char *);
 db_result_t storage_get_row_amount(relation_t *, tuple_id_t *);
 db_result_t storage_read_from(db_storage_id_t, void *, unsigned long, unsigned);
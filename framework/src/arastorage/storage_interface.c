@@ -523,6 +523,42 @@ db_result_t storage_get_row(relation_t *rel, tuple_id_t *tuple_id, storage_row_t
 	return DB_OK;
 }
 
+/*
+ * Read up to *count rows starting from tuple_id with one seek and one read.
+ * On return, *count holds the number of rows read.  A trailing partial
+ * row is an error, as in storage_get_row().
+ */
+db_result_t storage_get_rows(relation_t *rel, tuple_id_t tuple_id, storage_row_t rows, tuple_id_t *count)
+{
+	ssize_t r;
+
+	if (rel->row_length == 0 || *count == 0) {
+		*count = 0;
+		return DB_FINISHED;
+	}
+
+	if (storage_seek(rel->tuple_storage, (unsigned long)tuple_id * rel->row_length, SEEK_SET) == (off_t)-1) {
+		return DB_STORAGE_ERROR;
+	}
+
+	r = storage_read(rel->tuple_storage, rows, *count * rel->row_length);
+	if (r < 0) {
+		DB_LOG_E("DB: Reading failed on fd %d\n", rel->tuple_storage);
+		return DB_STORAGE_ERROR;
+	} else if (r % rel->row_length != 0) {
+		DB_LOG_E("DB: Incomplete record: %d < %d\n", r % rel->row_length, rel->row_length);
+		return DB_STORAGE_ERROR;
+	}
+
+	*count = (tuple_id_t)(r / rel->row_length);
+	if (*count == 0) {
+		return DB_FINISHED;
+	}
+
+	DB_LOG_D("DB: Read %d rows from relation %s\n", *count, rel->name);
+	return DB_OK;
+}
+
 db_result_t storage_put_row(relation_t *rel, storage_row_t row, uint8_t flag)
 {
 	db_result_t result;
@@ -541,6 +577,32 @@ db_result_t storage_put_row(relation_t *rel, storage_row_t row, uint8_t flag)
 	return result;
 }
 
+/* Append count consecutive rows to the tuple file with a single write. */
+db_result_t storage_put_rows(relation_t *rel, storage_row_t rows, tuple_id_t count)
+{
+	ssize_t r;
+	size_t length;
+
+	length = (size_t)rel->row_length * count;
+
+#ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
+	/* Rows still in the insert buffer must reach the file first to keep the order. */
+	if (DB_ERROR(storage_flush_insert_buffer())) {
+		return DB_STORAGE_ERROR;
+	}
+#endif
+
+	r = storage_write(rel->tuple_storage, rows, length);
+	if (r < 0 || (size_t)r != length) {
+		DB_LOG_E("DB: Failed to store %u rows\n", (unsigned)count);
+		return DB_STORAGE_ERROR;
+	}
+
+	rel->cardinality += count;
+	rel->next_row += count;
+	return DB_OK;
+}
+
 db_result_t storage_write_row(db_storage_id_t fd, storage_row_t row, unsigned length, char *filename)
 {
 #ifdef CONFIG_ARASTORAGE_ENABLE_WRITE_BUFFER
@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * libc/ttrace/lib_ttrace_ring.c
+ *
+ * The trace points of the binary trace ring: an event is reserved in the
+ * ring, stamped and filled in place, without going through the T-trace
+ * device.  Only the format string and the arguments of trace_begin() are
+ * kept; they are formatted when the trace is printed.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <ttrace.h>
+#include <tinyara/ttrace_internal.h>
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int trace_mark(int tag, char type, int8_t code)
+{
+	struct ttrace_event_s *event;
+
+	event = ttrace_reserve(tag);
+	if (event == NULL) {
+		return TTRACE_INVALID;
+	}
+
+	event->pid = getpid();
+	event->code = code;
+	event->fmt = NULL;
+
+	ttrace_commit(event, type);
+	return TTRACE_VALID;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_begin
+ *
+ * Description:
+ *   Record the beginning of a span.  Up to TTRACE_EVENT_NARGS arguments
+ *   are kept with the format, one for each conversion in it.
+ *
+ ****************************************************************************/
+
+int trace_begin(int tag, char *str, ...)
+{
+	struct ttrace_event_s *event;
+	const char *fmt;
+	va_list ap;
+	int nargs = 0;
+
+	event = ttrace_reserve(tag);
+	if (event == NULL) {
+		return TTRACE_INVALID;
+	}
+
+	event->pid = getpid();
+	event->fmt = str;
+
+	va_start(ap, str);
+	for (fmt = str; *fmt != '\0' && nargs < TTRACE_EVENT_NARGS; fmt++) {
+		if (*fmt != '%') {
+			continue;
+		}
+
+		if (fmt[1] == '%') {
+			fmt++;
+		} else {
+			event->args[nargs++] = va_arg(ap, uint32_t);
+		}
+	}
+	va_end(ap);
+
+	event->code = TTRACE_CODE_VARIABLE | nargs;
+
+	ttrace_commit(event, TTRACE_EVENT_TYPE_BEGIN);
+	return TTRACE_VALID;
+}
+
+int trace_begin_u(int tag, int8_t uid)
+{
+	return trace_mark(tag, TTRACE_EVENT_TYPE_BEGIN, TTRACE_CODE_UNIQUE | uid);
+}
+
+/****************************************************************************
+ * Name: trace_end
+ *
+ * Description:
+ *   Record the end of the last span begun by the task.
+ *
+ ****************************************************************************/
+
+int trace_end(int tag)
+{
+	return trace_mark(tag, TTRACE_EVENT_TYPE_END, TTRACE_CODE_UNIQUE);
+}
+
+int trace_end_u(int tag)
+{
+	return trace_end(tag);
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * arch/arm/src/armv7-r/arm_cyclecount.c
+ *
+ * The cycle counter of the performance monitors (PMCCNTR), counting every
+ * processor clock.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <stdint.h>
+
+#include <tinyara/arch.h>
+
+#include "sctlr.h"
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Bit 31 of PMCNTENSET enables the cycle counter */
+
+#define PMCNTENSET_C (1 << 31)
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_cyclecount_initialize
+ *
+ * Description:
+ *   Enable the performance monitors and start the cycle counter from zero,
+ *   without the divider, so that it counts every cycle.
+ *
+ ****************************************************************************/
+
+void up_cyclecount_initialize(void)
+{
+	unsigned int pmcr;
+
+	pmcr = cp15_rdpmcr();
+	pmcr &= ~PCMR_D;
+	pmcr |= PCMR_E | PCMR_C;
+	cp15_wrpmcr(pmcr);
+
+	cp15_wrpmcntenset(PMCNTENSET_C);
+}
+
+/****************************************************************************
+ * Name: up_cyclecount
+ *
+ * Description:
+ *   Return the current value of the cycle counter.
+ *
+ ****************************************************************************/
+
+uint32_t up_cyclecount(void)
+{
+	return cp15_rdpmccntr();
+}
+
+#endif							/* CONFIG_ARCH_HAVE_CYCLECOUNT */
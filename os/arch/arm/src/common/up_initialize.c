@@ -197,6 +197,12 @@ void up_initialize(void)
 	}
 #endif
 
+	/* Start the cycle counter, which is only read from now on */
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+	up_cyclecount_initialize();
+#endif
+
 	/* Initialize the system timer interrupt */
 
 #if !defined(CONFIG_SUPPRESS_INTERRUPTS) && !defined(CONFIG_SUPPRESS_TIMER_INTS) && \
@@ -40,6 +40,9 @@
 #include <tinyara/kmalloc.h>
 #include <tinyara/fs/fs.h>
 #include <tinyara/arch.h>
+#ifdef CONFIG_TTRACE_BINARY
+#include <tinyara/ttrace_internal.h>
+#endif
 
 #include <arch/irq.h>
 
@@ -80,7 +83,9 @@ struct ttrace_dev_s {
  ****************************************************************************/
 /* Character driver methods */
 static ssize_t ttrace_read(FAR struct file *, FAR char *, size_t);
+#ifndef CONFIG_TTRACE_BINARY
 static ssize_t ttrace_write(FAR struct file *, FAR const char *, size_t);
+#endif
 static int ttrace_ioctl(FAR struct file *, int, unsigned long);
 
 /****************************************************************************
@@ -91,7 +96,11 @@ static const struct file_operations g_ttracefops = {
 	0,            /* open */
 	0,            /* close */
 	ttrace_read,  /* read */
+#ifdef CONFIG_TTRACE_BINARY
+	0,            /* write: events are recorded straight into the ring */
+#else
 	ttrace_write, /* write */
+#endif
 	0,            /* seek */
 	ttrace_ioctl  /* ioctl */
 };
@@ -132,11 +141,15 @@ static ssize_t ttrace_read(FAR struct file *filep, FAR char *buffer, size_t len)
 	DEBUGASSERT(priv);
 	sched_lock();
 
+#ifdef CONFIG_TTRACE_BINARY
+	len = ttrace_ring_read(buffer, len);
+#else
 	ttdbg("buffer: %p, g_packets: %p, g_packets_size: %d\r\n", buffer, g_packets, priv->ttrace_head);
 	memcpy(buffer, g_packets, priv->ttrace_head);
 
 	memset((void *)g_packets, 0, priv->ttrace_head);
 	priv->ttrace_head = 0;
+#endif
 
 	sched_unlock();
 	return len;
@@ -146,6 +159,7 @@ static ssize_t ttrace_read(FAR struct file *filep, FAR char *buffer, size_t len)
  * Name: ttrace_write
  ****************************************************************************/
 
+#ifndef CONFIG_TTRACE_BINARY
 static ssize_t ttrace_write(FAR struct file *filep, FAR const char *buffer, size_t len)
 {
 	struct inode *inode = filep->f_inode;
@@ -169,6 +183,7 @@ static ssize_t ttrace_write(FAR struct file *filep, FAR const char *buffer, size
 	sched_unlock();
 	return len;
 }
+#endif
 
 /****************************************************************************
  * Name: ttrace_ioctl
@@ -187,10 +202,16 @@ static ssize_t ttrace_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 	case TTRACE_START:
 		g_state = TTRACE_STATE_RUNNING;
 		priv->ttrace_head = 0;
+#ifdef CONFIG_TTRACE_BINARY
+		ttrace_ring_start(g_selected_tag);
+#endif
 		break;
 	case TTRACE_FINISH:
 		g_selected_tag = 0;
 		g_state = TTRACE_STATE_IDLE;
+#ifdef CONFIG_TTRACE_BINARY
+		ttrace_ring_stop();
+#endif
 		break;
 	case TTRACE_INFO:
 		ttdbg("state: %d\r\n", g_state);
@@ -211,8 +232,12 @@ static ssize_t ttrace_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 		}
 		break;
 	case TTRACE_USED_BUFSIZE:
-		ttdbg("used bufsize: %d\r\n", priv->ttrace_head);
+#ifdef CONFIG_TTRACE_BINARY
+		ret = ttrace_ring_used();
+#else
 		ret = priv->ttrace_head;
+#endif
+		ttdbg("used bufsize: %d\r\n", ret);
 		break;
 	case TTRACE_BUFFER:
 		ttdbg("Resize of trace buffer is not supported yet.\r\n");
@@ -241,6 +266,10 @@ static ssize_t ttrace_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
 int ttrace_init(void)
 {
+#ifdef CONFIG_TTRACE_BINARY
+	ttrace_ring_initialize(g_packets, sizeof(g_packets));
+#endif
+
 	/* Register the syslog character driver */
 	return register_driver(CONFIG_TTRACE_DEVPATH, &g_ttracefops, 0666, &g_sysdev);
 }
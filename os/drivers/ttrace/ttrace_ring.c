@@ -0,0 +1,301 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * drivers/ttrace/ttrace_ring.c
+ *
+ * The binary trace ring.  The trace buffer holds a power of two number of
+ * fixed-size events.  Writers reserve the next event with an atomic
+ * increment of the head, without any lock, so that the kernel records
+ * context switches from the scheduler and trace_begin() and trace_end()
+ * record straight from the caller.  When the ring is full the oldest
+ * events are overwritten.  Events are read back when tracing is finished.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <tinyara/sched.h>
+#include <tinyara/ttrace_internal.h>
+
+#ifdef CONFIG_TTRACE_BINARY
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+struct ttrace_ring_s g_ttrace_ring;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ttrace_ring_calibrate
+ *
+ * Description:
+ *   Count the cycles during one tick of the system timer, so that the
+ *   events can be timed in microseconds when they are printed.
+ *
+ ****************************************************************************/
+
+static uint32_t ttrace_ring_calibrate(void)
+{
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+	systime_t ticks;
+	uint32_t cycles;
+
+	ticks = clock_systimer();
+	while (clock_systimer() == ticks) ;
+
+	ticks = clock_systimer();
+	cycles = ttrace_cycles();
+	while (clock_systimer() == ticks) ;
+
+	return ttrace_cycles() - cycles;
+#else
+	return 0;
+#endif
+}
+
+/****************************************************************************
+ * Name: ttrace_ring_note
+ *
+ * Description:
+ *   Record an event of the kernel which has a single argument.
+ *
+ ****************************************************************************/
+
+static void ttrace_ring_note(int tag, char type, uint32_t arg)
+{
+	FAR struct ttrace_event_s *event;
+
+	event = ttrace_reserve(tag);
+	if (event == NULL) {
+		return;
+	}
+
+	event->pid = getpid();
+	event->code = TTRACE_CODE_VARIABLE;
+	event->fmt = NULL;
+	event->args[0] = arg;
+
+	ttrace_commit(event, type);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ttrace_ring_initialize
+ *
+ * Description:
+ *   Lay the ring out in the trace buffer.
+ *
+ ****************************************************************************/
+
+void ttrace_ring_initialize(FAR char *buffer, size_t size)
+{
+	uintptr_t start = ((uintptr_t)buffer + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+	uint32_t nevents = 1;
+
+	size -= start - (uintptr_t)buffer;
+	while (nevents * 2 * sizeof(struct ttrace_event_s) <= size) {
+		nevents *= 2;
+	}
+
+	g_ttrace_ring.events = (FAR struct ttrace_event_s *)start;
+	g_ttrace_ring.mask = nevents - 1;
+	g_ttrace_ring.start.magic = TTRACE_HEADER_MAGIC;
+}
+
+/****************************************************************************
+ * Name: ttrace_ring_start
+ *
+ * Description:
+ *   Empty the ring and start recording the events of the given tags.
+ *
+ ****************************************************************************/
+
+void ttrace_ring_start(uint32_t tags)
+{
+	g_ttrace_ring.tags = 0;
+	memset(g_ttrace_ring.events, 0, (g_ttrace_ring.mask + 1) * sizeof(struct ttrace_event_s));
+	g_ttrace_ring.head = 0;
+
+	g_ttrace_ring.start.cycles_per_tick = ttrace_ring_calibrate();
+	g_ttrace_ring.start.ticks = clock_systimer();
+	g_ttrace_ring.start.cycles = ttrace_cycles();
+
+	g_ttrace_ring.tags = tags;
+}
+
+/****************************************************************************
+ * Name: ttrace_ring_stop
+ ****************************************************************************/
+
+void ttrace_ring_stop(void)
+{
+	g_ttrace_ring.tags = 0;
+}
+
+/****************************************************************************
+ * Name: ttrace_ring_used
+ *
+ * Description:
+ *   Return the number of bytes which ttrace_ring_read() returns.
+ *
+ ****************************************************************************/
+
+size_t ttrace_ring_used(void)
+{
+	uint32_t nevents = g_ttrace_ring.head;
+
+	if (nevents > g_ttrace_ring.mask + 1) {
+		nevents = g_ttrace_ring.mask + 1;
+	}
+
+	return sizeof(struct ttrace_header_s) + nevents * sizeof(struct ttrace_event_s);
+}
+
+/****************************************************************************
+ * Name: ttrace_ring_read
+ *
+ * Description:
+ *   Copy the header and as many events as fit in the buffer, from the
+ *   oldest one, and empty the ring.
+ *
+ ****************************************************************************/
+
+ssize_t ttrace_ring_read(FAR char *buffer, size_t len)
+{
+	struct ttrace_header_s header;
+	uint32_t head = g_ttrace_ring.head;
+	uint32_t size = g_ttrace_ring.mask + 1;
+	uint32_t first;
+	uint32_t index;
+	size_t done;
+
+	if (len < sizeof(struct ttrace_header_s)) {
+		return 0;
+	}
+
+	memcpy(&header, &g_ttrace_ring.start, sizeof(header));
+	header.nevents = head < size ? head : size;
+	header.lost = head - header.nevents;
+	first = head - header.nevents;
+
+	if (header.nevents > (len - sizeof(header)) / sizeof(struct ttrace_event_s)) {
+		header.nevents = (len - sizeof(header)) / sizeof(struct ttrace_event_s);
+	}
+
+	memcpy(buffer, &header, sizeof(header));
+	done = sizeof(header);
+
+	for (index = first; index != first + header.nevents; index++) {
+		memcpy(&buffer[done], &g_ttrace_ring.events[index & g_ttrace_ring.mask], sizeof(struct ttrace_event_s));
+		done += sizeof(struct ttrace_event_s);
+	}
+
+	memset(g_ttrace_ring.events, 0, size * sizeof(struct ttrace_event_s));
+	g_ttrace_ring.head = 0;
+	return done;
+}
+
+/****************************************************************************
+ * Name: trace_irq_enter, trace_irq_leave, trace_sem_wait and trace_sem_done
+ *
+ * Description:
+ *   Record the handling of an interrupt and the time a task spends blocked
+ *   on a semaphore.
+ *
+ ****************************************************************************/
+
+void trace_irq_enter(int irq)
+{
+	ttrace_ring_note(TTRACE_TAG_IRQ, TTRACE_EVENT_TYPE_IRQ, irq);
+}
+
+void trace_irq_leave(int irq)
+{
+	ttrace_ring_note(TTRACE_TAG_IRQ, TTRACE_EVENT_TYPE_IRQ_END, irq);
+}
+
+void trace_sem_wait(FAR void *sem)
+{
+	ttrace_ring_note(TTRACE_TAG_LOCK, TTRACE_EVENT_TYPE_SEM, (uintptr_t)sem);
+}
+
+void trace_sem_done(FAR void *sem)
+{
+	ttrace_ring_note(TTRACE_TAG_LOCK, TTRACE_EVENT_TYPE_SEM_END, (uintptr_t)sem);
+}
+
+/****************************************************************************
+ * Name: sched_note_start, sched_note_stop and sched_note_switch
+ *
+ * Description:
+ *   The scheduler instrumentation hooks.  Context switches are recorded
+ *   when the task tag is traced.
+ *
+ ****************************************************************************/
+
+void sched_note_start(FAR struct tcb_s *tcb)
+{
+}
+
+void sched_note_stop(FAR struct tcb_s *tcb)
+{
+}
+
+void sched_note_switch(FAR struct tcb_s *prev, FAR struct tcb_s *next)
+{
+	FAR struct ttrace_event_s *event;
+
+	event = ttrace_reserve(TTRACE_TAG_TASK);
+	if (event == NULL) {
+		return;
+	}
+
+	event->pid = next->pid;
+	event->code = TTRACE_CODE_VARIABLE;
+	event->fmt = NULL;
+	event->args[0] = (uint16_t)prev->pid | (uint32_t)prev->sched_priority << 16 | (uint32_t)prev->task_state << 24;
+	event->args[1] = (uint16_t)next->pid | (uint32_t)next->sched_priority << 16;
+#if CONFIG_TASK_NAME_SIZE > 0
+	strncpy((FAR char *)&event->args[2], next->name, TTRACE_EVENT_COMM_BYTES);
+#else
+	memset(&event->args[2], 0, TTRACE_EVENT_COMM_BYTES);
+#endif
+
+	ttrace_commit(event, TTRACE_EVENT_TYPE_SCHED);
+}
+
+#endif							/* CONFIG_TTRACE_BINARY */
@@ -73,6 +73,8 @@
 #include <crc16.h>
 #include <crc32.h>
 #include <tinyara/math.h>
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
 #include <tinyara/kmalloc.h>
 #include <tinyara/fs/fs.h>
 #include <tinyara/fs/ioctl.h>
@@ -155,6 +157,58 @@
 #endif
 
 #define SMART_MAX_ALLOCS        6
+
+/* The free sector index is a tournament tree over the erase blocks: every
+ * node holds the block with the highest allocation priority below it.
+ */
+
+#define SMART_FREEINDEX_NONE    0xFFFF
+#define SMART_FREEINDEX_UNWORN  0x1000
+
+/* Time source of the allocator statistics */
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+#define smart_timestamp()       up_cyclecount()
+#else
+#define smart_timestamp()       ((uint32_t)clock_systimer())
+#endif
+
+/* Count of the bytes programmed to the device */
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+#define smart_count_write(dev, nbytes) ((dev)->byteswritten += (nbytes))
+#else
+#define smart_count_write(dev, nbytes)
+#endif
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+#ifndef CONFIG_MTD_SMART_MAP_PAGES
+#define CONFIG_MTD_SMART_MAP_PAGES 8
+#endif
+
+/* With CONFIG_MTD_SMART_MINIMIZE_RAM, the logical to physical sector map is
+ * split in pages of SMART_MAP_PAGE_SECTORS logical sectors and only
+ * CONFIG_MTD_SMART_MAP_PAGES of them are kept in RAM.
+ */
+
+#define SMART_MAP_PAGE_SHIFT    6
+#define SMART_MAP_PAGE_SECTORS  (1 << SMART_MAP_PAGE_SHIFT)
+#define SMART_MAP_PAGE_MASK     (SMART_MAP_PAGE_SECTORS - 1)
+#define SMART_MAP_NOPAGE        0xFFFF
+#endif
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+/* A checkpoint slot holds a header sector followed by the saved RAM state.
+ * The slots are the last erase blocks of the device; the reservation is
+ * skipped if it takes more than 1/SMART_CKPT_MAXSHARE of the device.
+ */
+
+#define SMART_CKPT_MAGIC        0x534d4350
+#define SMART_CKPT_NSEGS        3
+#define SMART_CKPT_MAXSHARE     8
+#define SMART_CKPT_ADDRESS(d, s) \
+	((uint32_t)((d)->ckptbase + (s) * (d)->ckptblocks) * (d)->erasesize)
+#endif
 //#define CONFIG_MTD_SMART_PACK_COUNTS
 
 #ifndef CONFIG_MTD_SMART_ALLOC_DEBUG
@@ -215,14 +269,6 @@ static const uint8_t gWearBitToLevelMap4[] = {
  * Private Types
  ****************************************************************************/
 
-#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
-struct smart_cache_s {
-	uint16_t logical;			/* Logical sector number */
-	uint16_t physical;			/* Associated physical sector */
-	uint16_t birth;				/* The "birthday" of this entry */
-};
-#endif
-
 /* When CRC is enabled, we allocate sectors in memory only and only write
  * to the device when an actual writesector is performed.  If during the
  * alloc process we do a physical write, we would either have to hold off on
@@ -245,10 +291,14 @@ struct smart_struct_s {
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 	uint32_t unusedsectors;	/* Count of unused sectors (i.e. free when erased) */
 	uint32_t blockerases;		/* Count of unused sectors (i.e. free when erased) */
+	uint32_t alloccount;		/* Number of free sector allocations */
+	uint32_t allocmax;			/* Longest free sector allocation */
+	uint64_t alloctime;		/* Total time spent allocating free sectors */
+	uint32_t byteswritten;		/* Number of bytes programmed to the device */
 #endif
 	uint16_t reservedsector;    /* Number of reserved sector (i.e. logging sectors of journal) */
 	uint16_t neraseblocks;		/* Number of erase blocks or sub-sectors */
-	uint16_t lastallocblock;	/* Last  block we allocated a sector from */
+	uint16_t freeindexsize;	/* Number of leaves of the free sector index */
 	uint16_t freesectors;		/* Total number of free sectors */
 	uint16_t releasesectors;	/* Total number of released sectors */
 	uint16_t mtdBlksPerSector;	/* Number of MTD blocks per SMART Sector */
@@ -258,6 +308,7 @@ struct smart_struct_s {
 	uint32_t erasesize;			/* Size of an erase block */
 	FAR uint8_t *releasecount;	/* Count of released sectors per erase block */
 	FAR uint8_t *freecount;	/* Count of free sectors per erase block */
+	FAR uint16_t *freeindex;	/* Free sector index of the erase blocks */
 	FAR char *rwbuffer;			/* Our sector read/write buffer */
 	FAR uint8_t *bytebuffer;	/* Array of bytes to be used in smart_bytewrite */
 	char
@@ -290,11 +341,20 @@ struct smart_struct_s {
 	FAR uint16_t *sMap;			/* Virtual to physical sector map */
 #else
 	FAR uint8_t *sBitMap;		/* Virtual sector used bit-map */
-	FAR struct smart_cache_s *sCache;	/* Sector cache */
-	uint16_t cache_entries;	/* Number of valid entries in the cache */
+	FAR uint16_t *mappages;	/* Resident pages of the sector map */
+	FAR uint8_t *mapslot;		/* Resident slot + 1 of each map page, 0 if none */
+	uint16_t mapowner[CONFIG_MTD_SMART_MAP_PAGES];	/* Map page held by each slot */
+	uint32_t mapbirth[CONFIG_MTD_SMART_MAP_PAGES];	/* Last access of each slot */
+	uint32_t map_nextbirth;	/* Map page aging value */
 	uint16_t cache_lastlog;	/* Keep track of the last sector accessed */
 	uint16_t cache_lastphys;	/* Keep the physical sector number also */
-	uint16_t cache_nextbirth;	/* Sector cache aging value */
+#endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	uint16_t ckptbase;			/* First erase block of the checkpoint slots */
+	uint16_t ckptblocks;		/* Erase blocks per checkpoint slot, 0 if none */
+	uint8_t ckptnewest;			/* Slot of the newest checkpoint */
+	uint8_t ckptslot;			/* Slot + 1 of a checkpoint matching the device */
+	uint32_t ckptgen;			/* Generation of the newest checkpoint */
 #endif
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	FAR uint8_t *erasecounts;	/* Number of erases for each erase block */
@@ -316,6 +376,38 @@ struct smart_multiroot_device_s {
 };
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+/* Header of a checkpoint slot.  The CRC covers the saved data, then this
+ * header with the crc field zeroed.  The stale byte is left erased when
+ * the checkpoint is written and programmed when the device is modified.
+ */
+
+struct smart_checkpoint_s {
+	uint32_t magic;				/* SMART_CKPT_MAGIC */
+	uint32_t generation;		/* Incremented with every checkpoint */
+	uint32_t crc;				/* CRC-32 of the data and the header */
+	uint32_t uneven_wearcount;	/* Saved dev->uneven_wearcount */
+	uint32_t blockerases;		/* Saved dev->blockerases */
+	uint16_t sectorsize;		/* Geometry the data was saved with */
+	uint16_t totalsectors;
+	uint16_t neraseblocks;
+	uint16_t freesectors;		/* Saved sector counts */
+	uint16_t releasesectors;
+	uint8_t formatversion;		/* Saved format information */
+	uint8_t namesize;
+	uint8_t rootdirentries;
+	uint8_t wearflags;			/* Saved dev->wearflags */
+	uint8_t stale;				/* Erased while the checkpoint is valid */
+};
+
+/* A piece of the RAM state saved in a checkpoint */
+
+struct smart_ckptseg_s {
+	FAR uint8_t *data;
+	size_t len;
+};
+#endif
+
 /* Format 1 sector header definition */
 
 #if SMART_STATUS_VERSION == 1
@@ -394,8 +486,17 @@ static ssize_t smart_write(FAR struct inode *inode, const unsigned char *buffer,
 #endif
 static int smart_geometry(FAR struct inode *inode, struct geometry *geometry);
 static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg);
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_save(FAR struct smart_struct_s *dev);
+static int smart_checkpoint_invalidate(FAR struct smart_struct_s *dev);
+#endif
+
+static ssize_t smart_bwrite(FAR struct smart_struct_s *dev, off_t startblock, size_t nblocks, FAR const uint8_t *buffer);
+static int smart_erase(FAR struct smart_struct_s *dev, off_t startblock, size_t nblocks);
 
 static uint16_t smart_findfreephyssector(FAR struct smart_struct_s *dev, uint8_t canrelocate);
+static void smart_freeindex_update(FAR struct smart_struct_s *dev, uint16_t block);
+static void smart_freeindex_build(FAR struct smart_struct_s *dev);
 
 #ifdef CONFIG_FS_WRITABLE
 static int smart_writesector(FAR struct smart_struct_s *dev, unsigned long arg);
@@ -409,6 +510,10 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 
 static int smart_relocate_sector(FAR struct smart_struct_s *dev, uint16_t oldsector, uint16_t newsector);
 
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_map_reset(FAR struct smart_struct_s *dev);
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -519,7 +624,23 @@ static int smart_open(FAR struct inode *inode)
 
 static int smart_close(FAR struct inode *inode)
 {
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	FAR struct smart_struct_s *dev;
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+	dev = ((FAR struct smart_multiroot_device_s *)inode->i_private)->dev;
+#else
+	dev = (FAR struct smart_struct_s *)inode->i_private;
+#endif
+#endif
+
 	fvdbg("Entry\n");
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	/* Save the sector map so that the next mount does not scan the device */
+
+	(void)smart_checkpoint_save(dev);
+#endif
 	return OK;
 }
 
@@ -831,7 +952,7 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 			/* Erase the erase block */
 
 			eraseblock = alignedblock / mtdBlksPerErase;
-			ret = MTD_ERASE(dev->mtd, eraseblock, 1);
+			ret = smart_erase(dev, eraseblock, 1);
 			if (ret < 0) {
 				fdbg("Erase block=%d failed: %d\n", eraseblock, ret);
 
@@ -855,7 +976,7 @@ static ssize_t smart_write(FAR struct inode *inode, FAR const unsigned char *buf
 		/* Try to write to the sector. */
 
 		fdbg("Write MTD block %d from offset %d\n", nextblock, offset);
-		nxfrd = MTD_BWRITE(dev->mtd, nextblock, blkstowrite, &buffer[offset]);
+		nxfrd = smart_bwrite(dev, nextblock, blkstowrite, &buffer[offset]);
 		if (nxfrd != blkstowrite) {
 			/* The block is not empty!!  What to do? */
 
@@ -1002,11 +1123,17 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 		dev->sBitMap = NULL;
 	}
 
-	dev->cache_entries = 0;
-	dev->cache_lastlog = 0xFFFF;
-	dev->cache_nextbirth = 0;
+	if (dev->mappages != NULL) {
+		smart_free(dev, dev->mappages);
+		dev->mappages = NULL;
+	}
 #endif
 
+	if (dev->freeindex != NULL) {
+		smart_free(dev, dev->freeindex);
+		dev->freeindex = NULL;
+	}
+
 	if (dev->rwbuffer != NULL) {
 		smart_free(dev, dev->rwbuffer);
 		dev->rwbuffer = NULL;
@@ -1105,18 +1232,18 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 	allocsize = dev->neraseblocks << 1;
 #endif
 
-	/* Allocate the sector cache */
-
-	if (dev->sCache == NULL) {
-		dev->sCache = (FAR struct smart_cache_s *)smart_malloc(dev, CONFIG_MTD_SMART_SECTOR_CACHE_SIZE * sizeof(struct smart_cache_s) + allocsize, "Sector Cache");
-	}
+	/* Allocate the resident map pages, followed by the count arrays and the
+	 * resident slot of each map page.
+	 */
 
-	if (!dev->sCache) {
-		fdbg("Error allocating SMART sector cache\n");
+	dev->mappages = (FAR uint16_t *)smart_malloc(dev, CONFIG_MTD_SMART_MAP_PAGES * SMART_MAP_PAGE_SECTORS * sizeof(uint16_t) + allocsize + ((totalsectors + SMART_MAP_PAGE_MASK) >> SMART_MAP_PAGE_SHIFT), "Sector map pages");
+	if (!dev->mappages) {
+		fdbg("Error allocating SMART sector map pages\n");
 		goto errexit;
 	}
 
-	dev->releasecount = (FAR uint8_t *)dev->sCache + (CONFIG_MTD_SMART_SECTOR_CACHE_SIZE * sizeof(struct smart_cache_s));
+	dev->releasecount = (FAR uint8_t *)&dev->mappages[CONFIG_MTD_SMART_MAP_PAGES * SMART_MAP_PAGE_SECTORS];
+	dev->mapslot = dev->releasecount + allocsize;
 
 #ifdef CONFIG_MTD_SMART_PACK_COUNTS
 	if (dev->sectorsPerBlk > 16) {
@@ -1131,8 +1258,24 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
 	dev->freecount = dev->releasecount + dev->neraseblocks;
 #endif
 
+	smart_map_reset(dev);
 #endif							/* CONFIG_MTD_SMART_MINIMIZE_RAM */
 
+	/* Allocate the free sector index.  Its leaves are the erase blocks. */
+
+	dev->freeindexsize = 2;
+	while (dev->freeindexsize < dev->neraseblocks) {
+		dev->freeindexsize <<= 1;
+	}
+
+	dev->freeindex = (FAR uint16_t *)smart_malloc(dev, dev->freeindexsize * sizeof(uint16_t), "Free index");
+	if (!dev->freeindex) {
+		fdbg("Error allocating SMART free sector index\n");
+		goto errexit;
+	}
+
+	memset(dev->freeindex, 0xFF, dev->freeindexsize * sizeof(uint16_t));
+
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	/* Allocate a buffer to hold the erase counts */
 
@@ -1202,11 +1345,16 @@ errexit:
 		smart_free(dev, dev->sBitMap);
 	}
 
-	if (dev->sCache) {
-		smart_free(dev, dev->sCache);
+	if (dev->mappages) {
+		smart_free(dev, dev->mappages);
 	}
 #endif
 
+	if (dev->freeindex) {
+		smart_free(dev, dev->freeindex);
+		dev->freeindex = NULL;
+	}
+
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 	if (dev->wearstatus) {
 		smart_free(dev, dev->wearstatus);
@@ -1223,6 +1371,53 @@ errexit:
 	return -ENOMEM;
 }
 
+/****************************************************************************
+ * Name: smart_bwrite
+ *
+ * Description: Writes blocks to the underlying MTD device.  This, together
+ *              with smart_erase() and smart_bytewrite(), is the only way
+ *              the device is changed, so it first marks a checkpoint that
+ *              matches the device as stale.
+ *
+ ****************************************************************************/
+
+static ssize_t smart_bwrite(FAR struct smart_struct_s *dev, off_t startblock, size_t nblocks, FAR const uint8_t *buffer)
+{
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	int ret;
+
+	ret = smart_checkpoint_invalidate(dev);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
+	smart_count_write(dev, nblocks * dev->geo.blocksize);
+	return MTD_BWRITE(dev->mtd, startblock, nblocks, buffer);
+}
+
+/****************************************************************************
+ * Name: smart_erase
+ *
+ * Description: Erases blocks of the underlying MTD device, after marking a
+ *              checkpoint that matches the device as stale.
+ *
+ ****************************************************************************/
+
+static int smart_erase(FAR struct smart_struct_s *dev, off_t startblock, size_t nblocks)
+{
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	int ret;
+
+	ret = smart_checkpoint_invalidate(dev);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
+	return MTD_ERASE(dev->mtd, startblock, nblocks);
+}
+
 /****************************************************************************
  * Name: smart_bytewrite
  *
@@ -1237,10 +1432,19 @@ errexit:
 static ssize_t smart_bytewrite(FAR struct smart_struct_s *dev, size_t offset, int nbytes, FAR const uint8_t *buffer)
 {
 	ssize_t ret;
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	ret = smart_checkpoint_invalidate(dev);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
 #ifdef CONFIG_MTD_BYTE_WRITE
 	/* Check if the underlying MTD device supports write */
 
 	if (dev->mtd->write != NULL) {
+		smart_count_write(dev, nbytes);
 		ret = MTD_WRITE(dev->mtd, offset, nbytes, buffer);
 		goto errout;
 	} else
@@ -1272,7 +1476,7 @@ static ssize_t smart_bytewrite(FAR struct smart_struct_s *dev, size_t offset, in
 
 		/* Write the data back to the device */
 
-		ret = MTD_BWRITE(dev->mtd, startblock, nblocks, (FAR uint8_t *)dev->bytebuffer);
+		ret = smart_bwrite(dev, startblock, nblocks, (FAR uint8_t *)dev->bytebuffer);
 		if (ret < 0) {
 			fdbg("Error %d writing to device\n", -ret);
 			goto errout;
@@ -1285,176 +1489,233 @@ errout:
 }
 
 /****************************************************************************
- * Name: smart_add_sector_to_cache
+ * Name: smart_map_reset
  *
- * Description: Adds a logical to physical sector maaping to the sector
- *              map cache.  The cache is used to minimize RAM by eliminating
- *              a one-to-one mapping of all logical sectors and only keeping
- *              a fixed number of mappings per the
- *              CONFIG_MTD_SMART_SECTOR_CACHE_SIZE parameter.  Sectors are
- *              automatically managed and removed based on the time since
- *              they were accessed last.
+ * Description: Empties the logical to physical sector map.  The resident
+ *              slots are given to the lowest map pages, which smartfs uses
+ *              first, so that the volume scan fills them in.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
-static int smart_add_sector_to_cache(FAR struct smart_struct_s *dev, uint16_t logical, uint16_t physical, int line)
+static void smart_map_reset(FAR struct smart_struct_s *dev)
 {
-	uint16_t index, x;
-	uint16_t oldest;
-
-	/* If we aren't full yet, just add the sector to the end of the list */
-
-	index = 1;
-	if (dev->cache_entries < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE) {
-		index = dev->cache_entries++;
-	} else {
-		/* Cache is full.  We must find the least accessed entry and replace it */
-
-		oldest = 0xFFFF;
-		for (x = 0; x < CONFIG_MTD_SMART_SECTOR_CACHE_SIZE; x++) {
-			/* Never replace cache entries for system sectors */
-
-			if (dev->sCache[x].logical < dev->reservedsector) {
-				continue;
-			}
+	uint16_t npages;
+	uint16_t slot;
 
-			/* If the hit count is zero, then choose this entry */
+	npages = (dev->totalsectors + SMART_MAP_PAGE_MASK) >> SMART_MAP_PAGE_SHIFT;
+	memset(dev->mapslot, 0, npages);
+	memset(dev->mappages, 0xFF, CONFIG_MTD_SMART_MAP_PAGES * SMART_MAP_PAGE_SECTORS * sizeof(uint16_t));
 
-			if (dev->sCache[x].birth < oldest) {
-				oldest = dev->sCache[x].birth;
-				index = x;
-			}
-		}
-	}
-
-	/* Now add the sector at index */
-
-	dev->sCache[index].logical = logical;
-	dev->sCache[index].physical = physical;
-	dev->sCache[index].birth = dev->cache_nextbirth++;
-	dev->cache_lastlog = logical;
-	dev->cache_lastphys = physical;
-	if (dev->debuglevel > 1) {
-		dbg("Add Cache sector:  Log=%d, Phys=%d at index %d from line %d\n", logical, physical, index, line);
-	}
-
-	/* Test if the birthdays need to be adjusted */
-
-	if (oldest >= CONFIG_MTD_SMART_SECTOR_CACHE_SIZE + 1024) {
-		for (x = 0; x < dev->cache_entries; x++) {
-			dev->sCache[x].birth -= 1024;
+	for (slot = 0; slot < CONFIG_MTD_SMART_MAP_PAGES; slot++) {
+		if (slot < npages) {
+			dev->mapowner[slot] = slot;
+			dev->mapslot[slot] = slot + 1;
+		} else {
+			dev->mapowner[slot] = SMART_MAP_NOPAGE;
 		}
 
-		dev->cache_nextbirth -= 1024;
+		dev->mapbirth[slot] = 0;
 	}
 
-	return index;
+	dev->map_nextbirth = 1;
+	dev->cache_lastlog = 0xFFFF;
 }
 #endif
 
 /****************************************************************************
- * Name: smart_cache_lookup
+ * Name: smart_map_fault
  *
- * Description: Perform a cache lookup for the requested logical sector.
- *              If the sector is in the cache, then update the hitcount and
- *              return the physical mapping.  If a cache miss occurs, then
- *              the routine will scan the volume to find the logical sector
- *              and add / replace a cache entry with the newly located sector.
+ * Description: Makes a page of the sector map resident, replacing the least
+ *              recently used one.  The page is rebuilt from the headers of
+ *              the sectors in use: erase blocks without any committed
+ *              sector are skipped, the scan of an erase block stops after
+ *              its last committed sector and the whole scan stops as soon
+ *              as all used logical sectors of the page are found.  In the
+ *              worst case that is still a read of every committed sector
+ *              header; the pages have no copy on the flash.  Returns the
+ *              slot of the page.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
-static uint16_t smart_cache_lookup(FAR struct smart_struct_s *dev, uint16_t logical)
+static int smart_map_fault(FAR struct smart_struct_s *dev, uint16_t page)
 {
-	int ret;
-	uint16_t block, sector;
-	uint16_t x, physical, logicalsector;
 	struct smart_sect_header_s header;
-	size_t readaddress;
+	FAR uint16_t *entries;
+	uint16_t logical;
+	uint16_t physical;
+	uint16_t block;
+	uint16_t sector;
+	uint16_t slot;
+	uint16_t x;
+	int used;
+	int found;
+	int live;
+	int seen;
+	int ret;
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+	FAR struct smart_allocsector_s *allocsect;
+#endif
 
-	physical = 0xFFFF;
+	/* Take a free slot or else the least recently used one */
 
-	/* Test if searching for the last sector used */
+	slot = 0;
+	for (x = 0; x < CONFIG_MTD_SMART_MAP_PAGES; x++) {
+		if (dev->mapowner[x] == SMART_MAP_NOPAGE) {
+			slot = x;
+			break;
+		}
 
-	if (logical == dev->cache_lastlog) {
-		return dev->cache_lastphys;
+		if (dev->mapbirth[x] < dev->mapbirth[slot]) {
+			slot = x;
+		}
 	}
 
-	/* First search for the entry in the cache */
+	if (dev->mapowner[slot] != SMART_MAP_NOPAGE) {
+		dev->mapslot[dev->mapowner[slot]] = 0;
+		dev->mapowner[slot] = SMART_MAP_NOPAGE;
+	}
 
-	for (x = 0; x < dev->cache_entries; x++) {
-		if (dev->sCache[x].logical == logical) {
-			/* Entry found in the cache.  Grab the physical mapping. */
+	entries = &dev->mappages[slot << SMART_MAP_PAGE_SHIFT];
+	memset(entries, 0xFF, SMART_MAP_PAGE_SECTORS * sizeof(uint16_t));
 
-			physical = dev->sCache[x].physical;
-			break;
+	/* Count the used logical sectors of the page */
+
+	used = 0;
+	for (x = page << SMART_MAP_PAGE_SHIFT; x < ((page + 1) << SMART_MAP_PAGE_SHIFT) && x < dev->totalsectors; x++) {
+		if (dev->sBitMap[x >> 3] & (1 << (x & 0x07))) {
+			used++;
 		}
 	}
 
-	/* If the entry wasn't found in the cache, then we must search the volume
-	 * for it and add it to the cache.
-	 */
+	found = 0;
 
-	if (physical == 0xFFFF) {
-		/* Now scan the MTD device.  Instead of scanning start to end, we
-		 * span the erase blocks and read one sector from each at a time.
-		 * this helps speed up the search on volumes that aren't full
-		 * because of sector allocation scheme will use the lower sector
-		 * numbers in each erase block first.
-		 */
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+	/* Sectors allocated but not written yet are only in the alloc list */
 
-		for (sector = 0; sector < dev->sectorsPerBlk && physical == 0xFFFF; sector++) {
-			/* Now scan across each erase block */
+	for (allocsect = dev->allocsector; allocsect != NULL; allocsect = allocsect->next) {
+		if ((allocsect->logical >> SMART_MAP_PAGE_SHIFT) == page) {
+			entries[allocsect->logical & SMART_MAP_PAGE_MASK] = allocsect->physical;
+			found++;
+		}
+	}
+#endif
 
-			for (block = 0; block < dev->geo.neraseblocks; block++) {
-				/* Calculate the read address for this sector */
+	for (block = 0; block < dev->neraseblocks && found < used; block++) {
+		/* Number of committed sectors not released in this erase block */
 
-				readaddress = block * dev->erasesize + sector * CONFIG_MTD_SMART_SECTOR_SIZE;
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+		live = dev->availSectPerBlk - smart_get_count(dev, dev->freecount, block) - smart_get_count(dev, dev->releasecount, block);
+#else
+		live = dev->availSectPerBlk - dev->freecount[block] - dev->releasecount[block];
+#endif
 
-				/* Read the header for this sector */
+		seen = 0;
+		for (sector = 0; sector < dev->availSectPerBlk && seen < live && found < used; sector++) {
+			/* Read the header for this sector */
 
-				ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s), (FAR uint8_t *)&header);
-				if (ret != sizeof(struct smart_sect_header_s)) {
-					goto err_out;
-				}
+			physical = block * dev->sectorsPerBlk + sector;
+			ret = MTD_READ(dev->mtd, (size_t)physical * dev->mtdBlksPerSector * dev->geo.blocksize, sizeof(struct smart_sect_header_s), (FAR uint8_t *)&header);
+			if (ret != sizeof(struct smart_sect_header_s)) {
+				fdbg("Error reading physical sector %d\n", physical);
+				return -EIO;
+			}
 
-				/* Get the logical sector number for this physical sector */
+			if (header.status == CONFIG_SMARTFS_ERASEDSTATE || !SECTOR_IS_COMMITTED(header) || SECTOR_IS_RELEASED(header)) {
+				continue;
+			}
 
-				logicalsector = *((FAR uint16_t *)header.logicalsector);
-#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
-				if (logicalsector == 0) {
-					continue;
-				}
+			seen++;
+			if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION) {
+				continue;
+			}
+
+			logical = UINT8TOUINT16(header.logicalsector);
+			if ((logical >> SMART_MAP_PAGE_SHIFT) == page && entries[logical & SMART_MAP_PAGE_MASK] == 0xFFFF) {
+				entries[logical & SMART_MAP_PAGE_MASK] = physical;
+				found++;
+			}
+		}
+	}
+
+	dev->mapowner[slot] = page;
+	dev->mapslot[page] = slot + 1;
+	if (dev->debuglevel > 1) {
+		dbg("Map page %d in slot %d:  %d of %d sectors found\n", page, slot, found, used);
+	}
+
+	return slot;
+}
 #endif
 
-				/* Test if this sector has been committed */
+/****************************************************************************
+ * Name: smart_add_sector_to_cache
+ *
+ * Description: Adds a logical to physical sector mapping to the sector
+ *              map, if the page of the logical sector is resident.  A page
+ *              which isn't resident is rebuilt from the device when one of
+ *              its sectors is looked up.
+ *
+ ****************************************************************************/
 
-				if (!(SECTOR_IS_COMMITTED(header))) {
-					continue;
-				}
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static void smart_add_sector_to_cache(FAR struct smart_struct_s *dev, uint16_t logical, uint16_t physical, int line)
+{
+	uint8_t slot;
 
-				/* Test if this sector has been release and skip it if it has */
+	slot = dev->mapslot[logical >> SMART_MAP_PAGE_SHIFT];
+	if (slot != 0) {
+		dev->mappages[((slot - 1) << SMART_MAP_PAGE_SHIFT) + (logical & SMART_MAP_PAGE_MASK)] = physical;
+		dev->mapbirth[slot - 1] = dev->map_nextbirth++;
+	}
 
-				if (SECOR_IS_RELEASED(header)) {
-					continue;
-				}
+	dev->cache_lastlog = logical;
+	dev->cache_lastphys = physical;
+	if (dev->debuglevel > 1) {
+		dbg("Add Cache sector:  Log=%d, Phys=%d at slot %d from line %d\n", logical, physical, slot, line);
+	}
+}
+#endif
 
-				if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION) {
-					continue;
-				}
+/****************************************************************************
+ * Name: smart_cache_lookup
+ *
+ * Description: Returns the physical sector of the requested logical sector.
+ *              Sectors which aren't used are answered from the bitmap, the
+ *              others from their page of the sector map, which is made
+ *              resident first if needed.
+ *
+ ****************************************************************************/
 
-				/* Test if this is the sector we are looking for */
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+static uint16_t smart_cache_lookup(FAR struct smart_struct_s *dev, uint16_t logical)
+{
+	uint16_t physical;
+	int slot;
 
-				if (logicalsector == logical) {
-					/* This is the sector we are looking for!  Add it to the cache */
+	/* Test if searching for the last sector used */
 
-					physical = block * dev->sectorsPerBlk + sector;
-					smart_add_sector_to_cache(dev, logical, physical, __LINE__);
-					break;
-				}
+	if (logical == dev->cache_lastlog) {
+		return dev->cache_lastphys;
+	}
+
+	if (logical >= dev->totalsectors) {
+		return 0xFFFF;
+	}
+
+	physical = 0xFFFF;
+	if (dev->sBitMap[logical >> 3] & (1 << (logical & 0x07))) {
+		slot = dev->mapslot[logical >> SMART_MAP_PAGE_SHIFT] - 1;
+		if (slot < 0) {
+			slot = smart_map_fault(dev, logical >> SMART_MAP_PAGE_SHIFT);
+			if (slot < 0) {
+				return 0xFFFF;
 			}
 		}
+
+		dev->mapbirth[slot] = dev->map_nextbirth++;
+		physical = dev->mappages[(slot << SMART_MAP_PAGE_SHIFT) + (logical & SMART_MAP_PAGE_MASK)];
 	}
 
 	/* Update the last logical sector found variable */
@@ -1462,7 +1723,6 @@ static uint16_t smart_cache_lookup(FAR struct smart_struct_s *dev, uint16_t logi
 	dev->cache_lastlog = logical;
 	dev->cache_lastphys = physical;
 
-err_out:
 	return physical;
 }
 #endif
@@ -1470,40 +1730,22 @@ err_out:
 /****************************************************************************
  * Name: smart_update_cache
  *
- * Description: Updates a cache entry (if present) replacing the logical
- *              sector's physical sector mapping with the new one provided.
- *              This does not affect the hit count.
+ * Description: Updates the logical sector's physical sector mapping with
+ *              the new one provided, if its page of the sector map is
+ *              resident.  This does not affect the page's age.
  *
  ****************************************************************************/
 
 #ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
 static void smart_update_cache(FAR struct smart_struct_s *dev, uint16_t logical, uint16_t physical)
 {
-	uint16_t x;
-
-	/* Scan through all cache entries and find the logical sector entry */
-
-	for (x = 0; x < dev->cache_entries; x++) {
-		if (dev->sCache[x].logical == logical) {
-			/* Entry found.  Update it's physical mapping */
-
-			dev->sCache[x].physical = physical;
+	uint8_t slot;
 
-			/* If we are freeing a sector, then remove the logical entry from
-			   the cache.
-			 */
-
-			if (physical == 0xFFFF) {
-				dev->sCache[x].logical = dev->sCache[dev->cache_entries - 1].logical;
-				dev->sCache[x].physical = dev->sCache[dev->cache_entries - 1].physical;
-				dev->cache_entries--;
-			}
-
-			if (dev->debuglevel > 1) {
-				dbg("Update Cache:  Log=%d, Phys=%d at index %d\n", logical, physical, x);
-			}
-
-			break;
+	slot = dev->mapslot[logical >> SMART_MAP_PAGE_SHIFT];
+	if (slot != 0) {
+		dev->mappages[((slot - 1) << SMART_MAP_PAGE_SHIFT) + (logical & SMART_MAP_PAGE_MASK)] = physical;
+		if (dev->debuglevel > 1) {
+			dbg("Update Cache:  Log=%d, Phys=%d at slot %d\n", logical, physical, slot);
 		}
 	}
 
@@ -1633,50 +1875,534 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev, uint16_t block,
 		 * to keep track of the number of times this has happened.
 		 */
 
-		level = 15;
-		dev->uneven_wearcount++;
+		level = 15;
+		dev->uneven_wearcount++;
+	}
+
+	bits = gWearLevelToBitMap4[level];
+
+	if (block & 0x01) {
+		/* Use the upper nibble */
+
+		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] &= 0x0F;
+		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] |= bits << 4;
+	} else {
+		/* Use the lower nibble */
+
+		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] &= 0xF0;
+		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] |= bits;
+	}
+
+	/* Mark wear bits as dirty */
+
+	dev->wearflags |= SMART_WEARFLAGS_WRITE_NEEDED;
+	smart_freeindex_update(dev, block);
+
+	/* Test if min / max need to be updated */
+
+	if (oldlevel + 1 == level) {
+		/* Test if max needs to be updated */
+
+		if (level > dev->maxwearlevel) {
+			dev->maxwearlevel = level;
+		}
+
+		/* Test if this was the min level.  If it was, then
+		   we need to rescan for min. */
+
+		if (oldlevel == dev->minwearlevel) {
+			smart_find_wear_minmax(dev);
+
+			if (oldlevel != dev->minwearlevel) {
+				fvdbg("##### New min wear level = %d\n", dev->minwearlevel);
+			}
+		}
+	}
+
+	return 0;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_register_rootdirs
+ *
+ * Description: Registers the block devices of the root directories after
+ *              the first one, from the format information of the volume.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+static int smart_register_rootdirs(FAR struct smart_struct_s *dev)
+{
+	int x;
+	char devname[22];
+	FAR struct smart_multiroot_device_s *rootdirdev;
+
+	/* If rootdirentries is greater than 1, then we need to register
+	 * additional block devices.
+	 */
+
+	for (x = 1; x < dev->rootdirentries; x++) {
+		if (dev->partname[0] != '\0') {
+			snprintf(dev->rwbuffer, sizeof(devname), "/dev/smart%d%sd%d", dev->minor, dev->partname, x + 1);
+		} else {
+			snprintf(devname, sizeof(devname), "/dev/smart%dd%d", dev->minor, x + 1);
+		}
+
+		/* Inode private data is a reference to a struct containing
+		 * the SMART device structure and the root directory number.
+		 */
+
+		rootdirdev = (struct smart_multiroot_device_s *)smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
+		if (rootdirdev == NULL) {
+			fdbg("Memory alloc failed\n");
+			return -ENOMEM;
+		}
+
+		/* Populate the rootdirdev */
+
+		rootdirdev->dev = dev;
+		rootdirdev->rootdirnum = x;
+		(void)register_blockdriver(dev->rwbuffer, &g_bops, 0, rootdirdev);
+
+		/* Inode private data is a reference to the SMART device structure */
+
+		(void)register_blockdriver(devname, &g_bops, 0, rootdirdev);
+	}
+
+	return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_reserve
+ *
+ * Description: Takes two checkpoint slots off the end of the device, each
+ *              large enough for the state of a volume with the configured
+ *              sector size.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static void smart_checkpoint_reserve(FAR struct smart_struct_s *dev)
+{
+	uint32_t erasesize;
+	uint32_t nsectors;
+	uint32_t size;
+	uint32_t nblocks;
+
+	dev->ckptbase = 0;
+	dev->ckptblocks = 0;
+	dev->ckptnewest = 0;
+	dev->ckptslot = 0;
+	dev->ckptgen = 0;
+
+	erasesize = dev->geo.erasesize;
+	if (erasesize == 0) {
+		erasesize = 262144;
+	}
+
+	nsectors = dev->geo.neraseblocks * (erasesize / CONFIG_MTD_SMART_SECTOR_SIZE);
+	if (nsectors > 65534) {
+		nsectors = 65534;
+	}
+
+	/* The header sector, the map, the two count arrays and the wear bits */
+
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+	size = nsectors * sizeof(uint16_t);
+#else
+	size = (nsectors + 7) >> 3;
+#endif
+	size += CONFIG_MTD_SMART_SECTOR_SIZE + (dev->geo.neraseblocks << 1) + (dev->geo.neraseblocks >> SMART_WEAR_BIT_DIVIDE);
+	nblocks = (size + erasesize - 1) / erasesize;
+
+	if (nblocks * 2 * SMART_CKPT_MAXSHARE > dev->geo.neraseblocks) {
+		fdbg("Device too small for a checkpoint\n");
+		return;
+	}
+
+	dev->ckptblocks = nblocks;
+	dev->geo.neraseblocks -= nblocks * 2;
+	dev->ckptbase = dev->geo.neraseblocks;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_segments
+ *
+ * Description: Lists the RAM state saved in a checkpoint: the logical
+ *              sector map (or the used sector bitmap), the release and free
+ *              counts and the wear status bits.  Returns the number of
+ *              segments.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_segments(FAR struct smart_struct_s *dev, FAR struct smart_ckptseg_s *segs)
+{
+	int nsegs = 0;
+
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+	/* The count arrays follow the map in the same allocation */
+
+	segs[nsegs].data = (FAR uint8_t *)dev->sMap;
+	segs[nsegs++].len = dev->totalsectors * sizeof(uint16_t) + (dev->neraseblocks << 1);
+#else
+	segs[nsegs].data = dev->sBitMap;
+	segs[nsegs++].len = (dev->totalsectors + 7) >> 3;
+	segs[nsegs].data = dev->releasecount;
+	segs[nsegs++].len = dev->mapslot - dev->releasecount;
+#endif
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	segs[nsegs].data = dev->wearstatus;
+	segs[nsegs++].len = dev->neraseblocks >> SMART_WEAR_BIT_DIVIDE;
+#endif
+
+	return nsegs;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_load
+ *
+ * Description: Restores the state of the device from the newest checkpoint
+ *              if it still matches the device.  Called by smart_scan()
+ *              once the sector size is known.  Any error means the full
+ *              scan must be done.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_load(FAR struct smart_struct_s *dev)
+{
+	struct smart_checkpoint_s hdr;
+	struct smart_ckptseg_s segs[SMART_CKPT_NSEGS];
+	uint32_t address;
+	uint32_t size;
+	uint32_t crc;
+	int nsegs;
+	int slot;
+	int x;
+	int ret;
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+	uint16_t npages;
+#endif
+
+	dev->ckptslot = 0;
+	if (dev->ckptblocks == 0 || dev->erasesize == 0) {
+		return -ENOENT;
+	}
+
+	/* Find the newest checkpoint.  The older one was made stale before the
+	 * newest was written.
+	 */
+
+	slot = -1;
+	for (x = 0; x < 2; x++) {
+		ret = MTD_READ(dev->mtd, SMART_CKPT_ADDRESS(dev, x), sizeof(hdr), (FAR uint8_t *)&hdr);
+		if (ret != sizeof(hdr)) {
+			return -EIO;
+		}
+
+		if (hdr.magic == SMART_CKPT_MAGIC && (slot < 0 || hdr.generation > dev->ckptgen)) {
+			slot = x;
+			dev->ckptgen = hdr.generation;
+		}
+	}
+
+	if (slot < 0) {
+		return -ENOENT;
+	}
+
+	dev->ckptnewest = slot;
+	ret = MTD_READ(dev->mtd, SMART_CKPT_ADDRESS(dev, slot), sizeof(hdr), (FAR uint8_t *)&hdr);
+	if (ret != sizeof(hdr)) {
+		return -EIO;
+	}
+
+	if (hdr.stale != CONFIG_SMARTFS_ERASEDSTATE) {
+		fvdbg("Checkpoint %d is stale\n", hdr.generation);
+		return -ESTALE;
+	}
+
+	if (hdr.sectorsize != dev->sectorsize || hdr.totalsectors != dev->totalsectors || hdr.neraseblocks != dev->neraseblocks) {
+		return -EINVAL;
+	}
+
+	nsegs = smart_checkpoint_segments(dev, segs);
+	size = dev->sectorsize;
+	for (x = 0; x < nsegs; x++) {
+		size += segs[x].len;
+	}
+
+	if (size > dev->ckptblocks * dev->erasesize) {
+		return -EINVAL;
+	}
+
+	/* Read the data in place.  If it turns out to be corrupted, the scan
+	 * initializes it all again.
+	 */
+
+	address = SMART_CKPT_ADDRESS(dev, slot) + dev->sectorsize;
+	crc = 0;
+	for (x = 0; x < nsegs; x++) {
+		ret = MTD_READ(dev->mtd, address, segs[x].len, segs[x].data);
+		if (ret != segs[x].len) {
+			return -EIO;
+		}
+
+		crc = crc32part(segs[x].data, segs[x].len, crc);
+		address += segs[x].len;
+	}
+
+	size = hdr.crc;
+	hdr.crc = 0;
+	crc = crc32part((FAR uint8_t *)&hdr, sizeof(hdr), crc);
+	if (crc != size) {
+		fdbg("Checkpoint %d CRC error\n", hdr.generation);
+		return -EINVAL;
+	}
+
+	dev->formatstatus = SMART_FMT_STAT_FORMATTED;
+	dev->formatversion = hdr.formatversion;
+	dev->namesize = hdr.namesize;
+	dev->freesectors = hdr.freesectors;
+	dev->releasesectors = hdr.releasesectors;
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	dev->blockerases = hdr.blockerases;
+#endif
+
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+	/* No map page is resident: they are rebuilt when first used */
+
+	smart_map_reset(dev);
+	npages = (dev->totalsectors + SMART_MAP_PAGE_MASK) >> SMART_MAP_PAGE_SHIFT;
+	memset(dev->mapslot, 0, npages);
+	for (x = 0; x < CONFIG_MTD_SMART_MAP_PAGES; x++) {
+		dev->mapowner[x] = SMART_MAP_NOPAGE;
+	}
+#endif
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	dev->uneven_wearcount = hdr.uneven_wearcount;
+	dev->wearflags = hdr.wearflags;
+	smart_find_wear_minmax(dev);
+
+#ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
+	for (x = 0; x < dev->geo.neraseblocks; x++) {
+		dev->erasecounts[x] = smart_get_wear_level(dev, x);
+	}
+#endif
+#endif
+
+	smart_freeindex_build(dev);
+
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+	dev->rootdirentries = hdr.rootdirentries;
+	ret = smart_register_rootdirs(dev);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
+	dev->ckptslot = slot + 1;
+	fvdbg("Mounted from checkpoint %d in slot %d\n", hdr.generation, slot);
+	return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_bwrite
+ *
+ * Description: Writes the read/write buffer to a sector of a checkpoint
+ *              slot.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_bwrite(FAR struct smart_struct_s *dev, uint32_t address)
+{
+	ssize_t ret;
+
+	ret = smart_bwrite(dev, address / dev->geo.blocksize, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+	if (ret != dev->mtdBlksPerSector) {
+		fdbg("Error %d writing checkpoint\n", (int)ret);
+		return -EIO;
+	}
+
+	return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_save
+ *
+ * Description: Saves the state of the device to the checkpoint slot not
+ *              holding the newest checkpoint: the slot is erased, the data
+ *              is written and the header goes last, so that a checkpoint
+ *              cut short by a power loss is never used.  Nothing is done
+ *              if the newest checkpoint still matches the device.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_save(FAR struct smart_struct_s *dev)
+{
+	struct smart_checkpoint_s hdr;
+	struct smart_ckptseg_s segs[SMART_CKPT_NSEGS];
+	uint32_t address;
+	uint32_t size;
+	uint32_t crc;
+	size_t done;
+	size_t fill;
+	size_t len;
+	int nsegs;
+	int slot;
+	int x;
+	int ret;
+
+	if (dev->ckptblocks == 0 || dev->ckptslot != 0) {
+		return OK;
+	}
+
+	if (dev->formatstatus != SMART_FMT_STAT_FORMATTED || dev->erasesize == 0) {
+		return -ENODEV;
 	}
 
-	bits = gWearLevelToBitMap4[level];
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+	/* Sectors allocated but not written yet would be lost by a scan */
 
-	if (block & 0x01) {
-		/* Use the upper nibble */
+	if (dev->allocsector != NULL) {
+		return -EBUSY;
+	}
+#endif
 
-		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] &= 0x0F;
-		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] |= bits << 4;
-	} else {
-		/* Use the lower nibble */
+	nsegs = smart_checkpoint_segments(dev, segs);
+	size = dev->sectorsize;
+	for (x = 0; x < nsegs; x++) {
+		size += segs[x].len;
+	}
 
-		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] &= 0xF0;
-		dev->wearstatus[block >> SMART_WEAR_BIT_DIVIDE] |= bits;
+	if (size > dev->ckptblocks * dev->erasesize) {
+		fdbg("Checkpoint of %d bytes does not fit\n", size);
+		return -ENOSPC;
 	}
 
-	/* Mark wear bits as dirty */
+	slot = dev->ckptnewest ^ 1;
+	ret = smart_erase(dev, dev->ckptbase + slot * dev->ckptblocks, dev->ckptblocks);
+	if (ret < 0) {
+		fdbg("Error %d erasing checkpoint slot %d\n", -ret, slot);
+		return ret;
+	}
 
-	dev->wearflags |= SMART_WEARFLAGS_WRITE_NEEDED;
+	/* Pack the data in sectors following the header sector */
 
-	/* Test if min / max need to be updated */
+	address = SMART_CKPT_ADDRESS(dev, slot);
+	crc = 0;
+	fill = 0;
+	for (x = 0; x < nsegs; x++) {
+		crc = crc32part(segs[x].data, segs[x].len, crc);
+		for (done = 0; done < segs[x].len; done += len) {
+			len = segs[x].len - done;
+			if (len > dev->sectorsize - fill) {
+				len = dev->sectorsize - fill;
+			}
 
-	if (oldlevel + 1 == level) {
-		/* Test if max needs to be updated */
+			memcpy(&dev->rwbuffer[fill], &segs[x].data[done], len);
+			fill += len;
+			if (fill == dev->sectorsize) {
+				address += dev->sectorsize;
+				ret = smart_checkpoint_bwrite(dev, address);
+				if (ret < 0) {
+					return ret;
+				}
 
-		if (level > dev->maxwearlevel) {
-			dev->maxwearlevel = level;
+				fill = 0;
+			}
 		}
+	}
 
-		/* Test if this was the min level.  If it was, then
-		   we need to rescan for min. */
+	if (fill > 0) {
+		memset(&dev->rwbuffer[fill], CONFIG_SMARTFS_ERASEDSTATE, dev->sectorsize - fill);
+		address += dev->sectorsize;
+		ret = smart_checkpoint_bwrite(dev, address);
+		if (ret < 0) {
+			return ret;
+		}
+	}
 
-		if (oldlevel == dev->minwearlevel) {
-			smart_find_wear_minmax(dev);
+	/* Now the header which makes the checkpoint valid */
 
-			if (oldlevel != dev->minwearlevel) {
-				fvdbg("##### New min wear level = %d\n", dev->minwearlevel);
-			}
-		}
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = SMART_CKPT_MAGIC;
+	hdr.generation = dev->ckptgen + 1;
+	hdr.sectorsize = dev->sectorsize;
+	hdr.totalsectors = dev->totalsectors;
+	hdr.neraseblocks = dev->neraseblocks;
+	hdr.freesectors = dev->freesectors;
+	hdr.releasesectors = dev->releasesectors;
+	hdr.formatversion = dev->formatversion;
+	hdr.namesize = dev->namesize;
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+	hdr.rootdirentries = dev->rootdirentries;
+#endif
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	hdr.uneven_wearcount = dev->uneven_wearcount;
+	hdr.wearflags = dev->wearflags;
+#endif
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	hdr.blockerases = dev->blockerases;
+#endif
+	hdr.stale = CONFIG_SMARTFS_ERASEDSTATE;
+	hdr.crc = crc32part((FAR uint8_t *)&hdr, sizeof(hdr), crc);
+
+	memset(dev->rwbuffer, CONFIG_SMARTFS_ERASEDSTATE, dev->sectorsize);
+	memcpy(dev->rwbuffer, &hdr, sizeof(hdr));
+	ret = smart_checkpoint_bwrite(dev, SMART_CKPT_ADDRESS(dev, slot));
+	if (ret < 0) {
+		return ret;
 	}
 
-	return 0;
+	dev->ckptgen = hdr.generation;
+	dev->ckptnewest = slot;
+	dev->ckptslot = slot + 1;
+	fvdbg("Checkpoint %d written to slot %d\n", hdr.generation, slot);
+	return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_invalidate
+ *
+ * Description: Marks the checkpoint matching the device stale before the
+ *              device is modified, so that the next mount does the full
+ *              scan unless a new checkpoint is written first.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_invalidate(FAR struct smart_struct_s *dev)
+{
+	uint8_t stale = (uint8_t)~CONFIG_SMARTFS_ERASEDSTATE;
+	uint8_t slot = dev->ckptslot;
+	ssize_t ret;
+
+	if (slot == 0) {
+		return OK;
+	}
+
+	/* Cleared first, as marking the checkpoint is itself a write */
+
+	dev->ckptslot = 0;
+	ret = smart_bytewrite(dev, SMART_CKPT_ADDRESS(dev, slot - 1) + offsetof(struct smart_checkpoint_s, stale), 1, &stale);
+	if (ret != 1) {
+		fdbg("Error %d invalidating checkpoint\n", (int)ret);
+		dev->ckptslot = slot;
+		return ret < 0 ? ret : -EIO;
+	}
+
+	return OK;
 }
 #endif
 
@@ -1708,11 +2434,6 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 	int dupsector;
 	uint16_t duplogsector;
 #endif
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
-	int x;
-	char devname[22];
-	FAR struct smart_multiroot_device_s *rootdirdev;
-#endif
 
 	fvdbg("Entry\n");
 
@@ -1770,6 +2491,16 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 	}
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	/* Restore the state saved when the device was last closed, unless it
+	 * was modified since.
+	 */
+
+	if (smart_checkpoint_load(dev) == OK) {
+		return OK;
+	}
+#endif
+
 	dev->formatstatus = SMART_FMT_STAT_NOFMT;
 	dev->freesectors = dev->availSectPerBlk * dev->geo.neraseblocks;
 	dev->releasesectors = 0;
@@ -1799,9 +2530,10 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 		dev->sMap[sector] = -1;
 	}
 #else
-	/* Clear all logical sector used bits */
+	/* Clear all logical sector used bits and empty the resident map pages */
 
 	memset(dev->sBitMap, 0, (dev->totalsectors + 7) >> 3);
+	smart_map_reset(dev);
 #endif
 
 	/* Now scan the MTD device */
@@ -1973,37 +2705,9 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
 			dev->rootdirentries = dev->rwbuffer[SMART_FMT_ROOTDIRS_POS];
 
-			/* If rootdirentries is greater than 1, then we need to register
-			 * additional block devices.
-			 */
-
-			for (x = 1; x < dev->rootdirentries; x++) {
-				if (dev->partname[0] != '\0') {
-					snprintf(dev->rwbuffer, sizeof(devname), "/dev/smart%d%sd%d", dev->minor, dev->partname, x + 1);
-				} else {
-					snprintf(devname, sizeof(devname), "/dev/smart%dd%d", dev->minor, x + 1);
-				}
-
-				/* Inode private data is a reference to a struct containing
-				 * the SMART device structure and the root directory number.
-				 */
-
-				rootdirdev = (struct smart_multiroot_device_s *)smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
-				if (rootdirdev == NULL) {
-					fdbg("Memory alloc failed\n");
-					ret = -ENOMEM;
-					goto err_out;
-				}
-
-				/* Populate the rootdirdev */
-
-				rootdirdev->dev = dev;
-				rootdirdev->rootdirnum = x;
-				ret = register_blockdriver(dev->rwbuffer, &g_bops, 0, rootdirdev);
-
-				/* Inode private data is a reference to the SMART device structure */
-
-				ret = register_blockdriver(devname, &g_bops, 0, rootdirdev);
+			ret = smart_register_rootdirs(dev);
+			if (ret < 0) {
+				goto err_out;
 			}
 #endif
 		}
@@ -2143,10 +2847,7 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 #else
 		/* Mark the logical sector as used in the bitmap */
 		dev->sBitMap[logicalsector >> 3] |= 1 << (logicalsector & 0x07);
-
-		if (logicalsector < dev->reservedsector) {
-			smart_add_sector_to_cache(dev, logicalsector, sector, __LINE__);
-		}
+		smart_add_sector_to_cache(dev, logicalsector, sector, __LINE__);
 #endif
 	}
 
@@ -2205,8 +2906,13 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 			dev->releasecount[sector / dev->sectorsPerBlk]++;
 #else
 			smart_update_cache(dev, 0, newsector);
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
 			smart_add_count(dev, dev->freecount, newsector / dev->sectorsPerBlk, -1);
 			smart_add_count(dev, dev->releasecount, sector / dev->sectorsPerBlk, 1);
+#else
+			dev->freecount[newsector / dev->sectorsPerBlk]--;
+			dev->releasecount[sector / dev->sectorsPerBlk]++;
+#endif
 #endif
 
 		}
@@ -2220,6 +2926,10 @@ static int smart_scan(FAR struct smart_struct_s *dev)
 	smart_read_wearstatus(dev);
 #endif
 
+	/* Now that the free counts and wear levels are known, index the blocks */
+
+	smart_freeindex_build(dev);
+
 	fdbg("SMART Scan\n");
 	fdbg("   Erase size:   %10d\n", dev->sectorsPerBlk * dev->sectorsize);
 	fdbg("   Erase count:  %10d\n", dev->neraseblocks);
@@ -2336,7 +3046,7 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev, uint16_t
 		dev->unusedsectors += freecount;
 		dev->blockerases++;
 #endif
-		MTD_ERASE(dev->mtd, block, 1);
+		smart_erase(dev, block, 1);
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 		if (dev->erasecounts) {
@@ -2370,6 +3080,7 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev, uint16_t
 		dev->releasecount[block] = prerelease;
 		dev->freecount[block] = dev->availSectPerBlk - prerelease;
 #endif							/* CONFIG_MTD_SMART_PACK_COUNTS */
+		smart_freeindex_update(dev, block);
 
 		/* Now that we have erased this block and updated the release / free counts,
 		 * if we are in WEAR LEVELING enabled mode, we must check if this erase block's
@@ -2577,6 +3288,7 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 #else
 			dev->freecount[block]--;
 #endif							/* CONFIG_MTD_SMART_PACK_COUNTS */
+			smart_freeindex_update(dev, block);
 		}
 
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
@@ -2775,6 +3487,13 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
 
 	/* Erase the MTD device */
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	ret = smart_checkpoint_invalidate(dev);
+	if (ret < 0) {
+		return ret;
+	}
+#endif
+
 	ret = MTD_IOCTL(dev->mtd, MTDIOC_BULKERASE, 0);
 	if (ret < 0) {
 		return ret;
@@ -2847,7 +3566,7 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
 
 	/* Write the sector to the flash */
 
-	wrcount = MTD_BWRITE(dev->mtd, 0, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+	wrcount = smart_bwrite(dev, 0, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 	if (wrcount != dev->mtdBlksPerSector) {
 		/* The block is not empty!!  What to do? */
 
@@ -2910,8 +3629,15 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
 
 		dev->sMap[x] = -1;
 	}
+#else
+	memset(dev->sBitMap, 0, (dev->totalsectors + 7) >> 3);
+	smart_map_reset(dev);
+	dev->sBitMap[0] = 1;
+	smart_add_sector_to_cache(dev, 0, 0, __LINE__);
 #endif
 
+	smart_freeindex_build(dev);
+
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
 
 	/* Un-register any extra directory device entries */
@@ -2996,7 +3722,7 @@ static int smart_relocate_sector(FAR struct smart_struct_s *dev, uint16_t oldsec
 
 	/* Write the data to the new physical sector location */
 
-	ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+	ret = smart_bwrite(dev, newsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 
 #else							/* CONFIG_MTD_SMART_ENABLE_CRC */
 
@@ -3008,7 +3734,7 @@ static int smart_relocate_sector(FAR struct smart_struct_s *dev, uint16_t oldsec
 
 	/* Write the data to the new physical sector location */
 
-	ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+	ret = smart_bwrite(dev, newsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 
 	/* Commit the sector */
 
@@ -3111,6 +3837,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 
 	dev->freecount[block] = 0;
 #endif
+	smart_freeindex_update(dev, block);
 
 	/* Next move all live data in the block to a new home. */
 
@@ -3216,11 +3943,12 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 #else
 		dev->freecount[newsector / dev->sectorsPerBlk]--;
 #endif
+		smart_freeindex_update(dev, newsector / dev->sectorsPerBlk);
 	}
 
 	/* Now erase the erase block */
 
-	MTD_ERASE(dev->mtd, block, 1);
+	smart_erase(dev, block, 1);
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 	dev->unusedsectors += freecount;
 	dev->blockerases++;
@@ -3264,6 +3992,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 	dev->freecount[block] = dev->availSectPerBlk - prerelease;
 	dev->releasecount[block] = prerelease;
 #endif
+	smart_freeindex_update(dev, block);
 
 #ifdef CONFIG_SMART_LOCAL_CHECKFREE
 	if (smart_checkfree(dev, __LINE__) != OK) {
@@ -3289,109 +4018,182 @@ errout:
 #else
 	dev->freecount[block] = freecount;
 #endif
+	smart_freeindex_update(dev, block);
 	return ret;
 }
 
 /****************************************************************************
- * Name: smart_findfreephyssector
+ * Name: smart_freeindex_key
  *
- * Description:  Finds a free physical sector based on free and released
- *               count logic, taking into account reserved sectors.
+ * Description:  Returns the allocation priority of an erase block, zero if
+ *               it has no free sector.  Blocks which are not worn come
+ *               first, by free count and then by lower wear level.  Worn
+ *               blocks come last, the least worn first.
  *
  ****************************************************************************/
 
-static uint16_t smart_findfreephyssector(FAR struct smart_struct_s *dev, uint8_t canrelocate)
+static uint16_t smart_freeindex_key(FAR struct smart_struct_s *dev, uint16_t block)
+{
+	uint16_t count;
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	uint8_t wearlevel;
+#endif
+
+	if (block == SMART_FREEINDEX_NONE) {
+		return 0;
+	}
+
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+	count = smart_get_count(dev, dev->freecount, block);
+#else
+	count = dev->freecount[block];
+#endif
+	if (count == 0) {
+		return 0;
+	}
+
+#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
+	wearlevel = smart_get_wear_level(dev, block);
+	if (wearlevel >= SMART_WEAR_FULL_RELOCATE_THRESHOLD) {
+		return ((15 - wearlevel) << 8) | count;
+	}
+
+	return SMART_FREEINDEX_UNWORN | (count << 4) | (15 - wearlevel);
+#else
+	return SMART_FREEINDEX_UNWORN | count;
+#endif
+}
+
+/****************************************************************************
+ * Name: smart_freeindex_node
+ *
+ * Description:  Recomputes a node of the free sector index from its two
+ *               children.
+ *
+ ****************************************************************************/
+
+static void smart_freeindex_node(FAR struct smart_struct_s *dev, uint16_t node)
+{
+	uint16_t child[2];
+	uint16_t x;
+
+	for (x = 0; x < 2; x++) {
+		child[x] = (node << 1) + x;
+		if (child[x] < dev->freeindexsize) {
+			child[x] = dev->freeindex[child[x]];
+		} else if (child[x] - dev->freeindexsize < dev->neraseblocks) {
+			child[x] -= dev->freeindexsize;
+		} else {
+			child[x] = SMART_FREEINDEX_NONE;
+		}
+	}
+
+	if (smart_freeindex_key(dev, child[1]) > smart_freeindex_key(dev, child[0])) {
+		dev->freeindex[node] = child[1];
+	} else {
+		dev->freeindex[node] = child[0];
+	}
+}
+
+/****************************************************************************
+ * Name: smart_freeindex_update
+ *
+ * Description:  Updates the free sector index after the free count or the
+ *               wear level of an erase block changed.
+ *
+ ****************************************************************************/
+
+static void smart_freeindex_update(FAR struct smart_struct_s *dev, uint16_t block)
+{
+	uint16_t node;
+
+	for (node = (dev->freeindexsize + block) >> 1; node > 0; node >>= 1) {
+		smart_freeindex_node(dev, node);
+	}
+}
+
+/****************************************************************************
+ * Name: smart_freeindex_build
+ *
+ * Description:  Rebuilds the whole free sector index, once the free counts
+ *               and wear levels of all erase blocks are known.
+ *
+ ****************************************************************************/
+
+static void smart_freeindex_build(FAR struct smart_struct_s *dev)
+{
+	uint16_t node;
+
+	for (node = dev->freeindexsize - 1; node > 0; node--) {
+		smart_freeindex_node(dev, node);
+	}
+}
+
+/****************************************************************************
+ * Name: smart_findfreesector
+ *
+ * Description:  Finds a free physical sector in the erase block with the
+ *               highest allocation priority, taking into account reserved
+ *               sectors.
+ *
+ ****************************************************************************/
+
+static uint16_t smart_findfreesector(FAR struct smart_struct_s *dev, uint8_t canrelocate)
 {
-	uint16_t count, allocfreecount, allocblock;
+	uint16_t count, allocblock;
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
-	uint16_t wornfreecount, wornblock;
-	uint8_t wearlevel, wornlevel;
+	uint8_t wornlevel;
 	uint8_t maxwearlevel;
 #endif
 	uint16_t physicalsector;
-	uint16_t x, block;
+	uint16_t x, block, first, offset;
 	uint32_t readaddr;
 	struct smart_sect_header_s header;
 	int ret;
 
-	/* Determine which erase block we should allocate the new
-	 * sector from. This is based on the number of free sectors
-	 * available in each erase block. */
+	/* The root of the free sector index is the erase block we should
+	 * allocate the new sector from.
+	 */
 
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 retry:
-#endif
-	allocfreecount = 0;
-	allocblock = 0xFFFF;
-#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
-	wornfreecount = 0;
-	wornblock = 0xFFFF;
-	wornlevel = 15;
-	maxwearlevel = 0;
 #endif
 	physicalsector = 0xFFFF;
-	if (++dev->lastallocblock >= dev->neraseblocks) {
-		dev->lastallocblock = 0;
-	}
+	allocblock = dev->freeindex[1];
+	if (smart_freeindex_key(dev, allocblock) == 0) {
+		fdbg("Program bug!  Expected a free sector, free=%d\n", dev->freesectors);
+		for (x = 0; x < dev->neraseblocks; x++) {
+			fdbg("%d ", dev->freecount[x]);
+		}
 
-	block = dev->lastallocblock;
-	for (x = 0; x < dev->neraseblocks; x++) {
-		/* Test if this block has more free blocks than the
-		 * currently selected block
-		 */
+		/* No free sectors found!  Bug? */
+
+		return -1;
+	}
 
 #ifdef CONFIG_MTD_SMART_PACK_COUNTS
-		count = smart_get_count(dev, dev->freecount, block);
+	count = smart_get_count(dev, dev->freecount, allocblock);
 #else
-		count = dev->freecount[block];
+	count = dev->freecount[allocblock];
 #endif
 
 #ifdef CONFIG_MTD_SMART_WEAR_LEVEL
-		/* Keep track of the block with the max free sectors that is worn */
-
-		wearlevel = smart_get_wear_level(dev, block);
-		if (wearlevel >= SMART_WEAR_FULL_RELOCATE_THRESHOLD) {
-			if (wearlevel > maxwearlevel && count > 0) {
-				maxwearlevel = wearlevel;
-			}
-
-			if (count > wornfreecount || (count > 0 && wearlevel < wornlevel)) {
-				/* Keep track of this block.  If there are only worn blocks with
-				 * free sectors left, then we will use it.
-				 */
-
-				if (x < dev->neraseblocks - 1 || !wornfreecount) {
-					wornfreecount = count;
-					wornblock = block;
-					wornlevel = wearlevel;
-				}
-			}
-		} else
-#endif
-
-			if (count > allocfreecount) {
-				/* Assign this block to alloc from */
+	if (smart_freeindex_key(dev, allocblock) < SMART_FREEINDEX_UNWORN) {
+		/* No un-worn blocks with free sectors.  Find the max wear level of the
+		 * worn blocks with free sectors.
+		 */
 
-				if (x < dev->neraseblocks - 1 || !allocfreecount) {
-					allocblock = block;
-					allocfreecount = count;
-				}
+		wornlevel = smart_get_wear_level(dev, allocblock);
+		maxwearlevel = 0;
+		for (block = 0; block < dev->neraseblocks; block++) {
+			if (smart_freeindex_key(dev, block) != 0 && smart_get_wear_level(dev, block) > maxwearlevel) {
+				maxwearlevel = smart_get_wear_level(dev, block);
 			}
-		if (++block >= dev->neraseblocks) {
-			block = 0;
 		}
-	}
-
-	/* Check if we found an allocblock. */
-
-	if (allocblock == 0xFFFF) {
-		/* No un-worn blocks with free sectors */
-
-#ifdef CONFIG_MTD_SMART_WEAR_LEVEL
 
 		/* If we are allowed to relocate unworn blocks then do so now */
 
-		if (canrelocate && wornfreecount < (dev->sectorsPerBlk >> 2) && wornlevel == maxwearlevel) {
+		if (canrelocate && count < (dev->sectorsPerBlk >> 2) && wornlevel == maxwearlevel) {
 			/* Relocate up to 8 unworn blocks */
 
 			block = 0;
@@ -3416,30 +4218,18 @@ retry:
 		} else {
 			dev->wearflags |= SMART_WEARFLAGS_FORCE_REORG;
 		}
-
-		/* Test if we found a worn block with free sectors */
-
-		if (wornblock != 0xFFFF) {
-			allocblock = wornblock;
-		} else
+	}
 #endif
 
-		{
-			fdbg("Program bug!  Expected a free sector, free=%d\n", dev->freesectors);
-			for (x = 0; x < dev->neraseblocks; x++) {
-				fdbg("%d ", dev->freecount[x]);
-			}
-
-			/* No free sectors found!  Bug? */
-
-			return -1;
-		}
-	}
+	/* Now find a free physical sector within this selected erase block to
+	 * allocate.  Sectors are allocated in order within an erase block, so
+	 * the free ones are normally the last count sectors: start there.
+	 */
 
-	/* Now find a free physical sector within this selected
-	 * erase block to allocate. */
+	first = count < dev->availSectPerBlk ? dev->availSectPerBlk - count : 0;
+	for (offset = 0; offset < dev->availSectPerBlk; offset++) {
+		x = allocblock * dev->sectorsPerBlk + (first + offset) % dev->availSectPerBlk;
 
-	for (x = allocblock * dev->sectorsPerBlk; x < allocblock * dev->sectorsPerBlk + dev->availSectPerBlk; x++) {
 		/* Check if this physical sector is available. */
 
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
@@ -3486,7 +4276,6 @@ retry:
 			if (dev->badSectorList[x] == FALSE) {
 #endif
 				physicalsector = x;
-				dev->lastallocblock = allocblock;
 				break;
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
 			}
@@ -3505,6 +4294,37 @@ retry:
 	return physicalsector;
 }
 
+/****************************************************************************
+ * Name: smart_findfreephyssector
+ *
+ * Description:  Finds a free physical sector and keeps the statistics of
+ *               the allocation time reported through procfs.
+ *
+ ****************************************************************************/
+
+static uint16_t smart_findfreephyssector(FAR struct smart_struct_s *dev, uint8_t canrelocate)
+{
+	uint16_t physicalsector;
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	uint32_t elapsed;
+
+	elapsed = smart_timestamp();
+#endif
+
+	physicalsector = smart_findfreesector(dev, canrelocate);
+
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+	elapsed = smart_timestamp() - elapsed;
+	dev->alloccount++;
+	dev->alloctime += elapsed;
+	if (elapsed > dev->allocmax) {
+		dev->allocmax = elapsed;
+	}
+#endif
+
+	return physicalsector;
+}
+
 /****************************************************************************
  * Name: smart_garbagecollect
  *
@@ -3888,7 +4708,7 @@ static int smart_write_alloc_sector(FAR struct smart_struct_s *dev, uint16_t log
 
 #ifndef CONFIG_MTD_SMART_ENABLE_CRC
 	fvdbg("Write MTD block %d\n", physical * dev->mtdBlksPerSector);
-	ret = MTD_BWRITE(dev->mtd, physical * dev->mtdBlksPerSector, 1, (FAR uint8_t *)dev->rwbuffer);
+	ret = smart_bwrite(dev, physical * dev->mtdBlksPerSector, 1, (FAR uint8_t *)dev->rwbuffer);
 	if (ret != 1) {
 		/* The block is not empty!!  What to do? */
 
@@ -4216,7 +5036,7 @@ relocate_good_sector:
 	if (needsrelocate) {
 		/* Write the entire sector to the new physical location, uncommitted. */
 
-		ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+		ret = smart_bwrite(dev, physsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 		if (ret != dev->mtdBlksPerSector) {
 			fdbg("Error writing to physical sector %d\n", physsector);
 			ret = -EIO;
@@ -4285,6 +5105,7 @@ relocate_good_sector:
 		dev->releasecount[block]++;
 		dev->freecount[physsector / dev->sectorsPerBlk]--;
 #endif
+		smart_freeindex_update(dev, physsector / dev->sectorsPerBlk);
 		dev->freesectors--;
 		dev->releasesectors++;
 
@@ -4315,7 +5136,7 @@ relocate_good_sector:
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
 		/* Write the entire sector to FLASH when CRC enabled */
 
-		ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
+		ret = smart_bwrite(dev, physsector * dev->mtdBlksPerSector, dev->mtdBlksPerSector, (FAR uint8_t *)dev->rwbuffer);
 		if (ret != dev->mtdBlksPerSector) {
 			fdbg("Error writing to physical sector %d\n", physsector);
 			ret = -EIO;
@@ -4405,6 +5226,7 @@ errout:
 		dev->releasecount[block]++;
 		dev->freecount[physsector / dev->sectorsPerBlk]--;
 #endif
+		smart_freeindex_update(dev, physsector / dev->sectorsPerBlk);
 		dev->freesectors--;
 		dev->releasesectors++;
 
@@ -4778,6 +5600,7 @@ static inline int smart_allocsector(FAR struct smart_struct_s *dev, unsigned lon
 #else
 	dev->freecount[physicalsector / dev->sectorsPerBlk]--;
 #endif
+	smart_freeindex_update(dev, physicalsector / dev->sectorsPerBlk);
 	dev->freesectors--;
 
 	/* Return the logical sector number */
@@ -4992,6 +5815,15 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #endif
 
 		goto ok_out;
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	case BIOC_CHECKPOINT:
+
+		/* Save the sector map, as when the device is closed */
+
+		ret = smart_checkpoint_save(dev);
+		goto ok_out;
+#endif
 #endif							/* CONFIG_FS_WRITABLE */
 
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
@@ -5008,6 +5840,10 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 		procfs_data->formatversion = dev->formatversion;
 		procfs_data->unusedsectors = dev->unusedsectors;
 		procfs_data->blockerases = dev->blockerases;
+		procfs_data->allocations = dev->alloccount;
+		procfs_data->allocavg = dev->alloccount ? (uint32_t)(dev->alloctime / dev->alloccount) : 0;
+		procfs_data->allocmax = dev->allocmax;
+		procfs_data->byteswritten = dev->byteswritten;
 		procfs_data->sectorsperblk = dev->sectorsPerBlk;
 
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
@@ -5055,6 +5891,15 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 	 * to the MTD driver (unchanged).
 	 */
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+	if (cmd == MTDIOC_BULKERASE) {
+		ret = smart_checkpoint_invalidate(dev);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+#endif
+
 	ret = MTD_IOCTL(dev->mtd, cmd, arg);
 	if (ret < 0) {
 		fdbg("ERROR: MTD ioctl(%04x) failed: %d\n", cmd, ret);
@@ -5131,6 +5976,12 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 			goto errout;
 		}
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+		/* Take the checkpoint slots off the end of the device */
+
+		smart_checkpoint_reserve(dev);
+#endif
+
 		/* Set the sector size to the default for now */
 
 #ifdef CONFIG_SMARTFS_BAD_SECTOR
@@ -5141,9 +5992,10 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 #ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
 		dev->sMap = NULL;
 #else
-		dev->sCache = NULL;
 		dev->sBitMap = NULL;
+		dev->mappages = NULL;
 #endif
+		dev->freeindex = NULL;
 		dev->rwbuffer = NULL;
 		dev->bytebuffer = NULL;
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
@@ -5176,8 +6028,13 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 
 		dev->totalsectors = (uint16_t)totalsectors;
 		dev->freesectors = (uint16_t)dev->availSectPerBlk * dev->geo.neraseblocks;
-		dev->lastallocblock = 0;
 		dev->debuglevel = 0;
+#if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
+		dev->alloccount = 0;
+		dev->allocmax = 0;
+		dev->alloctime = 0;
+		dev->byteswritten = 0;
+#endif
 
 		/* Mark the device format status an unknown */
 
@@ -5251,8 +6108,11 @@ errout:
 	}
 #else
 	smart_free(dev, dev->sBitMap);
-	smart_free(dev, dev->sCache);
+	smart_free(dev, dev->mappages);
 #endif
+	if (dev->freeindex != NULL) {
+		smart_free(dev, dev->freeindex);
+	}
 	if (dev->rwbuffer != NULL) {
 		smart_free(dev, dev->rwbuffer);
 	}
@@ -0,0 +1,349 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * fs/procfs/fs_procfswqueue.c
+ *
+ * /proc/wqueue shows the statistics of the kernel work queues: for each
+ * class of work the number of works performed, the average and largest
+ * latency from their expiry until they started and the average and
+ * longest time spent in them, in milliseconds; then for each worker
+ * thread the number of works it performed and how many of those it took
+ * from the other threads.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/stat.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/kmalloc.h>
+#include <tinyara/wqueue.h>
+#include <tinyara/fs/fs.h>
+#include <tinyara/fs/procfs.h>
+
+#if !defined(CONFIG_DISABLE_MOUNTPOINT) && defined(CONFIG_FS_PROCFS)
+#if defined(CONFIG_SCHED_WORKQUEUE_STATS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_WQUEUE)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+/* Determines the size of the buffer which holds the whole text: a heading,
+ * one line per queue and class and one per worker thread.
+ */
+
+#define WQUEUE_LINELEN 64
+#define WQUEUE_BUFSIZE (WQUEUE_LINELEN * (2 + 2 * WORK_NCLASSES + 1 + WORK_MAXTHREADS + 1))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* This structure describes one open "file" */
+
+struct wqueue_file_s {
+	struct procfs_file_s base;	/* Base open file structure */
+	unsigned int textsize;		/* Number of valid characters in text[] */
+	char text[WQUEUE_BUFSIZE];	/* The formatted statistics */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+/* File system methods */
+
+static int wqueue_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode);
+static int wqueue_close(FAR struct file *filep);
+static ssize_t wqueue_read(FAR struct file *filep, FAR char *buffer, size_t buflen);
+
+static int wqueue_dup(FAR const struct file *oldp, FAR struct file *newp);
+
+static int wqueue_stat(FAR const char *relpath, FAR struct stat *buf);
+
+/****************************************************************************
+ * Private Variables
+ ****************************************************************************/
+
+static FAR const char *g_wqueue_classname[WORK_NCLASSES] = {
+	"high", "normal", "bulk"
+};
+
+/****************************************************************************
+ * Public Variables
+ ****************************************************************************/
+
+/* See fs_mount.c -- this structure is explicitly externed there.
+ * We use the old-fashioned kind of initializers so that this will compile
+ * with any compiler.
+ */
+
+const struct procfs_operations wqueue_operations = {
+	wqueue_open,				/* open */
+	wqueue_close,				/* close */
+	wqueue_read,				/* read */
+	NULL,						/* write */
+
+	wqueue_dup,					/* dup */
+
+	NULL,						/* opendir */
+	NULL,						/* closedir */
+	NULL,						/* readdir */
+	NULL,						/* rewinddir */
+
+	wqueue_stat					/* stat */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wqueue_format
+ *
+ * Description:
+ *   Append the statistics of one work queue to the text.
+ *
+ ****************************************************************************/
+
+static size_t wqueue_format(FAR char *text, size_t remaining, FAR const char *name, int qid)
+{
+	FAR struct work_classstats_s *cls;
+	struct work_stats_s stats;
+	size_t len = 0;
+	int i;
+
+	if (work_getstats(qid, &stats) < 0) {
+		return 0;
+	}
+
+	for (i = 0; i < WORK_NCLASSES && len < remaining; i++) {
+		cls = &stats.cls[i];
+		if (cls->nwork == 0) {
+			continue;
+		}
+
+		len += snprintf(&text[len], remaining - len, "%-7s %-7s %8lu %7lu %7lu %7lu %7lu\n", name, g_wqueue_classname[i], (unsigned long)cls->nwork, (unsigned long)TICK2MSEC(cls->latency / cls->nwork), (unsigned long)TICK2MSEC(cls->maxlatency), (unsigned long)TICK2MSEC(cls->runtime / cls->nwork), (unsigned long)TICK2MSEC(cls->maxruntime));
+	}
+
+	return len < remaining ? len : remaining;
+}
+
+/****************************************************************************
+ * Name: wqueue_open
+ ****************************************************************************/
+
+static int wqueue_open(FAR struct file *filep, FAR const char *relpath, int oflags, mode_t mode)
+{
+	FAR struct wqueue_file_s *attr;
+
+	fvdbg("Open '%s'\n", relpath);
+
+	/* PROCFS is read-only.  Any attempt to open with any kind of write
+	 * access is not permitted.
+	 */
+
+	if ((oflags & O_WRONLY) != 0 || (oflags & O_RDONLY) == 0) {
+		fdbg("ERROR: Only O_RDONLY supported\n");
+		return -EACCES;
+	}
+
+	/* "wqueue" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "wqueue") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* Allocate a container to hold the file attributes */
+
+	attr = (FAR struct wqueue_file_s *)kmm_zalloc(sizeof(struct wqueue_file_s));
+	if (!attr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* Save the attributes as the open-specific state in filep->f_priv */
+
+	filep->f_priv = (FAR void *)attr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: wqueue_close
+ ****************************************************************************/
+
+static int wqueue_close(FAR struct file *filep)
+{
+	FAR struct wqueue_file_s *attr;
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct wqueue_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* Release the file attributes structure */
+
+	kmm_free(attr);
+	filep->f_priv = NULL;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: wqueue_read
+ ****************************************************************************/
+
+static ssize_t wqueue_read(FAR struct file *filep, FAR char *buffer, size_t buflen)
+{
+	FAR struct wqueue_file_s *attr;
+	size_t len;
+	off_t offset;
+	ssize_t ret;
+#ifdef CONFIG_SCHED_LPWORK
+	struct work_stats_s stats;
+	int i;
+#endif
+
+	fvdbg("buffer=%p buflen=%d\n", buffer, (int)buflen);
+
+	/* Recover our private data from the struct file instance */
+
+	attr = (FAR struct wqueue_file_s *)filep->f_priv;
+	DEBUGASSERT(attr);
+
+	/* If f_pos is zero, then take a snapshot of the statistics.  Otherwise,
+	 * keep returning the text of the previous read(), so that it stays
+	 * consistent when it is read in pieces.
+	 */
+
+	if (filep->f_pos == 0) {
+		len = snprintf(attr->text, WQUEUE_BUFSIZE, "%-7s %-7s %8s %7s %7s %7s %7s\n", "QUEUE", "CLASS", "COUNT", "AVGLAT", "MAXLAT", "AVGRUN", "MAXRUN");
+
+#ifdef CONFIG_SCHED_HPWORK
+		len += wqueue_format(&attr->text[len], WQUEUE_BUFSIZE - len, "hpwork", HPWORK);
+#endif
+#ifdef CONFIG_SCHED_LPWORK
+		len += wqueue_format(&attr->text[len], WQUEUE_BUFSIZE - len, "lpwork", LPWORK);
+
+		/* Then how the low priority work was shared among the threads */
+
+		if (work_getstats(LPWORK, &stats) == OK && stats.nthreads > 1 && len < WQUEUE_BUFSIZE) {
+			len += snprintf(&attr->text[len], WQUEUE_BUFSIZE - len, "\n%-7s %-7s %8s %7s\n", "QUEUE", "THREAD", "COUNT", "STOLEN");
+			for (i = 0; i < stats.nthreads && len < WQUEUE_BUFSIZE; i++) {
+				len += snprintf(&attr->text[len], WQUEUE_BUFSIZE - len, "%-7s %-7d %8lu %7lu\n", "lpwork", i, (unsigned long)stats.thread[i].nwork, (unsigned long)stats.thread[i].nsteal);
+			}
+		}
+#endif
+
+		attr->textsize = len < WQUEUE_BUFSIZE ? len : WQUEUE_BUFSIZE - 1;
+	}
+
+	/* Transfer the text to user receive buffer */
+
+	offset = filep->f_pos;
+	ret = procfs_memcpy(attr->text, attr->textsize, buffer, buflen, &offset);
+
+	/* Update the file offset */
+
+	if (ret > 0) {
+		filep->f_pos += ret;
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: wqueue_dup
+ *
+ * Description:
+ *   Duplicate open file data in the new file structure.
+ *
+ ****************************************************************************/
+
+static int wqueue_dup(FAR const struct file *oldp, FAR struct file *newp)
+{
+	FAR struct wqueue_file_s *oldattr;
+	FAR struct wqueue_file_s *newattr;
+
+	fvdbg("Dup %p->%p\n", oldp, newp);
+
+	/* Recover our private data from the old struct file instance */
+
+	oldattr = (FAR struct wqueue_file_s *)oldp->f_priv;
+	DEBUGASSERT(oldattr);
+
+	/* Allocate a new container to hold the task and attribute selection */
+
+	newattr = (FAR struct wqueue_file_s *)kmm_malloc(sizeof(struct wqueue_file_s));
+	if (!newattr) {
+		fdbg("ERROR: Failed to allocate file attributes\n");
+		return -ENOMEM;
+	}
+
+	/* The copy the file attributes from the old attributes to the new */
+
+	memcpy(newattr, oldattr, sizeof(struct wqueue_file_s));
+
+	/* Save the new attributes in the new file structure */
+
+	newp->f_priv = (FAR void *)newattr;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: wqueue_stat
+ *
+ * Description: Return information about a file or directory
+ *
+ ****************************************************************************/
+
+static int wqueue_stat(const char *relpath, struct stat *buf)
+{
+	/* "wqueue" is the only acceptable value for the relpath */
+
+	if (strcmp(relpath, "wqueue") != 0) {
+		fdbg("ERROR: relpath is '%s'\n", relpath);
+		return -ENOENT;
+	}
+
+	/* "wqueue" is the name for a read-only file */
+
+	buf->st_mode = S_IFREG | S_IROTH | S_IRGRP | S_IRUSR;
+	buf->st_size = 0;
+	buf->st_blksize = 0;
+	buf->st_blocks = 0;
+	return OK;
+}
+
+#endif							/* CONFIG_SCHED_WORKQUEUE_STATS && !CONFIG_FS_PROCFS_EXCLUDE_WQUEUE */
+#endif							/* !CONFIG_DISABLE_MOUNTPOINT && CONFIG_FS_PROCFS */
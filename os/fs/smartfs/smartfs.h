@@ -64,6 +64,7 @@
 #include <stdbool.h>
 #include <semaphore.h>
 
+#include <tinyara/clock.h>
 #include <tinyara/fs/mtd.h>
 #include <tinyara/fs/smart.h>
 
@@ -203,7 +204,21 @@
 /* Underlying MTD Block driver access functions */
 
 #define FS_BOPS(f)        (f)->fs_blkdriver->u.i_bops
-#define FS_IOCTL(f, c, a) (FS_BOPS(f)->ioctl ? FS_BOPS(f)->ioctl((f)->fs_blkdriver, c, a) : (-ENOSYS))
+#define FS_BLKIOCTL(f, c, a) (FS_BOPS(f)->ioctl ? FS_BOPS(f)->ioctl((f)->fs_blkdriver, c, a) : (-ENOSYS))
+
+#ifndef CONFIG_SMARTFS_READ_CACHE
+#define CONFIG_SMARTFS_READ_CACHE 0
+#endif
+
+/* With the read cache, the requests which change sectors go through
+ * smartfs_cache_ioctl(), which drops the sectors from the cache.
+ */
+
+#if CONFIG_SMARTFS_READ_CACHE > 0
+#define FS_IOCTL(f, c, a) smartfs_cache_ioctl(f, c, (unsigned long)(a))
+#else
+#define FS_IOCTL(f, c, a) FS_BLKIOCTL(f, c, a)
+#endif
 
 /* The logical sector number of the root directory. */
 
@@ -218,6 +233,14 @@
 #define CONFIG_SMARTFS_DIRDEPTH 8
 #endif
 
+#ifndef CONFIG_SMARTFS_SEEK_INDEX
+#define CONFIG_SMARTFS_SEEK_INDEX 0
+#endif
+
+#if CONFIG_SMARTFS_SEEK_INDEX == 1
+#error "CONFIG_SMARTFS_SEEK_INDEX must be 0 or at least 2"
+#endif
+
 /* Buffer flags (when CRC enabled) */
 
 #define SMARTFS_BFLAG_DIRTY       0x01	/* Set if data changed in the sector */
@@ -349,6 +372,41 @@ struct smartfs_chain_header_s {
 };
 #endif
 
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+/* The seek index of an open file: sectors of its chain with the file
+ * position of their first byte, in file order and at least 'spacing'
+ * bytes apart.
+ */
+
+struct smartfs_seekindex_s {
+	uint16_t nentries;			/* Number of entries in use */
+	uint32_t spacing;			/* Minimum distance between entries */
+	uint32_t pos[CONFIG_SMARTFS_SEEK_INDEX];	/* File position of each sector */
+	uint16_t sector[CONFIG_SMARTFS_SEEK_INDEX];	/* Logical sector numbers */
+};
+#endif
+
+#if CONFIG_SMARTFS_READ_CACHE > 0
+/* The sector read cache of a volume, shared by its open files.  Each entry
+ * holds the data of one logical sector as BIOC_READSECT returns it, from
+ * the chain header on.
+ */
+
+struct smartfs_cacheentry_s {
+	uint16_t sector;			/* Logical sector, SMARTFS_ERASEDSTATE_16BIT if unused */
+	uint32_t lastuse;			/* Use count of the cache at the last access */
+	FAR uint8_t *data;			/* Sector data, availbytes long */
+};
+
+struct smartfs_cache_s {
+	uint32_t usecount;			/* Incremented on each access */
+	uint32_t hits;				/* Reads served from the cache */
+	uint32_t misses;			/* Reads which had to read the sector */
+	uint32_t readaheads;		/* Sectors read ahead of the reader */
+	struct smartfs_cacheentry_s entry[CONFIG_SMARTFS_READ_CACHE];
+};
+#endif
+
 /* This structure describes the state of one open file.  This structure
  * is protected by the volume semaphore.
  */
@@ -358,6 +416,21 @@ struct smartfs_ofile_s {
 #ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
 	uint8_t *buffer;			/* Sector buffer to reduce writes */
 	uint8_t bflags;				/* Buffer flags */
+#endif
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+	FAR struct smartfs_seekindex_s
+			*seekindex;				/* Allocated by the first seek walking the chain */
+#endif
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+	FAR uint8_t *gbuffer;		/* Appends to currsector not committed yet */
+	uint16_t goffset;			/* Sector offset of the first held byte */
+	uint16_t glength;			/* Number of bytes held */
+	systime_t gstart;			/* Time of the first held append */
+	FAR struct smartfs_ofile_s *gnext;	/* Next file with held appends */
+	FAR struct smartfs_mountpt_s *gfs;	/* Volume of the held appends */
+#endif
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+	size_t rapos;				/* File position where the last read ended */
 #endif
 	int16_t crefs;				/* Reference count */
 	mode_t oflags;				/* Open mode */
@@ -395,6 +468,9 @@ struct smartfs_mountpt_s {
 #endif
 #ifdef CONFIG_SMARTFS_JOURNALING
 	struct journal_transaction_manager_s *journal;
+#endif
+#if CONFIG_SMARTFS_READ_CACHE > 0
+	FAR struct smartfs_cache_s *fs_cache;	/* Sector read cache */
 #endif
 	uint8_t fs_rootsector;		/* Root directory sector num */
 };
@@ -537,6 +613,14 @@ void smartfs_wrle32(uint8_t *dest, uint32_t val);
 struct smartfs_mountpt_s *smartfs_get_first_mount(void);
 #endif
 
+#if CONFIG_SMARTFS_READ_CACHE > 0
+int smartfs_cache_ioctl(struct smartfs_mountpt_s *fs, int cmd, unsigned long arg);
+int smartfs_cache_read(struct smartfs_mountpt_s *fs, uint16_t sector, FAR uint8_t **data);
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+void smartfs_cache_readahead(struct smartfs_mountpt_s *fs, uint16_t sector);
+#endif
+#endif
+
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
 uint16_t get_leftover_used_byte_count(uint8_t *buffer, uint16_t base_index);
 uint16_t get_used_byte_count_from_end(uint8_t *buffer);
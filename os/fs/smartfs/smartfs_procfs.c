@@ -88,6 +88,14 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Unit of the allocation times reported by the SMART MTD layer */
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+#define SMARTFS_PROCFS_TIME_UNIT "cycles"
+#else
+#define SMARTFS_PROCFS_TIME_UNIT "ticks"
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -752,6 +760,15 @@ static size_t smartfs_status_read(FAR struct file *filep, FAR char *buffer, size
 		if (ret == OK) {
 			/* Format and return data in the buffer */
 			len = snprintf(buffer, buflen, "Total Sectors    %d\nFree Sectors     %d\n" "Released Sectors %d\n", procfs_data.totalsectors, procfs_data.freesectors, procfs_data.releasesectors);
+			len += snprintf(&buffer[len], buflen - len, "Allocations      %u\nAlloc Time Avg   %u " SMARTFS_PROCFS_TIME_UNIT "\n" "Alloc Time Max   %u " SMARTFS_PROCFS_TIME_UNIT "\n", procfs_data.allocations, procfs_data.allocavg, procfs_data.allocmax);
+			len += snprintf(&buffer[len], buflen - len, "Bytes Written    %u\n", procfs_data.byteswritten);
+#if CONFIG_SMARTFS_READ_CACHE > 0
+			if (priv->level1.mount->fs_cache != NULL) {
+				FAR struct smartfs_cache_s *cache = priv->level1.mount->fs_cache;
+
+				len += snprintf(&buffer[len], buflen - len, "Cache Hits       %u\nCache Misses     %u\n" "Read Aheads      %u\n", cache->hits, cache->misses, cache->readaheads);
+			}
+#endif
 #ifdef CONFIG_DEBUG_FS
 			/* Calculate the sector utilization percentage */
 			if (procfs_data.blockerases == 0) {
@@ -75,6 +75,9 @@
 #include <tinyara/fs/ioctl.h>
 #include <tinyara/fs/mtd.h>
 #include <tinyara/fs/smart.h>
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+#include <tinyara/wqueue.h>
+#endif
 
 #include "smartfs.h"
 
@@ -116,6 +119,10 @@ static int smartfs_stat(struct inode *mountpt, const char *relpath, struct stat
 
 static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, off_t offset, int whence);
 
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+static int smartfs_group_commit(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf);
+#endif
+
 /****************************************************************************
  * Private Variables
  ****************************************************************************/
@@ -123,6 +130,16 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 static uint8_t g_seminitialized = FALSE;
 static sem_t g_sem;
 
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+/* The open files of all the volumes which hold appends, and the work that
+ * commits them when the latency bound has passed.  Both are protected by
+ * g_sem, which all the volumes share.
+ */
+
+static FAR struct smartfs_ofile_s *g_gheld;
+static struct work_s g_gwork;
+#endif
+
 /****************************************************************************
  * Public Variables
  ****************************************************************************/
@@ -317,6 +334,16 @@ static int smartfs_open(FAR struct file *filep, const char *relpath, int oflags,
 	sf->curroffset = sizeof(struct smartfs_chain_header_s);
 	sf->currsector = sf->entry.firstsector;
 	sf->byteswritten = 0;
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+	sf->seekindex = NULL;
+#endif
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+	sf->gbuffer = NULL;
+	sf->glength = 0;
+#endif
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+	sf->rapos = (size_t)-1;
+#endif
 
 	/* Test if we opened for APPEND mode.  If we did, then seek to the
 	 * end of the file.
@@ -443,6 +470,19 @@ static int smartfs_close(FAR struct file *filep)
 		kmm_free(sf->buffer);
 	}
 #endif
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+	if (sf->seekindex) {
+		kmm_free(sf->seekindex);
+	}
+#endif
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+	/* Take the file off the held list, even if the sync failed */
+
+	(void)smartfs_group_commit(fs, sf);
+	if (sf->gbuffer) {
+		kmm_free(sf->gbuffer);
+	}
+#endif
 
 	kmm_free(sf);
 
@@ -460,12 +500,18 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 	struct inode *inode;
 	struct smartfs_mountpt_s *fs;
 	struct smartfs_ofile_s *sf;
+#if CONFIG_SMARTFS_READ_CACHE == 0
 	struct smart_read_write_s readwrite;
+#endif
 	struct smartfs_chain_header_s *header;
+	FAR uint8_t *data;
 	int ret = OK;
 	uint32_t bytesread;
 	uint16_t bytestoread;
 	uint16_t bytesinsector;
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+	bool sequential;
+#endif
 
 	/* Sanity checks */
 
@@ -482,6 +528,18 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 	/* Take the semaphore */
 
 	smartfs_semtake(fs);
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+	sequential = (sf->filepos == sf->rapos);
+#endif
+
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+	/* Commit the appends held for this file, so that they can be read */
+
+	ret = smartfs_group_commit(fs, sf);
+	if (ret != OK) {
+		goto errout_with_semaphore;
+	}
+#endif
 
 	/* Loop until all byte read or error */
 
@@ -495,6 +553,15 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 			break;
 		}
 
+#if CONFIG_SMARTFS_READ_CACHE > 0
+		/* Get the current sector from the cache */
+
+		ret = smartfs_cache_read(fs, sf->currsector, &data);
+		if (ret < 0) {
+			fdbg("Error %d reading sector %d data\n", ret, sf->currsector);
+			goto errout_with_semaphore;
+		}
+#else
 		/* Read the curent sector into our buffer */
 
 		readwrite.logsector = sf->currsector;
@@ -507,13 +574,16 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 			goto errout_with_semaphore;
 		}
 
+		data = (uint8_t *)fs->fs_rwbuffer;
+#endif
+
 		/* Point header to the read data to get used byte count */
 
-		header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+		header = (struct smartfs_chain_header_s *)data;
 
 		/* Get number of used bytes in this sector */
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
-		bytesinsector = get_leftover_used_byte_count((uint8_t *)readwrite.buffer, get_used_byte_count((uint8_t *)header->used));
+		bytesinsector = get_leftover_used_byte_count(data, get_used_byte_count((uint8_t *)header->used));
 #else
 		bytesinsector = SMARTFS_USED(header);
 
@@ -537,7 +607,7 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 		if (bytestoread > 0) {
 			/* Do incremental copy from this sector */
 
-			memcpy(&buffer[bytesread], &fs->fs_rwbuffer[sf->curroffset], bytestoread);
+			memcpy(&buffer[bytesread], &data[sf->curroffset], bytestoread);
 			bytesread += bytestoread;
 			sf->filepos += bytestoread;
 			sf->curroffset += bytestoread;
@@ -561,6 +631,18 @@ static ssize_t smartfs_read(FAR struct file *filep, char *buffer, size_t buflen)
 		}
 	}
 
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+	/* If the file is read sequentially, i.e. this read started where the
+	 * previous one ended, and it stopped at the start of the next sector of
+	 * the chain, the next read will need that sector.
+	 */
+
+	if (sequential && sf->currsector != SMARTFS_ERASEDSTATE_16BIT && sf->curroffset == sizeof(struct smartfs_chain_header_s)) {
+		smartfs_cache_readahead(fs, sf->currsector);
+	}
+	sf->rapos = sf->filepos;
+#endif
+
 	/* Return the number of bytes we read */
 
 	ret = bytesread;
@@ -570,6 +652,144 @@ errout_with_semaphore:
 	return ret;
 }
 
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+/****************************************************************************
+ * Name: smartfs_group_commit
+ *
+ * Description: Logs the appends held for a file with one journal
+ *   transaction, and writes them to their sector.
+ *
+ ****************************************************************************/
+
+static int smartfs_group_commit(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf)
+{
+	struct smart_read_write_s readwrite;
+	FAR struct smartfs_ofile_s **prev;
+	uint16_t t_sector;
+	uint16_t t_offset;
+	int ret;
+
+	if (sf->glength == 0) {
+		return OK;
+	}
+
+	/* The file no longer holds appends */
+
+	for (prev = &g_gheld; *prev != sf; prev = &(*prev)->gnext) ;
+	*prev = sf->gnext;
+	if (g_gheld == NULL) {
+		(void)work_cancel(LPWORK, &g_gwork);
+	}
+
+	readwrite.logsector = sf->currsector;
+	readwrite.offset = sf->goffset;
+	readwrite.count = sf->glength;
+	readwrite.buffer = &sf->gbuffer[sf->goffset];
+	sf->glength = 0;
+
+	ret = smartfs_create_journalentry(fs, T_WRITE, readwrite.logsector, readwrite.offset, readwrite.count, readwrite.offset + readwrite.count - sizeof(struct smartfs_chain_header_s), 1, readwrite.buffer, &t_sector, &t_offset);
+	if (ret != OK) {
+		fdbg("Journal entry creation failed.\n");
+		return ret;
+	}
+
+	ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+	if (ret < 0) {
+		fdbg("Error %d writing sector %d data\n", ret, readwrite.logsector);
+		return ret;
+	}
+
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_group_worker
+ *
+ * Description: Commits the appends held for longer than the latency bound,
+ *   and runs again when the oldest of the remaining ones is due.
+ *
+ ****************************************************************************/
+
+static void smartfs_group_worker(FAR void *arg)
+{
+	FAR struct smartfs_ofile_s *sf;
+	FAR struct smartfs_ofile_s *next;
+	systime_t bound = MSEC2TICK(CONFIG_SMARTFS_JOURNAL_COMMIT_MS);
+	systime_t delay = bound;
+	systime_t age;
+	int ret;
+
+	/* No volume is needed to take g_sem */
+
+	while (sem_wait(&g_sem) != 0) {
+		ASSERT(*get_errno_ptr() == EINTR);
+	}
+
+	for (sf = g_gheld; sf != NULL; sf = next) {
+		next = sf->gnext;
+		age = clock_systimer() - sf->gstart;
+		if (age >= bound) {
+			ret = smartfs_group_commit(sf->gfs, sf);
+			if (ret != OK) {
+				fdbg("Error %d committing held appends\n", ret);
+			}
+		} else if (bound - age < delay) {
+			delay = bound - age;
+		}
+	}
+
+	if (g_gheld != NULL) {
+		(void)work_queue(LPWORK, &g_gwork, smartfs_group_worker, NULL, delay);
+	}
+
+	sem_post(&g_sem);
+}
+
+/****************************************************************************
+ * Name: smartfs_group_append
+ *
+ * Description: Holds an append to the current sector of a file.  The held
+ *   appends are committed by smartfs_group_worker() once the first of them
+ *   is older than the latency bound, or earlier by the next append.  They
+ *   are always contiguous, up to the current offset of the file in its
+ *   current sector: a sync, which is done before the file moves to another
+ *   sector or position or is closed, commits them.
+ *
+ ****************************************************************************/
+
+static int smartfs_group_append(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, FAR struct smart_read_write_s *readwrite)
+{
+	if (sf->gbuffer == NULL) {
+		sf->gbuffer = (FAR uint8_t *)kmm_malloc(fs->fs_llformat.availbytes);
+		if (sf->gbuffer == NULL) {
+			return -ENOMEM;
+		}
+	}
+
+	DEBUGASSERT(sf->glength == 0 || sf->goffset + sf->glength == readwrite->offset);
+
+	if (sf->glength == 0) {
+		sf->goffset = readwrite->offset;
+		sf->gstart = clock_systimer();
+		sf->gfs = fs;
+		sf->gnext = g_gheld;
+		g_gheld = sf;
+		if (work_available(&g_gwork)) {
+			(void)work_queue(LPWORK, &g_gwork, smartfs_group_worker, NULL, MSEC2TICK(CONFIG_SMARTFS_JOURNAL_COMMIT_MS));
+		}
+	}
+
+	memcpy(&sf->gbuffer[readwrite->offset], readwrite->buffer, readwrite->count);
+	sf->glength += readwrite->count;
+
+	if (clock_systimer() - sf->gstart >= MSEC2TICK(CONFIG_SMARTFS_JOURNAL_COMMIT_MS)) {
+		return smartfs_group_commit(fs, sf);
+	}
+
+	return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: smartfs_sync_internal
  *
@@ -632,6 +852,15 @@ static int smartfs_sync_internal(struct smartfs_mountpt_s *fs, struct smartfs_of
 	}
 #else							/* CONFIG_SMARTFS_USE_SECTOR_BUFFER */
 
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+	/* Write the appends held for the current sector first */
+
+	ret = smartfs_group_commit(fs, sf);
+	if (ret != OK) {
+		goto errout;
+	}
+#endif
+
 	/* Test if we have written bytes to the current sector that
 	 * need to be recorded in the chain header's used bytes field. */
 
@@ -875,6 +1104,12 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 		/* Perform the write */
 
 		if (readwrite.count > 0) {
+#ifdef CONFIG_SMARTFS_JOURNAL_GROUP_COMMIT
+			ret = smartfs_group_append(fs, sf, &readwrite);
+			if (ret != OK) {
+				goto errout_with_semaphore;
+			}
+#else
 #ifdef CONFIG_SMARTFS_JOURNALING
 			ret = smartfs_create_journalentry(fs, T_WRITE, readwrite.logsector, readwrite.offset, readwrite.count, sf->curroffset + readwrite.count - sizeof(struct smartfs_chain_header_s), 1, readwrite.buffer, &t_sector, &t_offset);
 			if (ret != OK) {
@@ -888,6 +1123,7 @@ static ssize_t smartfs_write(FAR struct file *filep, const char *buffer, size_t
 				fdbg("Error %d writing sector %d data\n", ret, sf->currsector);
 				goto errout_with_semaphore;
 			}
+#endif
 		}
 #endif							/* CONFIG_SMARTFS_USE_SECTOR_BUFFER */
 
@@ -1016,6 +1252,135 @@ errout_with_semaphore:
 	return ret;
 }
 
+/****************************************************************************
+ * Name: smartfs_seekindex_slot
+ *
+ * Description: Returns where an entry for the given file position goes in
+ *              the sorted index, or -1 if it is closer than the spacing to
+ *              a remembered position on either side.
+ *
+ ****************************************************************************/
+
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+static int smartfs_seekindex_slot(struct smartfs_seekindex_s *index, off_t pos)
+{
+	uint16_t x;
+
+	for (x = index->nentries; x > 0 && index->pos[x - 1] > pos; x--) ;
+
+	if (x > 0 && pos < index->pos[x - 1] + index->spacing) {
+		return -1;
+	}
+
+	if (x < index->nentries && index->pos[x] < pos + index->spacing) {
+		return -1;
+	}
+
+	return x;
+}
+#endif
+
+/****************************************************************************
+ * Name: smartfs_seekindex_add
+ *
+ * Description: Remembers that a sector of the file chain starts at the
+ *              given file position, if it is far enough from the other
+ *              remembered ones.  The entries are kept sorted, so a walk
+ *              which started in the middle of the file still fills in the
+ *              sectors before it later.  When the index is full, every
+ *              other entry is dropped and the spacing doubled.
+ *
+ ****************************************************************************/
+
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+static void smartfs_seekindex_add(struct smartfs_mountpt_s *fs, struct smartfs_ofile_s *sf, off_t pos, uint16_t sector)
+{
+	struct smartfs_seekindex_s *index = sf->seekindex;
+	uint16_t x;
+	int slot;
+
+	if (index == NULL) {
+		index = (struct smartfs_seekindex_s *)kmm_malloc(sizeof(struct smartfs_seekindex_s));
+		if (index == NULL) {
+			return;
+		}
+
+		index->nentries = 0;
+		index->spacing = fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s);
+		sf->seekindex = index;
+	}
+
+	slot = smartfs_seekindex_slot(index, pos);
+	if (slot < 0) {
+		return;
+	}
+
+	if (index->nentries == CONFIG_SMARTFS_SEEK_INDEX) {
+		for (x = 0; x < CONFIG_SMARTFS_SEEK_INDEX / 2; x++) {
+			index->pos[x] = index->pos[x << 1];
+			index->sector[x] = index->sector[x << 1];
+		}
+
+		index->nentries = x;
+		index->spacing <<= 1;
+		slot = smartfs_seekindex_slot(index, pos);
+		if (slot < 0) {
+			return;
+		}
+	}
+
+	for (x = index->nentries; x > slot; x--) {
+		index->pos[x] = index->pos[x - 1];
+		index->sector[x] = index->sector[x - 1];
+	}
+
+	index->pos[slot] = pos;
+	index->sector[slot] = sector;
+	index->nentries++;
+}
+#endif
+
+/****************************************************************************
+ * Name: smartfs_seekindex_start
+ *
+ * Description: Moves the start of a seek walk to the last remembered sector
+ *              starting before the new position, if it is further along
+ *              the chain than the current start.
+ *
+ ****************************************************************************/
+
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+static void smartfs_seekindex_start(struct smartfs_ofile_s *sf, off_t newpos)
+{
+	struct smartfs_seekindex_s *index = sf->seekindex;
+	uint16_t lo;
+	uint16_t hi;
+	uint16_t mid;
+
+	if (index == NULL || index->nentries == 0 || index->pos[0] >= newpos) {
+		return;
+	}
+
+	/* Binary search for the last entry before newpos */
+
+	lo = 0;
+	hi = index->nentries;
+	while (hi - lo > 1) {
+		mid = (lo + hi) >> 1;
+		if (index->pos[mid] < newpos) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+
+	if (index->pos[lo] > sf->filepos) {
+		sf->filepos = index->pos[lo];
+		sf->currsector = index->sector[lo];
+	}
+}
+#endif
+
 /****************************************************************************
  * Name: smartfs_seek_internal
  *
@@ -1034,7 +1399,7 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 	off_t newpos;
 	off_t sectorstartpos;
 #ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
-	int sector_used = 0;
+	int sector_used;
 #endif
 	/* Test if this is a seek to get the current file pos */
 
@@ -1103,8 +1468,21 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 		sf->filepos = 0;
 	}
 
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+	/* A sector remembered by an earlier seek may be closer */
+
+	smartfs_seekindex_start(sf, newpos);
+#endif
+#ifdef CONFIG_SMARTFS_DYNAMIC_HEADER
+	sector_used = sf->filepos / (fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s));
+#endif
+
 	header = (struct smartfs_chain_header_s *)fs->fs_rwbuffer;
 	while ((sf->currsector != SMARTFS_ERASEDSTATE_16BIT) && (sf->filepos + fs->fs_llformat.availbytes - sizeof(struct smartfs_chain_header_s) < newpos)) {
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+		smartfs_seekindex_add(fs, sf, sf->filepos, sf->currsector);
+#endif
+
 		/* Read the sector's header */
 
 		readwrite.logsector = sf->currsector;
@@ -1129,6 +1507,12 @@ static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs, struct smartfs_
 		sf->currsector = SMARTFS_NEXTSECTOR(header);
 	}
 
+#if CONFIG_SMARTFS_SEEK_INDEX > 0
+	if (sf->currsector != SMARTFS_ERASEDSTATE_16BIT) {
+		smartfs_seekindex_add(fs, sf, sf->filepos, sf->currsector);
+	}
+#endif
+
 #ifdef CONFIG_SMARTFS_USE_SECTOR_BUFFER
 
 	/* When using sector buffering, we must read in the last buffer to our
@@ -95,6 +95,10 @@
  * Private Function Prototypes
  ****************************************************************************/
 
+#if CONFIG_SMARTFS_READ_CACHE > 0
+static FAR struct smartfs_cache_s *smartfs_cache_alloc(struct smartfs_mountpt_s *fs);
+#endif
+
 /****************************************************************************
  * Private Variables
  ****************************************************************************/
@@ -554,6 +558,9 @@ int smartfs_mount(struct smartfs_mountpt_s *fs, bool writeable)
 
 			fs->fs_rwbuffer = nextfs->fs_rwbuffer;
 			fs->fs_workbuffer = nextfs->fs_workbuffer;
+#if CONFIG_SMARTFS_READ_CACHE > 0
+			fs->fs_cache = nextfs->fs_cache;
+#endif
 			break;
 		}
 
@@ -599,6 +606,16 @@ int smartfs_mount(struct smartfs_mountpt_s *fs, bool writeable)
 	fs->fs_workbuffer = (char *)kmm_malloc(256);
 	fs->fs_rootsector = SMARTFS_ROOT_DIR_SECTOR;
 
+#if CONFIG_SMARTFS_READ_CACHE > 0
+	/* Allocate the sector read cache.  Without it, the reads go to the
+	 * device through the read/write buffer.
+	 */
+
+	if (fs->fs_cache == NULL) {
+		fs->fs_cache = smartfs_cache_alloc(fs);
+	}
+#endif
+
 	/* We did it! */
 
 	fs->fs_mounted = TRUE;
@@ -706,6 +723,11 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 #endif
 		kmm_free(fs->fs_rwbuffer);
 		kmm_free(fs->fs_workbuffer);
+#if CONFIG_SMARTFS_READ_CACHE > 0
+		if (fs->fs_cache) {
+			kmm_free(fs->fs_cache);
+		}
+#endif
 
 		/* Set the buffer's to invalid value to catch program bugs */
 
@@ -740,6 +762,11 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
 #endif
 	kmm_free(fs->fs_rwbuffer);
 	kmm_free(fs->fs_workbuffer);
+#if CONFIG_SMARTFS_READ_CACHE > 0
+	if (fs->fs_cache) {
+		kmm_free(fs->fs_cache);
+	}
+#endif
 #endif
 
 	return ret;
@@ -1703,6 +1730,231 @@ struct smartfs_mountpt_s *smartfs_get_first_mount(void)
 }
 #endif
 
+#if CONFIG_SMARTFS_READ_CACHE > 0
+/****************************************************************************
+ * Name: smartfs_cache_alloc
+ *
+ * Description: Allocates the sector read cache of a volume with all its
+ *              entries unused.  The sector data follows the cache structure
+ *              in the same allocation.
+ *
+ ****************************************************************************/
+
+static FAR struct smartfs_cache_s *smartfs_cache_alloc(struct smartfs_mountpt_s *fs)
+{
+	FAR struct smartfs_cache_s *cache;
+	FAR uint8_t *data;
+	int x;
+
+	cache = (FAR struct smartfs_cache_s *)kmm_zalloc(sizeof(struct smartfs_cache_s) + CONFIG_SMARTFS_READ_CACHE * fs->fs_llformat.availbytes);
+	if (cache == NULL) {
+		fdbg("No memory for the read cache\n");
+		return NULL;
+	}
+
+	data = (FAR uint8_t *)&cache[1];
+	for (x = 0; x < CONFIG_SMARTFS_READ_CACHE; x++) {
+		cache->entry[x].sector = SMARTFS_ERASEDSTATE_16BIT;
+		cache->entry[x].data = data;
+		data += fs->fs_llformat.availbytes;
+	}
+
+	return cache;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_find
+ *
+ * Description: Returns the cache entry of a sector, or NULL if the sector
+ *              is not in the cache.
+ *
+ ****************************************************************************/
+
+static FAR struct smartfs_cacheentry_s *smartfs_cache_find(FAR struct smartfs_cache_s *cache, uint16_t sector)
+{
+	int x;
+
+	for (x = 0; x < CONFIG_SMARTFS_READ_CACHE; x++) {
+		if (cache->entry[x].sector == sector) {
+			return &cache->entry[x];
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_load
+ *
+ * Description: Reads a sector into the least recently used entry of the
+ *              cache.
+ *
+ ****************************************************************************/
+
+static int smartfs_cache_load(struct smartfs_mountpt_s *fs, uint16_t sector, FAR struct smartfs_cacheentry_s **result)
+{
+	FAR struct smartfs_cache_s *cache = fs->fs_cache;
+	FAR struct smartfs_cacheentry_s *entry;
+	struct smart_read_write_s readwrite;
+	int ret;
+	int x;
+
+	/* Take an unused entry, or else the least recently used one */
+
+	entry = &cache->entry[0];
+	for (x = 0; x < CONFIG_SMARTFS_READ_CACHE; x++) {
+		if (cache->entry[x].sector == SMARTFS_ERASEDSTATE_16BIT) {
+			entry = &cache->entry[x];
+			break;
+		}
+
+		if (cache->entry[x].lastuse < entry->lastuse) {
+			entry = &cache->entry[x];
+		}
+	}
+
+	readwrite.logsector = sector;
+	readwrite.offset = 0;
+	readwrite.buffer = entry->data;
+	readwrite.count = fs->fs_llformat.availbytes;
+	ret = FS_BLKIOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+	if (ret < 0) {
+		entry->sector = SMARTFS_ERASEDSTATE_16BIT;
+		return ret;
+	}
+
+	entry->sector = sector;
+	entry->lastuse = ++cache->usecount;
+	*result = entry;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_ioctl
+ *
+ * Description: Passes a request to the block driver and drops from the
+ *              cache the sectors it changes.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_ioctl(struct smartfs_mountpt_s *fs, int cmd, unsigned long arg)
+{
+	FAR struct smartfs_cache_s *cache = fs->fs_cache;
+	FAR struct smartfs_cacheentry_s *entry;
+	int ret;
+	int x;
+
+	if (cache != NULL) {
+		entry = NULL;
+		switch (cmd) {
+		case BIOC_WRITESECT:
+			entry = smartfs_cache_find(cache, ((FAR struct smart_read_write_s *)arg)->logsector);
+			break;
+
+		case BIOC_FREESECT:
+			entry = smartfs_cache_find(cache, (uint16_t)arg);
+			break;
+
+		case BIOC_LLFORMAT:
+			for (x = 0; x < CONFIG_SMARTFS_READ_CACHE; x++) {
+				cache->entry[x].sector = SMARTFS_ERASEDSTATE_16BIT;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if (entry != NULL) {
+			entry->sector = SMARTFS_ERASEDSTATE_16BIT;
+		}
+	}
+
+	ret = FS_BLKIOCTL(fs, cmd, arg);
+
+	/* A newly allocated sector has no data yet */
+
+	if (cache != NULL && cmd == BIOC_ALLOCSECT && ret >= 0) {
+		entry = smartfs_cache_find(cache, (uint16_t)ret);
+		if (entry != NULL) {
+			entry->sector = SMARTFS_ERASEDSTATE_16BIT;
+		}
+	}
+
+	return ret;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_read
+ *
+ * Description: Returns the data of a sector, from the chain header on, from
+ *              the cache or read into it.  Without a cache the sector is
+ *              read into the read/write buffer.  The data is valid until the
+ *              next request to the volume.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_read(struct smartfs_mountpt_s *fs, uint16_t sector, FAR uint8_t **data)
+{
+	FAR struct smartfs_cache_s *cache = fs->fs_cache;
+	FAR struct smartfs_cacheentry_s *entry;
+	struct smart_read_write_s readwrite;
+	int ret;
+
+	if (cache == NULL) {
+		readwrite.logsector = sector;
+		readwrite.offset = 0;
+		readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
+		readwrite.count = fs->fs_llformat.availbytes;
+		ret = FS_BLKIOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+		if (ret < 0) {
+			return ret;
+		}
+
+		*data = (uint8_t *)fs->fs_rwbuffer;
+		return OK;
+	}
+
+	entry = smartfs_cache_find(cache, sector);
+	if (entry != NULL) {
+		cache->hits++;
+		entry->lastuse = ++cache->usecount;
+	} else {
+		cache->misses++;
+		ret = smartfs_cache_load(fs, sector, &entry);
+		if (ret < 0) {
+			return ret;
+		}
+	}
+
+	*data = entry->data;
+	return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_readahead
+ *
+ * Description: Reads the given sector into the cache, if it is not there
+ *              yet, for a reader which is about to need it.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SMARTFS_READ_AHEAD
+void smartfs_cache_readahead(struct smartfs_mountpt_s *fs, uint16_t sector)
+{
+	FAR struct smartfs_cacheentry_s *entry;
+
+	if (fs->fs_cache == NULL || smartfs_cache_find(fs->fs_cache, sector) != NULL) {
+		return;
+	}
+
+	if (smartfs_cache_load(fs, sector, &entry) == OK) {
+		fs->fs_cache->readaheads++;
+	}
+}
+#endif
+#endif							/* CONFIG_SMARTFS_READ_CACHE > 0 */
+
 #ifdef CONFIG_SMARTFS_SECTOR_RECOVERY
 /****************************************************************************
  * Name: smartfs_examine_sector
@@ -2962,6 +3214,7 @@ static int smartfs_write_transaction(struct smartfs_mountpt_s *fs, struct journa
 	int ret;
 	int info;
 	uint16_t startsector;
+	uint16_t datalen;
 	struct smart_read_write_s req;
 	struct smartfs_logging_entry_s *entry;
 
@@ -2983,13 +3236,29 @@ static int smartfs_write_transaction(struct smartfs_mountpt_s *fs, struct journa
 		startsector = SMARTFS_LOGGING_SECTOR + j_mgr->jarea * CONFIG_SMARTFS_NLOGGING_SECTORS;
 	}
 
+	/* Data is present unless the transaction is a T_DELETE, for which we
+	 * are reusing the datalen field of the logging entry.
+	 */
+	datalen = 0;
+	if (entry->datalen > 0 && GET_TRANS_TYPE(entry->trans_info) != T_DELETE) {
+		datalen = entry->datalen;
+	}
+
 	*sector = j_mgr->sector;
 	*offset = j_mgr->offset;
 	req.logsector = *sector;
 	req.offset = *offset;
-	req.count = sizeof(struct smartfs_logging_entry_s);
+	req.count = sizeof(struct smartfs_logging_entry_s) + datalen;
 	req.buffer = j_mgr->buffer;
-	/* Write the entry */
+
+	if (req.offset + req.count > j_mgr->availbytes) {
+		/* Not enough space to write full data in the same sector.
+		 * Write only what can be accomodated
+		 */
+		req.count = j_mgr->availbytes - req.offset;
+	}
+
+	/* Write the entry, followed by its data, with a single write */
 	ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&req);
 	if (ret != OK) {
 		fdbg("write entry failed ret : %d\n", ret);
@@ -2997,52 +3266,27 @@ static int smartfs_write_transaction(struct smartfs_mountpt_s *fs, struct journa
 	}
 	/* Increment the journal manager offset */
 	j_mgr->offset += req.count;
-	req.offset += req.count;
 	req.buffer += req.count;
-	if (entry->datalen > 0 && GET_TRANS_TYPE(entry->trans_info) != T_DELETE) {
-		/* Write data if present. We also check transaction type because we are
-		 * reusing datalen field of logging entry in case of T_DELETE
-		 */
-		req.count = entry->datalen;
-
-		if (req.offset + entry->datalen > j_mgr->availbytes) {
-			/* Not enough space to write full data in the same sector.
-			 * Write only what can be accomodated
-			 */
-			req.count = j_mgr->availbytes - req.offset;
+	if (req.count < sizeof(struct smartfs_logging_entry_s) + datalen) {
+		/* If any data is left to write, go to next sector */
+		req.count = sizeof(struct smartfs_logging_entry_s) + datalen - req.count;
+		req.logsector++;
+		if (req.logsector >= startsector + CONFIG_SMARTFS_NLOGGING_SECTORS) {
+			/* This case should have been handled above. */
+			fdbg("logical sector is too big!! %d\n", req.logsector);
+			return -ENOSPC;
 		}
+		req.offset = 0;
 
-		if (req.count > 0) {
-			/* Write the data */
-			ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&req);
-			if (ret != OK) {
-				fdbg("write data failed ret : %d\n", ret);
-				return ret;
-			}
-			req.buffer += req.count;
-			j_mgr->offset += req.count;
-		}
-		if (req.count < entry->datalen) {
-			/* If any data is left to write, go to next sector */
-			req.logsector++;
-			if (req.logsector >= startsector + CONFIG_SMARTFS_NLOGGING_SECTORS) {
-				/* This case should have been handled above. */
-				fdbg("logical sector is too big!! %d\n", req.logsector);
-				return -ENOSPC;
-			}
-			req.offset = 0;
-			req.count = entry->datalen - req.count;
-
-			/* Write remaining data */
-			ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&req);
-			if (ret != OK) {
-				fdbg("write remained data failed ret : %d\n", ret);
-				return ret;
-			}
-			/* Update journal manager sector and offset */
-			j_mgr->sector = req.logsector;
-			j_mgr->offset = req.count;
+		/* Write remaining data */
+		ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&req);
+		if (ret != OK) {
+			fdbg("write remained data failed ret : %d\n", ret);
+			return ret;
 		}
+		/* Update journal manager sector and offset */
+		j_mgr->sector = req.logsector;
+		j_mgr->offset = req.count;
 	}
 
 	/* Mark the transaction as STARTED */
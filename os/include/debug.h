@@ -134,20 +134,27 @@
 /* Temporary LOGM macros to route all dbg messages.
 Once LOGM is approved, each module should have its own index
 */
+#ifndef LOGM_IDX
 #define LOGM_IDX (0)
-#define LOGM_PRI (1)
+#endif
 #define LOGM_EN  (2)
 
+/* Messages which the logm filter suppresses are not even passed to logm */
+
+#define logmdbg(priority, format, ...) \
+	(LOGM_FILTERED(LOGM_IDX, priority) ? logm_suppress(LOGM_IDX) : \
+	 logm(LOGM_EN, LOGM_IDX, priority, format, ##__VA_ARGS__))
+
 #ifdef CONFIG_DEBUG_ERROR
 #ifdef CONFIG_LOGM
 #define dbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_ERR, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #define dbg_noarg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, format, ##__VA_ARGS__)
+	logmdbg(LOGM_ERR, format, ##__VA_ARGS__)
 
 #define lldbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_ERR, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #else
 /**
@@ -179,10 +186,10 @@ Once LOGM is approved, each module should have its own index
 #ifdef CONFIG_DEBUG_WARN
 #ifdef CONFIG_LOGM
 #define wdbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_WRN, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #define llwdbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_WRN, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #else
 /**
@@ -212,10 +219,10 @@ Once LOGM is approved, each module should have its own index
 #ifdef CONFIG_DEBUG_VERBOSE
 #ifdef CONFIG_LOGM
 #define vdbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_INF, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #define llvdbg(format, ...) \
-	logm(LOGM_EN, LOGM_IDX, LOGM_PRI, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
+	logmdbg(LOGM_INF, EXTRA_FMT format EXTRA_ARG, ##__VA_ARGS__)
 
 #else
 /**
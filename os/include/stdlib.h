@@ -119,6 +119,22 @@ struct mallinfo {
 								 * chunks handed out by malloc. */
 	int fordblks;				/* This is the total size of memory occupied
 								 * by free (not in use) chunks.*/
+#ifdef CONFIG_MM_QUICKLIST
+	int qlblks;					/* This is the number of free chunks held by
+								 * the small allocation quick lists */
+	int qlhits;					/* This is the number of small allocations
+								 * served from a quick list */
+	int qlmisses;				/* This is the number of small allocations
+								 * which had to search the free chunks */
+	int mxsearch;				/* This is the longest search of the free
+								 * chunks made by an allocation */
+	int fragmentation;			/* This is the percentage of free space which
+								 * lies outside of the largest free chunk */
+#endif
+#ifdef CONFIG_MM_TASK_CACHE
+	int semwaits;				/* This is the number of times a task had to
+								 * wait for the heap semaphore */
+#endif
 };
 
 /* Structure type returned by the div() function. */
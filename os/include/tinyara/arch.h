@@ -1363,6 +1363,23 @@ void up_disable_irq(int irq);
 int up_prioritize_irq(int irq, int priority);
 #endif
 
+/****************************************************************************
+ * Name: up_cyclecount_initialize and up_cyclecount
+ *
+ * Description:
+ *   up_cyclecount() returns a free running 32-bit counter of the processor
+ *   cycles, which wraps around.  It is cheap enough to timestamp events in
+ *   the scheduler.  up_cyclecount_initialize() starts the counter and is
+ *   called once by up_initialize(); other users only read the counter, as
+ *   restarting it would disturb the timestamps of everyone else.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+void up_cyclecount_initialize(void);
+uint32_t up_cyclecount(void);
+#endif
+
 /****************************************************************************
  * Tickless OS Support.
  *
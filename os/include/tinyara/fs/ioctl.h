@@ -229,6 +229,12 @@
 										 *      the block with specific debug
 										 *      command and data.
 										 * OUT: None.  */
+#define BIOC_CHECKPOINT _BIOC(0x000C)	/* Save the state of a SMART flash device
+										 * so that the next mount does not need
+										 * to scan it.
+										 * IN:  None
+										 * OUT: None (ioctl return value provides
+										 *      success/failure indication). */
 
 /* TinyAra MTD driver ioctl definitions ***************************************/
 
@@ -99,6 +99,10 @@ struct mtd_smart_procfs_data_s {
 	uint8_t formatversion;		/* Version of the volume format */
 	uint32_t unusedsectors;	/* Number of unused sectors (free when erased) */
 	uint32_t blockerases;		/* Number block erase operations */
+	uint32_t allocations;		/* Number of free sector allocations */
+	uint32_t allocavg;			/* Average time of an allocation */
+	uint32_t allocmax;			/* Longest allocation */
+	uint32_t byteswritten;		/* Number of bytes programmed to the device */
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
 	FAR const uint8_t *erasecounts;	/* Array of erase counts per erase block */
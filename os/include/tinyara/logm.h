@@ -19,7 +19,9 @@
 #ifndef __OS_INCLUDE_TINYARA_LOGM_H
 #define __OS_INCLUDE_TINYARA_LOGM_H
 
+#include <tinyara/config.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #define LOGM_DEF_PRIORITY (7)
 /* Log priority levels in logm */
@@ -36,6 +38,22 @@ enum logm_loglevels_e {
 	LOGM_OFF  /* Is this needed? */
 };
 
+/* The logm filter suppresses, for each module index, the messages less
+ * urgent than a level.  LOGM_FILTERED() tells whether a message
+ * is suppressed, and logm_suppress() counts it.
+ */
+
+#ifdef CONFIG_LOGM_FILTER
+#define LOGM_NMODULES CONFIG_LOGM_NMODULES
+
+#define LOGM_FILTERED(indx, priority) \
+	((unsigned int)(indx) < LOGM_NMODULES && (unsigned int)(priority) < LOGM_OFF && \
+	 (g_logm_filter[indx] & (1 << (priority))) != 0)
+#else
+#define LOGM_FILTERED(indx, priority) (0)
+#define logm_suppress(indx) (0)
+#endif
+
 enum logm_param_type_e {
 	LOGM_BUFSIZE,
 	LOGM_INTERVAL,
@@ -52,11 +70,22 @@ extern "C"
 #  define EXTERN extern
 #endif
 
+#ifdef CONFIG_LOGM_FILTER
+/* Bit p of g_logm_filter[indx] suppresses the messages of priority p */
+
+EXTERN uint8_t g_logm_filter[LOGM_NMODULES];
+#endif
+
 void logm_start(void);
 int logm_internal(int priority, const char *fmt, va_list valst);
 int logm(int flag, int mod, int priority, const char *fmt, ...);
 int logm_set_values(enum logm_param_type_e type, int value);
 int logm_get_values(enum logm_param_type_e type, int* value);
+#ifdef CONFIG_LOGM_FILTER
+int logm_suppress(int indx);
+int logm_set_filter(int indx, int level);
+int logm_get_filter(int indx, int *level, uint32_t *suppressed);
+#endif
 
 #undef EXTERN
 #if defined(__cplusplus)
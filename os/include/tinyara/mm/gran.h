@@ -133,9 +133,7 @@ extern "C" {
  *   The actual memory allocates will be 64 byte (wasting 17 bytes) and
  *   will be aligned at least to (1 << log2align).
  *
- *   NOTE: The current implementation also restricts the maximum allocation
- *   size to 32 granules.  That restriction could be eliminated with some
- *   additional coding effort.
+ *   An allocation may span any number of granules.
  *
  * Input Parameters:
  *   heapstart - Start of the granule allocation heap
@@ -216,9 +214,7 @@ void gran_reserve(GRAN_HANDLE handle, uintptr_t start, size_t size);
  * Description:
  *   Allocate memory from the granule heap.
  *
- *   NOTE: The current implementation also restricts the maximum allocation
- *   size to 32 granules.  That restriction could be eliminated with some
- *   additional coding effort.
+ *   An allocation may span any number of granules.
  *
  * Input Parameters:
  *   handle - The handle previously returned by gran_initialize
@@ -292,6 +292,34 @@ struct mm_freenode_s {
 #define CHECK_FREENODE_SIZE \
 	DEBUGASSERT(sizeof(struct mm_freenode_s) == SIZEOF_MM_FREENODE)
 
+/* Quick lists hold freed small chunks, one list per chunk size.  A cached
+ * chunk keeps its allocated bit so that it is never coalesced, and is
+ * linked through the flink field of its free node header.
+ */
+
+#ifdef CONFIG_MM_QUICKLIST
+#define MM_QUICKLIST_MAXCHUNK MM_ALIGN_UP(CONFIG_MM_QUICKLIST_MAXSIZE + SIZEOF_MM_ALLOCNODE)
+#define MM_QUICKLIST_NCLASSES (MM_QUICKLIST_MAXCHUNK >> MM_MIN_SHIFT)
+#define MM_QUICKLIST_NDX(s)   (((s) >> MM_MIN_SHIFT) - 1)
+
+struct mm_quicklist_s {
+	FAR struct mm_freenode_s *head;	/* Most recently freed chunk */
+	uint8_t count;					/* Number of chunks in the list */
+};
+
+#ifdef CONFIG_MM_TASK_CACHE
+/* The small chunks of the user heap kept by one thread.  Only the owning
+ * thread touches it, except when its TCB is released.
+ */
+
+struct mm_taskcache_s {
+	struct mm_quicklist_s lists[MM_QUICKLIST_NCLASSES];
+	uint32_t flushgen;				/* Last flush request seen by the thread */
+	FAR struct mm_taskcache_s *flink;	/* Next released cache to drain */
+};
+#endif
+#endif
+
 /* This describes one heap (possibly with multiple regions) */
 
 struct mm_heap_s {
@@ -326,6 +354,22 @@ struct mm_heap_s {
 	 */
 
 	struct mm_freenode_s mm_nodelist[MM_NNODES];
+
+#ifdef CONFIG_MM_QUICKLIST
+	/* Freed small chunks indexed by chunk size, and the statistics which
+	 * are reported through mallinfo()
+	 */
+
+	struct mm_quicklist_s mm_quicklist[MM_QUICKLIST_NCLASSES];
+	size_t mm_qlblks;			/* Chunks held by the quick lists */
+	size_t mm_qlsize;			/* Bytes held by the quick lists */
+	size_t mm_qlhits;			/* Small allocations served by a quick list */
+	size_t mm_qlmisses;			/* Small allocations served by the heap */
+	size_t mm_mxsearch;			/* Longest free node list search */
+#endif
+#ifdef CONFIG_MM_TASK_CACHE
+	size_t mm_semwaits;			/* Semaphore takes which had to wait */
+#endif
 };
 
 /****************************************************************************
@@ -434,6 +478,7 @@ FAR void *kmm_malloc(size_t size);
 /* Functions contained in mm_free.c *****************************************/
 
 void mm_free(FAR struct mm_heap_s *heap, FAR void *mem);
+void mm_freechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
 
 /* Functions contained in kmm_free.c ****************************************/
 
@@ -590,6 +635,25 @@ void mm_addfreechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
 
 int mm_size2ndx(size_t size);
 
+/* Functions contained in mm_quicklist.c ************************************/
+
+#ifdef CONFIG_MM_QUICKLIST
+void mm_quicklist_initialize(FAR struct mm_heap_s *heap);
+FAR void *mm_quicklist_alloc(FAR struct mm_heap_s *heap, size_t size);
+bool mm_quicklist_free(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
+bool mm_quicklist_flush(FAR struct mm_heap_s *heap);
+#endif
+
+/* Functions contained in mm_taskcache.c ************************************/
+
+#ifdef CONFIG_MM_TASK_CACHE
+FAR void *mm_taskcache_alloc(FAR struct mm_heap_s *heap, size_t size);
+bool mm_taskcache_free(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node);
+void mm_taskcache_release(FAR struct mm_taskcache_s *cache);
+bool mm_taskcache_flush(FAR struct mm_heap_s *heap);
+void mm_taskcache_enable(bool enable);
+#endif
+
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 /* Functions contained in kmm_mallinfo.c . Used to display memory allocation details */
 void heapinfo_parse(FAR struct mm_heap_s *heap, int mode, int pid);
@@ -467,6 +467,9 @@ struct task_group_s {
 /* struct tcb_s ******************************************************************/
 
 FAR struct wdog_s;				/* Forward reference                   */
+#ifdef CONFIG_MM_TASK_CACHE
+struct mm_taskcache_s;			/* Forward reference                   */
+#endif
 /** @brief This is the common part of the task control block (TCB).  The TCB is the heart
  * of the TinyAra task-control logic.  Each task or thread is represented by a TCB
  * that includes these common definitions.
@@ -579,6 +582,10 @@ struct tcb_s {
 	int peak_alloc_size;
 	int num_alloc_free;
 #endif
+
+#ifdef CONFIG_MM_TASK_CACHE
+	FAR struct mm_taskcache_s *mm_cache;	/* Small chunks kept by this thread */
+#endif
 };
 
 /* struct task_tcb_s *************************************************************/
@@ -41,6 +41,11 @@
 #include <debug.h>
 #include <time.h>
 #include <sys/types.h>
+#ifdef CONFIG_TTRACE_BINARY
+#include <ttrace.h>
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#endif
 
 /****************************************************************************
  * Public Type Declarations
@@ -94,6 +99,7 @@ static const struct tag_list ttrace_tags[] = {
 	{"lock",    "Lock",          TTRACE_TAG_LOCK},
 	{"task",    "TASK",          TTRACE_TAG_TASK},
 	{"ipc",     "IPC",           TTRACE_TAG_IPC},
+	{"irq",     "Interrupts",    TTRACE_TAG_IRQ},
 };
 
 struct sched_message {          // total 32B
@@ -121,6 +127,125 @@ struct trace_packet {        // total 44 byte(message), 12byte(uid)
 	union trace_message msg;   // 32B
 };
 
+#ifdef CONFIG_TTRACE_BINARY
+#define TTRACE_EVENT_TYPE_SCHED    's'
+#define TTRACE_EVENT_TYPE_IRQ      'i'
+#define TTRACE_EVENT_TYPE_IRQ_END  'x'
+#define TTRACE_EVENT_TYPE_SEM      'w'
+#define TTRACE_EVENT_TYPE_SEM_END  'a'
+
+#define TTRACE_EVENT_NARGS          4
+#define TTRACE_EVENT_COMM_BYTES     8
+
+#define TTRACE_HEADER_MAGIC         0x54545242	/* "TTRB" */
+
+/* One event of the binary trace ring.  The format of a begin event is only
+ * applied to its arguments when the trace is printed.  A context switch
+ * keeps the previous task in args[0] (pid, priority << 16, state << 24),
+ * the next one in args[1] (pid, priority << 16) and the first bytes of the
+ * name of the next task in args[2] and args[3].  The interrupt events keep
+ * the IRQ number and the semaphore events the semaphore in args[0].
+ */
+
+struct ttrace_event_s {        // total 32B
+	uint32_t cycles;           // 4B, cycle counter
+	uint32_t ticks;            // 4B, system timer, to unwrap the cycles
+	int16_t pid;               // 2B
+	uint8_t event_type;        // 1B, zero until the event is complete
+	int8_t code;               // 1B, code(1b) + number of args(7b) or uid(7b)
+	const char *fmt;           // 4B
+	uint32_t args[TTRACE_EVENT_NARGS];  // 16B
+};
+
+/* read() of the T-trace device returns this header, then the events from
+ * the oldest to the newest.
+ */
+
+struct ttrace_header_s {
+	uint32_t magic;            // TTRACE_HEADER_MAGIC
+	uint32_t nevents;          // Number of events which follow
+	uint32_t lost;             // Number of events overwritten in the ring
+	uint32_t cycles_per_tick;  // Zero without cycle counter
+	uint32_t ticks;            // System timer when the trace started
+	uint32_t cycles;           // Cycle counter when the trace started
+};
+
+struct ttrace_ring_s {
+	volatile uint32_t tags;    // Selected tags, zero when not tracing
+	volatile uint32_t head;    // Number of events reserved since the start
+	uint32_t mask;             // Number of events in the ring - 1
+	struct ttrace_header_s start;
+	struct ttrace_event_s *events;
+};
+
+extern struct ttrace_ring_s g_ttrace_ring;
+
+#ifdef CONFIG_ARCH_HAVE_CYCLECOUNT
+#define ttrace_cycles() up_cyclecount()
+#else
+#define ttrace_cycles() 0
+#endif
+
+/* Reserve the next event of the ring if the tag is being traced and
+ * timestamp it.  Whoever calls this fills the event and completes it with
+ * ttrace_commit(), in any context.
+ */
+
+static inline struct ttrace_event_s *ttrace_reserve(int tag)
+{
+	struct ttrace_event_s *event;
+	uint32_t index;
+
+	if ((g_ttrace_ring.tags & tag) == 0) {
+		return NULL;
+	}
+
+	index = __sync_fetch_and_add(&g_ttrace_ring.head, 1);
+	event = &g_ttrace_ring.events[index & g_ttrace_ring.mask];
+	event->event_type = 0;
+	event->cycles = ttrace_cycles();
+	event->ticks = clock_systimer();
+	return event;
+}
+
+static inline void ttrace_commit(struct ttrace_event_s *event, char type)
+{
+	__sync_synchronize();
+	event->event_type = (uint8_t)type;
+}
+
+/* Return the time of an event in microseconds since the trace started */
+
+static uint64_t ttrace_event_usec(const struct ttrace_header_s *header, const struct ttrace_event_s *event)
+{
+	uint32_t cpt = header->cycles_per_tick;
+	uint64_t coarse;
+	uint64_t cycles;
+
+	coarse = (uint64_t)(event->ticks - header->ticks) * (cpt > 0 ? cpt : 1);
+	if (cpt == 0) {
+		return coarse * USEC_PER_TICK;
+	}
+
+	/* The system timer tells how many times the cycle counter wrapped */
+
+	cycles = (coarse & ~(uint64_t)0xffffffff) | (uint32_t)(event->cycles - header->cycles);
+	if (cycles + 0x80000000 < coarse) {
+		cycles += (uint64_t)1 << 32;
+	} else if (cycles > coarse + 0x80000000 && cycles > 0xffffffff) {
+		cycles -= (uint64_t)1 << 32;
+	}
+
+	return cycles * USEC_PER_TICK / cpt;
+}
+
+void ttrace_ring_initialize(char *buffer, size_t size);
+void ttrace_ring_start(uint32_t tags);
+void ttrace_ring_stop(void);
+size_t ttrace_ring_used(void);
+ssize_t ttrace_ring_read(char *buffer, size_t len);
+#endif
+
 static int show_packet(struct trace_packet *packet)
 {
 	int uid = (packet->codelen & TTRACE_CODE_UNIQUE) >> 7;
@@ -106,6 +106,13 @@
  *  checks for work in units of microseconds.  Default: 50*1000 (50 MS).
  * CONFIG_SCHED_LPWORKSTACKSIZE - The stack size allocated for the lower
  *   priority worker thread.  Default: 2048.
+ * CONFIG_SCHED_LPWORK_STEALING - Give each lower priority worker thread
+ *   its own queues of ready work, one per class of work, and let idle
+ *   threads take work from the others.  Default: n
+ * CONFIG_SCHED_LPWORK_BULKTHREADS - The number of lower priority worker
+ *   threads which may run WORK_CLASS_BULK work.  Default: 1
+ * CONFIG_SCHED_WORKQUEUE_STATS - Keep latency statistics of the kernel
+ *   work queues, see work_getstats().  Default: n
  *
  * The user-mode work queue is only available in the protected or kernel
  * builds.  This those configurations, the user-mode work queue provides the
@@ -287,6 +294,17 @@
 
 #endif							/* CONFIG_LIB_USRWORK && !__KERNEL__ */
 
+/* Classes of low priority work, see work_queue_class().  Each worker takes
+ * high priority work before normal work.  Bulk work, such as flash writes
+ * or TLS handshakes, only runs on the CONFIG_SCHED_LPWORK_BULKTHREADS
+ * workers reserved for it, so that it never holds up the other classes.
+ */
+
+#define WORK_CLASS_HIGH    0	/* Short and latency sensitive */
+#define WORK_CLASS_NORMAL  1	/* The class of work_queue() */
+#define WORK_CLASS_BULK    2	/* Long running */
+#define WORK_NCLASSES      3
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -304,12 +322,55 @@ typedef void (*worker_t)(FAR void *arg);
 
 struct work_s {
 	struct dq_entry_s dq;		/* Implements a doubly linked list */
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	FAR struct work_s *parent;	/* Expiry heap of the kernel work queues */
+	FAR struct work_s *child[2];
+#endif
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+	uint8_t wclass;				/* The class of the work, WORK_CLASS_* */
+	uint8_t wndx;				/* The low priority worker holding the work */
+#endif
 	worker_t worker;			/* Work callback */
 	FAR void *arg;				/* Callback argument */
 	systime_t qtime;			/* Time work queued */
 	systime_t delay;			/* Delay until work performed */
 };
 
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+/* Statistics of the work performed in one class, in clock ticks.  The
+ * latency is the time from the expiry of a work until its worker starts.
+ */
+
+struct work_classstats_s {
+	uint32_t nwork;				/* The number of works performed */
+	uint32_t latency;			/* Total latency */
+	uint32_t maxlatency;		/* Largest latency */
+	uint32_t runtime;			/* Total time spent in the worker callbacks */
+	uint32_t maxruntime;		/* Longest time spent in a worker callback */
+};
+
+/* Statistics of the threads of a work queue */
+
+struct work_threadstats_s {
+	uint32_t nwork;				/* The number of works performed */
+	uint32_t nsteal;			/* Of those, taken from other threads */
+};
+
+#if defined(CONFIG_SCHED_LPWORK) && CONFIG_SCHED_LPNTHREADS > 1
+#define WORK_MAXTHREADS CONFIG_SCHED_LPNTHREADS
+#else
+#define WORK_MAXTHREADS 1
+#endif
+
+/* Statistics of one work queue, see work_getstats() */
+
+struct work_stats_s {
+	uint8_t nthreads;			/* The number of valid entries in thread[] */
+	struct work_classstats_s cls[WORK_NCLASSES];
+	struct work_threadstats_s thread[WORK_MAXTHREADS];
+};
+#endif
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -375,6 +436,25 @@ int work_usrstart(void);
 
 int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay);
 
+/****************************************************************************
+ * Name: work_queue_class
+ *
+ * Description:
+ *   Like work_queue(), but also give the class of the work, one of
+ *   WORK_CLASS_HIGH, WORK_CLASS_NORMAL or WORK_CLASS_BULK.  The class only
+ *   matters for the low priority work queue with
+ *   CONFIG_SCHED_LPWORK_STEALING; otherwise this is the same as
+ *   work_queue().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_WORKQUEUE
+int work_queue_class(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay, uint8_t wclass);
+#else
+#define work_queue_class(qid, work, worker, arg, delay, wclass) \
+	work_queue(qid, work, worker, arg, delay)
+#endif
+
 /****************************************************************************
  * Name: work_cancel
  *
@@ -432,6 +512,25 @@ int work_signal(int qid);
 
 #define work_available(work) ((work)->worker == NULL)
 
+/****************************************************************************
+ * Name: work_getstats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of a kernel work queue.
+ *
+ * Input parameters:
+ *   qid   - The work queue ID
+ *   stats - The location to return the statistics
+ *
+ * Returned Value:
+ *   Zero on success, -EINVAL if the work queue is not known.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKQUEUE_STATS)
+int work_getstats(int qid, FAR struct work_stats_s *stats);
+#endif
+
 /****************************************************************************
  * Name: lpwork_boostpriority
  *
@@ -1267,6 +1267,9 @@
  * Comment this macro to disable support for SSL session tickets
  */
 //#define MBEDTLS_SSL_SESSION_TICKETS
+#if defined(CONFIG_TLS_SESSION_RESUMPTION)
+#define MBEDTLS_SSL_SESSION_TICKETS
+#endif
 
 /**
  * \def MBEDTLS_SSL_EXPORT_KEYS
@@ -33,6 +33,15 @@
 #include <tls/ssl_cache.h>
 #endif
 
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+#ifdef MBEDTLS_SSL_TICKET_C
+#include <tls/ssl_ticket.h>
+#endif
+#ifdef MBEDTLS_THREADING_C
+#include <tls/threading.h>
+#endif
+#endif
+
 #define EASY_TLS_DEBUG	ndbg
 
 enum easy_tls_error {
@@ -64,6 +73,14 @@ typedef struct tls_cert_and_key {
 #endif
 } tls_cred;
 
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+typedef struct tls_saved_session {
+	char *host_name;				///< server name of the session, NULL if the entry is free
+	mbedtls_ssl_session session;	///< session (and ticket) offered at the next connection
+	unsigned int lastuse;			///< value of the use count when the session was last used
+} tls_saved_session;
+#endif
+
 typedef struct tls_context {
 	mbedtls_ssl_config *conf;
 	mbedtls_x509_crt *crt;
@@ -74,6 +91,18 @@ typedef struct tls_context {
 #ifdef MBEDTLS_SSL_CACHE_C
 	mbedtls_ssl_cache_context *cache;
 #endif
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	tls_saved_session *sessions;	///< client session store, CONFIG_TLS_SESSION_STORE_SIZE entries
+	unsigned int usecount;			///< number of uses of the session store
+#ifdef MBEDTLS_SSL_TICKET_C
+	mbedtls_ssl_ticket_context *ticket;
+#endif
+#ifdef MBEDTLS_THREADING_C
+	mbedtls_threading_mutex_t mutex;
+#endif
+#endif
+	unsigned int full_handshakes;		///< number of successful full handshakes
+	unsigned int resumed_handshakes;	///< number of successful abbreviated handshakes
 } tls_ctx;
 
 typedef struct tls_options {
@@ -120,6 +149,9 @@ int TLSCtx_free(tls_ctx *ctx);
  *			should be called after connect(accept) socket because it will do
  *			tls handshake with input file descriptor.
  *
+ *			With CONFIG_TLS_SESSION_RESUMPTION, a client resumes the last
+ *			session with the server named by opt->host_name, if any.
+ *
  * @param[in] fd	a file descriptor(socket) to make secure session.
  * @param[in] ctx	initialized structure pointer for TLSCtx();
  * @param[in] opt	a structure pointer including several tls options.
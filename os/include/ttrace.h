@@ -44,6 +44,7 @@
 #define TTRACE_TAG_LOCK            (1 << 2)
 #define TTRACE_TAG_TASK            (1 << 3)
 #define TTRACE_TAG_IPC             (1 << 4)
+#define TTRACE_TAG_IRQ             (1 << 5)
 
 /****************************************************************************
  * Public Variables
@@ -63,7 +64,16 @@ int trace_begin(int tag, char *str, ...);
 int trace_begin_u(int tag, int8_t uid);
 int trace_end(int tag);
 int trace_end_u(int tag);
+#ifdef CONFIG_TTRACE_BINARY
+/* The scheduler records the context switches itself */
+#define trace_sched(a, b)
+void trace_irq_enter(int irq);
+void trace_irq_leave(int irq);
+void trace_sem_wait(FAR void *sem);
+void trace_sem_done(FAR void *sem);
+#else
 int trace_sched(struct tcb_s *prev, struct tcb_s *next);
+#endif
 #else
 #define trace_begin(a, b, ...)
 #define trace_begin_u(a, b)
@@ -72,6 +82,13 @@ int trace_sched(struct tcb_s *prev, struct tcb_s *next);
 #define trace_sched(a, b)
 #endif
 
+#ifndef CONFIG_TTRACE_BINARY
+#define trace_irq_enter(a)
+#define trace_irq_leave(a)
+#define trace_sem_wait(a)
+#define trace_sem_done(a)
+#endif
+
 #if defined(__cplusplus)
 }
 #endif
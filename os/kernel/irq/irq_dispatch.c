@@ -57,6 +57,7 @@
 #include <tinyara/config.h>
 
 #include <debug.h>
+#include <ttrace.h>
 #include <tinyara/arch.h>
 #include <tinyara/irq.h>
 
@@ -117,5 +118,7 @@ void irq_dispatch(int irq, FAR void *context)
 
 	/* Then dispatch to the interrupt handler */
 
+	trace_irq_enter(irq);
 	vector(irq, context, arg);
+	trace_irq_leave(irq);
 }
@@ -62,6 +62,7 @@
 
 #include <tinyara/arch.h>
 #include <tinyara/sched.h>
+#include <tinyara/mm/mm.h>
 
 #include "sched/sched.h"
 #include "group/group.h"
@@ -207,6 +208,18 @@ int sched_releasetcb(FAR struct tcb_s *tcb, uint8_t ttype)
 		ret = up_addrenv_detach(tcb->group, tcb);
 #endif
 
+#ifdef CONFIG_MM_TASK_CACHE
+		/* Give the small chunks cached by the thread back to the user heap.
+		 * Not through sched_ufree(), which would cache them again for the
+		 * running thread.
+		 */
+
+		if (tcb->mm_cache) {
+			mm_taskcache_release(tcb->mm_cache);
+			tcb->mm_cache = NULL;
+		}
+#endif
+
 #ifdef HAVE_TASK_GROUP
 		/* Leave the group (if we did not already leave in task_exithook.c) */
 
@@ -60,6 +60,7 @@
 #include <semaphore.h>
 #include <errno.h>
 #include <assert.h>
+#include <ttrace.h>
 #include <tinyara/arch.h>
 #include <tinyara/cancelpt.h>
 
@@ -193,7 +194,9 @@ int sem_wait(FAR sem_t *sem)
 			/* Add the TCB to the prioritized semaphore wait queue */
 
 			set_errno(0);
+			trace_sem_wait(sem);
 			up_block_task(rtcb, TSTATE_WAIT_SEM);
+			trace_sem_done(sem);
 
 			/* When we resume at this point, either (1) the semaphore has been
 			 * assigned to this thread of execution, or (2) the semaphore wait
@@ -324,7 +327,9 @@ int sem_wait_for_isr(FAR sem_t *sem)
 
 			set_errno(0);
 
+			trace_sem_wait(sem);
 			up_block_task(rtcb, TSTATE_WAIT_SEM);
+			trace_sem_done(sem);
 
 			/* When we resume at this point, either (1) the semaphore has been
 			 * assigned to this thread of execution, or (2) the semaphore wait
@@ -111,7 +111,9 @@
 
 static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
 {
+#ifndef CONFIG_SCHED_WORKQUEUE_SORTING
 	struct work_s *cur_work;
+#endif
 	irqstate_t flags;
 	int ret = -ENOENT;
 
@@ -124,6 +126,34 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wo
 
 	flags = irqsave();
 	if (work->worker != NULL) {
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+		/* Ready low priority work sits in the queue of a worker */
+
+		if (work->wndx != WORK_NOWORKER) {
+			if (wqueue != (FAR struct kwork_wqueue_s *)&g_lpwork) {
+				irqrestore(flags);
+				return -ENOENT;
+			}
+
+			dq_rem((FAR dq_entry_t *)work, &g_lpwork.worker[work->wndx].ready[work->wclass]);
+			work->wndx = WORK_NOWORKER;
+			work->worker = NULL;
+			irqrestore(flags);
+			return OK;
+		}
+#endif
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+		/* Make sure that the work is in this queue and not in another one */
+
+		if (!work_heap_contains(wqueue, work)) {
+			irqrestore(flags);
+			return -ENOENT;
+		}
+
+		/* Remove the entry from the heap and mark it as available */
+
+		work_heap_remove(wqueue, work);
+#else
 		/* A little test of the integrity of the work queue */
 
 		DEBUGASSERT(work->dq.flink || (FAR dq_entry_t *)work == wqueue->q.tail);
@@ -147,6 +177,7 @@ static int work_qcancel(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wo
 		 */
 
 		dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+#endif
 		work->worker = NULL;
 		ret = OK;
 	}
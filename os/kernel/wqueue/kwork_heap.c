@@ -0,0 +1,288 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/wqueue/kwork_heap.c
+ *
+ * The pending work of a kernel work queue is kept in a binary min-heap
+ * ordered by expiry time.  The heap is built from the links in the work
+ * structures themselves, so no memory is needed beyond the work structures
+ * and any number of them can be queued.  Node n of the heap (counting from
+ * 1 at the root) is found by following the bits of n below its most
+ * significant bit from the root, 0 to the left child and 1 to the right.
+ *
+ * Insertion and removal take O(log n) steps and the earliest work is
+ * always at the root, so the time spent with interrupts disabled does not
+ * depend on how much work is queued.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <assert.h>
+
+#include <tinyara/clock.h>
+#include <tinyara/wqueue.h>
+
+#include "wqueue/wqueue.h"
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKQUEUE_SORTING)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The expiry time of a work and a comparison which survives the wrap of
+ * the system timer, as long as no delay exceeds half of its range.
+ */
+
+#define WORK_EXPIRY(w)      ((w)->qtime + (w)->delay)
+#define WORK_BEFORE(w1, w2) \
+	((systime_t)(WORK_EXPIRY(w1) - WORK_EXPIRY(w2)) > ((systime_t)-1 >> 1))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_heap_node
+ *
+ * Description:
+ *   Return the work at position 'n' of the heap, or its parent if 'parent'
+ *   is true.
+ *
+ ****************************************************************************/
+
+static FAR struct work_s *work_heap_node(FAR struct kwork_wqueue_s *wqueue, unsigned int n, bool parent)
+{
+	FAR struct work_s *work = wqueue->root;
+	int bit;
+
+	for (bit = 0; (n >> bit) > 1; bit++) ;
+
+	for (bit--; bit >= (parent ? 1 : 0); bit--) {
+		work = work->child[(n >> bit) & 1];
+	}
+
+	return work;
+}
+
+/****************************************************************************
+ * Name: work_heap_link
+ *
+ * Description:
+ *   Point the parent of 'old', or the root, at 'repl'.
+ *
+ ****************************************************************************/
+
+static void work_heap_link(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *old, FAR struct work_s *repl)
+{
+	FAR struct work_s *parent = old->parent;
+
+	if (parent == NULL) {
+		wqueue->root = repl;
+	} else if (parent->child[0] == old) {
+		parent->child[0] = repl;
+	} else {
+		parent->child[1] = repl;
+	}
+
+	if (repl != NULL) {
+		repl->parent = parent;
+	}
+}
+
+/****************************************************************************
+ * Name: work_heap_swap
+ *
+ * Description:
+ *   Exchange a work with its parent.
+ *
+ ****************************************************************************/
+
+static void work_heap_swap(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *parent, FAR struct work_s *work)
+{
+	FAR struct work_s *child0 = work->child[0];
+	FAR struct work_s *child1 = work->child[1];
+	FAR struct work_s *sibling;
+	int side;
+
+	side = (parent->child[1] == work);
+	sibling = parent->child[!side];
+
+	/* The work takes the place of its parent ... */
+
+	work_heap_link(wqueue, parent, work);
+	work->child[side] = parent;
+	work->child[!side] = sibling;
+	if (sibling != NULL) {
+		sibling->parent = work;
+	}
+
+	/* ... and the parent takes the children of the work */
+
+	parent->parent = work;
+	parent->child[0] = child0;
+	parent->child[1] = child1;
+	if (child0 != NULL) {
+		child0->parent = parent;
+	}
+
+	if (child1 != NULL) {
+		child1->parent = parent;
+	}
+}
+
+/****************************************************************************
+ * Name: work_heap_siftup and work_heap_siftdown
+ *
+ * Description:
+ *   Move a work up or down until it expires no earlier than its parent and
+ *   no later than its children.
+ *
+ ****************************************************************************/
+
+static void work_heap_siftup(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	while (work->parent != NULL && WORK_BEFORE(work, work->parent)) {
+		work_heap_swap(wqueue, work->parent, work);
+	}
+}
+
+static void work_heap_siftdown(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	FAR struct work_s *child;
+
+	while ((child = work->child[0]) != NULL) {
+		if (work->child[1] != NULL && WORK_BEFORE(work->child[1], child)) {
+			child = work->child[1];
+		}
+
+		if (!WORK_BEFORE(child, work)) {
+			break;
+		}
+
+		work_heap_swap(wqueue, work, child);
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_heap_insert
+ *
+ * Description:
+ *   Add a work to the heap of a work queue.  The qtime and delay of the
+ *   work must already be set.  Interrupts must be disabled by the caller.
+ *
+ ****************************************************************************/
+
+void work_heap_insert(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	FAR struct work_s *parent;
+	unsigned int n;
+
+	n = ++wqueue->nwork;
+	work->child[0] = NULL;
+	work->child[1] = NULL;
+
+	if (n == 1) {
+		work->parent = NULL;
+		wqueue->root = work;
+		return;
+	}
+
+	parent = work_heap_node(wqueue, n, true);
+	DEBUGASSERT(parent != NULL && parent->child[n & 1] == NULL);
+
+	parent->child[n & 1] = work;
+	work->parent = parent;
+	work_heap_siftup(wqueue, work);
+}
+
+/****************************************************************************
+ * Name: work_heap_remove
+ *
+ * Description:
+ *   Remove a work from the heap of a work queue.  The last work of the heap
+ *   takes its place and is then moved up or down.  Interrupts must be
+ *   disabled by the caller.
+ *
+ ****************************************************************************/
+
+void work_heap_remove(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	FAR struct work_s *last;
+
+	DEBUGASSERT(wqueue->nwork > 0);
+
+	last = work_heap_node(wqueue, wqueue->nwork, false);
+	wqueue->nwork--;
+
+	/* Detach the last work from the bottom of the heap */
+
+	work_heap_link(wqueue, last, NULL);
+	if (last == work) {
+		return;
+	}
+
+	/* And put it where the removed work was */
+
+	work_heap_link(wqueue, work, last);
+	last->child[0] = work->child[0];
+	last->child[1] = work->child[1];
+	if (last->child[0] != NULL) {
+		last->child[0]->parent = last;
+	}
+
+	if (last->child[1] != NULL) {
+		last->child[1]->parent = last;
+	}
+
+	if (last->parent != NULL && WORK_BEFORE(last, last->parent)) {
+		work_heap_siftup(wqueue, last);
+	} else {
+		work_heap_siftdown(wqueue, last);
+	}
+}
+
+/****************************************************************************
+ * Name: work_heap_contains
+ *
+ * Description:
+ *   Return true if a queued work is in the heap of the given work queue,
+ *   and not in that of another queue.  Interrupts must be disabled by the
+ *   caller.
+ *
+ ****************************************************************************/
+
+bool work_heap_contains(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work)
+{
+	while (work->parent != NULL) {
+		work = work->parent;
+	}
+
+	return work == wqueue->root;
+}
+
+#endif							/* CONFIG_SCHED_WORKQUEUE && CONFIG_SCHED_WORKQUEUE_SORTING */
@@ -176,7 +176,12 @@ int work_hpstart(void)
 	/* Initialize work queue data structures */
 
 	g_hpwork.delay = CONFIG_SCHED_HPWORKPERIOD / USEC_PER_TICK;
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	g_hpwork.root = NULL;
+	g_hpwork.nwork = 0;
+#else
 	dq_init(&g_hpwork.q);
+#endif
 
 	/* Start the high-priority, kernel mode worker thread */
 
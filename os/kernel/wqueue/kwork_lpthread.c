@@ -154,7 +154,11 @@ static int work_lpthread(int argc, char *argv[])
 			 * to wait indefinitely until a signal is received.
 			 */
 
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+			work_lpprocess(0, wndx);
+#else
 			work_process((FAR struct kwork_wqueue_s *)&g_lpwork, 0, wndx);
+#endif
 		} else
 #endif
 		{
@@ -175,7 +179,11 @@ static int work_lpthread(int argc, char *argv[])
 			 * period provided by g_lpwork.delay expires.
 			 */
 
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+			work_lpprocess(g_lpwork.delay, 0);
+#else
 			work_process((FAR struct kwork_wqueue_s *)&g_lpwork, g_lpwork.delay, 0);
+#endif
 		}
 	}
 
@@ -208,10 +216,15 @@ int work_lpstart(void)
 
 	/* Initialize work queue data structures */
 
-	memset(&g_lpwork, 0, sizeof(struct kwork_wqueue_s));
+	memset(&g_lpwork, 0, sizeof(struct lp_wqueue_s));
 
 	g_lpwork.delay = CONFIG_SCHED_LPWORKPERIOD / USEC_PER_TICK;
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	g_lpwork.root = NULL;
+	g_lpwork.nwork = 0;
+#else
 	dq_init(&g_lpwork.q);
+#endif
 
 	/* Don't permit any of the threads to run until we have fully initialized
 	 * g_lpwork.
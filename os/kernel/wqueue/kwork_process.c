@@ -133,10 +133,14 @@ void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 	systime_t elapsed;
 #ifndef CONFIG_SCHED_WORKQUEUE_SORTING
 	systime_t remaining;
-#endif
 	systime_t stick;
+#endif
 	systime_t ctick;
 	systime_t next;
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+	systime_t expiry;
+	uint8_t wclass;
+#endif
 
 	/* Then process queued work.  We need to keep interrupts disabled while
 	 * we process items in the work list.
@@ -145,6 +149,58 @@ void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 	next = period;
 	flags = irqsave();
 
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	/* The earliest work is always at the root of the heap, so only expired
+	 * work and the next one to expire are ever looked at.
+	 */
+
+	while ((work = wqueue->root) != NULL) {
+		ctick = clock_systimer();
+		elapsed = ctick - work->qtime;
+
+		if (elapsed < work->delay) {
+			/* Not ready.  Sleep until it will be. */
+
+			next = work->delay - elapsed;
+			break;
+		}
+
+		/* Remove the ready-to-execute work from the heap and extract the
+		 * work description from the entry (in case the work instance will
+		 * be re-used after it has been de-queued).
+		 */
+
+		work_heap_remove(wqueue, (FAR struct work_s *)work);
+		worker = work->worker;
+		arg = work->arg;
+		DEBUGASSERT(worker != NULL);
+
+		/* Mark the work as no longer being queued */
+
+		work->worker = NULL;
+
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+		expiry = work->qtime + work->delay;
+		wclass = WORK_CLASS(work);
+#endif
+
+		/* Do the work.  Re-enable interrupts while the work is being
+		 * performed... we don't have any idea how long this will take!
+		 */
+
+		irqrestore(flags);
+		worker(arg);
+
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+		work_stats_update(wqueue, wndx, wclass, expiry, ctick, false);
+#endif
+		flags = irqsave();
+	}
+
+	if (wqueue->root == NULL) {
+		period = 0;
+	}
+#else
 	/* Get the time that we started this polling cycle in clock ticks. */
 
 	stick = clock_systimer();
@@ -228,12 +284,6 @@ void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 
 			/* Will it be ready before the next scheduled wakeup interval? */
 
-#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
-			next = work->delay - elapsed;
-
-			/* Then break at while loop due to sorted list */
-			break;
-#else
 			remaining = work->delay - elapsed;
 			if (remaining < next) {
 				/* Yes.. Then schedule to wake up when the work is ready */
@@ -243,14 +293,8 @@ void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx)
 			/* Then try the next in the list. */
 
 			work = (FAR struct work_s *)work->dq.flink;
-#endif
 		}
 	}
-
-#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
-	if ((FAR struct work_s *)wqueue->q.head == NULL) {
-		period = 0;
-	}
 #endif
 
 #if (defined(CONFIG_SCHED_LPWORK) && CONFIG_SCHED_LPNTHREADS > 0) || defined(CONFIG_SCHED_WORKQUEUE_SORTING)
@@ -112,22 +112,33 @@
  *            int is invoked.
  *   delay  - Delay (in clock ticks) from the time queue until the worker
  *            is invoked. Zero means to perform the work immediately.
+ *   wclass - The class of the work
  *
  * Returned Value:
  *   Zero (OK) on success, a negated errno on failure.
  *
  ****************************************************************************/
 
-static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay, uint8_t wclass)
 {
+#ifndef CONFIG_SCHED_WORKQUEUE_SORTING
 	struct work_s *cur_work;
-	struct work_s *next_work;
+#endif
 	irqstate_t flags;
 	DEBUGASSERT(work != NULL);
 
-	next_work = NULL;
 	flags = irqsave();
 
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	/* Work stays in the heap exactly as long as its worker is set, so there
+	 * is no need to search for it.
+	 */
+
+	if (work->worker != NULL) {
+		irqrestore(flags);
+		return -EALREADY;
+	}
+#else
 	/* check whether requested work is in queue list or not */
 	cur_work = (struct work_s *)wqueue->q.head;
 	while (cur_work != NULL) {
@@ -136,24 +147,27 @@ static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wor
 			return -EALREADY;
 		}
 
-		if ((cur_work->delay > delay) && (next_work == NULL)) {
-			next_work = cur_work;
-		}
-
 		cur_work = (struct work_s *)cur_work->dq.flink;
 	}
+#endif
 
 	work->worker = worker;		/* Work callback */
 	work->arg = arg;			/* Callback argument */
 	work->delay = delay;		/* Delay until work performed */
 	work->qtime = clock_systimer();	/* Time work queued */
 
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+	work->wclass = wclass < WORK_NCLASSES ? wclass : WORK_CLASS_NORMAL;
+	work->wndx = WORK_NOWORKER;
+
+	/* Low priority work which is ready goes straight to a worker */
+
+	if (delay == 0 && wqueue == (FAR struct kwork_wqueue_s *)&g_lpwork) {
+		work_lpready(work);
+	} else
+#endif
 #ifdef CONFIG_SCHED_WORKQUEUE_SORTING
-	if (next_work) {
-		dq_addbefore((FAR dq_entry_t *)next_work, (FAR dq_entry_t *)work, &wqueue->q);
-	} else {
-		dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
-	}
+	work_heap_insert(wqueue, work);
 #else
 	dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
 #endif
@@ -169,18 +183,14 @@ static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wor
  ****************************************************************************/
 
 /****************************************************************************
- * Name: work_queue
+ * Name: work_queue_class
  *
  * Description:
- *   Queue kernel-mode work to be performed at a later time.  All queued work
- *   will be performed on the worker thread of of execution (not the caller's).
- *
- *   The work structure is allocated by caller, but completely managed by
- *   the work queue logic.  The caller should never modify the contents of
- *   the work queue structure; the caller should not call work_queue()
- *   again until either (1) the previous work has been performed and removed
- *   from the queue, or (2) work_cancel() has been called to cancel the work
- *   and remove it from the work queue.
+ *   Queue kernel-mode work of the given class to be performed at a later
+ *   time.  The class, one of WORK_CLASS_HIGH, WORK_CLASS_NORMAL or
+ *   WORK_CLASS_BULK, only matters for the low priority work queue with
+ *   CONFIG_SCHED_LPWORK_STEALING.  Otherwise this is the same as
+ *   work_queue().
  *
  * Input parameters:
  *   qid    - The work queue ID (index)
@@ -191,13 +201,14 @@ static int work_qqueue(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *wor
  *            int is invoked.
  *   delay  - Delay (in clock ticks) from the time queue until the worker
  *            is invoked. Zero means to perform the work immediately.
+ *   wclass - The class of the work
  *
  * Returned Value:
  *   Zero on success, a negated errno on failure
  *
  ****************************************************************************/
 
-int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+int work_queue_class(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay, uint8_t wclass)
 {
 #if defined(CONFIG_SCHED_HPWORK) || defined(CONFIG_SCHED_LPWORK)
 	int result;
@@ -206,7 +217,7 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg,
 	if (qid == HPWORK) {
 		/* Cancel high priority work */
 
-		result = work_qqueue((FAR struct kwork_wqueue_s *)&g_hpwork, work, worker, arg, delay);
+		result = work_qqueue((FAR struct kwork_wqueue_s *)&g_hpwork, work, worker, arg, delay, wclass);
 		if (result != OK) {
 			return result;
 		}
@@ -217,10 +228,17 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg,
 		if (qid == LPWORK) {
 			/* Cancel low priority work */
 
-			result = work_qqueue((FAR struct kwork_wqueue_s *)&g_lpwork, work, worker, arg, delay);
+			result = work_qqueue((FAR struct kwork_wqueue_s *)&g_lpwork, work, worker, arg, delay, wclass);
 			if (result != OK) {
 				return result;
 			}
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+			/* Work which is ready has already been handed to a worker */
+
+			if (delay == 0) {
+				return OK;
+			}
+#endif
 			return work_signal(LPWORK);
 		} else
 #endif
@@ -229,4 +247,38 @@ int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg,
 		}
 }
 
+/****************************************************************************
+ * Name: work_queue
+ *
+ * Description:
+ *   Queue kernel-mode work to be performed at a later time.  All queued work
+ *   will be performed on the worker thread of of execution (not the caller's).
+ *
+ *   The work structure is allocated by caller, but completely managed by
+ *   the work queue logic.  The caller should never modify the contents of
+ *   the work queue structure; the caller should not call work_queue()
+ *   again until either (1) the previous work has been performed and removed
+ *   from the queue, or (2) work_cancel() has been called to cancel the work
+ *   and remove it from the work queue.
+ *
+ * Input parameters:
+ *   qid    - The work queue ID (index)
+ *   work   - The work structure to queue
+ *   worker - The worker callback to be invoked.  The callback will invoked
+ *            on the worker thread of execution.
+ *   arg    - The argument that will be passed to the workder callback when
+ *            int is invoked.
+ *   delay  - Delay (in clock ticks) from the time queue until the worker
+ *            is invoked. Zero means to perform the work immediately.
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
+
+int work_queue(int qid, FAR struct work_s *work, worker_t worker, FAR void *arg, uint32_t delay)
+{
+	return work_queue_class(qid, work, worker, arg, delay, WORK_CLASS_NORMAL);
+}
+
 #endif							/* CONFIG_SCHED_WORKQUEUE */
@@ -98,6 +98,13 @@ int work_signal(int qid)
 #endif
 #ifdef CONFIG_SCHED_LPWORK
 		if (qid == LPWORK) {
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+			/* Ready work is handed to the workers directly, so a signal is
+			 * only needed for worker 0 to look at the delayed work again.
+			 */
+
+			pid = g_lpwork.worker[0].pid;
+#else
 			int wndx;
 			int i;
 
@@ -119,6 +126,7 @@ int work_signal(int qid)
 			 */
 
 			pid = g_lpwork.worker[wndx].pid;
+#endif
 		} else
 #endif
 		{
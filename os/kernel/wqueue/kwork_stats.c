@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/wqueue/kwork_stats.c
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <string.h>
+#include <errno.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <tinyara/wqueue.h>
+
+#include "wqueue/wqueue.h"
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKQUEUE_STATS)
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_stats_update
+ *
+ * Description:
+ *   Account one work which has been performed.
+ *
+ ****************************************************************************/
+
+void work_stats_update(FAR struct kwork_wqueue_s *wqueue, int wndx, uint8_t wclass, systime_t expiry, systime_t start, bool steal)
+{
+	FAR struct work_classstats_s *cls = &wqueue->stats.cls[wclass];
+	uint32_t latency = (uint32_t)(start - expiry);
+	uint32_t runtime = (uint32_t)(clock_systimer() - start);
+	irqstate_t flags;
+
+	flags = irqsave();
+
+	cls->nwork++;
+	cls->latency += latency;
+	if (latency > cls->maxlatency) {
+		cls->maxlatency = latency;
+	}
+
+	cls->runtime += runtime;
+	if (runtime > cls->maxruntime) {
+		cls->maxruntime = runtime;
+	}
+
+	if (wndx < WORK_MAXTHREADS) {
+		wqueue->stats.thread[wndx].nwork++;
+		if (steal) {
+			wqueue->stats.thread[wndx].nsteal++;
+		}
+	}
+
+	irqrestore(flags);
+}
+
+/****************************************************************************
+ * Name: work_getstats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of a kernel work queue.
+ *
+ * Input parameters:
+ *   qid   - The work queue ID
+ *   stats - The location to return the statistics
+ *
+ * Returned Value:
+ *   Zero on success, -EINVAL if the work queue is not known.
+ *
+ ****************************************************************************/
+
+int work_getstats(int qid, FAR struct work_stats_s *stats)
+{
+	FAR struct kwork_wqueue_s *wqueue;
+	irqstate_t flags;
+	int nthreads;
+
+#ifdef CONFIG_SCHED_HPWORK
+	if (qid == HPWORK) {
+		wqueue = (FAR struct kwork_wqueue_s *)&g_hpwork;
+		nthreads = 1;
+	} else
+#endif
+#ifdef CONFIG_SCHED_LPWORK
+		if (qid == LPWORK) {
+			wqueue = (FAR struct kwork_wqueue_s *)&g_lpwork;
+			nthreads = CONFIG_SCHED_LPNTHREADS;
+		} else
+#endif
+		{
+			return -EINVAL;
+		}
+
+	flags = irqsave();
+	memcpy(stats, &wqueue->stats, sizeof(struct work_stats_s));
+	irqrestore(flags);
+
+	stats->nthreads = nthreads < WORK_MAXTHREADS ? nthreads : WORK_MAXTHREADS;
+	return OK;
+}
+
+#endif							/* CONFIG_SCHED_WORKQUEUE && CONFIG_SCHED_WORKQUEUE_STATS */
@@ -0,0 +1,279 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * kernel/wqueue/kwork_steal.c
+ *
+ * Every low priority worker has a deque of ready work for each class of
+ * work.  Delayed work waits in the expiry heap of the queue until it is
+ * due and is then handed to a worker, as is work queued without delay.
+ * A worker runs the oldest work of its own deques and, when they are
+ * empty, takes the newest work from the deques of the other workers.  The
+ * classes are served in order, and a worker only ever takes bulk work if
+ * it is one of the workers reserved for it.
+ *
+ * Worker 0 keeps the time: it sleeps until the earliest delayed work is
+ * due.  The other workers sleep until they are given work.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <unistd.h>
+#include <signal.h>
+#include <assert.h>
+#include <queue.h>
+
+#include <tinyara/arch.h>
+#include <tinyara/clock.h>
+#include <tinyara/wqueue.h>
+
+#include "wqueue/wqueue.h"
+
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The worker which is given ready work when none is idle */
+
+static uint8_t g_lpnext;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_lpexpire
+ *
+ * Description:
+ *   Hand the delayed work which is due to the workers.  Returns the number
+ *   of ticks until the next delayed work is due, or zero if there is none.
+ *   Interrupts must be disabled by the caller.
+ *
+ ****************************************************************************/
+
+static systime_t work_lpexpire(void)
+{
+	FAR struct kwork_wqueue_s *wqueue = (FAR struct kwork_wqueue_s *)&g_lpwork;
+	FAR struct work_s *work;
+	systime_t elapsed;
+
+	while ((work = wqueue->root) != NULL) {
+		elapsed = clock_systimer() - work->qtime;
+		if (elapsed < work->delay) {
+			return work->delay - elapsed;
+		}
+
+		work_heap_remove(wqueue, work);
+		work_lpready(work);
+	}
+
+	return 0;
+}
+
+/****************************************************************************
+ * Name: work_lptake
+ *
+ * Description:
+ *   Take the next work for a worker: by class, first the oldest work of its
+ *   own deque and then the newest work of the deques of the other workers.
+ *   Returns NULL if there is no work which the worker may run.  Interrupts
+ *   must be disabled by the caller.
+ *
+ ****************************************************************************/
+
+static FAR struct work_s *work_lptake(int wndx, FAR bool *steal)
+{
+	FAR struct work_s *work;
+	int wclass;
+	int i;
+
+	for (wclass = 0; wclass < WORK_NCLASSES; wclass++) {
+		if (!WORK_CANRUN(wndx, wclass)) {
+			continue;
+		}
+
+		work = (FAR struct work_s *)dq_remfirst(&g_lpwork.worker[wndx].ready[wclass]);
+		if (work != NULL) {
+			*steal = false;
+			return work;
+		}
+
+		for (i = 1; i < CONFIG_SCHED_LPNTHREADS; i++) {
+			int victim = (wndx + i) % CONFIG_SCHED_LPNTHREADS;
+
+			work = (FAR struct work_s *)dq_remlast(&g_lpwork.worker[victim].ready[wclass]);
+			if (work != NULL) {
+				*steal = true;
+				return work;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_lpready
+ *
+ * Description:
+ *   Hand a work which is ready to run to one of the low priority workers,
+ *   preferring an idle worker which may run its class, and wake that
+ *   worker up.  Interrupts must be disabled by the caller.
+ *
+ ****************************************************************************/
+
+void work_lpready(FAR struct work_s *work)
+{
+	FAR struct kworker_s *kworker;
+	int wndx;
+	int i;
+
+	/* Look for an idle worker which may run the work */
+
+	for (wndx = -1, i = 0; i < CONFIG_SCHED_LPNTHREADS; i++) {
+		if (WORK_CANRUN(i, work->wclass) && !g_lpwork.worker[i].busy) {
+			wndx = i;
+			break;
+		}
+	}
+
+	/* Otherwise take turns among the busy ones */
+
+	if (wndx < 0) {
+		do {
+			wndx = g_lpnext;
+			g_lpnext = (g_lpnext + 1) % CONFIG_SCHED_LPNTHREADS;
+		} while (!WORK_CANRUN(wndx, work->wclass));
+	}
+
+	kworker = &g_lpwork.worker[wndx];
+	dq_addlast((FAR dq_entry_t *)work, &kworker->ready[work->wclass]);
+	work->wndx = wndx;
+
+	/* Wake the worker up.  It is marked busy right away, so that the next
+	 * work goes to another idle worker.
+	 */
+
+	if (!kworker->busy) {
+		kworker->busy = true;
+		(void)kill(kworker->pid, SIGWORK);
+	}
+}
+
+/****************************************************************************
+ * Name: work_lpprocess
+ *
+ * Description:
+ *   The low priority counterpart of work_process() with per-worker queues.
+ *   Expired delayed work is handed out to the workers, and then the worker
+ *   runs work from its own queues, or takes work from those of the other
+ *   workers, until there is none that it may run.
+ *
+ ****************************************************************************/
+
+void work_lpprocess(uint32_t period, int wndx)
+{
+	FAR struct work_s *work;
+	worker_t worker;
+	irqstate_t flags;
+	FAR void *arg;
+	systime_t next;
+	bool steal;
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+	systime_t expiry;
+	systime_t start;
+	uint8_t wclass;
+#endif
+
+	flags = irqsave();
+
+	for (;;) {
+		next = work_lpexpire();
+
+		work = work_lptake(wndx, &steal);
+		if (work == NULL) {
+			break;
+		}
+
+		/* Extract the work description and mark the work as no longer
+		 * being queued before re-enabling interrupts.
+		 */
+
+		worker = work->worker;
+		arg = work->arg;
+		DEBUGASSERT(worker != NULL);
+
+		work->worker = NULL;
+		work->wndx = WORK_NOWORKER;
+
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+		expiry = work->qtime + work->delay;
+		wclass = work->wclass;
+		start = clock_systimer();
+#endif
+
+		irqrestore(flags);
+		worker(arg);
+
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+		work_stats_update((FAR struct kwork_wqueue_s *)&g_lpwork, wndx, wclass, expiry, start, steal);
+#endif
+		flags = irqsave();
+	}
+
+	/* Nothing left to do.  Worker 0 sleeps until the next delayed work is
+	 * due, or for the polling period if there is none; the others wait to
+	 * be given work, or as well until the next delayed work is due, which
+	 * they hand out if worker 0 is busy then.  Either is cut short by
+	 * SIGWORK.
+	 */
+
+	g_lpwork.worker[wndx].busy = false;
+
+	if (period > 0) {
+		usleep((next > 0 && next < period ? next : period) * USEC_PER_TICK);
+	} else {
+		struct timespec timeout;
+		sigset_t set;
+
+		sigemptyset(&set);
+		sigaddset(&set, SIGWORK);
+		if (next > 0) {
+			timeout.tv_sec = next / TICK_PER_SEC;
+			timeout.tv_nsec = (next % TICK_PER_SEC) * NSEC_PER_TICK;
+			(void)sigtimedwait(&set, NULL, &timeout);
+		} else {
+			DEBUGVERIFY(sigwaitinfo(&set, NULL));
+		}
+	}
+
+	g_lpwork.worker[wndx].busy = true;
+	irqrestore(flags);
+}
+
+#endif							/* CONFIG_SCHED_LPWORK_STEALING */
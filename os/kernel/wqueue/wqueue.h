@@ -63,6 +63,8 @@
 #include <stdbool.h>
 #include <queue.h>
 
+#include <tinyara/wqueue.h>
+
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
@@ -74,6 +76,25 @@
 #define HPWORKNAME "hpwork"
 #define LPWORKNAME "lpwork"
 
+/* The class of a work */
+
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+#define WORK_CLASS(w)      ((w)->wclass)
+#else
+#define WORK_CLASS(w)      WORK_CLASS_NORMAL
+#endif
+
+/* A low priority worker may run bulk work if it is one of the last
+ * CONFIG_SCHED_LPWORK_BULKTHREADS workers.
+ */
+
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+#define WORK_NOWORKER      0xff
+#define WORK_CANRUN(wndx, wclass) \
+	((wclass) != WORK_CLASS_BULK || \
+	 (wndx) >= CONFIG_SCHED_LPNTHREADS - CONFIG_SCHED_LPWORK_BULKTHREADS)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -82,13 +103,24 @@
 struct kworker_s {
 	pid_t pid;					/* The task ID of the worker thread */
 	volatile bool busy;			/* True: Worker is not available */
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+	struct dq_queue_s ready[WORK_NCLASSES];	/* Expired work, one deque per class */
+#endif
 };
 
 /* This structure defines the state of one kernel-mode work queue */
 
 struct kwork_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	FAR struct work_s *root;	/* Heap of pending work, earliest expiry first */
+	unsigned int nwork;			/* The number of works in the heap */
+#else
 	struct dq_queue_s q;		/* The queue of pending work */
+#endif
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+	struct work_stats_s stats;	/* Latency statistics */
+#endif
 	struct kworker_s worker[1];	/* Describes a worker thread */
 };
 
@@ -99,7 +131,15 @@ struct kwork_wqueue_s {
 #ifdef CONFIG_SCHED_HPWORK
 struct hp_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	FAR struct work_s *root;	/* Heap of pending work, earliest expiry first */
+	unsigned int nwork;			/* The number of works in the heap */
+#else
 	struct dq_queue_s q;		/* The queue of pending work */
+#endif
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+	struct work_stats_s stats;	/* Latency statistics */
+#endif
 	struct kworker_s worker[1];	/* Describes the single high priority worker */
 };
 #endif
@@ -111,7 +151,15 @@ struct hp_wqueue_s {
 #ifdef CONFIG_SCHED_LPWORK
 struct lp_wqueue_s {
 	uint32_t delay;				/* Delay between polling cycles (ticks) */
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+	FAR struct work_s *root;	/* Heap of pending work, earliest expiry first */
+	unsigned int nwork;			/* The number of works in the heap */
+#else
 	struct dq_queue_s q;		/* The queue of pending work */
+#endif
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+	struct work_stats_s stats;	/* Latency statistics */
+#endif
 
 	/* Describes each thread in the low priority queue's thread pool */
 
@@ -198,5 +246,79 @@ int work_lpstart(void);
 
 void work_process(FAR struct kwork_wqueue_s *wqueue, uint32_t period, int wndx);
 
+#ifdef CONFIG_SCHED_WORKQUEUE_SORTING
+/****************************************************************************
+ * Name: work_heap_insert, work_heap_remove and work_heap_contains
+ *
+ * Description:
+ *   Maintain the heap of pending work of a kernel work queue, ordered by
+ *   expiry time (see kwork_heap.c).  Interrupts must be disabled by the
+ *   caller.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *   work   - The work to add, remove or look for
+ *
+ ****************************************************************************/
+
+void work_heap_insert(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work);
+void work_heap_remove(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work);
+bool work_heap_contains(FAR struct kwork_wqueue_s *wqueue, FAR struct work_s *work);
+#endif
+
+#ifdef CONFIG_SCHED_LPWORK_STEALING
+/****************************************************************************
+ * Name: work_lpready
+ *
+ * Description:
+ *   Hand a work which is ready to run to one of the low priority workers,
+ *   preferring an idle worker which may run its class, and wake that
+ *   worker up.  Interrupts must be disabled by the caller.
+ *
+ * Input parameters:
+ *   work - The work which is ready to run
+ *
+ ****************************************************************************/
+
+void work_lpready(FAR struct work_s *work);
+
+/****************************************************************************
+ * Name: work_lpprocess
+ *
+ * Description:
+ *   The low priority counterpart of work_process() with per-worker queues.
+ *   Expired delayed work is handed out to the workers, and then the worker
+ *   runs work from its own queues, or takes work from those of the other
+ *   workers, until there is none that it may run.
+ *
+ * Input parameters:
+ *   period - The polling period in clock ticks, zero to wait for a signal
+ *   wndx   - The worker thread index
+ *
+ ****************************************************************************/
+
+void work_lpprocess(uint32_t period, int wndx);
+#endif
+
+#ifdef CONFIG_SCHED_WORKQUEUE_STATS
+/****************************************************************************
+ * Name: work_stats_update
+ *
+ * Description:
+ *   Account one work which has been performed.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *   wndx   - The worker thread index
+ *   wclass - The class of the work
+ *   expiry - The time at which the work was due
+ *   start  - The time at which its worker was called
+ *   steal  - True if the work was taken from the queue of another worker
+ *
+ ****************************************************************************/
+
+void work_stats_update(FAR struct kwork_wqueue_s *wqueue, int wndx, uint8_t wclass, systime_t expiry, systime_t start, bool steal);
+#endif
+
 #endif							/* CONFIG_SCHED_WORKQUEUE */
 #endif							/* __SCHED_WQUEUE_WQUEUE_H */
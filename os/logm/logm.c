@@ -31,13 +31,12 @@
 int g_logm_head;
 int g_logm_tail;
 int g_logm_available;
-int g_logm_enqueued_count;
 int g_logm_dropmsg_count;
-int g_logm_overflow_offset;
 
+#ifndef CONFIG_LOGM_DEFERRED_FORMAT
 static void logm_putc(FAR struct lib_outstream_s *this, int ch)
 {
-	if (this->nput < g_logm_available - 1) {
+	if (this->nput < g_logm_available) {
 		g_logm_rsvbuf[(g_logm_tail + this->nput++) % logm_bufsize] = ch;
 	}
 }
@@ -50,17 +49,33 @@ static void logm_initstream(FAR struct lib_outstream_s *outstream)
 #endif
 	outstream->nput = 0;
 }
+#endif
 
 /* logm_internal hook for syslog & printfs */
 int logm_internal(int priority, const char *fmt, va_list ap)
 {
-	irqstate_t flags;
 	int ret = 0;
 	struct lib_outstream_s strm;
+#ifndef CONFIG_LOGM_DEFERRED_FORMAT
+	irqstate_t flags;
 #ifdef CONFIG_LOGM_TIMESTAMP
 	struct timespec ts;
 #endif
+#endif
 
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+	/* Keep the message as a record, to be formatted by the logm task.  This
+	 * takes no lock, so it may be done from interrupt handlers as well.
+	 */
+
+	if (LOGM_STATUS(LOGM_READY)) {
+		ret = logm_record_write(priority, fmt, ap);
+		if (ret >= 0) {
+			return ret;
+		}
+		ret = 0;
+	}
+#else
 	if (LOGM_STATUS(LOGM_READY) && !LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ) && !up_interrupt_context()) {
 		flags = irqsave();
 
@@ -73,7 +88,6 @@ int logm_internal(int priority, const char *fmt, va_list ap)
 		if (g_logm_available <= 0) {
 			LOGM_STATUS_SET(LOGM_BUFFER_OVERFLOW);
 			g_logm_dropmsg_count = 1;
-			g_logm_overflow_offset = g_logm_tail;
 			irqrestore(flags);
 			return 0;
 		}
@@ -88,21 +102,22 @@ int logm_internal(int priority, const char *fmt, va_list ap)
 		}
 #endif
 		ret = lib_vsprintf(&strm, fmt, ap);
-		g_logm_rsvbuf[(g_logm_tail + ret) % logm_bufsize] = '\0';
 
 		/* set g_logm_tail for next entered message */
-		g_logm_tail = (g_logm_tail + ret + 1) % logm_bufsize;
-		g_logm_available -= (ret + 1);
-		g_logm_enqueued_count++;
+		g_logm_tail = (g_logm_tail + ret) % logm_bufsize;
+		g_logm_available -= ret;
 
 		irqrestore(flags);
-	} else {
-		/* Low Output: Sytem is not yet completely ready or this is called from interrupt handler */
+		logm_wakeup();
+		return ret;
+	}
+#endif
+
+	/* Low Output: Sytem is not yet completely ready or this is called from interrupt handler */
 #ifdef CONFIG_ARCH_LOWPUTC
-		lib_lowoutstream(&strm);
-		ret = lib_vsprintf(&strm, fmt, ap);
+	lib_lowoutstream(&strm);
+	ret = lib_vsprintf(&strm, fmt, ap);
 #endif
-	}
 
 	return ret;
 }
@@ -113,7 +128,9 @@ int logm(int flag, int indx, int priority, const char *fmt, ...)
 	va_list ap;
 	int ret;
 
-	/* LOGIC for initial test here */
+	if (LOGM_FILTERED(indx, priority)) {
+		return logm_suppress(indx);
+	}
 
 	va_start(ap, fmt);
 	ret = logm_internal(priority, fmt, ap);
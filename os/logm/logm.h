@@ -20,6 +20,7 @@
 
 #include <tinyara/config.h>
 #include <stdint.h>
+#include <stdarg.h>
 
 /****************************************************************************
  * Preprocessor Definitions
@@ -51,12 +52,42 @@
 #define LOGM_STATUS_SET(a) (logm_status |= (a))
 #define LOGM_STATUS_CLEAR(a) (logm_status &= ~(a))
 
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+#ifdef CONFIG_LOGM_RECORD_SIZE
+#define LOGM_RECORD_SIZE CONFIG_LOGM_RECORD_SIZE
+#else
+#define LOGM_RECORD_SIZE (128)
+#endif
+
+/* Flags of a logm record */
+
+#define LOGM_REC_VALID BIT(0)	/* The record is completely written */
+#define LOGM_REC_PAD   BIT(1)	/* The record only skips the end of the buffer */
+
+#define LOGM_REC_ALIGN(n) (((n) + 3) & ~3)
+#endif
+
 /****************************************************************************
  * Private Declarations
  ****************************************************************************/
 
 /* Structure for a single debug message */
 
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+/* With CONFIG_LOGM_DEFERRED_FORMAT, a message is kept in the logm buffer as
+ * this header, followed by the arguments of the format: the values as they
+ * were passed, and the strings copied with their terminating NUL.
+ */
+
+struct logm_rec_s {
+	uint16_t size;				/* Bytes in the record, header included */
+	uint8_t flags;				/* See LOGM_REC_* */
+	uint8_t priority;			/* Priority of the message */
+	uint32_t ticks;				/* System time when the message was logged */
+	FAR const char *fmt;		/* Format of the message */
+};
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 #define EXTERN extern "C"
@@ -68,19 +99,27 @@ extern "C" {
 EXTERN int g_logm_head;
 EXTERN int g_logm_tail;
 EXTERN int g_logm_available;
-EXTERN int g_logm_enqueued_count;
-EXTERN int g_logm_overflow_offset;
 EXTERN int g_logm_dropmsg_count;
 EXTERN char * g_logm_rsvbuf;
 EXTERN int logm_bufsize;
 EXTERN uint8_t logm_status;
 EXTERN volatile int new_logm_bufsize;
 EXTERN volatile int logm_print_interval;
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+EXTERN volatile int g_logm_writers;
+#endif
 
 /************************************************************************************
  * Private Function Prototypes
  ************************************************************************************/
 int logm_task(int argc, char *argv[]);
+void logm_wakeup(void);
+void logm_sink_write(const char *buf, int len);
+int logm_sink_getstats(int index, const char **name, uint32_t *written, uint32_t *dropped);
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+int logm_record_write(int priority, const char *fmt, va_list ap);
+void logm_record_flush(void);
+#endif
 void logm_register_tashcmds(void);
 static int logm_tash(int argc, char **args);
 
@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+#include <stdint.h>
+#include <errno.h>
+#include <tinyara/logm.h>
+#include "logm.h"
+
+/* All messages are shown until a filter is set */
+
+uint8_t g_logm_filter[LOGM_NMODULES];
+
+static uint32_t g_logm_suppressed[LOGM_NMODULES];
+
+/* Count a message which the filter suppressed */
+int logm_suppress(int indx)
+{
+	__sync_fetch_and_add(&g_logm_suppressed[indx], 1);
+	return 0;
+}
+
+/* Show the messages of module 'indx', or of all modules if it is negative,
+ * up to priority 'level'.  LOGM_OFF suppresses all of them.
+ */
+int logm_set_filter(int indx, int level)
+{
+	uint8_t mask;
+	int i;
+
+	if (indx >= LOGM_NMODULES || level < LOGM_EMR || level > LOGM_OFF) {
+		return -EINVAL;
+	}
+
+	mask = level >= LOGM_OFF ? 0xff : (uint8_t)(0xff << (level + 1));
+
+	for (i = 0; i < LOGM_NMODULES; i++) {
+		if (indx < 0 || i == indx) {
+			g_logm_filter[i] = mask;
+		}
+	}
+
+	return OK;
+}
+
+/* Return the level of module 'indx' and the number of its messages which
+ * were suppressed.
+ */
+int logm_get_filter(int indx, int *level, uint32_t *suppressed)
+{
+	uint8_t mask;
+
+	if (indx < 0 || indx >= LOGM_NMODULES) {
+		return -EINVAL;
+	}
+
+	mask = g_logm_filter[indx];
+	for (*level = LOGM_DBG; *level >= LOGM_EMR && (mask & (1 << *level)) != 0; (*level)--) ;
+	if (*level < LOGM_EMR) {
+		*level = LOGM_OFF;
+	}
+
+	*suppressed = g_logm_suppressed[indx];
+	return OK;
+}
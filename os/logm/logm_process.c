@@ -19,8 +19,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <unistd.h>
+#include <semaphore.h>
 #include <sys/types.h>
 #include <arch/irq.h>
+#include <tinyara/clock.h>
 #include <tinyara/logm.h>
 #include <tinyara/config.h>
 #include "logm.h"
@@ -33,6 +36,43 @@ int logm_bufsize = LOGM_BUFFER_SIZE;
 char * g_logm_rsvbuf = NULL;
 volatile int logm_print_interval = LOGM_PRINT_INTERVAL * 1000;
 
+static sem_t g_logm_sem;
+static volatile int g_logm_wakeup;
+
+#ifndef CONFIG_LOGM_DEFERRED_FORMAT
+/* Hand the text in the logm buffer to the sinks, in at most two pieces */
+static void logm_drain(void)
+{
+	irqstate_t flags;
+	int dropped;
+	int len;
+	char msg[64];
+
+	while ((len = logm_bufsize - g_logm_available) > 0) {
+		if (g_logm_head + len > logm_bufsize) {
+			len = logm_bufsize - g_logm_head;
+		}
+
+		logm_sink_write(&g_logm_rsvbuf[g_logm_head], len);
+
+		flags = irqsave();
+		g_logm_head = (g_logm_head + len) % logm_bufsize;
+		g_logm_available += len;
+		irqrestore(flags);
+	}
+
+	if (LOGM_STATUS(LOGM_BUFFER_OVERFLOW)) {
+		flags = irqsave();
+		dropped = g_logm_dropmsg_count;
+		LOGM_STATUS_CLEAR(LOGM_BUFFER_OVERFLOW);
+		irqrestore(flags);
+
+		len = snprintf(msg, sizeof(msg), "\n[LOGM BUFFER OVERFLOW] %d messages are dropped\n", dropped);
+		logm_sink_write(msg, len);
+	}
+}
+#endif
+
 static int logm_change_bufsize(int buflen)
 {
 	/* Keep using old size if a parameter is invalid */
@@ -53,22 +93,28 @@ static int logm_change_bufsize(int buflen)
 	g_logm_tail = 0;
 	logm_bufsize = buflen;
 	g_logm_available = buflen;
-	g_logm_enqueued_count = 0;
 	g_logm_dropmsg_count = 0;
-	g_logm_overflow_offset = -1;
 
 	LOGM_STATUS_CLEAR(LOGM_BUFFER_RESIZE_REQ);
 
 	return OK;
 }
 
+/* Wake the logm task up, unless it has already been */
+void logm_wakeup(void)
+{
+	if (__sync_lock_test_and_set(&g_logm_wakeup, 1) == 0) {
+		sem_post(&g_logm_sem);
+	}
+}
+
 int logm_task(int argc, char *argv[])
 {
-	int ret = 0;
 	irqstate_t flags;
 
 	g_logm_rsvbuf = (char *)malloc(logm_bufsize);
 	memset(g_logm_rsvbuf, 0, logm_bufsize);
+	sem_init(&g_logm_sem, 0, 0);
 
 	/* Now logm is ready */
 	LOGM_STATUS_SET(LOGM_READY);
@@ -79,34 +125,41 @@ int logm_task(int argc, char *argv[])
 #endif
 
 	while (1) {
-		while (g_logm_enqueued_count > 0) {
-			ret = 0;
-			while (*(g_logm_rsvbuf + (g_logm_head + ret) % logm_bufsize)) {
-				fputc(g_logm_rsvbuf[(g_logm_head + ret++) % logm_bufsize], stdout);
-			}
-			g_logm_head = (g_logm_head + ret + 1) % logm_bufsize;
-			g_logm_available += (ret + 1);
-
-			g_logm_enqueued_count--;
+		/* Sleep until something is logged, then let more messages come in
+		 * for the print interval so that they are written together.
+		 */
 
-			if (LOGM_STATUS(LOGM_BUFFER_OVERFLOW)) {
-				LOGM_STATUS_CLEAR(LOGM_BUFFER_OVERFLOW);
-			}
+		while (sem_wait(&g_logm_sem) != OK) ;
 
-			if (g_logm_overflow_offset >= 0 && g_logm_overflow_offset == g_logm_head) {
-				fprintf(stdout, "\n[LOGM BUFFER OVERFLOW] %d messages are dropped\n", g_logm_dropmsg_count);
-				g_logm_overflow_offset = -1;
-			}
+		if (logm_print_interval > 0) {
+			usleep(logm_print_interval);
 		}
 
+		__sync_lock_release(&g_logm_wakeup);
+
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+		logm_record_flush();
+#else
+		logm_drain();
+#endif
+
 		if (LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ)) {
 			flags = irqsave();
+#ifdef CONFIG_LOGM_DEFERRED_FORMAT
+			/* A writer is still copying into the buffer, try again soon */
+
+			if (g_logm_writers > 0) {
+				irqrestore(flags);
+				usleep(USEC_PER_TICK);
+				logm_wakeup();
+				continue;
+			}
+#endif
 			if (logm_change_bufsize(new_logm_bufsize) != OK) {
 				fprintf(stdout, "\n[LOGM] Failed to change buffer size\n");
 			}
 			irqrestore(flags);
 		}
-		usleep(logm_print_interval);
 	}
 	return 0;					// Just to make compiler happy
 }
@@ -0,0 +1,494 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/* Deferred formatting of logm messages
+ *
+ * A caller does not format its message.  It copies the format pointer, the
+ * arguments and a timestamp into a record, reserves room for the record in
+ * the logm buffer with a compare-and-swap on g_logm_tail and copies it
+ * there.  Interrupts stay enabled, and a caller which is interrupted by
+ * another one (even from an interrupt handler) simply gets the next room.
+ * The record is published by setting LOGM_REC_VALID last.
+ *
+ * The logm task prints the records in order, stopping at the first one
+ * which is not complete yet, and clears each one it has printed so that the
+ * free part of the buffer always reads as zero.  A record never wraps: if it
+ * does not fit at the end of the buffer, the end is skipped with a padding
+ * record, or silently if it is too small even for a header.
+ *
+ * The arguments are found by parsing the format the same way lib_vsprintf()
+ * does, so each one is stored as the type that lib_vsprintf() will read it
+ * as.  The format itself is not copied: it must stay valid until the
+ * message is printed, as string literals do.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <arch/irq.h>
+#include <tinyara/clock.h>
+#include <tinyara/streams.h>
+#include "logm.h"
+
+/* The kind of argument a conversion consumes */
+
+enum logm_argtype_e {
+	LOGM_ARG_NONE,
+	LOGM_ARG_INT,
+	LOGM_ARG_LONG,
+	LOGM_ARG_LLONG,
+	LOGM_ARG_PTR,
+	LOGM_ARG_DOUBLE,
+	LOGM_ARG_STRING
+};
+
+#define LOGM_SPEC_MAX 24
+#define LOGM_OUTBUF_SIZE 128
+
+/* A stream which hands the text to the sinks in pieces of LOGM_OUTBUF_SIZE */
+
+struct logm_outstream_s {
+	struct lib_outstream_s public;
+	int len;
+	char buf[LOGM_OUTBUF_SIZE];
+};
+
+volatile int g_logm_writers;
+
+/* Find the next conversion of a format, as lib_vsprintf() parses it.
+ * Returns the character after the conversion, or NULL if there is none.
+ * *spec is set to its '%', *nstar to the number of '*' int arguments
+ * before the value and *type to the type of the value.
+ */
+static const char *logm_nextspec(const char *fmt, const char **spec, int *nstar, int *type)
+{
+	while (*fmt != '\0' && *fmt != '%') {
+		fmt++;
+	}
+
+	if (*fmt == '\0') {
+		return NULL;
+	}
+
+	*spec = fmt++;
+	*nstar = 0;
+	*type = LOGM_ARG_NONE;
+
+	for (; *fmt != '\0' && !strchr("diuxXpobeEfgGlLsc%", *fmt); fmt++) {
+#ifndef CONFIG_NOPRINTF_FIELDWIDTH
+		if (*fmt == '*') {
+			(*nstar)++;
+		}
+#endif
+	}
+
+	switch (*fmt) {
+	case '\0':
+		return fmt;
+	case '%':
+		return fmt + 1;
+	case 's':
+		*type = LOGM_ARG_STRING;
+		return fmt + 1;
+	case 'c':
+		*type = LOGM_ARG_INT;
+		return fmt + 1;
+	case 'L':
+#ifdef CONFIG_HAVE_LONG_LONG
+		*type = LOGM_ARG_LLONG;
+#endif
+		fmt++;
+		break;
+	case 'l':
+		*type = LOGM_ARG_LONG;
+		fmt++;
+		if (*fmt == 'l') {
+#ifdef CONFIG_HAVE_LONG_LONG
+			*type = LOGM_ARG_LLONG;
+#endif
+			fmt++;
+		}
+		break;
+	default:
+		break;
+	}
+
+	if (*fmt != '\0' && strchr("diuxXpob", *fmt)) {
+		if (*fmt == 'p') {
+			*type = LOGM_ARG_PTR;
+		} else if (*type == LOGM_ARG_NONE) {
+			*type = LOGM_ARG_INT;
+		}
+	}
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+	else if (*fmt != '\0' && strchr("eEfgG", *fmt)) {
+		*type = LOGM_ARG_DOUBLE;
+	}
+#endif
+	else {
+		/* lib_vsprintf() takes no value for anything else */
+
+		*type = LOGM_ARG_NONE;
+	}
+
+	return *fmt != '\0' ? fmt + 1 : fmt;
+}
+
+/* Copy the arguments of a format into a record, as many as fit.  Returns the
+ * number of bytes used.
+ */
+static int logm_pack(uint8_t *buf, int size, const char *fmt, va_list ap)
+{
+	const char *spec;
+	const char *str;
+	int nstar;
+	int type;
+	int len = 0;
+	int n;
+
+#define LOGM_PACK(t) \
+	do { \
+		t v = va_arg(ap, t); \
+		if (len + (int)sizeof(t) > size) { \
+			return len; \
+		} \
+		memcpy(&buf[len], &v, sizeof(t)); \
+		len += sizeof(t); \
+	} while (0)
+
+	while ((fmt = logm_nextspec(fmt, &spec, &nstar, &type)) != NULL) {
+		while (nstar-- > 0) {
+			LOGM_PACK(int);
+		}
+
+		switch (type) {
+		case LOGM_ARG_INT:
+			LOGM_PACK(int);
+			break;
+		case LOGM_ARG_LONG:
+			LOGM_PACK(long);
+			break;
+#ifdef CONFIG_HAVE_LONG_LONG
+		case LOGM_ARG_LLONG:
+			LOGM_PACK(long long);
+			break;
+#endif
+		case LOGM_ARG_PTR:
+			LOGM_PACK(void *);
+			break;
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+		case LOGM_ARG_DOUBLE:
+			LOGM_PACK(double);
+			break;
+#endif
+		case LOGM_ARG_STRING:
+			str = va_arg(ap, const char *);
+			if (str == NULL) {
+				str = "(null)";
+			}
+
+			/* Keep as much of the string as fits */
+
+			if (len >= size) {
+				return len;
+			}
+			n = strlen(str);
+			if (n > size - len - 1) {
+				n = size - len - 1;
+			}
+			memcpy(&buf[len], str, n);
+			buf[len + n] = '\0';
+			len += n + 1;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return len;
+#undef LOGM_PACK
+}
+
+/* Reserve room for a record of 'size' bytes in the logm buffer.  Returns its
+ * offset, or ERROR if the buffer is full.
+ */
+static int logm_reserve(int size)
+{
+	FAR struct logm_rec_s *pad;
+	int head;
+	int tail;
+	int pos;
+
+	do {
+		/* Read the tail first: the head read after it can only have moved
+		 * towards it, so the free room is never overestimated.
+		 */
+
+		tail = g_logm_tail;
+		__sync_synchronize();
+		head = g_logm_head;
+		pos = tail;
+
+		if (tail >= head) {
+			/* Free room at the end of the buffer and before the head.  The
+			 * tail may only come back to the head if the buffer is empty.
+			 */
+			if (tail + size > logm_bufsize || (tail + size == logm_bufsize && head == 0)) {
+				pos = 0;
+				if (size >= head) {
+					return ERROR;
+				}
+			}
+		} else if (tail + size >= head) {
+			return ERROR;
+		}
+	} while (!__sync_bool_compare_and_swap(&g_logm_tail, tail, (pos + size) % logm_bufsize));
+
+	/* Skip the end of the buffer if the record wrapped */
+
+	if (pos != tail && logm_bufsize - tail >= (int)sizeof(struct logm_rec_s)) {
+		pad = (FAR struct logm_rec_s *)&g_logm_rsvbuf[tail];
+		pad->size = logm_bufsize - tail;
+		__sync_synchronize();
+		pad->flags = LOGM_REC_VALID | LOGM_REC_PAD;
+	}
+
+	return pos;
+}
+
+static void logm_outputc(FAR struct lib_outstream_s *this, int ch)
+{
+	FAR struct logm_outstream_s *strm = (FAR struct logm_outstream_s *)this;
+
+	strm->buf[strm->len++] = ch;
+	if (strm->len == LOGM_OUTBUF_SIZE) {
+		logm_sink_write(strm->buf, strm->len);
+		strm->len = 0;
+	}
+	this->nput++;
+}
+
+/* Print one record through a stream */
+static void logm_print(FAR struct lib_outstream_s *strm, FAR struct logm_rec_s *rec)
+{
+	FAR const uint8_t *arg = (FAR const uint8_t *)(rec + 1);
+	FAR const uint8_t *end = (FAR const uint8_t *)rec + rec->size;
+	const char *fmt = rec->fmt;
+	const char *next;
+	const char *spec;
+	char buf[LOGM_SPEC_MAX];
+	int nstar;
+	int type;
+	int len;
+	int n;
+
+#ifdef CONFIG_LOGM_TIMESTAMP
+	(void)lib_sprintf(strm, "[%4d.%4d] ", (int)(rec->ticks / TICK_PER_SEC), (int)((rec->ticks % TICK_PER_SEC) * USEC_PER_TICK / 100));
+#endif
+
+#define LOGM_UNPACK(t, v) \
+	do { \
+		if (arg + sizeof(t) > end) { \
+			goto truncated; \
+		} \
+		memcpy(&(v), arg, sizeof(t)); \
+		arg += sizeof(t); \
+	} while (0)
+
+	while ((next = logm_nextspec(fmt, &spec, &nstar, &type)) != NULL) {
+		/* The text before the conversion */
+
+		while (fmt < spec) {
+			strm->put(strm, *fmt++);
+		}
+
+		/* The conversion, with its '*' replaced by the stored values */
+
+		for (len = 0; fmt < next; fmt++) {
+			if (*fmt == '*') {
+				LOGM_UNPACK(int, n);
+				if (len < LOGM_SPEC_MAX - 12 && (n >= 0 || fmt[-1] != '.')) {
+					len += sprintf(&buf[len], "%d", n);
+				}
+			} else if (len < LOGM_SPEC_MAX - 1) {
+				buf[len++] = *fmt;
+			}
+		}
+		buf[len] = '\0';
+		fmt = next;
+
+		switch (type) {
+		case LOGM_ARG_INT: {
+			int v;
+			LOGM_UNPACK(int, v);
+			(void)lib_sprintf(strm, buf, v);
+			break;
+		}
+		case LOGM_ARG_LONG: {
+			long v;
+			LOGM_UNPACK(long, v);
+			(void)lib_sprintf(strm, buf, v);
+			break;
+		}
+#ifdef CONFIG_HAVE_LONG_LONG
+		case LOGM_ARG_LLONG: {
+			long long v;
+			LOGM_UNPACK(long long, v);
+			(void)lib_sprintf(strm, buf, v);
+			break;
+		}
+#endif
+		case LOGM_ARG_PTR: {
+			void *v;
+			LOGM_UNPACK(void *, v);
+			(void)lib_sprintf(strm, buf, v);
+			break;
+		}
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+		case LOGM_ARG_DOUBLE: {
+			double v;
+			LOGM_UNPACK(double, v);
+			(void)lib_sprintf(strm, buf, v);
+			break;
+		}
+#endif
+		case LOGM_ARG_STRING:
+			if (arg >= end) {
+				goto truncated;
+			}
+			(void)lib_sprintf(strm, buf, arg);
+			arg += strlen((FAR const char *)arg) + 1;
+			break;
+		default:
+			(void)lib_sprintf(strm, buf);
+			break;
+		}
+	}
+
+	/* The text after the last conversion */
+
+	while (*fmt != '\0') {
+		strm->put(strm, *fmt++);
+	}
+	return;
+
+truncated:
+	(void)lib_sprintf(strm, "...\n");
+#undef LOGM_UNPACK
+}
+
+/* Keep a message in the logm buffer, to be formatted by the logm task.
+ * Returns the number of bytes used in the buffer, zero if the message was
+ * dropped, or -EBUSY if the buffer is being resized.
+ */
+int logm_record_write(int priority, const char *fmt, va_list ap)
+{
+	uint32_t rec[LOGM_RECORD_SIZE / sizeof(uint32_t)];
+	FAR struct logm_rec_s *hdr = (FAR struct logm_rec_s *)rec;
+	FAR struct logm_rec_s *dst;
+	int size;
+	int pos;
+
+	/* The logm task does not resize the buffer while there are writers */
+
+	__sync_fetch_and_add(&g_logm_writers, 1);
+	if (LOGM_STATUS(LOGM_BUFFER_RESIZE_REQ)) {
+		__sync_fetch_and_sub(&g_logm_writers, 1);
+		return -EBUSY;
+	}
+
+	hdr->flags = 0;
+	hdr->priority = priority;
+	hdr->ticks = (uint32_t)clock_systimer();
+	hdr->fmt = fmt;
+
+	size = logm_pack((FAR uint8_t *)(hdr + 1), sizeof(rec) - sizeof(struct logm_rec_s), fmt, ap);
+	size = LOGM_REC_ALIGN(sizeof(struct logm_rec_s) + size);
+	hdr->size = size;
+
+	pos = logm_reserve(size);
+	if (pos < 0) {
+		__sync_fetch_and_add(&g_logm_dropmsg_count, 1);
+		__sync_fetch_and_sub(&g_logm_writers, 1);
+		return 0;
+	}
+
+	dst = (FAR struct logm_rec_s *)&g_logm_rsvbuf[pos];
+	memcpy(dst, hdr, size);
+	__sync_synchronize();
+	dst->flags |= LOGM_REC_VALID;
+
+	__sync_fetch_and_sub(&g_logm_writers, 1);
+	logm_wakeup();
+	return size;
+}
+
+/* Print the complete records of the logm buffer, and clear them */
+void logm_record_flush(void)
+{
+	struct logm_outstream_s strm;
+	FAR struct logm_rec_s *rec;
+	int head;
+	int size;
+	int dropped;
+
+	strm.public.put = logm_outputc;
+#ifdef CONFIG_STDIO_LINEBUFFER
+	strm.public.flush = lib_noflush;
+#endif
+	strm.public.nput = 0;
+	strm.len = 0;
+
+	while ((head = g_logm_head) != g_logm_tail) {
+		if (logm_bufsize - head < (int)sizeof(struct logm_rec_s)) {
+			/* Too small for a record, the writer went on at the start */
+
+			g_logm_head = 0;
+			continue;
+		}
+
+		rec = (FAR struct logm_rec_s *)&g_logm_rsvbuf[head];
+		if ((rec->flags & LOGM_REC_VALID) == 0) {
+			/* Still being written */
+
+			break;
+		}
+		__sync_synchronize();
+
+		size = rec->size;
+		if ((rec->flags & LOGM_REC_PAD) == 0) {
+			logm_print(&strm.public, rec);
+		}
+
+		memset(rec, 0, size);
+		__sync_synchronize();
+		g_logm_head = (head + size) % logm_bufsize;
+	}
+
+	dropped = __sync_fetch_and_and(&g_logm_dropmsg_count, 0);
+	if (dropped > 0) {
+		(void)lib_sprintf(&strm.public, "\n[LOGM BUFFER OVERFLOW] %d messages are dropped\n", dropped);
+	}
+
+	if (strm.len > 0) {
+		logm_sink_write(strm.buf, strm.len);
+	}
+}
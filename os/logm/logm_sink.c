@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/* Outputs of the logm task
+ *
+ * The logm task hands the text it drains from the logm buffer to every
+ * sink in turn.  Each sink decides what to do when it cannot take the
+ * text: the console blocks, which slows the draining down and makes the
+ * writers drop messages when the buffer fills; the file and the syslog
+ * server drop the text they cannot take, and try again with the next one,
+ * so that they never hold the console back.  Each sink counts the bytes it
+ * wrote and those it dropped.
+ */
+
+#include <tinyara/config.h>
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#ifdef CONFIG_LOGM_SINK_SYSLOG
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
+#include "logm.h"
+
+/* The syslog priority of the messages sent to the server: user, info */
+
+#define LOGM_SYSLOG_PRI 14
+
+struct logm_sink_s {
+	const char *name;
+	int (*write)(struct logm_sink_s *sink, const char *buf, int len);
+	int fd;
+	uint32_t written;
+	uint32_t dropped;
+};
+
+#ifdef CONFIG_LOGM_SINK_CONSOLE
+static int logm_console_write(struct logm_sink_s *sink, const char *buf, int len)
+{
+	int done = 0;
+	int ret;
+
+	while (done < len) {
+		ret = write(fileno(stdout), &buf[done], len - done);
+		if (ret <= 0) {
+			break;
+		}
+		done += ret;
+	}
+
+	return done;
+}
+#endif
+
+#ifdef CONFIG_LOGM_SINK_FILE
+static int logm_file_write(struct logm_sink_s *sink, const char *buf, int len)
+{
+	int ret;
+
+	/* The file system may not be mounted yet when logm starts */
+
+	if (sink->fd < 0) {
+		sink->fd = open(CONFIG_LOGM_SINK_FILE_PATH, O_WRONLY | O_CREAT | O_APPEND, 0666);
+		if (sink->fd < 0) {
+			return ERROR;
+		}
+	}
+
+	ret = write(sink->fd, buf, len);
+	if (ret < 0) {
+		close(sink->fd);
+		sink->fd = -1;
+	}
+
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_LOGM_SINK_SYSLOG
+/* Send each line to the syslog server as one datagram */
+static int logm_syslog_write(struct logm_sink_s *sink, const char *buf, int len)
+{
+	static char line[CONFIG_LOGM_SINK_SYSLOG_LINELEN];
+	static int linelen;
+	struct sockaddr_in addr;
+	int carried;
+	int lost = 0;
+	int start;
+	int i;
+
+	if (sink->fd < 0) {
+		sink->fd = socket(AF_INET, SOCK_DGRAM, 0);
+		if (sink->fd < 0) {
+			return ERROR;
+		}
+	}
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(CONFIG_LOGM_SINK_SYSLOG_PORT);
+	addr.sin_addr.s_addr = inet_addr(CONFIG_LOGM_SINK_SYSLOG_SERVER);
+
+	start = snprintf(line, sizeof(line), "<%d>", LOGM_SYSLOG_PRI);
+
+	/* The start of an unfinished line was taken, and counted, by an earlier
+	 * call.
+	 */
+
+	carried = linelen > 0 ? linelen - start : 0;
+
+	for (i = 0; i < len; i++) {
+		if (linelen == 0) {
+			linelen = start;
+		}
+
+		if (buf[i] != '\n') {
+			line[linelen++] = buf[i];
+			if (linelen < sizeof(line)) {
+				continue;
+			}
+		}
+
+		/* Never wait for the network: a line which cannot be sent now is
+		 * dropped.
+		 */
+
+		if (sendto(sink->fd, line, linelen, MSG_DONTWAIT, (struct sockaddr *)&addr, sizeof(addr)) != linelen) {
+			lost += linelen - start - carried + (buf[i] == '\n');
+			sink->written -= carried;
+			sink->dropped += carried;
+		}
+		carried = 0;
+		linelen = 0;
+	}
+
+	return len - lost;
+}
+#endif
+
+static struct logm_sink_s g_logm_sinks[] = {
+#ifdef CONFIG_LOGM_SINK_CONSOLE
+	{"console", logm_console_write, -1, 0, 0},
+#endif
+#ifdef CONFIG_LOGM_SINK_FILE
+	{"file", logm_file_write, -1, 0, 0},
+#endif
+#ifdef CONFIG_LOGM_SINK_SYSLOG
+	{"syslog", logm_syslog_write, -1, 0, 0},
+#endif
+	{NULL, NULL, -1, 0, 0}
+};
+
+/* Hand some text to all sinks */
+void logm_sink_write(const char *buf, int len)
+{
+	struct logm_sink_s *sink;
+	int ret;
+
+	for (sink = g_logm_sinks; sink->name != NULL; sink++) {
+		ret = sink->write(sink, buf, len);
+		if (ret < 0) {
+			ret = 0;
+		}
+
+		sink->written += ret;
+		sink->dropped += len - ret;
+	}
+}
+
+/* Return the counters of the sink 'index', or ERROR past the last one */
+int logm_sink_getstats(int index, const char **name, uint32_t *written, uint32_t *dropped)
+{
+	if (index < 0 || index >= sizeof(g_logm_sinks) / sizeof(g_logm_sinks[0]) - 1) {
+		return ERROR;
+	}
+
+	*name = g_logm_sinks[index].name;
+	*written = g_logm_sinks[index].written;
+	*dropped = g_logm_sinks[index].dropped;
+	return OK;
+}
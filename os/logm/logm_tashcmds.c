@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 #include <apps/shell/tash.h>
 #include <tinyara/logm.h>
 #include "logm.h"
@@ -35,13 +36,22 @@ void logm_register_tashcmds(void)
 static void logm_usage(void)
 {
 	fprintf(stdout, "[LOGM USAGE]\n");
+#ifdef CONFIG_LOGM_FILTER
+	fprintf(stdout, "usage: logm [-b <BUFSIZE>] [-i <TIME>] [-f [<MODULE>:]<LEVEL>]\n");
+#else
 	fprintf(stdout, "usage: logm [-b <BUFSIZE>] [-i <TIME>]\n");
+#endif
 
 	fprintf(stdout, "options:\n");
 	fprintf(stdout, "    -b BUFSIZE\n");
 	fprintf(stdout, "        Set logm buffer size (bytes)\n");
 	fprintf(stdout, "    -i TIME\n");
 	fprintf(stdout, "        Set buffer flusing interval (ms)\n");
+#ifdef CONFIG_LOGM_FILTER
+	fprintf(stdout, "    -f [MODULE:]LEVEL\n");
+	fprintf(stdout, "        Show messages of MODULE (default: all) up to LEVEL\n");
+	fprintf(stdout, "        (0: emergency ... 7: debug, 8: none)\n");
+#endif
 
 }
 
@@ -49,6 +59,10 @@ static void logm_info(void)
 {
 	int bufsize;
 	int interval;
+	const char *name;
+	uint32_t written;
+	uint32_t dropped;
+	int i;
 
 	logm_get_values(LOGM_BUFSIZE, &bufsize);
 	logm_get_values(LOGM_INTERVAL, &interval);
@@ -56,8 +70,42 @@ static void logm_info(void)
 	fprintf(stdout, "[LOGM CONFIGURATIONS]\n");
 	fprintf(stdout, "  Buffer size : %d (bytes)\n", bufsize);
 	fprintf(stdout, "  Flusing interval : %d (ms)\n", interval);
+
+	for (i = 0; logm_sink_getstats(i, &name, &written, &dropped) == OK; i++) {
+		fprintf(stdout, "  Output %s : %u written, %u dropped (bytes)\n", name, (unsigned int)written, (unsigned int)dropped);
+	}
+
+#ifdef CONFIG_LOGM_FILTER
+	/* Only the modules which are filtered, or have been */
+
+	for (i = 0; i < LOGM_NMODULES; i++) {
+		int level;
+
+		if (logm_get_filter(i, &level, &dropped) == OK && (level != LOGM_DBG || dropped > 0)) {
+			fprintf(stdout, "  Module %d : level %d, %u suppressed\n", i, level, (unsigned int)dropped);
+		}
+	}
+#endif
 }
 
+#ifdef CONFIG_LOGM_FILTER
+/* Parse "[MODULE:]LEVEL" */
+static void logm_filter(const char *arg)
+{
+	const char *colon = strchr(arg, ':');
+	int indx = -1;
+
+	if (colon != NULL) {
+		indx = atoi(arg);
+		arg = colon + 1;
+	}
+
+	if (logm_set_filter(indx, atoi(arg)) != OK) {
+		fprintf(stdout, "Invalid module or level\n");
+	}
+}
+#endif
+
 static int logm_tash(int argc, char **args)
 {
 	int opt;
@@ -79,8 +127,9 @@ static int logm_tash(int argc, char **args)
 	/*
 	 * -b [bufsize] : set buffer size (bytes)
 	 * -i [time] : set buffer flushing interval (ms)
+	 * -f [module:]level : set the level of messages shown
 	 */
-	while ((opt = getopt(argc, args, "b:i:")) != -1) {
+	while ((opt = getopt(argc, args, "b:i:f:")) != -1) {
 		switch (opt) {
 		case 'b':
 			/* TASH>> logm -b 10240 */
@@ -88,15 +137,25 @@ static int logm_tash(int argc, char **args)
 			if (optarg != NULL && atoi(optarg) > 0) {
 				logm_set_values(LOGM_BUFSIZE, atoi(optarg));
 				LOGM_STATUS_SET(LOGM_BUFFER_RESIZE_REQ);
+				logm_wakeup();
 			}
 			break;
 		case 'i':
 			/* TASH>> logm -i 1000 */
 			/* sets interval for flushing buffer as 1000ms (=1sec) */
-			if (optarg != NULL && atoi(optarg) > 0) {
+			if (optarg != NULL && atoi(optarg) >= 0) {
 				logm_set_values(LOGM_INTERVAL, atoi(optarg));
 			}
 			break;
+#ifdef CONFIG_LOGM_FILTER
+		case 'f':
+			/* TASH>> logm -f 3:4 */
+			/* shows messages of module 3 up to warnings */
+			if (optarg != NULL) {
+				logm_filter(optarg);
+			}
+			break;
+#endif
 		default:
 			logm_usage();
 			return 0;
@@ -69,10 +69,22 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
-/* Sizes of things */
+/* Sizes of things.  The granule allocation table (GAT) is followed by two
+ * summary tables with one bit per GAT entry.
+ */
 
 #define SIZEOF_GAT(n) ((n + 31) >> 5)
-#define SIZEOF_GRAN_S(n) (sizeof(struct gran_s) + sizeof(uint32_t) * (SIZEOF_GAT(n) - 1))
+#define SIZEOF_GATSUM(n) SIZEOF_GAT(SIZEOF_GAT(n))
+#define SIZEOF_GRAN_S(n) \
+	(sizeof(struct gran_s) + sizeof(uint32_t) * (SIZEOF_GAT(n) + 2 * SIZEOF_GATSUM(n) - 1))
+
+/* Index of the lowest set bit of a non-zero GAT or summary entry */
+
+#ifdef __GNUC__
+#define GRAN_CTZ(x) __builtin_ctz(x)
+#else
+#define GRAN_CTZ(x) gran_ctz(x)
+#endif
 
 /* Debug */
 
@@ -109,6 +121,9 @@ struct gran_s {
 	sem_t      exclsem;			/* For exclusive access to the GAT */
 #endif
 	uintptr_t  heapstart;		/* The aligned start of the granule heap */
+	uint16_t   ngat;			/* The number of entries in the GAT */
+	FAR uint32_t *gatfull;		/* Bit set when the GAT entry has no free granule */
+	FAR uint32_t *gatempty;		/* Bit set when the GAT entry has no allocated granule */
 	uint32_t   gat[1];			/* Start of the granule allocation table */
 };
 
@@ -161,4 +176,52 @@ void gran_leave_critical(FAR struct gran_s *priv);
 
 void gran_mark_allocated(FAR struct gran_s *priv, uintptr_t alloc, unsigned int ngranules);
 
+/****************************************************************************
+ * Name: gran_mark_free
+ *
+ * Description:
+ *   Mark a range of granules as free.
+ *
+ * Input Parameters:
+ *   priv  - The granule heap state structure.
+ *   alloc - The address of the allocation.
+ *   ngranules - The number of granules allocated
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void gran_mark_free(FAR struct gran_s *priv, uintptr_t alloc, unsigned int ngranules);
+
+/****************************************************************************
+ * Name: gran_update_summary
+ *
+ * Description:
+ *   Bring the summary bits of one GAT entry up to date after the entry has
+ *   been changed.
+ *
+ * Input Parameters:
+ *   priv   - The granule heap state structure.
+ *   gatidx - The index of the GAT entry.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void gran_update_summary(FAR struct gran_s *priv, unsigned int gatidx);
+
+#ifndef __GNUC__
+/****************************************************************************
+ * Name: gran_ctz
+ *
+ * Description:
+ *   Return the index of the lowest set bit of a non-zero value.
+ *
+ ****************************************************************************/
+
+int gran_ctz(uint32_t value);
+#endif
+
 #endif							/* __MM_MM_GRAN_MM_GRAN_H */
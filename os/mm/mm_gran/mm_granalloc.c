@@ -73,179 +73,182 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: gran_common_alloc
+ * Name: gran_find_free
  *
  * Description:
- *   Allocate memory from the granule heap.
- *
- * Input Parameters:
- *   priv - The granule heap state structure.
- *   size - The size of the memory region to allocate.
- *
- * Returned Value:
- *   On success, a non-NULL pointer to the allocated memory is returned.
+ *   Return the number of the first free granule at or after 'granno', or
+ *   -1 if there is none.  GAT entries with no free granule are skipped by
+ *   way of the 'gatfull' summary.
  *
  ****************************************************************************/
 
-static inline FAR void *gran_common_alloc(FAR struct gran_s *priv, size_t size)
+static int gran_find_free(FAR struct gran_s *priv, unsigned int granno)
 {
-	unsigned int ngranules;
-	size_t       tmpmask;
-	uintptr_t    alloc;
-	uint32_t     curr;
-	uint32_t     next;
-	uint32_t     mask;
-	int          granidx;
-	int          gatidx;
-	int          bitidx;
-	int          shift;
-
-	DEBUGASSERT(priv && size <= 32 * (1 << priv->log2gran));
-
-	if (priv && size > 0) {
-		/* Get exclusive access to the GAT */
+	unsigned int gatidx = granno >> 5;
+	unsigned int sumidx;
+	uint32_t     word;
 
-		gran_enter_critical(priv);
-
-		/* How many contiguous granules we we need to find? */
-
-		tmpmask = (1 << priv->log2gran) - 1;
-		ngranules = (size + tmpmask) >> priv->log2gran;
-
-		/* Then create mask for that number of granules */
-
-		DEBUGASSERT(ngranules <= 32);
-		mask = 0xffffffff >> (32 - ngranules);
-
-		/* Now search the granule allocation table for that number of contiguous */
-
-		alloc = priv->heapstart;
+	if (gatidx >= priv->ngat) {
+		return -1;
+	}
 
-		for (granidx = 0; granidx < priv->ngranules; granidx += 32) {
-			/* Get the GAT index associated with the granule table entry */
+	/* Free granules in the rest of the first GAT entry */
 
-			gatidx = granidx >> 5;
-			curr = priv->gat[gatidx];
+	word = ~priv->gat[gatidx] & (0xffffffff << (granno & 31));
+	if (word != 0) {
+		return (gatidx << 5) + GRAN_CTZ(word);
+	}
 
-			/* Handle the case where there are no free granules in the entry */
+	/* Then the first GAT entry which is not full */
 
-			if (curr == 0xffffffff) {
-				alloc += (32 << priv->log2gran);
-				continue;
-			}
+	gatidx++;
+	sumidx = gatidx >> 5;
+	if ((gatidx & 31) != 0) {
+		word = ~priv->gatfull[sumidx] & (0xffffffff << (gatidx & 31));
+	} else if (gatidx < priv->ngat) {
+		word = ~priv->gatfull[sumidx];
+	} else {
+		return -1;
+	}
 
-			/* Get the next entry from the GAT to support a 64 bit shift */
+	while (word == 0) {
+		sumidx++;
+		if ((sumidx << 5) >= priv->ngat) {
+			return -1;
+		}
 
-			if (granidx < priv->ngranules) {
-				next = priv->gat[gatidx + 1];
-			}
+		word = ~priv->gatfull[sumidx];
+	}
 
-			/* Use all ones when are at the last entry in the GAT (meaning
-			 * nothing can be allocated.
-			 */
+	gatidx = (sumidx << 5) + GRAN_CTZ(word);
+	if (gatidx >= priv->ngat) {
+		return -1;
+	}
 
-			else {
-				next = 0xffffffff;
-			}
+	/* The bits beyond the last granule are always set, so a free bit here
+	 * is always a granule of the heap.
+	 */
 
-			/* Search through the allocations in the 'curr' GAT entry
-			 * to see if we can satisfy the allocation starting in that
-			 * entry.
-			 *
-			 * This loop continues until either all of the bits have been
-			 * examined (bitidx >= 32), or until there are insufficient
-			 * granules left to satisfy the allocation.
-			 */
+	return (gatidx << 5) + GRAN_CTZ(~priv->gat[gatidx]);
+}
 
-			for (bitidx = 0; bitidx < 32 && (granidx + bitidx + ngranules) <= priv->ngranules;) {
-				/* Break out if there are no further free bits in 'curr'.
-				 * All of the zero bits might have gotten shifted out.
-				 */
+/****************************************************************************
+ * Name: gran_find_used
+ *
+ * Description:
+ *   Return the number of the first allocated granule at or after 'granno',
+ *   or the number of granules in the heap if there is none.  GAT entries
+ *   with no allocated granule are skipped by way of the 'gatempty'
+ *   summary.
+ *
+ ****************************************************************************/
 
-				if (curr == 0xffffffff) {
-					break;
-				}
+static unsigned int gran_find_used(FAR struct gran_s *priv, unsigned int granno)
+{
+	unsigned int gatidx = granno >> 5;
+	unsigned int sumidx;
+	uint32_t     word;
 
-				/* Check for the first zero bit in the lower or upper 16-bits.
-				 * From the test above, we know that at least one of the 32-
-				 * bits in 'curr' is zero.
-				 */
+	if (gatidx >= priv->ngat) {
+		return priv->ngranules;
+	}
 
-				else if ((curr & 0x0000ffff) == 0x0000ffff) {
-					/* Not in the lower 16 bits.  The first free bit must be
-					 * in the upper 16 bits.
-					 */
+	/* Allocated granules in the rest of the first GAT entry */
 
-					shift = 16;
-				}
+	word = priv->gat[gatidx] & (0xffffffff << (granno & 31));
+	if (word != 0) {
+		granno = (gatidx << 5) + GRAN_CTZ(word);
+		return granno < priv->ngranules ? granno : priv->ngranules;
+	}
 
-				/* We know that the first free bit is now within the lower 16
-				 * bits of 'curr'.  Is it in the upper or lower byte?
-				 */
+	/* Then the first GAT entry which is not empty */
 
-				else if ((curr & 0x0000ff) == 0x000000ff) {
-					/* Not in the lower 8 bits.  The first free bit must be in
-					 * the upper 8 bits.
-					 */
+	gatidx++;
+	sumidx = gatidx >> 5;
+	if ((gatidx & 31) != 0) {
+		word = ~priv->gatempty[sumidx] & (0xffffffff << (gatidx & 31));
+	} else if (gatidx < priv->ngat) {
+		word = ~priv->gatempty[sumidx];
+	} else {
+		return priv->ngranules;
+	}
 
-					shift = 8;
-				}
+	while (word == 0) {
+		sumidx++;
+		if ((sumidx << 5) >= priv->ngat) {
+			return priv->ngranules;
+		}
 
-				/* We know that the first free bit is now within the lower 4
-				 * bits of 'curr'.  Is it in the upper or lower nibble?
-				 */
+		word = ~priv->gatempty[sumidx];
+	}
 
-				else if ((curr & 0x00000f) == 0x0000000f) {
-					/* Not in the lower 4 bits.  The first free bit must be in
-					 * the upper 4 bits.
-					 */
+	gatidx = (sumidx << 5) + GRAN_CTZ(word);
+	if (gatidx >= priv->ngat) {
+		return priv->ngranules;
+	}
 
-					shift = 4;
-				}
+	granno = (gatidx << 5) + GRAN_CTZ(priv->gat[gatidx]);
+	return granno < priv->ngranules ? granno : priv->ngranules;
+}
 
-				/* We know that the first free bit is now within the lower 4 bits
-				 * of 'curr'.  Is it in the upper or lower pair?
-				 */
+/****************************************************************************
+ * Name: gran_common_alloc
+ *
+ * Description:
+ *   Allocate memory from the granule heap.
+ *
+ * Input Parameters:
+ *   priv - The granule heap state structure.
+ *   size - The size of the memory region to allocate.
+ *
+ * Returned Value:
+ *   On success, a non-NULL pointer to the allocated memory is returned.
+ *
+ ****************************************************************************/
 
-				else if ((curr & 0x000003) == 0x00000003) {
-					/* Not in the lower 2 bits.  The first free bit must be in
-					 * the upper 2 bits.
-					 */
+static inline FAR void *gran_common_alloc(FAR struct gran_s *priv, size_t size)
+{
+	unsigned int ngranules;
+	unsigned int end;
+	size_t       tmpmask;
+	uintptr_t    alloc;
+	int          start;
 
-					shift = 2;
-				}
+	DEBUGASSERT(priv);
 
-				/* We know that the first free bit is now within the lower 4 bits
-				 * of 'curr'.  Check if we have the allocation at this bit position.
-				 */
+	if (priv && size > 0) {
+		/* How many contiguous granules we we need to find? */
 
-				else if ((curr & mask) == 0) {
-					/* Yes.. mark these granules allocated */
+		tmpmask = (1 << priv->log2gran) - 1;
+		ngranules = (size + tmpmask) >> priv->log2gran;
+		if (ngranules > priv->ngranules) {
+			return NULL;
+		}
 
-					gran_mark_allocated(priv, alloc, ngranules);
+		/* Get exclusive access to the GAT */
 
-					/* And return the allocation address */
+		gran_enter_critical(priv);
 
-					gran_leave_critical(priv);
-					return (FAR void *)alloc;
-				}
+		/* First fit: find the start of each free run and then its end,
+		 * until a run is long enough.
+		 */
 
-				/* The free allocation does not start at this position */
+		start = gran_find_free(priv, 0);
+		while (start >= 0 && start + ngranules <= priv->ngranules) {
+			end = gran_find_used(priv, start);
+			if (end - start >= ngranules) {
+				/* Mark these granules allocated */
 
-				else {
-					shift = 1;
-				}
+				alloc = priv->heapstart + ((uintptr_t)start << priv->log2gran);
+				gran_mark_allocated(priv, alloc, ngranules);
 
-				/* Set up for the next time through the loop.  Perform a 64
-				 * bit shift to move to the next gran position andi ncrement
-				 * to the next candidate allocation address.
-				 */
+				/* And return the allocation address */
 
-				alloc  += (shift << priv->log2gran);
-				curr    = (curr >> shift) | (next << (32 - shift));
-				next  >>= shift;
-				bitidx += shift;
+				gran_leave_critical(priv);
+				return (FAR void *)alloc;
 			}
+
+			start = gran_find_free(priv, end);
 		}
 
 		gran_leave_critical(priv);
@@ -264,9 +267,9 @@ static inline FAR void *gran_common_alloc(FAR struct gran_s *priv, size_t size)
  * Description:
  *   Allocate memory from the granule heap.
  *
- *   NOTE: The current implementation also restricts the maximum allocation
- *   size to 32 granules.  That restriction could be eliminated with some
- *   additional coding effort.
+ *   An allocation may span any number of granules.  The search uses the
+ *   summary bits to skip every 32 granules which are all allocated, or all
+ *   free, in one step.
  *
  * Input Parameters:
  *   handle - The handle previously returned by gran_initialize
@@ -116,6 +116,7 @@ static inline FAR struct gran_s *gran_common_initialize(FAR void *heapstart, siz
 	unsigned int       mask;
 	unsigned int       alignedsize;
 	unsigned int       ngranules;
+	unsigned int       gatidx;
 
 	/* Check parameters if debug is on.  Note the size of a granule is
 	 * limited to 2**31 bytes and that the size of the granule must be greater
@@ -147,6 +148,22 @@ static inline FAR struct gran_s *gran_common_initialize(FAR void *heapstart, siz
 		priv->log2gran  = log2gran;
 		priv->ngranules = ngranules;
 		priv->heapstart = alignedstart;
+		priv->ngat      = SIZEOF_GAT(ngranules);
+		priv->gatfull   = &priv->gat[priv->ngat];
+		priv->gatempty  = &priv->gatfull[SIZEOF_GATSUM(ngranules)];
+
+		/* The bits beyond the last granule are marked allocated, so that
+		 * the search never hands them out.  The summary bits beyond the
+		 * last GAT entry are left clear, so that the searches stop there.
+		 */
+
+		if ((ngranules & 31) != 0) {
+			priv->gat[priv->ngat - 1] = 0xffffffff << (ngranules & 31);
+		}
+
+		for (gatidx = 0; gatidx < priv->ngat; gatidx++) {
+			gran_update_summary(priv, gatidx);
+		}
 
 		/* Initialize mutual exclusion support */
 
@@ -194,9 +211,8 @@ static inline FAR struct gran_s *gran_common_initialize(FAR void *heapstart, siz
  *   The actual memory allocates will be 64 byte (wasting 17 bytes) and
  *   will be aligned at least to (1 << log2align).
  *
- *   NOTE: The current implementation also restricts the maximum allocation
- *   size to 32 granules.  That restriction could be eliminated with some
- *   additional coding effort.
+ *   An allocation may span any number of granules.  A summary bit per 32
+ *   granules lets the search skip whole runs of allocated or free granules.
  *
  * Input Parameters:
  *   heapstart - Start of the granule allocation heap
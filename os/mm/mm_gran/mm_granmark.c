@@ -56,6 +56,7 @@
 
 #include <tinyara/config.h>
 
+#include <stdbool.h>
 #include <assert.h>
 
 #include <tinyara/mm/gran.h>
@@ -72,6 +73,58 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: gran_mark
+ *
+ * Description:
+ *   Set or clear the GAT bits of a range of granules, one GAT entry at a
+ *   time, and keep the summary bits of every entry touched up to date.
+ *
+ ****************************************************************************/
+
+static void gran_mark(FAR struct gran_s *priv, uintptr_t alloc, unsigned int ngranules, bool allocated)
+{
+	unsigned int granno;
+	unsigned int gatidx;
+	unsigned int gatbit;
+	unsigned int nbits;
+	uint32_t     gatmask;
+
+	/* Determine the granule number of the allocation */
+
+	granno = (alloc - priv->heapstart) >> priv->log2gran;
+	DEBUGASSERT(granno + ngranules <= priv->ngranules);
+
+	/* Determine the GAT table index associated with the allocation */
+
+	gatidx = granno >> 5;
+	gatbit = granno & 31;
+
+	while (ngranules > 0) {
+		/* The bits of the range which lie in this GAT entry */
+
+		nbits = 32 - gatbit;
+		if (nbits > ngranules) {
+			nbits = ngranules;
+		}
+
+		gatmask = (0xffffffff >> (32 - nbits)) << gatbit;
+		if (allocated) {
+			DEBUGASSERT((priv->gat[gatidx] & gatmask) == 0);
+			priv->gat[gatidx] |= gatmask;
+		} else {
+			DEBUGASSERT((priv->gat[gatidx] & gatmask) == gatmask);
+			priv->gat[gatidx] &= ~gatmask;
+		}
+
+		gran_update_summary(priv, gatidx);
+
+		ngranules -= nbits;
+		gatidx++;
+		gatbit = 0;
+	}
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -94,53 +147,105 @@
 
 void gran_mark_allocated(FAR struct gran_s *priv, uintptr_t alloc, unsigned int ngranules)
 {
-	unsigned int granno;
-	unsigned int gatidx;
-	unsigned int gatbit;
-	unsigned int avail;
-	uint32_t     gatmask;
-
-	/* Determine the granule number of the allocation */
+	gran_mark(priv, alloc, ngranules, true);
+}
 
-	granno = (alloc - priv->heapstart) >> priv->log2gran;
+/****************************************************************************
+ * Name: gran_mark_free
+ *
+ * Description:
+ *   Mark a range of granules as free.
+ *
+ * Input Parameters:
+ *   priv  - The granule heap state structure.
+ *   alloc - The address of the allocation.
+ *   ngranules - The number of granules allocated
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-	/* Determine the GAT table index associated with the allocation */
+void gran_mark_free(FAR struct gran_s *priv, uintptr_t alloc, unsigned int ngranules)
+{
+	gran_mark(priv, alloc, ngranules, false);
+}
 
-	gatidx = granno >> 5;
-	gatbit = granno & 31;
+/****************************************************************************
+ * Name: gran_update_summary
+ *
+ * Description:
+ *   Bring the summary bits of one GAT entry up to date after the entry has
+ *   been changed.
+ *
+ * Input Parameters:
+ *   priv   - The granule heap state structure.
+ *   gatidx - The index of the GAT entry.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-	/* Mark bits in the GAT entry or entries */
+void gran_update_summary(FAR struct gran_s *priv, unsigned int gatidx)
+{
+	unsigned int sumidx = gatidx >> 5;
+	uint32_t     summask = (uint32_t)1 << (gatidx & 31);
 
-	avail = 32 - gatbit;
-	if (ngranules > avail) {
-		/* Mark bits in the first GAT entry */
+	if (priv->gat[gatidx] == 0xffffffff) {
+		priv->gatfull[sumidx] |= summask;
+	} else {
+		priv->gatfull[sumidx] &= ~summask;
+	}
 
-		gatmask = 0xffffffff << gatbit;
-		DEBUGASSERT((priv->gat[gatidx] & gatmask) == 0);
+	if (priv->gat[gatidx] == 0) {
+		priv->gatempty[sumidx] |= summask;
+	} else {
+		priv->gatempty[sumidx] &= ~summask;
+	}
+}
 
-		priv->gat[gatidx] |= gatmask;
-		ngranules -= avail;
+#ifndef __GNUC__
+/****************************************************************************
+ * Name: gran_ctz
+ *
+ * Description:
+ *   Return the index of the lowest set bit of a non-zero value.
+ *
+ ****************************************************************************/
 
-		/* Mark bits in the second GAT entry */
+int gran_ctz(uint32_t value)
+{
+	int bit = 0;
 
-		gatmask = 0xffffffff >> (32 - ngranules);
-		DEBUGASSERT((priv->gat[gatidx + 1] & gatmask) == 0);
+	DEBUGASSERT(value != 0);
 
-		priv->gat[gatidx + 1] |= gatmask;
+	if ((value & 0x0000ffff) == 0) {
+		value >>= 16;
+		bit += 16;
 	}
 
-	/* Handle the case where where all of the granules come from one entry */
+	if ((value & 0x000000ff) == 0) {
+		value >>= 8;
+		bit += 8;
+	}
 
-	else {
-		/* Mark bits in a single GAT entry */
+	if ((value & 0x0000000f) == 0) {
+		value >>= 4;
+		bit += 4;
+	}
 
-		gatmask = 0xffffffff >> (32 - ngranules);
-		gatmask <<= gatbit;
-		DEBUGASSERT((priv->gat[gatidx] & gatmask) == 0);
+	if ((value & 0x00000003) == 0) {
+		value >>= 2;
+		bit += 2;
+	}
 
-		priv->gat[gatidx] |= gatmask;
-		return;
+	if ((value & 0x00000001) == 0) {
+		bit += 1;
 	}
+
+	return bit;
 }
+#endif
 
 #endif							/* CONFIG_GRAN */
@@ -77,40 +77,21 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mm_free
+ * Name: mm_freechunk
  *
  * Description:
- *   Returns a chunk of memory to the list of free nodes,  merging with
- *   adjacent free chunks if possible.
+ *   Returns an allocated chunk to the list of free nodes, merging with
+ *   adjacent free chunks if possible.  It is assumed that the caller holds
+ *   the mm semaphore.
  *
  ****************************************************************************/
-void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
+void mm_freechunk(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
 {
-	FAR struct mm_freenode_s *node;
 	FAR struct mm_freenode_s *prev;
 	FAR struct mm_freenode_s *next;
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 	struct mm_allocnode_s *alloc_node;
-#endif
-
-	mvdbg("Freeing %p\n", mem);
-
-	/* Protect against attempts to free a NULL reference */
-
-	if (!mem) {
-		return;
-	}
 
-	/* We need to hold the MM semaphore while we muck with the
-	 * nodelist.
-	 */
-
-	mm_takesemaphore(heap);
-
-	/* Map the memory chunk into a free node */
-
-	node = (FAR struct mm_freenode_s *)((char *)mem - SIZEOF_MM_ALLOCNODE);
-#ifdef CONFIG_DEBUG_MM_HEAPINFO
 	alloc_node = (struct mm_allocnode_s *)node;
 
 	if ((alloc_node->preceding & MM_ALLOC_BIT) != 0) {
@@ -176,5 +157,52 @@ void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
 	/* Add the merged node to the nodelist */
 
 	mm_addfreechunk(heap, node);
+}
+
+/****************************************************************************
+ * Name: mm_free
+ *
+ * Description:
+ *   Returns a chunk of memory to the list of free nodes,  merging with
+ *   adjacent free chunks if possible.  With CONFIG_MM_QUICKLIST, a small
+ *   chunk is kept on the quick list of its size instead, and with
+ *   CONFIG_MM_TASK_CACHE in the cache of the running thread first.
+ *
+ ****************************************************************************/
+void mm_free(FAR struct mm_heap_s *heap, FAR void *mem)
+{
+	FAR struct mm_freenode_s *node;
+
+	mvdbg("Freeing %p\n", mem);
+
+	/* Protect against attempts to free a NULL reference */
+
+	if (!mem) {
+		return;
+	}
+
+	/* Map the memory chunk into a free node */
+
+	node = (FAR struct mm_freenode_s *)((char *)mem - SIZEOF_MM_ALLOCNODE);
+
+#ifdef CONFIG_MM_TASK_CACHE
+	if (mm_taskcache_free(heap, node)) {
+		return;
+	}
+#endif
+
+	/* We need to hold the MM semaphore while we muck with the
+	 * nodelist.
+	 */
+
+	mm_takesemaphore(heap);
+
+#ifdef CONFIG_MM_QUICKLIST
+	if (!mm_quicklist_free(heap, node))
+#endif
+	{
+		mm_freechunk(heap, node);
+	}
+
 	mm_givesemaphore(heap);
 }
@@ -226,6 +226,13 @@ void mm_initialize(FAR struct mm_heap_s *heap, FAR void *heapstart, size_t heaps
 
 	mm_seminitialize(heap);
 
+#ifdef CONFIG_MM_QUICKLIST
+	mm_quicklist_initialize(heap);
+#endif
+#ifdef CONFIG_MM_TASK_CACHE
+	heap->mm_semwaits = 0;
+#endif
+
 	/* Add the initial region of memory to the heap */
 
 	mm_addregion(heap, heapstart, heapsize);
@@ -55,6 +55,7 @@
  ****************************************************************************/
 
 #include <tinyara/config.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <debug.h>
@@ -136,6 +137,33 @@ int mm_mallinfo(FAR struct mm_heap_s *heap, FAR struct mallinfo *info)
 
 	DEBUGASSERT(uordblks + fordblks == heap->mm_heapsize);
 
+#ifdef CONFIG_MM_QUICKLIST
+	/* Chunks on the quick lists are marked allocated, but they are free */
+
+	mm_takesemaphore(heap);
+	uordblks      -= heap->mm_qlsize;
+	fordblks      += heap->mm_qlsize;
+	info->qlblks   = heap->mm_qlblks;
+	info->qlhits   = heap->mm_qlhits;
+	info->qlmisses = heap->mm_qlmisses;
+	info->mxsearch = heap->mm_mxsearch;
+	mm_givesemaphore(heap);
+
+	/* The share of free space outside of the largest free chunk */
+
+	if (fordblks == 0) {
+		info->fragmentation = 0;
+	} else if (fordblks < SIZE_MAX / 100) {
+		info->fragmentation = (int)((fordblks - mxordblk) * 100 / fordblks);
+	} else {
+		info->fragmentation = (int)((fordblks - mxordblk) / (fordblks / 100));
+	}
+#endif
+
+#ifdef CONFIG_MM_TASK_CACHE
+	info->semwaits = heap->mm_semwaits;
+#endif
+
 	info->arena    = heap->mm_heapsize;
 	info->ordblks  = ordblks;
 	info->mxordblk = mxordblk;
@@ -101,6 +101,12 @@
  *
  *  8-byte alignment of the allocated data is assured.
  *
+ *  With CONFIG_MM_QUICKLIST, a small request is first served from the quick
+ *  list of its size, and the quick lists are returned to the heap before an
+ *  allocation is allowed to fail.  With CONFIG_MM_TASK_CACHE, the cache of
+ *  the running thread is tried before the heap semaphore is taken, and is
+ *  also returned to the heap before the allocation fails.
+ *
  ****************************************************************************/
 #ifdef CONFIG_DEBUG_MM_HEAPINFO
 FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size, mmaddress_t caller_retaddr)
@@ -111,6 +117,9 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 	FAR struct mm_freenode_s *node;
 	void *ret = NULL;
 	int ndx;
+#ifdef CONFIG_MM_QUICKLIST
+	size_t search;
+#endif
 
 	/* Handle bad sizes */
 
@@ -124,10 +133,29 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 
 	size = MM_ALIGN_UP(size + SIZEOF_MM_ALLOCNODE);
 
+#ifdef CONFIG_MM_TASK_CACHE
+	ret = mm_taskcache_alloc(heap, size);
+	if (ret) {
+		mvdbg("Allocated %p, size %d\n", ret, size);
+		return ret;
+	}
+#endif
+
 	/* We need to hold the MM semaphore while we muck with the nodelist. */
 
 	mm_takesemaphore(heap);
 
+#ifdef CONFIG_MM_QUICKLIST
+	ret = mm_quicklist_alloc(heap, size);
+	if (ret) {
+		mm_givesemaphore(heap);
+		mvdbg("Allocated %p, size %d\n", ret, size);
+		return ret;
+	}
+
+retry:
+#endif
+
 	/* Get the location in the node list to start the search. Special case
 	 * really big allocations
 	 */
@@ -145,7 +173,26 @@ FAR void *mm_malloc(FAR struct mm_heap_s *heap, size_t size)
 	 * other mm_nodelist[] entries.
 	 */
 
+#ifdef CONFIG_MM_QUICKLIST
+	for (search = 0, node = heap->mm_nodelist[ndx].flink; node && node->size < size; node = node->flink, search++) ;
+
+	if (search > heap->mm_mxsearch) {
+		heap->mm_mxsearch = search;
+	}
+
+	/* Cached small chunks may be merged into a chunk which is large enough */
+
+	if (!node && mm_quicklist_flush(heap)) {
+		goto retry;
+	}
+#ifdef CONFIG_MM_TASK_CACHE
+	if (!node && mm_taskcache_flush(heap)) {
+		goto retry;
+	}
+#endif
+#else
 	for (node = heap->mm_nodelist[ndx].flink; node && node->size < size; node = node->flink) ;
+#endif
 
 	/* If we found a node with non-zero size, then this is one to use. Since
 	 * the list is ordered, we know that is must be best fitting chunk
@@ -0,0 +1,176 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_quicklist.c
+ *
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_QUICKLIST
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Global Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_quicklist_initialize
+ *
+ * Description:
+ *   Empty the quick lists and clear their statistics.
+ *
+ ****************************************************************************/
+
+void mm_quicklist_initialize(FAR struct mm_heap_s *heap)
+{
+	memset(heap->mm_quicklist, 0, sizeof(heap->mm_quicklist));
+	heap->mm_qlblks = 0;
+	heap->mm_qlsize = 0;
+	heap->mm_qlhits = 0;
+	heap->mm_qlmisses = 0;
+	heap->mm_mxsearch = 0;
+}
+
+/****************************************************************************
+ * Name: mm_quicklist_alloc
+ *
+ * Description:
+ *   Take a chunk of the given size from its quick list.  The size is the
+ *   chunk size including the allocation node.  Returns NULL if the size is
+ *   not cached or its list is empty.  It is assumed that the caller holds
+ *   the mm semaphore.
+ *
+ ****************************************************************************/
+
+FAR void *mm_quicklist_alloc(FAR struct mm_heap_s *heap, size_t size)
+{
+	FAR struct mm_quicklist_s *list;
+	FAR struct mm_freenode_s *node;
+
+	if (size > MM_QUICKLIST_MAXCHUNK) {
+		return NULL;
+	}
+
+	list = &heap->mm_quicklist[MM_QUICKLIST_NDX(size)];
+	node = list->head;
+	if (node == NULL) {
+		heap->mm_qlmisses++;
+		return NULL;
+	}
+
+	DEBUGASSERT(node->size == size && (node->preceding & MM_ALLOC_BIT) != 0);
+	list->head = node->flink;
+	list->count--;
+	heap->mm_qlblks--;
+	heap->mm_qlsize -= size;
+	heap->mm_qlhits++;
+
+	return (FAR void *)((FAR char *)node + SIZEOF_MM_ALLOCNODE);
+}
+
+/****************************************************************************
+ * Name: mm_quicklist_free
+ *
+ * Description:
+ *   Cache an allocated chunk on the quick list of its size.  Returns false
+ *   if the chunk is too large or its list is full, in which case the caller
+ *   returns it to the heap.  It is assumed that the caller holds the mm
+ *   semaphore.
+ *
+ ****************************************************************************/
+
+bool mm_quicklist_free(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	FAR struct mm_quicklist_s *list;
+
+	if (node->size > MM_QUICKLIST_MAXCHUNK) {
+		return false;
+	}
+
+	list = &heap->mm_quicklist[MM_QUICKLIST_NDX(node->size)];
+	if (list->count >= CONFIG_MM_QUICKLIST_DEPTH) {
+		return false;
+	}
+
+	/* The allocated bit stays set, so the neighbours never merge with it */
+
+	node->flink = list->head;
+	list->head = node;
+	list->count++;
+	heap->mm_qlblks++;
+	heap->mm_qlsize += node->size;
+
+	return true;
+}
+
+/****************************************************************************
+ * Name: mm_quicklist_flush
+ *
+ * Description:
+ *   Return every cached chunk to the heap, so that it can be coalesced and
+ *   satisfy larger requests.  Returns false if nothing was cached.  It is
+ *   assumed that the caller holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+bool mm_quicklist_flush(FAR struct mm_heap_s *heap)
+{
+	FAR struct mm_freenode_s *node;
+	FAR struct mm_freenode_s *next;
+	int ndx;
+
+	if (heap->mm_qlblks == 0) {
+		return false;
+	}
+
+	mvdbg("Flushing %u cached chunks, %u bytes\n", heap->mm_qlblks, heap->mm_qlsize);
+
+	for (ndx = 0; ndx < MM_QUICKLIST_NCLASSES; ndx++) {
+		for (node = heap->mm_quicklist[ndx].head; node; node = next) {
+			next = node->flink;
+			mm_freechunk(heap, node);
+		}
+		heap->mm_quicklist[ndx].head = NULL;
+		heap->mm_quicklist[ndx].count = 0;
+	}
+
+	heap->mm_qlblks = 0;
+	heap->mm_qlsize = 0;
+	return true;
+}
+
+#endif							/* CONFIG_MM_QUICKLIST */
@@ -161,6 +161,9 @@ int mm_trysemaphore(FAR struct mm_heap_s *heap)
 void mm_takesemaphore(FAR struct mm_heap_s *heap)
 {
 	pid_t my_pid = getpid();
+#ifdef CONFIG_MM_TASK_CACHE
+	int semcount = 1;
+#endif
 
 	/* Do I already have the semaphore? */
 
@@ -172,6 +175,9 @@ void mm_takesemaphore(FAR struct mm_heap_s *heap)
 		/* Take the semaphore (perhaps waiting) */
 
 		msemdbg("PID=%d taking\n", my_pid);
+#ifdef CONFIG_MM_TASK_CACHE
+		(void)sem_getvalue(&heap->mm_semaphore, &semcount);
+#endif
 		while (sem_wait(&heap->mm_semaphore) != 0) {
 			/* The only case that an error should occur here is if
 			 * the wait was awakened by a signal.
@@ -184,6 +190,14 @@ void mm_takesemaphore(FAR struct mm_heap_s *heap)
 
 		heap->mm_holder      = my_pid;
 		heap->mm_counts_held = 1;
+
+#ifdef CONFIG_MM_TASK_CACHE
+		/* Count the takes which found the semaphore held by another task */
+
+		if (semcount <= 0) {
+			heap->mm_semwaits++;
+		}
+#endif
 	}
 
 	msemdbg("Holder=%d count=%d\n", heap->mm_holder, heap->mm_counts_held);
@@ -0,0 +1,389 @@
+/****************************************************************************
+ *
+ * Copyright 2017 Samsung Electronics All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific
+ * language governing permissions and limitations under the License.
+ *
+ ****************************************************************************/
+/****************************************************************************
+ * mm/mm_heap/mm_taskcache.c
+ *
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <tinyara/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <tinyara/sched.h>
+#include <tinyara/arch.h>
+#include <tinyara/irq.h>
+#include <tinyara/mm/mm.h>
+
+#ifdef CONFIG_MM_TASK_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MM_TASK_CACHE_BATCH > CONFIG_MM_TASK_CACHE_DEPTH
+#error "CONFIG_MM_TASK_CACHE_BATCH must not be larger than CONFIG_MM_TASK_CACHE_DEPTH"
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static bool g_taskcache_disabled;
+
+/* Bumped by an allocation that failed, so that every thread gives its
+ * cached chunks back to the heap the next time it uses its cache.
+ */
+
+static volatile uint32_t g_taskcache_flushgen;
+
+/* The caches of released threads which could not be drained at the time,
+ * because the heap semaphore was busy.
+ */
+
+static FAR struct mm_taskcache_s *g_taskcache_released;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_taskcache_get
+ *
+ * Description:
+ *   Return the cache of the running thread for the given heap, creating it
+ *   when requested.  Only the user heap is cached, and never from interrupt
+ *   handlers.
+ *
+ ****************************************************************************/
+
+static FAR struct mm_taskcache_s *mm_taskcache_get(FAR struct mm_heap_s *heap, bool create)
+{
+	FAR struct tcb_s *tcb;
+	FAR struct mm_taskcache_s *cache;
+
+	if (heap != &g_mmheap || g_taskcache_disabled || up_interrupt_context()) {
+		return NULL;
+	}
+
+	tcb = sched_self();
+	if (tcb->mm_cache == NULL && create) {
+		/* mm_malloc() finds no cache yet, so this can not recurse */
+
+		cache = (FAR struct mm_taskcache_s *)mm_malloc(heap, sizeof(struct mm_taskcache_s));
+		if (cache != NULL) {
+			memset(cache, 0, sizeof(struct mm_taskcache_s));
+			tcb->mm_cache = cache;
+		}
+	}
+
+	return tcb->mm_cache;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_push
+ *
+ * Description:
+ *   Put a chunk on a list.  The head is written last, so a thread deleted
+ *   in the middle leaves a consistent list behind.
+ *
+ ****************************************************************************/
+
+static void mm_taskcache_push(FAR struct mm_quicklist_s *list, FAR struct mm_freenode_s *node)
+{
+	node->flink = list->head;
+	list->head = node;
+	list->count++;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_drain
+ *
+ * Description:
+ *   Give every chunk of a thread cache back to the heap, where it can be
+ *   coalesced.  Returns false if the cache was empty.  It is assumed that
+ *   the caller holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+static bool mm_taskcache_drain(FAR struct mm_heap_s *heap, FAR struct mm_taskcache_s *cache)
+{
+	FAR struct mm_freenode_s *node;
+	FAR struct mm_freenode_s *next;
+	bool drained = false;
+	int ndx;
+
+	cache->flushgen = g_taskcache_flushgen;
+	for (ndx = 0; ndx < MM_QUICKLIST_NCLASSES; ndx++) {
+		for (node = cache->lists[ndx].head; node; node = next) {
+			next = node->flink;
+			mm_freechunk(heap, node);
+			drained = true;
+		}
+		cache->lists[ndx].head = NULL;
+		cache->lists[ndx].count = 0;
+	}
+
+	return drained;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_reap
+ *
+ * Description:
+ *   Give the chunks of the released caches, and the caches themselves,
+ *   back to the heap.  Returns false if there was nothing to give back.  It
+ *   is assumed that the caller holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+static bool mm_taskcache_reap(FAR struct mm_heap_s *heap)
+{
+	FAR struct mm_taskcache_s *cache;
+	FAR struct mm_taskcache_s *next;
+	irqstate_t flags;
+
+	flags = irqsave();
+	cache = g_taskcache_released;
+	g_taskcache_released = NULL;
+	irqrestore(flags);
+
+	if (cache == NULL) {
+		return false;
+	}
+
+	for (; cache != NULL; cache = next) {
+		next = cache->flink;
+		(void)mm_taskcache_drain(heap, cache);
+		mm_freechunk(heap, (FAR struct mm_freenode_s *)((FAR char *)cache - SIZEOF_MM_ALLOCNODE));
+	}
+
+	return true;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_check
+ *
+ * Description:
+ *   Drain the cache of the running thread if a flush was requested since
+ *   the thread last used it, and the caches of released threads which are
+ *   still pending.
+ *
+ ****************************************************************************/
+
+static void mm_taskcache_check(FAR struct mm_heap_s *heap, FAR struct mm_taskcache_s *cache)
+{
+	if (cache->flushgen != g_taskcache_flushgen || g_taskcache_released != NULL) {
+		mm_takesemaphore(heap);
+		if (cache->flushgen != g_taskcache_flushgen) {
+			(void)mm_taskcache_drain(heap, cache);
+		}
+		(void)mm_taskcache_reap(heap);
+		mm_givesemaphore(heap);
+	}
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: mm_taskcache_alloc
+ *
+ * Description:
+ *   Take a chunk of the given size from the cache of the running thread.
+ *   The size is the chunk size including the allocation node.  An empty
+ *   list is refilled with up to CONFIG_MM_TASK_CACHE_BATCH chunks from the
+ *   heap quick list under a single take of the heap semaphore.  Returns
+ *   NULL if nothing could be found, in which case the caller allocates
+ *   from the heap.
+ *
+ ****************************************************************************/
+
+FAR void *mm_taskcache_alloc(FAR struct mm_heap_s *heap, size_t size)
+{
+	FAR struct mm_taskcache_s *cache;
+	FAR struct mm_quicklist_s *list;
+	FAR struct mm_freenode_s *node;
+	FAR void *mem;
+	int i;
+
+	if (size > MM_QUICKLIST_MAXCHUNK) {
+		return NULL;
+	}
+
+	cache = mm_taskcache_get(heap, false);
+	if (cache == NULL) {
+		return NULL;
+	}
+	mm_taskcache_check(heap, cache);
+
+	list = &cache->lists[MM_QUICKLIST_NDX(size)];
+	if (list->head == NULL) {
+		mm_takesemaphore(heap);
+		for (i = 0; i < CONFIG_MM_TASK_CACHE_BATCH; i++) {
+			mem = mm_quicklist_alloc(heap, size);
+			if (mem == NULL) {
+				break;
+			}
+			mm_taskcache_push(list, (FAR struct mm_freenode_s *)((FAR char *)mem - SIZEOF_MM_ALLOCNODE));
+		}
+		mm_givesemaphore(heap);
+	}
+
+	node = list->head;
+	if (node == NULL) {
+		return NULL;
+	}
+
+	list->head = node->flink;
+	list->count--;
+
+	return (FAR void *)((FAR char *)node + SIZEOF_MM_ALLOCNODE);
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_free
+ *
+ * Description:
+ *   Keep an allocated chunk in the cache of the running thread.  A full
+ *   list first gives CONFIG_MM_TASK_CACHE_BATCH chunks back to the heap
+ *   under a single take of the heap semaphore.  Returns false if the chunk
+ *   is not cached, in which case the caller returns it to the heap.
+ *
+ ****************************************************************************/
+
+bool mm_taskcache_free(FAR struct mm_heap_s *heap, FAR struct mm_freenode_s *node)
+{
+	FAR struct mm_taskcache_s *cache;
+	FAR struct mm_quicklist_s *list;
+	FAR struct mm_freenode_s *drained;
+	int i;
+
+	if (node->size > MM_QUICKLIST_MAXCHUNK) {
+		return false;
+	}
+
+	cache = mm_taskcache_get(heap, true);
+	if (cache == NULL) {
+		return false;
+	}
+	mm_taskcache_check(heap, cache);
+
+	list = &cache->lists[MM_QUICKLIST_NDX(node->size)];
+	if (list->count >= CONFIG_MM_TASK_CACHE_DEPTH) {
+		mm_takesemaphore(heap);
+		for (i = 0; i < CONFIG_MM_TASK_CACHE_BATCH && list->head; i++) {
+			drained = list->head;
+			list->head = drained->flink;
+			list->count--;
+			if (!mm_quicklist_free(heap, drained)) {
+				mm_freechunk(heap, drained);
+			}
+		}
+		mm_givesemaphore(heap);
+	}
+
+	mm_taskcache_push(list, node);
+	return true;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_release
+ *
+ * Description:
+ *   Give the chunks of the cache of a released thread, and the cache
+ *   itself, back to the heap.  They bypass the cache of the running thread,
+ *   which is not the owner.  If the heap semaphore can not be taken without
+ *   waiting, the cache is queued and given back by the next thread which
+ *   uses its cache or fails an allocation.
+ *
+ ****************************************************************************/
+
+void mm_taskcache_release(FAR struct mm_taskcache_s *cache)
+{
+	FAR struct mm_heap_s *heap = &g_mmheap;
+	irqstate_t flags;
+
+	flags = irqsave();
+	cache->flink = g_taskcache_released;
+	g_taskcache_released = cache;
+	irqrestore(flags);
+
+	if (!up_interrupt_context() && mm_trysemaphore(heap) == OK) {
+		(void)mm_taskcache_reap(heap);
+		mm_givesemaphore(heap);
+	}
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_flush
+ *
+ * Description:
+ *   Called when an allocation from the heap failed.  Gives the chunks
+ *   cached by the running thread and by released threads back to the heap,
+ *   and asks every other thread to do the same the next time it allocates
+ *   or frees.  Returns false if nothing was given back.  It is assumed that the
+ *   caller holds the mm semaphore.
+ *
+ ****************************************************************************/
+
+bool mm_taskcache_flush(FAR struct mm_heap_s *heap)
+{
+	FAR struct tcb_s *tcb;
+	bool drained;
+
+	if (heap != &g_mmheap || up_interrupt_context()) {
+		return false;
+	}
+
+	g_taskcache_flushgen++;
+	drained = mm_taskcache_reap(heap);
+
+	/* Caches stay with their threads while disabled, so drain regardless */
+
+	tcb = sched_self();
+	if (tcb->mm_cache != NULL && mm_taskcache_drain(heap, tcb->mm_cache)) {
+		drained = true;
+	}
+
+	return drained;
+}
+
+/****************************************************************************
+ * Name: mm_taskcache_enable
+ *
+ * Description:
+ *   Enable or disable the thread caches at run time, e.g. to compare the
+ *   heap semaphore contention with and without them.  Chunks already cached
+ *   stay with their threads until the threads exit.
+ *
+ ****************************************************************************/
+
+void mm_taskcache_enable(bool enable)
+{
+	g_taskcache_disabled = !enable;
+}
+
+#endif							/* CONFIG_MM_TASK_CACHE */
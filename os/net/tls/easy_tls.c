@@ -18,8 +18,10 @@
 
 #include <tinyara/config.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <tls/easy_tls.h>
+#include <tls/ssl_internal.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -36,6 +38,14 @@
 		buf = NULL;					\
 	}
 
+#if defined(CONFIG_TLS_SESSION_RESUMPTION) && defined(MBEDTLS_THREADING_C)
+#define TLS_STORE_LOCK(ctx)		mbedtls_mutex_lock(&(ctx)->mutex)
+#define TLS_STORE_UNLOCK(ctx)	mbedtls_mutex_unlock(&(ctx)->mutex)
+#else
+#define TLS_STORE_LOCK(ctx)
+#define TLS_STORE_UNLOCK(ctx)
+#endif
+
 /****************************************************************************
  * Static Functions
  ****************************************************************************/
@@ -45,6 +55,104 @@ static void easy_tls_debug(void *ctx, int level, const char *file, int line, con
 	EASY_TLS_DEBUG("%04d: |%d| %s", line, level, str);
 }
 
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+static void tls_session_drop(tls_saved_session *saved)
+{
+	mbedtls_ssl_session_free(&saved->session);
+	TLS_FREE(saved->host_name);
+}
+
+static tls_saved_session *tls_session_lookup(tls_ctx *ctx, const char *host_name)
+{
+	int i;
+
+	for (i = 0; i < CONFIG_TLS_SESSION_STORE_SIZE; i++) {
+		if (ctx->sessions[i].host_name && strcmp(ctx->sessions[i].host_name, host_name) == 0) {
+			return &ctx->sessions[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Offer the saved session of the server to the handshake */
+
+static void tls_session_restore(tls_session *session, tls_ctx *ctx, tls_opt *opt)
+{
+	tls_saved_session *saved;
+
+	if (opt->server != MBEDTLS_SSL_IS_CLIENT || opt->host_name == NULL) {
+		return;
+	}
+
+	TLS_STORE_LOCK(ctx);
+	saved = tls_session_lookup(ctx, opt->host_name);
+	if (saved && mbedtls_ssl_set_session(session->ssl, &saved->session) == 0) {
+		saved->lastuse = ++ctx->usecount;
+	}
+	TLS_STORE_UNLOCK(ctx);
+}
+
+/* Save the session of a completed handshake, in place of the previous
+ * session with the server or of the least recently used one.
+ */
+
+static void tls_session_save(tls_session *session, tls_ctx *ctx, tls_opt *opt)
+{
+	tls_saved_session *saved;
+	int i;
+
+	if (opt->server != MBEDTLS_SSL_IS_CLIENT || opt->host_name == NULL) {
+		return;
+	}
+
+	TLS_STORE_LOCK(ctx);
+	saved = tls_session_lookup(ctx, opt->host_name);
+	if (saved == NULL) {
+		saved = &ctx->sessions[0];
+		for (i = 1; i < CONFIG_TLS_SESSION_STORE_SIZE && saved->host_name; i++) {
+			if (ctx->sessions[i].host_name == NULL || ctx->sessions[i].lastuse < saved->lastuse) {
+				saved = &ctx->sessions[i];
+			}
+		}
+
+		tls_session_drop(saved);
+		saved->host_name = strdup(opt->host_name);
+		if (saved->host_name == NULL) {
+			goto out;
+		}
+	}
+
+	mbedtls_ssl_session_free(&saved->session);
+	if (mbedtls_ssl_get_session(session->ssl, &saved->session) != 0) {
+		tls_session_drop(saved);
+		goto out;
+	}
+
+	saved->lastuse = ++ctx->usecount;
+out:
+	TLS_STORE_UNLOCK(ctx);
+}
+
+/* Forget the session of a server after a failed handshake */
+
+static void tls_session_forget(tls_ctx *ctx, tls_opt *opt)
+{
+	tls_saved_session *saved;
+
+	if (opt->server != MBEDTLS_SSL_IS_CLIENT || opt->host_name == NULL) {
+		return;
+	}
+
+	TLS_STORE_LOCK(ctx);
+	saved = tls_session_lookup(ctx, opt->host_name);
+	if (saved) {
+		tls_session_drop(saved);
+	}
+	TLS_STORE_UNLOCK(ctx);
+}
+#endif
+
 static int tls_context_init(tls_ctx *ctx)
 {
 	if (ctx == NULL) {
@@ -58,6 +166,18 @@ static int tls_context_init(tls_ctx *ctx)
 	mbedtls_ctr_drbg_init(ctx->ctr_drbg);
 #ifdef MBEDTLS_SSL_CACHE_C
 	mbedtls_ssl_cache_init(ctx->cache);
+#endif
+	ctx->full_handshakes = 0;
+	ctx->resumed_handshakes = 0;
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	memset(ctx->sessions, 0, CONFIG_TLS_SESSION_STORE_SIZE * sizeof(tls_saved_session));
+	ctx->usecount = 0;
+#ifdef MBEDTLS_SSL_TICKET_C
+	mbedtls_ssl_ticket_init(ctx->ticket);
+#endif
+#ifdef MBEDTLS_THREADING_C
+	mbedtls_mutex_init(&ctx->mutex);
+#endif
 #endif
 	return 0;
 }
@@ -74,6 +194,12 @@ static int tls_context_alloc(tls_ctx *ctx)
 	TLS_MALLOC(ctx->timer, sizeof(mbedtls_timing_delay_context));
 #ifdef MBEDTLS_SSL_CACHE_C
 	TLS_MALLOC(ctx->cache, sizeof(mbedtls_ssl_cache_context));
+#endif
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	TLS_MALLOC(ctx->sessions, CONFIG_TLS_SESSION_STORE_SIZE * sizeof(tls_saved_session));
+#ifdef MBEDTLS_SSL_TICKET_C
+	TLS_MALLOC(ctx->ticket, sizeof(mbedtls_ssl_ticket_context));
+#endif
 #endif
 	return 0;
 }
@@ -89,12 +215,22 @@ static void tls_context_free(tls_ctx *ctx)
 		TLS_FREE(ctx->timer);
 #ifdef MBEDTLS_SSL_CACHE_C
 		TLS_FREE(ctx->cache);
+#endif
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+		TLS_FREE(ctx->sessions);
+#ifdef MBEDTLS_SSL_TICKET_C
+		TLS_FREE(ctx->ticket);
+#endif
 #endif
 	}
 }
 
 static void tls_context_release(tls_ctx *ctx)
 {
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	int i;
+#endif
+
 	if (ctx) {
 		mbedtls_ssl_config_free(ctx->conf);
 		mbedtls_x509_crt_free(ctx->crt);
@@ -103,6 +239,17 @@ static void tls_context_release(tls_ctx *ctx)
 		mbedtls_ctr_drbg_free(ctx->ctr_drbg);
 #ifdef MBEDTLS_SSL_CACHE_C
 		mbedtls_ssl_cache_free(ctx->cache);
+#endif
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+		for (i = 0; i < CONFIG_TLS_SESSION_STORE_SIZE; i++) {
+			tls_session_drop(&ctx->sessions[i]);
+		}
+#ifdef MBEDTLS_SSL_TICKET_C
+		mbedtls_ssl_ticket_free(ctx->ticket);
+#endif
+#ifdef MBEDTLS_THREADING_C
+		mbedtls_mutex_free(&ctx->mutex);
+#endif
 #endif
 	}
 }
@@ -112,6 +259,15 @@ static int tls_entropy_init(tls_ctx *ctx)
 	return mbedtls_ctr_drbg_seed(ctx->ctr_drbg, mbedtls_entropy_func, ctx->entropy, NULL, 0);
 }
 
+static int tls_ticket_init(tls_ctx *ctx)
+{
+#if defined(CONFIG_TLS_SESSION_RESUMPTION) && defined(MBEDTLS_SSL_TICKET_C)
+	return mbedtls_ssl_ticket_setup(ctx->ticket, mbedtls_ctr_drbg_random, ctx->ctr_drbg, MBEDTLS_CIPHER_AES_256_GCM, CONFIG_TLS_SESSION_TICKET_LIFETIME);
+#else
+	return 0;
+#endif
+}
+
 static int tls_set_cred(tls_ctx *ctx, tls_cred *cred)
 {
 	int ret = TLS_PARSE_CRED_FAIL;
@@ -186,6 +342,11 @@ static int tls_set_default(tls_session *session, tls_ctx *ctx, tls_opt *opt)
 #if defined(MBEDTLS_SSL_CACHE_C)
 	mbedtls_ssl_conf_session_cache(ctx->conf, ctx->cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
 #endif
+#if defined(CONFIG_TLS_SESSION_RESUMPTION) && defined(MBEDTLS_SSL_TICKET_C)
+	if (opt->server == MBEDTLS_SSL_IS_SERVER) {
+		mbedtls_ssl_conf_session_tickets_cb(ctx->conf, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, ctx->ticket);
+	}
+#endif
 
 	if (opt->auth_mode <= MBEDTLS_SSL_VERIFY_UNSET) {
 		mbedtls_ssl_conf_authmode(ctx->conf, opt->auth_mode);
@@ -248,6 +409,11 @@ tls_ctx *TLSCtx(tls_cred *cred)
 		goto errout;
 	}
 
+	if ((ret = tls_ticket_init(ctx)) != TLS_SUCCESS) {
+		EASY_TLS_DEBUG("tls_ticket_init fail %d\n", ret);
+		goto errout;
+	}
+
 	if ((ret = tls_set_cred(ctx, cred)) != TLS_SUCCESS) {
 		EASY_TLS_DEBUG("tls_set_cred fail %d\n", ret);
 		goto errout;
@@ -279,6 +445,7 @@ int TLSCtx_free(tls_ctx *ctx)
 tls_session *TLSSession(int fd, tls_ctx *ctx, tls_opt *opt)
 {
 	int ret;
+	int resumed = 0;
 	tls_session *session = NULL;
 
 	if (ctx == NULL || opt == NULL || fd <= 0) {
@@ -305,20 +472,45 @@ tls_session *TLSSession(int fd, tls_ctx *ctx, tls_opt *opt)
 		goto errout;
 	}
 
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	tls_session_restore(session, ctx, opt);
+#endif
+
 	EASY_TLS_DEBUG("Handshake start .... ");
 
-	while ((ret = mbedtls_ssl_handshake(session->ssl)) != 0) {
-		if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+	/* Step through the handshake, as mbedtls_ssl_handshake() does, to see
+	 * whether the session is resumed before the handshake state is freed.
+	 */
+
+	while (session->ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+		if (session->ssl->handshake) {
+			resumed = session->ssl->handshake->resume;
+		}
+
+		ret = mbedtls_ssl_handshake_step(session->ssl);
+		if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
 			if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
 				EASY_TLS_DEBUG("Failed !! certificate verify fail %d\n", ret);
 			}
 			EASY_TLS_DEBUG("Failed !! %d\n", ret);
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+			tls_session_forget(ctx, opt);
+#endif
 			goto errout;
 		}
+	}
 
+	if (resumed) {
+		ctx->resumed_handshakes++;
+	} else {
+		ctx->full_handshakes++;
 	}
 
-	EASY_TLS_DEBUG("Success !!\n");
+#ifdef CONFIG_TLS_SESSION_RESUMPTION
+	tls_session_save(session, ctx, opt);
+#endif
+
+	EASY_TLS_DEBUG("Success !! (%s)\n", resumed ? "resumed" : "full handshake");
 	return session;
 errout:
 	TLSSession_free(session);
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+###########################################################################
+#
+# Copyright 2017 Samsung Electronics All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+# either express or implied. See the License for the specific
+# language governing permissions and limitations under the License.
+#
+###########################################################################
+#
+# Convert the output of 'ttrace -p', captured from the console, into Chrome
+# trace events (JSON) which chrome://tracing and Perfetto load.
+#
+# The running task and the interrupts are shown on two tracks of a "CPU"
+# process, and the spans and semaphore waits of each task on its own track
+# of a "tasks" process, as 'ttrace -j' does on the target.
+#
+# Usage: ttrace_chrome.py -f console.log -o trace.json
+
+import sys
+import re
+import json
+from optparse import OptionParser
+
+PID_CPU = 0
+PID_TASKS = 1
+TID_SCHED = 0
+TID_IRQ = 1
+
+LINE = re.compile(r'\[(\d+):(\d+)\]\s+(-?\d+):\s+(\w)\|(.*)')
+SCHED = re.compile(r'next_comm=(.*) next_pid=(\d+)')
+
+parser = OptionParser()
+parser.add_option("-f", "--file", dest="infilename", help="console log FILE with the output of 'ttrace -p'. Default is stdin.", metavar="INPUT_FILE")
+parser.add_option("-o", "--output", dest="output", help="Output written to this file. Default is stdout.", metavar="OUTPUT_FILE")
+(options, args) = parser.parse_args()
+
+
+def metadata(what, pid, tid, name):
+    return {"ph": "M", "name": what, "pid": pid, "tid": tid, "args": {"name": name}}
+
+
+def span(phase, ts, pid, tid, name=None):
+    event = {"ph": phase, "ts": ts, "pid": pid, "tid": tid}
+    if name is not None:
+        event["name"] = name
+    return event
+
+
+def convert(lines):
+    events = [metadata("process_name", PID_CPU, 0, "CPU"),
+              metadata("thread_name", PID_CPU, TID_SCHED, "running"),
+              metadata("thread_name", PID_CPU, TID_IRQ, "interrupts"),
+              metadata("process_name", PID_TASKS, 0, "tasks")]
+    comms = {}
+    running = False
+    ts = 0
+
+    for line in lines:
+        match = LINE.search(line)
+        if match is None:
+            continue
+
+        ts = int(match.group(1)) * 1000000 + int(match.group(2))
+        pid = int(match.group(3))
+        kind = match.group(4)
+        payload = match.group(5).strip()
+
+        if kind == 's':
+            sched = SCHED.search(payload)
+            if sched is None:
+                continue
+            comm = sched.group(1)
+            next_pid = int(sched.group(2))
+            if comms.get(next_pid) != comm:
+                comms[next_pid] = comm
+                events.append(metadata("thread_name", PID_TASKS, next_pid, comm))
+            if running:
+                events.append(span("E", ts, PID_CPU, TID_SCHED))
+            events.append(span("B", ts, PID_CPU, TID_SCHED, comm))
+            running = True
+        elif kind in ('i', 'x'):
+            name = "irq " + payload.split('=')[-1]
+            events.append(span("B" if kind == 'i' else "E", ts, PID_CPU, TID_IRQ, name))
+        elif kind in ('w', 'a'):
+            events.append(span("B" if kind == 'w' else "E", ts, PID_TASKS, pid, "sem_wait"))
+        elif kind == 'b':
+            events.append(span("B", ts, PID_TASKS, pid, payload))
+        elif kind == 'e':
+            events.append(span("E", ts, PID_TASKS, pid))
+
+    if running:
+        events.append(span("E", ts, PID_CPU, TID_SCHED))
+
+    return {"traceEvents": events}
+
+
+def main():
+    if options.infilename:
+        infile = open(options.infilename, 'r')
+    else:
+        infile = sys.stdin
+
+    trace = convert(infile)
+
+    if options.output:
+        outfile = open(options.output, 'w')
+    else:
+        outfile = sys.stdout
+
+    json.dump(trace, outfile, indent=1)
+    outfile.write("\n")
+
+
+if __name__ == '__main__':
+    main()